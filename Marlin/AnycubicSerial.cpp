@@ -46,27 +46,43 @@
 // using a ring buffer (I think), in which head is the index of the location
 // to which to write the next incoming character and tail is the index of the
 // location from which to read.
-#if (RAMEND < 1000)
-  #define SERIAL_BUFFER_SIZE 16
-#else
-  #define SERIAL_BUFFER_SIZE 64
-#endif
+#define RX_BUFFER_MASK (ANYCUBIC_RX_BUFFER_SIZE - 1)
+#define TX_BUFFER_MASK (ANYCUBIC_TX_BUFFER_SIZE - 1)
+
+struct ring_buffer_rx
+{
+  unsigned char buffer[ANYCUBIC_RX_BUFFER_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+};
 
-struct ring_buffer
+struct ring_buffer_tx
 {
-  unsigned char buffer[SERIAL_BUFFER_SIZE];
-  volatile unsigned int head;
-  volatile unsigned int tail;
+  unsigned char buffer[ANYCUBIC_TX_BUFFER_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
 };
 
 #if defined(UBRR3H)
-  ring_buffer rx_buffer_ajg  =  { { 0 }, 0, 0 };
-  ring_buffer tx_buffer_ajg  =  { { 0 }, 0, 0 };
+  ring_buffer_rx rx_buffer_ajg  =  { { 0 }, 0, 0 };
+  ring_buffer_tx tx_buffer_ajg  =  { { 0 }, 0, 0 };
+#endif
+
+#if ENABLED(ANYCUBIC_SERIAL_STATS_DROPPED)
+  uint16_t rx_dropped_bytes_ajg = 0;
+#endif
+
+// Spin while the output buffer is full. The native build's clock only
+// runs when the firmware asks it to, so let it run to the next byte out.
+#ifdef __MARLIN_NATIVE__
+  #define TX_WAIT() native_advance(16)
+#else
+  #define TX_WAIT() NOOP
 #endif
 
-inline void store_char(unsigned char c, ring_buffer *buffer)
+inline void store_char(unsigned char c, ring_buffer_rx *buffer)
 {
-  int i = (unsigned int)(buffer->head + 1) % SERIAL_BUFFER_SIZE;
+  const uint8_t i = (uint8_t)(buffer->head + 1) & RX_BUFFER_MASK;
 
   // if we should be storing the received character into the location
   // just before the tail (meaning that the head would advance to the
@@ -76,6 +92,9 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
     buffer->buffer[buffer->head] = c;
     buffer->head = i;
   }
+  #if ENABLED(ANYCUBIC_SERIAL_STATS_DROPPED)
+    else if (!++rx_dropped_bytes_ajg) --rx_dropped_bytes_ajg;
+  #endif
 }
 
 #if defined(USART3_RX_vect) && defined(UDR3)
@@ -103,7 +122,7 @@ ISR(USART3_UDRE_vect)
   else {
     // There is more data in the output buffer. Send the next byte
     unsigned char c = tx_buffer_ajg.buffer[tx_buffer_ajg.tail];
-    tx_buffer_ajg.tail = (tx_buffer_ajg.tail + 1) % SERIAL_BUFFER_SIZE;
+    tx_buffer_ajg.tail = (uint8_t)(tx_buffer_ajg.tail + 1) & TX_BUFFER_MASK;
 	
     UDR3 = c;
   }
@@ -113,7 +132,7 @@ ISR(USART3_UDRE_vect)
 
 // Constructors ////////////////////////////////////////////////////////////////
 
-AnycubicSerialClass::AnycubicSerialClass(ring_buffer *rx_buffer, ring_buffer *tx_buffer,
+AnycubicSerialClass::AnycubicSerialClass(ring_buffer_rx *rx_buffer, ring_buffer_tx *tx_buffer,
   volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
   volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
   volatile uint8_t *ucsrc, volatile uint8_t *udr,
@@ -132,6 +151,9 @@ AnycubicSerialClass::AnycubicSerialClass(ring_buffer *rx_buffer, ring_buffer *tx
   _rxcie = rxcie;
   _udrie = udrie;
   _u2x = u2x;
+  #if ENABLED(ANYCUBIC_SERIAL_STATS_DROPPED)
+    tx_dropped_bytes = 0;
+  #endif
 }
 
 // Public Methods //////////////////////////////////////////////////////////////
@@ -242,7 +264,7 @@ void AnycubicSerialClass::end()
 
 int AnycubicSerialClass::available(void)
 {
-  return (int)(SERIAL_BUFFER_SIZE + _rx_buffer->head - _rx_buffer->tail) % SERIAL_BUFFER_SIZE;
+  return (uint8_t)(_rx_buffer->head - _rx_buffer->tail) & RX_BUFFER_MASK;
 }
 
 int AnycubicSerialClass::peek(void)
@@ -261,7 +283,7 @@ int AnycubicSerialClass::read(void)
     return -1;
   } else {
     unsigned char c = _rx_buffer->buffer[_rx_buffer->tail];
-    _rx_buffer->tail = (unsigned int)(_rx_buffer->tail + 1) % SERIAL_BUFFER_SIZE;
+    _rx_buffer->tail = (uint8_t)(_rx_buffer->tail + 1) & RX_BUFFER_MASK;
     return c;
   }
 }
@@ -275,13 +297,13 @@ void AnycubicSerialClass::flush()
 
 size_t AnycubicSerialClass::write(uint8_t c)
 {
-  int i = (_tx_buffer->head + 1) % SERIAL_BUFFER_SIZE;
+  const uint8_t i = (uint8_t)(_tx_buffer->head + 1) & TX_BUFFER_MASK;
 	
   // If the output buffer is full, there's nothing for it other than to 
   // wait for the interrupt handler to empty it a bit
-  // ???: return 0 here instead?
+  // (use tryWrite() to drop instead of waiting)
   while (i == _tx_buffer->tail)
-    ;
+    TX_WAIT();
 	
   _tx_buffer->buffer[_tx_buffer->head] = c;
   _tx_buffer->head = i;
@@ -294,6 +316,68 @@ size_t AnycubicSerialClass::write(uint8_t c)
   return 1;
 }
 
+// Free space in the output buffer
+int AnycubicSerialClass::availableForWrite(void)
+{
+  return (uint8_t)(_tx_buffer->tail - _tx_buffer->head - 1) & TX_BUFFER_MASK;
+}
+
+// Copy bytes that are known to fit and publish the new head once
+void AnycubicSerialClass::queueTX(const uint8_t *buffer, uint8_t count)
+{
+  uint8_t head = _tx_buffer->head;
+  while (count--) {
+    _tx_buffer->buffer[head] = *buffer++;
+    head = (head + 1) & TX_BUFFER_MASK;
+  }
+
+  CRITICAL_SECTION_START;
+    _tx_buffer->head = head;
+    sbi(*_ucsrb, _udrie);
+    transmitting = true;
+    sbi(*_ucsra, TXC0);
+  CRITICAL_SECTION_END;
+}
+
+// Bulk write. Waits only while the whole output buffer is full.
+size_t AnycubicSerialClass::write(const uint8_t *buffer, size_t size)
+{
+  size_t remaining = size;
+  while (remaining) {
+    const uint8_t room = availableForWrite();
+    if (!room) { TX_WAIT(); continue; } // wait for the interrupt handler to empty it a bit
+    const uint8_t count = remaining < room ? remaining : room;
+    queueTX(buffer, count);
+    buffer += count;
+    remaining -= count;
+  }
+  return size;
+}
+
+// Queue the whole buffer if it fits, without waiting, or else drop all of
+// it: a line cut short would be misread. Returns the number of bytes queued.
+size_t AnycubicSerialClass::tryWrite(const uint8_t *buffer, size_t size)
+{
+  if (size <= (size_t)availableForWrite()) {
+    if (size) queueTX(buffer, size);
+    return size;
+  }
+  #if ENABLED(ANYCUBIC_SERIAL_STATS_DROPPED)
+    tx_dropped_bytes = size > (size_t)(0xFFFF - tx_dropped_bytes) ? 0xFFFF : tx_dropped_bytes + size;
+  #endif
+  return 0;
+}
+
+#if ENABLED(ANYCUBIC_SERIAL_STATS_DROPPED)
+  uint16_t AnycubicSerialClass::droppedRX(void)
+  {
+    CRITICAL_SECTION_START;
+      const uint16_t dropped = rx_dropped_bytes_ajg;
+    CRITICAL_SECTION_END;
+    return dropped;
+  }
+#endif
+
 AnycubicSerialClass::operator bool() {
 	return true;
 }
@@ -35,13 +35,30 @@
 
 #define  FORCE_INLINE __attribute__((always_inline)) inline
 
-struct ring_buffer;
+// Ring buffer sizes for the TFT UART. Use only powers of 2. (...,16,32,64,128,256)
+#ifndef ANYCUBIC_RX_BUFFER_SIZE
+  #define ANYCUBIC_RX_BUFFER_SIZE 64
+#endif
+#ifndef ANYCUBIC_TX_BUFFER_SIZE
+  #define ANYCUBIC_TX_BUFFER_SIZE 128
+#endif
+
+#if !IS_POWER_OF_2(ANYCUBIC_RX_BUFFER_SIZE) || ANYCUBIC_RX_BUFFER_SIZE < 2 || ANYCUBIC_RX_BUFFER_SIZE > 256
+  #error "ANYCUBIC_RX_BUFFER_SIZE must be a power of 2 from 2 to 256."
+#endif
+#if !IS_POWER_OF_2(ANYCUBIC_TX_BUFFER_SIZE) || ANYCUBIC_TX_BUFFER_SIZE < 2 || ANYCUBIC_TX_BUFFER_SIZE > 256
+  #error "ANYCUBIC_TX_BUFFER_SIZE must be a power of 2 from 2 to 256."
+#endif
+
+// Single-byte indexes, so head and tail are read atomically outside the ISRs
+struct ring_buffer_rx;
+struct ring_buffer_tx;
 
 class AnycubicSerialClass : public Stream
 {
   private:
-    ring_buffer *_rx_buffer;
-    ring_buffer *_tx_buffer;
+    ring_buffer_rx *_rx_buffer;
+    ring_buffer_tx *_tx_buffer;
     volatile uint8_t *_ubrrh;
     volatile uint8_t *_ubrrl;
     volatile uint8_t *_ucsra;
@@ -54,8 +71,12 @@ class AnycubicSerialClass : public Stream
     uint8_t _udrie;
     uint8_t _u2x;
     bool transmitting;
+    #if ENABLED(ANYCUBIC_SERIAL_STATS_DROPPED)
+      uint16_t tx_dropped_bytes;
+    #endif
+    void queueTX(const uint8_t *buffer, uint8_t count);
   public:
-    AnycubicSerialClass(ring_buffer *rx_buffer, ring_buffer *tx_buffer,
+    AnycubicSerialClass(ring_buffer_rx *rx_buffer, ring_buffer_tx *tx_buffer,
       volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
       volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
       volatile uint8_t *ucsrc, volatile uint8_t *udr,
@@ -68,11 +89,18 @@ class AnycubicSerialClass : public Stream
     virtual int read(void);
     virtual void flush(void);
     virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    int availableForWrite(void);
+    size_t tryWrite(const uint8_t *buffer, size_t size);
+    #if ENABLED(ANYCUBIC_SERIAL_STATS_DROPPED)
+      uint16_t droppedRX(void);
+      FORCE_INLINE uint16_t droppedTX(void) { return tx_dropped_bytes; }
+    #endif
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
     inline size_t write(unsigned int n) { return write((uint8_t)n); }
     inline size_t write(int n) { return write((uint8_t)n); }
-    using Print::write; // pull in write(str) and write(buf, size) from Print
+    using Print::write; // pull in write(str) from Print
     operator bool();
 };
 
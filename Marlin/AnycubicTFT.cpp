@@ -72,16 +72,242 @@ void AnycubicTFTClass::Setup() {
 #endif
   }
 #endif
+
+  ReadOutageEEPromData();
+}
+
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+
+/**
+ * Outage journal layout: a 32 byte header slot followed by
+ * OUTAGE_RECORD_SLOTS record slots of 32 bytes, the top 1K of the EEPROM.
+ */
+#define OUTAGE_DATA_VERSION   4
+#define OUTAGE_SLOT_SIZE      32
+#define OUTAGE_RECORD_SLOTS   31
+#define OUTAGE_HEADER_ADDR    (E2END+1 - OUTAGE_SLOT_SIZE * (OUTAGE_RECORD_SLOTS + 1))
+#define OUTAGE_RECORD_ADDR(S) (OUTAGE_HEADER_ADDR + OUTAGE_SLOT_SIZE * ((S) + 1))
+#define OUTAGE_EEPROM(A)      ((uint8_t*)(uintptr_t)(A))
+
+static uint8_t OutageChecksum(const uint8_t *data, const uint8_t len)
+{
+  uint8_t sum=0xA5;
+  for(uint8_t i=0; i<len; i++) sum=((sum << 1) | (sum >> 7)) ^ data[i];
+  return sum;
 }
 
+void AnycubicTFTClass::OutageJournalStart()
+{
+  char path[MAXPATHNAMELENGTH];
+  card.getAbsFilename(path);
+  OutageHeader.OutageDataVersion=OUTAGE_DATA_VERSION;
+  OutageHeader.PrintId++;
+  if(strlen(path)<sizeof(OutageHeader.FileName))
+    strcpy(OutageHeader.FileName,path);
+  else
+    OutageHeader.FileName[0]='\0'; // Too long to resume, don't journal
+  OutageHeader.Checksum=OutageChecksum((uint8_t*)OutageHeader.FileName,sizeof(OutageHeader.FileName)) ^ OutageHeader.PrintId;
+  OutageHeaderPending=true;
+  next_outage_record_ms=millis();
+}
+
+// Is the open file the one the journal is for?
+bool AnycubicTFTClass::OutageJournalHasOpenFile()
+{
+  char path[MAXPATHNAMELENGTH];
+  card.getAbsFilename(path);
+  return OutageHeader.FileName[0] && !strcmp(path,OutageHeader.FileName);
+}
+
+void AnycubicTFTClass::OutageJournalEnd()
+{
+  if(!OutageHeader.FileName[0]) return;
+  OutageHeader.FileName[0]='\0';
+  OutageHeader.Checksum=OutageChecksum((uint8_t*)OutageHeader.FileName,sizeof(OutageHeader.FileName)) ^ OutageHeader.PrintId;
+  OutageHeaderPending=true;
+}
+
+// Forget an outage record that was not resumed, and leave SDOUTAGE
+void AnycubicTFTClass::OutageJournalDiscard()
+{
+  OutageJournalEnd();
+  TFTstate=ANYCUBIC_TFT_STATE_IDLE;
+}
+
+/**
+ * Write at most one byte of a pending header or record, and only if
+ * the EEPROM is ready, so the main loop never waits on it.
+ */
+void AnycubicTFTClass::OutageJournalWrite()
+{
+  if(!OutageWriteBlock)
+  {
+    if(!OutageHeaderPending) return;
+    OutageHeaderPending=false;
+    OutageWriteBlock=1;
+    OutageWriteIndex=0;
+  }
+  if(!eeprom_is_ready()) return;
+
+  const uint8_t *src;
+  uint8_t *dst;
+  uint8_t len;
+  if(OutageWriteBlock==1)
+  {
+    src=(const uint8_t*)&OutageHeader;
+    dst=OUTAGE_EEPROM(OUTAGE_HEADER_ADDR);
+    len=sizeof(OutageHeader);
+  }
+  else
+  {
+    src=(const uint8_t*)&OutageData;
+    dst=OUTAGE_EEPROM(OUTAGE_RECORD_ADDR(OutageSlot));
+    len=sizeof(OutageData);
+  }
+
+  // Write the checksum last so that a torn record is detected
+  const uint8_t i=(OutageWriteBlock==1)
+    ? (OutageWriteIndex<2 ? OutageWriteIndex : OutageWriteIndex==len-1 ? 2 : OutageWriteIndex+1)
+    : OutageWriteIndex;
+  if(eeprom_read_byte(dst+i)!=src[i])
+    eeprom_write_byte(dst+i,src[i]);
+
+  if(++OutageWriteIndex>=len)
+  {
+    if(OutageWriteBlock==2 && ++OutageSlot>=OUTAGE_RECORD_SLOTS) OutageSlot=0;
+    OutageWriteBlock=0;
+  }
+}
+
+/**
+ * Issue the resume sequence one command per call, retrying
+ * while the command queue is full.
+ */
+void AnycubicTFTClass::OutageResume()
+{
+  char cmd[40], str_1[16], str_2[16];
+  switch(OutageResumeStep)
+  {
+    case 1: sprintf_P(cmd,PSTR("M140 S%i"),OutageData.last_bed_temp); break;
+    case 2: sprintf_P(cmd,PSTR("M104 S%i"),OutageData.last_hotend_temp); break;
+    case 3: sprintf_P(cmd,PSTR("M190 S%i"),OutageData.last_bed_temp); break;
+    case 4: sprintf_P(cmd,PSTR("M109 S%i"),OutageData.last_hotend_temp); break;
+    case 5:
+      sprintf_P(cmd,PSTR("G92 Z%s E%s"),
+        dtostrf(OutageData.last_position[Z_AXIS],1,3,str_1),
+        dtostrf(OutageData.last_position[E_AXIS],1,3,str_2));
+      break;
+    case 6: strcpy_P(cmd,PSTR("G91")); break;
+    case 7: strcpy_P(cmd,PSTR("G1 Z5 F240")); break;
+    case 8: strcpy_P(cmd,PSTR("G90")); break;
+    case 9: strcpy_P(cmd,PSTR("G28 X Y")); break;
+    case 10:
+      sprintf_P(cmd,PSTR("G1 X%s Y%s F3000"),
+        dtostrf(OutageData.last_position[X_AXIS],1,3,str_1),
+        dtostrf(OutageData.last_position[Y_AXIS],1,3,str_2));
+      break;
+    case 11: sprintf_P(cmd,PSTR("G1 Z%s F240"),dtostrf(OutageData.last_position[Z_AXIS],1,3,str_1)); break;
+    case 12: sprintf_P(cmd,PSTR("M106 S%i"),OutageData.last_fan_speed); break;
+    // The file carries on with the modes and feedrate it had, not those of the moves above
+    case 13: strcpy_P(cmd,OutageData.last_relative_e ? PSTR("M83") : PSTR("M82")); break;
+    case 14: sprintf_P(cmd,PSTR("G1 F%u"),OutageData.last_feedrate); break;
+    case 15: strcpy_P(cmd,PSTR("M24")); break;
+    default: OutageResumeStep=0; return;
+  }
+  if(enqueue_and_echo_command(cmd))
+    OutageResumeStep++;
+}
+
+#endif // ANYCUBIC_OUTAGE_JOURNAL
+
+/**
+ * Journal where the SD command now moving started, at most once every
+ * ANYCUBIC_OUTAGE_JOURNAL_INTERVAL, and push pending bytes to the EEPROM.
+ */
 void AnycubicTFTClass::WriteOutageEEPromData() {
-  int pos=E2END-256;
-  
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  OutageJournalWrite();
+
+  if(!card.sdprinting || !OutageHeader.FileName[0] || OutageWriteBlock || OutageHeaderPending
+    || !stepper.command_start_changed || PENDING(millis(),next_outage_record_ms)) return;
+
+  bool from_sd;
+  uint32_t sdpos;
+  long steps[XYZE];
+  CRITICAL_SECTION_START;
+    from_sd=stepper.command_start_from_sd;
+    sdpos=stepper.command_start_sdpos;
+    COPY(steps,stepper.command_start_position);
+    OutageData.last_feedrate=stepper.command_start_feedrate;
+    OutageData.last_relative_e=stepper.command_start_relative_e;
+    stepper.command_start_changed=false;
+  CRITICAL_SECTION_END;
+  if(!from_sd) return; // Not a command from the file
+
+  float pos[XYZE];
+  LOOP_XYZE(i) pos[i]=steps[i]*planner.steps_to_mm[i];
+  #if PLANNER_LEVELING
+    planner.unapply_leveling(pos);
+  #endif
+
+  OutageData.PrintId=OutageHeader.PrintId;
+  OutageData.Sequence++;
+  OutageData.last_fan_speed=fanSpeeds[0];
+  OutageData.lastSDposition=sdpos;
+  COPY(OutageData.last_position,pos);
+  OutageData.last_hotend_temp=thermalManager.degTargetHotend(0);
+  OutageData.last_bed_temp=thermalManager.degTargetBed();
+  OutageData.Checksum=OutageChecksum((uint8_t*)&OutageData,offsetof(OutageDataStruct,Checksum));
+
+  OutageWriteBlock=2;
+  OutageWriteIndex=0;
+  next_outage_record_ms=millis()+ANYCUBIC_OUTAGE_JOURNAL_INTERVAL;
+#endif
 }
 
+/**
+ * At boot, find the newest complete record of an unfinished print.
+ * If there is one, the TFT is offered to resume it (A15).
+ */
 void AnycubicTFTClass::ReadOutageEEPromData() {
-  int pos=E2END-256;
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  static_assert(sizeof(OutageHeader)<=OUTAGE_SLOT_SIZE,"The outage journal header must fit in OUTAGE_SLOT_SIZE.");
+  static_assert(sizeof(OutageData)<=OUTAGE_SLOT_SIZE,"An outage journal record must fit in OUTAGE_SLOT_SIZE.");
+
+  eeprom_read_block(&OutageHeader,OUTAGE_EEPROM(OUTAGE_HEADER_ADDR),sizeof(OutageHeader));
+  const bool header_ok=(OutageHeader.OutageDataVersion==OUTAGE_DATA_VERSION)
+    && (OutageHeader.Checksum==(OutageChecksum((uint8_t*)OutageHeader.FileName,sizeof(OutageHeader.FileName)) ^ OutageHeader.PrintId));
+  if(!header_ok)
+  {
+    OutageHeader.OutageDataVersion=OUTAGE_DATA_VERSION;
+    OutageHeader.PrintId=0;
+    OutageHeader.FileName[0]='\0';
+  }
+
+  bool found=false;
+  OutageDataStruct record;
+  for(uint8_t s=0; s<OUTAGE_RECORD_SLOTS; s++)
+  {
+    eeprom_read_block(&record,OUTAGE_EEPROM(OUTAGE_RECORD_ADDR(s)),sizeof(record));
+    if(record.PrintId!=OutageHeader.PrintId
+      || record.Checksum!=OutageChecksum((uint8_t*)&record,offsetof(OutageDataStruct,Checksum))) continue;
+    if(!found || int8_t(record.Sequence-OutageData.Sequence)>0)
+    {
+      OutageData=record;
+      OutageSlot=(s+1)%OUTAGE_RECORD_SLOTS;
+      found=true;
+    }
+  }
 
+  if(header_ok && found && OutageHeader.FileName[0])
+  {
+    TFTstate=ANYCUBIC_TFT_STATE_SDOUTAGE;
+#ifdef ANYCUBIC_TFT_DEBUG
+    SERIAL_ECHOPAIR("TFT Serial Debug: Outage record for ",OutageHeader.FileName);
+    SERIAL_ECHOLNPAIR(" at ",OutageData.lastSDposition);
+#endif
+  }
+#endif
 }
 
 
@@ -91,6 +317,11 @@ void AnycubicTFTClass::StartPrint(){
     enqueue_and_echo_commands_P(PSTR("G91\nG1 Z-10 F240\nG90"));
 #endif
   }
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  else if (!OutageJournalHasOpenFile()) {
+    OutageJournalStart();
+  }
+#endif
   starttime=millis();
   card.startFileprint();
   TFTstate=ANYCUBIC_TFT_STATE_SDPRINT;
@@ -122,15 +353,81 @@ void AnycubicTFTClass::StopPrint(){
 }
 
 
-float AnycubicTFTClass::CodeValue()
+/**
+ * Scan a complete command once, noting the first occurrence of each
+ * letter A-Z, so that CodeSeen() is a bit test instead of a strchr().
+ */
+void AnycubicTFTClass::TokenizeCommand(char *cmd)
+{
+  TFTcmdptr = cmd;
+  ZERO(TFTcodebits);
+  for (char *p = cmd; *p; p++) {
+    const uint8_t ind = *p - 'A';
+    if (ind < COUNT(TFTparam) && !TEST(TFTcodebits[ind >> 3], ind & 0x7)) {
+      SBI(TFTcodebits[ind >> 3], ind & 0x7);
+      TFTparam[ind] = p - cmd;
+    }
+  }
+}
+
+/**
+ * The value following the last seen code, as fixed point with two
+ * decimals ("-0.15" gives -15). Integer math only, no strtod().
+ */
+int32_t AnycubicTFTClass::CodeValueFixed()
 {
-  return (strtod(&TFTcmdbuffer[TFTbufindr][TFTstrchr_pointer - TFTcmdbuffer[TFTbufindr] + 1], NULL));
+  const char *p = TFTstrchr_pointer + 1;
+  while (*p == ' ') p++;
+  const bool negative = (*p == '-');
+  if (negative || *p == '+') p++;
+
+  int32_t value = 0;
+  while (NUMERIC(*p)) {
+    if (value < 1000000L) value = value * 10 + (*p - '0');
+    p++;
+  }
+  value *= 100;
+  if (*p == '.' && NUMERIC(p[1])) {
+    value += (p[1] - '0') * 10;
+    if (NUMERIC(p[2])) value += p[2] - '0';
+  }
+  return negative ? -value : value;
 }
 
 bool AnycubicTFTClass::CodeSeen(char code)
 {
-  TFTstrchr_pointer = strchr(TFTcmdbuffer[TFTbufindr], code);
-  return (TFTstrchr_pointer != NULL);  //Return True if a character was found
+  const uint8_t ind = code - 'A';
+  if (ind >= COUNT(TFTparam) || !TEST(TFTcodebits[ind >> 3], ind & 0x7))
+    return false;
+  TFTstrchr_pointer = TFTcmdptr + TFTparam[ind];
+  return true;
+}
+
+// Status replies are built whole in RAM, then queued whole or dropped
+// (AnycubicSerial.tryWrite), so a TFT polling faster than the line drains
+// never stalls the main loop. The TFT polls again.
+#define TFT_REPLY_SIZE 128
+
+static char *AppendText(char *p, const char *text)
+{
+  strcpy(p, text);
+  return p + strlen(p);
+}
+
+static char *AppendTextP(char *p, const char *text)
+{
+  strcpy_P(p, text);
+  return p + strlen(p);
+}
+
+static char *AppendNumber(char *p, uint32_t value)
+{
+  char digits[10];
+  uint8_t n=0;
+  do { digits[n++]='0' + value%10; value/=10; } while(value);
+  while(n) *p++=digits[--n];
+  *p=0;
+  return p;
 }
 
 uint16_t AnycubicTFTClass::GetFileNr()
@@ -147,28 +444,17 @@ void AnycubicTFTClass::Ls()
 {
   if(card.cardOK)
   {
-    uint8_t cnt=0;
-    for(cnt=0; cnt<card.getnrfilenames(); cnt++){
+    // The TFT pages backwards from the end of the list, four files at a time
+    const int16_t last=MyFileNrCnt-filenumber;
+    // Each file's two lines go out together or not at all
+    for(int16_t cnt=max(last-4,0); cnt<last; cnt++)
+    {
       card.getfilename(cnt);
-      
-      if((MyFileNrCnt-filenumber)<4)
-      {
-        if(fileoutputcnt<MyFileNrCnt-filenumber)
-        {
-          ANYCUBIC_SERIAL_PROTOCOLLN(card.filename);
-          ANYCUBIC_SERIAL_PROTOCOLLN(card.longFilename);
-        }
-      }
-      else if((fileoutputcnt>=((MyFileNrCnt-4)-filenumber))&&(fileoutputcnt<MyFileNrCnt-filenumber))
-      {
-        ANYCUBIC_SERIAL_PROTOCOLLN(card.filename);
-        ANYCUBIC_SERIAL_PROTOCOLLN(card.longFilename);
-      }
-      fileoutputcnt++;
+      char reply[FILENAME_LENGTH + LONG_FILENAME_LENGTH + 4], *p=AppendText(reply, card.filename);
+      *p++='\r';
+      *p++='\n';
+      SendReply(reply, AppendText(p, card.longFilename));
     }
-    if(fileoutputcnt>=MyFileNrCnt)
-      fileoutputcnt=0;
-    
   }
 }
 
@@ -177,6 +463,10 @@ void AnycubicTFTClass::CheckSDCardChange()
   if (LastSDstatus != IS_SD_INSERTED)
   {
     LastSDstatus = IS_SD_INSERTED;
+
+#if ENABLED(SDCARD_DIR_INDEX)
+    card.flush_dir_index(); // A different card may have been inserted
+#endif
     
     if (LastSDstatus)
     {
@@ -224,6 +514,109 @@ void AnycubicTFTClass::CheckHeaterError()
   }
 }
 
+/**
+ * Sample the values reported to the TFT. The status polls (A0-A7, A34)
+ * are answered from this frame so they do no float math of their own.
+ * Fields that changed are flagged for the next A34.
+ */
+void AnycubicTFTClass::RefreshStatusFrame()
+{
+  StatusFrameStruct frame;
+  frame.hotend_temp=int(thermalManager.degHotend(0) + 0.5);
+  frame.hotend_target=int(thermalManager.degTargetHotend(0) + 0.5);
+  frame.bed_temp=int(thermalManager.degBed() + 0.5);
+  frame.bed_target=int(thermalManager.degTargetBed() + 0.5);
+
+  //frame.fan_percent=((fanSpeed*100)/256+1);
+  frame.fan_percent=constrain((fanSpeeds[0]*100)/179+1,0,100); //MAX 70%
+
+  if(!card.sdprinting)
+    frame.sd_percent=-1;
+  else if(!card.cardOK)
+    frame.sd_percent=-2;
+  else
+    frame.sd_percent=card.percentDone();
+
+  frame.print_minutes=(starttime != 0) ? millis()/60000 - starttime/60000 : 0xFFFF;
+
+  for(uint8_t axis=X_AXIS; axis<=Z_AXIS; axis++)
+    frame.position[axis]=LROUND(current_position[axis] * 100);
+
+  uint8_t changed=0;
+  if(frame.hotend_temp!=StatusFrame.hotend_temp) SBI(changed, 0);
+  if(frame.hotend_target!=StatusFrame.hotend_target) SBI(changed, 1);
+  if(frame.bed_temp!=StatusFrame.bed_temp) SBI(changed, 2);
+  if(frame.bed_target!=StatusFrame.bed_target) SBI(changed, 3);
+  if(frame.fan_percent!=StatusFrame.fan_percent) SBI(changed, 4);
+  if(memcmp(frame.position, StatusFrame.position, sizeof(frame.position))) SBI(changed, 5);
+  if(frame.sd_percent!=StatusFrame.sd_percent) SBI(changed, 6);
+  if(frame.print_minutes!=StatusFrame.print_minutes) SBI(changed, 7);
+  StatusFieldsChanged|=changed;
+  StatusFrame=frame;
+}
+
+// A value in hundredths with two decimals, like Print::print(float)
+char *AnycubicTFTClass::AppendFixed(char *p, int32_t value)
+{
+  if(value<0)
+  {
+    *p++='-';
+    value=-value;
+  }
+  p=AppendNumber(p, value/100);
+  *p++='.';
+  *p++='0' + (value/10)%10;
+  *p++='0' + value%10;
+  *p=0;
+  return p;
+}
+
+/**
+ * One status field, including its leading space, in the format of the
+ * corresponding A0-A7 reply. At most 50 characters.
+ */
+char *AnycubicTFTClass::AppendStatusField(char *p, const uint8_t field)
+{
+  *p++=' ';
+  switch(field)
+  {
+    case 0: return AppendText(p, itostr3(StatusFrame.hotend_temp));
+    case 1: return AppendText(p, itostr3(StatusFrame.hotend_target));
+    case 2: return AppendText(p, itostr3(StatusFrame.bed_temp));
+    case 3: return AppendText(p, itostr3(StatusFrame.bed_target));
+    case 4: return AppendNumber(p, StatusFrame.fan_percent);
+    case 5:
+      p=AppendFixed(AppendTextP(p, PSTR("X: ")), StatusFrame.position[X_AXIS]);
+      p=AppendFixed(AppendTextP(p, PSTR(" Y: ")), StatusFrame.position[Y_AXIS]);
+      p=AppendFixed(AppendTextP(p, PSTR(" Z: ")), StatusFrame.position[Z_AXIS]);
+      return AppendTextP(p, PSTR(" "));
+    case 6:
+      if(StatusFrame.sd_percent>=0)
+        return AppendText(p, itostr3(StatusFrame.sd_percent));
+      return AppendTextP(p, StatusFrame.sd_percent==-2 ? PSTR("J02") : PSTR("---"));
+    case 7:
+      if(StatusFrame.print_minutes != 0xFFFF) // print time
+      {
+        p=AppendText(p, itostr2(StatusFrame.print_minutes/60));
+        p=AppendTextP(p, PSTR(" H "));
+        p=AppendText(p, itostr2(StatusFrame.print_minutes%60));
+        return AppendTextP(p, PSTR(" M"));
+      }
+      return AppendTextP(p, PSTR(" 999:999"));
+  }
+  *p=0;
+  return p;
+}
+
+// End the reply that starts at line and ends at p, and queue it unless
+// the transmit buffer is too full. Returns false if it was dropped.
+bool AnycubicTFTClass::SendReply(char *line, char *p)
+{
+  *p++='\r';
+  *p++='\n';
+  return AnycubicSerial.tryWrite((const uint8_t *)line, p - line) != 0;
+}
+
 void AnycubicTFTClass::StateHandler()
 {
   switch (TFTstate) {
@@ -231,6 +624,9 @@ void AnycubicTFTClass::StateHandler()
     if(card.sdprinting){
       TFTstate=ANYCUBIC_TFT_STATE_SDPRINT;
       starttime=millis();
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+      OutageJournalStart();
+#endif
 
       // --> Send print info to display... most probably print started via gcode
     }
@@ -244,6 +640,9 @@ void AnycubicTFTClass::StateHandler()
         } else {
           // File is closed --> stopped
           TFTstate=ANYCUBIC_TFT_STATE_IDLE;
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+          OutageJournalEnd();
+#endif
           ANYCUBIC_SERIAL_PROTOCOLPGM("J14");// J14 print done
           ANYCUBIC_SERIAL_ENTER();
 #ifdef ANYCUBIC_TFT_DEBUG
@@ -263,6 +662,9 @@ void AnycubicTFTClass::StateHandler()
   case ANYCUBIC_TFT_STATE_SDPAUSE_REQ:
     if((!card.sdprinting) && (!planner.movesplanned())){
       // We have to wait until the sd card printing has been settled
+#if ENABLED(SEGMENT_TIME_BUDGET)
+      planner.end_block_stream();
+#endif
 #ifndef ADVANCED_PAUSE_FEATURE
       enqueue_and_echo_commands_P(PSTR("G91\nG1 Z10 F240\nG90"));
 #endif
@@ -286,12 +688,26 @@ void AnycubicTFTClass::StateHandler()
       ANYCUBIC_SERIAL_PROTOCOLPGM("J16");// J16 stop print
       ANYCUBIC_SERIAL_ENTER();
       TFTstate=ANYCUBIC_TFT_STATE_IDLE;
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+      OutageJournalEnd();
+#endif
 #ifdef ANYCUBIC_TFT_DEBUG
       SERIAL_ECHOLNPGM("TFT Serial Debug: SD print stopped... J16");
 #endif
       enqueue_and_echo_commands_P(PSTR("M84"));
     }
     break;
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  case ANYCUBIC_TFT_STATE_SDOUTAGE:
+    // The resume sequence ends with M24. Any other print (M23/M24 from
+    // the host) gets a journal of its own.
+    if(card.sdprinting){
+      TFTstate=ANYCUBIC_TFT_STATE_SDPRINT;
+      starttime=millis();
+      if(!OutageJournalHasOpenFile()) OutageJournalStart();
+    }
+    break;
+#endif
   default:
     break;
   }
@@ -351,10 +767,9 @@ void AnycubicTFTClass::GetCommandFromTFT()
       
       TFTcmdbuffer[TFTbufindw][serial3_count] = 0; //terminate string
       
-      if((strchr(TFTcmdbuffer[TFTbufindw], 'A') != NULL)){
-        int16_t a_command;
-        TFTstrchr_pointer = strchr(TFTcmdbuffer[TFTbufindw], 'A');
-        a_command=((int)((strtod(&TFTcmdbuffer[TFTbufindw][TFTstrchr_pointer - TFTcmdbuffer[TFTbufindw] + 1], NULL))));
+      TokenizeCommand(TFTcmdbuffer[TFTbufindw]);
+      if(CodeSeen('A')){
+        const int16_t a_command=CodeValueInt();
 #ifdef ANYCUBIC_TFT_DEBUG
         if ((a_command>7) && (a_command != 20)) // No debugging of status polls, please!
           SERIAL_ECHOLNPAIR("TFT Serial Command: ", TFTcmdbuffer[TFTbufindw]);
@@ -363,88 +778,22 @@ void AnycubicTFTClass::GetCommandFromTFT()
         switch(a_command){
             
           case 0: //A0 GET HOTEND TEMP
-            ANYCUBIC_SERIAL_PROTOCOLPGM("A0V ");
-            ANYCUBIC_SERIAL_PROTOCOL(itostr3(int(thermalManager.degHotend(0) + 0.5)));
-            ANYCUBIC_SERIAL_ENTER();
-            break;
           case 1: //A1  GET HOTEND TARGET TEMP
-            ANYCUBIC_SERIAL_PROTOCOLPGM("A1V ");
-            ANYCUBIC_SERIAL_PROTOCOL(itostr3(int(thermalManager.degTargetHotend(0) + 0.5)));
-            ANYCUBIC_SERIAL_ENTER();
-            break;
           case 2: //A2 GET HOTBED TEMP
-            ANYCUBIC_SERIAL_PROTOCOLPGM("A2V ");
-            ANYCUBIC_SERIAL_PROTOCOL(itostr3(int(thermalManager.degBed() + 0.5)));
-            ANYCUBIC_SERIAL_ENTER();
-            break;
           case 3: //A3 GET HOTBED TARGET TEMP
-            ANYCUBIC_SERIAL_PROTOCOLPGM("A3V ");
-            ANYCUBIC_SERIAL_PROTOCOL(itostr3(int(thermalManager.degTargetBed() + 0.5)));
-            ANYCUBIC_SERIAL_ENTER();
-            break;
-            
-          case 4://A4 GET FAN SPEED
-          {
-            unsigned int temp;
-            //   temp=((fanSpeed*100)/256+1);
-            temp=((fanSpeeds[0]*100)/179+1);//MAX 70%
-            temp=constrain(temp,0,100);
-            ANYCUBIC_SERIAL_PROTOCOLPGM("A4V ");
-            ANYCUBIC_SERIAL_PROTOCOL(temp);
-            ANYCUBIC_SERIAL_ENTER();
-          }
-            break;
-          case 5:// A5 GET CURRENT COORDINATE
-            ANYCUBIC_SERIAL_PROTOCOLPGM("A5V");
-            ANYCUBIC_SERIAL_SPACE();
-            ANYCUBIC_SERIAL_PROTOCOLPGM("X: ");
-            ANYCUBIC_SERIAL_PROTOCOL(current_position[X_AXIS]);
-            ANYCUBIC_SERIAL_SPACE();
-            ANYCUBIC_SERIAL_PROTOCOLPGM("Y: ");
-            ANYCUBIC_SERIAL_PROTOCOL(current_position[Y_AXIS]);
-            ANYCUBIC_SERIAL_SPACE();
-            ANYCUBIC_SERIAL_PROTOCOLPGM("Z: ");
-            ANYCUBIC_SERIAL_PROTOCOL(current_position[Z_AXIS]);
-            ANYCUBIC_SERIAL_SPACE();
-            ANYCUBIC_SERIAL_ENTER();
-            break;
+          case 4: //A4 GET FAN SPEED
+          case 5: // A5 GET CURRENT COORDINATE
           case 6: //A6 GET SD CARD PRINTING STATUS
-            if(card.sdprinting){
-              ANYCUBIC_SERIAL_PROTOCOLPGM("A6V ");
-              if(card.cardOK)
-              {
-                ANYCUBIC_SERIAL_PROTOCOL(itostr3(card.percentDone()));
-              }
-              else
-              {
-                ANYCUBIC_SERIAL_PROTOCOLPGM("J02");
-              }
-            }
-            else
-              ANYCUBIC_SERIAL_PROTOCOLPGM("A6V ---");
-            ANYCUBIC_SERIAL_ENTER();
-            break;
-          case 7://A7 GET PRINTING TIME
+          case 7: //A7 GET PRINTING TIME
           {
-            ANYCUBIC_SERIAL_PROTOCOLPGM("A7V ");
-            if(starttime != 0) // print time
-            {
-              uint16_t time = millis()/60000 - starttime/60000;
-              ANYCUBIC_SERIAL_PROTOCOL(itostr2(time/60));
-              ANYCUBIC_SERIAL_SPACE();
-              ANYCUBIC_SERIAL_PROTOCOLPGM("H");
-              ANYCUBIC_SERIAL_SPACE();
-              ANYCUBIC_SERIAL_PROTOCOL(itostr2(time%60));
-              ANYCUBIC_SERIAL_SPACE();
-              ANYCUBIC_SERIAL_PROTOCOLPGM("M");
-            }else{
-              ANYCUBIC_SERIAL_SPACE();
-              ANYCUBIC_SERIAL_PROTOCOLPGM("999:999");
-            }
-            ANYCUBIC_SERIAL_ENTER();
-            
-            break;
+            // Answered from the cached status frame
+            char reply[TFT_REPLY_SIZE], *p=reply;
+            *p++='A';
+            *p++='0' + a_command;
+            *p++='V';
+            SendReply(reply, AppendStatusField(p, a_command));
           }
+            break;
           case 8: // A8 GET  SD LIST
             MyFileNrCnt=0;
             if(!IS_SD_INSERTED)
@@ -457,13 +806,14 @@ void AnycubicTFTClass::GetCommandFromTFT()
               MyFileNrCnt=GetFileNr();
               
               if(CodeSeen('S'))
-                filenumber=CodeValue();
+                filenumber=CodeValueInt();
               
-              ANYCUBIC_SERIAL_PROTOCOLPGM("FN "); // Filelist start
-              ANYCUBIC_SERIAL_ENTER();
-              Ls();
-              ANYCUBIC_SERIAL_PROTOCOLPGM("END"); // Filelist stop
-              ANYCUBIC_SERIAL_ENTER();
+              char reply[8];
+              if(SendReply(reply, AppendTextP(reply, PSTR("FN ")))) // Filelist start
+              {
+                Ls();
+                SendReply(reply, AppendTextP(reply, PSTR("END"))); // Filelist stop
+              }
             }
             break;
           case 9: // A9 pause sd print
@@ -502,6 +852,10 @@ void AnycubicTFTClass::GetCommandFromTFT()
             kill(PSTR(MSG_KILLED));
             break;
           case 13: // A13 SELECTION FILE
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+            if((TFTstate==ANYCUBIC_TFT_STATE_SDOUTAGE) && (!OutageResumeStep))
+              OutageJournalDiscard(); // Another print is chosen over resuming
+#endif
             if((!planner.movesplanned()) && (TFTstate!=ANYCUBIC_TFT_STATE_SDPAUSE) && (TFTstate!=ANYCUBIC_TFT_STATE_SDOUTAGE))
             {
               starpos = (strchr(TFTstrchr_pointer + 4,'*'));
@@ -525,6 +879,10 @@ void AnycubicTFTClass::GetCommandFromTFT()
             }
             break;
           case 14: // A14 START PRINTING
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+            if((TFTstate==ANYCUBIC_TFT_STATE_SDOUTAGE) && (!OutageResumeStep))
+              OutageJournalDiscard(); // Another print is chosen over resuming
+#endif
             if((!planner.movesplanned()) && (TFTstate!=ANYCUBIC_TFT_STATE_SDPAUSE) && (TFTstate!=ANYCUBIC_TFT_STATE_SDOUTAGE) && (card.isFileOpen()))
             {
               StartPrint();
@@ -536,29 +894,36 @@ void AnycubicTFTClass::GetCommandFromTFT()
             }
             break;
           case 15: // A15 RESUMING FROM OUTAGE
-            //                    			if((!planner.movesplanned())&&(!TFTresumingflag))
-            //                          {
-            //                                if(card.cardOK)
-            //                                FlagResumFromOutage=true;
-            //                                ResumingFlag=1;
-            //                                card.startFileprint();
-            //                                starttime=millis();
-            //                                ANYCUBIC_SERIAL_SUCC_START;
-            //                          }
-            //                          ANYCUBIC_SERIAL_ENTER();
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+            if((!planner.movesplanned()) && (TFTstate==ANYCUBIC_TFT_STATE_SDOUTAGE) && (!OutageResumeStep))
+            {
+              char path[sizeof(OutageHeader.FileName)];
+              strcpy(path,OutageHeader.FileName);
+              if(!card.cardOK) card.initsd();
+              card.openFile(path,true);
+              if(card.isFileOpen())
+              {
+                card.setIndex(OutageData.lastSDposition);
+                FlagResumFromOutage=true;
+                OutageResumeStep=1;
+                ANYCUBIC_SERIAL_SUCC_START;
+              }
+            }
+            ANYCUBIC_SERIAL_ENTER();
+#endif
             break;
           case 16: // A16 set hotend temp
           {
             unsigned int tempvalue;
             if(CodeSeen('S'))
             {
-              tempvalue=constrain(CodeValue(),0,275);
+              tempvalue=constrain(CodeValueInt(),0,275);
               thermalManager.setTargetHotend(tempvalue,0);
             }
             else if((CodeSeen('C'))&&(!planner.movesplanned()))
             {
               if((READ(Z_TEST)==0)) enqueue_and_echo_commands_P(PSTR("G1 Z10")); //RASE Z AXIS
-              tempvalue=constrain(CodeValue(),0,275);
+              tempvalue=constrain(CodeValueInt(),0,275);
               thermalManager.setTargetHotend(tempvalue,0);
             }
           }
@@ -567,7 +932,7 @@ void AnycubicTFTClass::GetCommandFromTFT()
           case 17:// A17 set heated bed temp
           {
             unsigned int tempbed;
-            if(CodeSeen('S')){tempbed=constrain(CodeValue(),0,150);
+            if(CodeSeen('S')){tempbed=constrain(CodeValueInt(),0,150);
               thermalManager.setTargetBed(tempbed);
             }
           }
@@ -577,8 +942,7 @@ void AnycubicTFTClass::GetCommandFromTFT()
             unsigned int temp;
             if (CodeSeen('S'))
             {
-              temp=(CodeValue()*255/100);
-              temp=constrain(temp,0,255);
+              temp=constrain(CodeValueFixed()*255/10000,0,255);
               fanSpeeds[0]=temp;
             }
             else fanSpeeds[0]=255;
@@ -622,44 +986,44 @@ void AnycubicTFTClass::GetCommandFromTFT()
           case 22: // A22 move X/Y/Z or extrude
             if((!planner.movesplanned()) && (TFTstate!=ANYCUBIC_TFT_STATE_SDPAUSE) && (TFTstate!=ANYCUBIC_TFT_STATE_SDOUTAGE))
             {
-              float coorvalue;
+              int32_t coorvalue; // hundredths of a mm
               unsigned int movespeed=0;
               char value[30];
               if(CodeSeen('F')) // Set feedrate
-                movespeed = CodeValue();
+                movespeed = CodeValueInt();
               
               enqueue_and_echo_commands_P(PSTR("G91"));  // relative coordinates
               
               if(CodeSeen('X')) // Move in X direction
               {
-                coorvalue=CodeValue();
-                if((coorvalue<=0.2)&&coorvalue>0){sprintf_P(value,PSTR("G1 X0.1F%i"),movespeed);}
-                else if((coorvalue<=-0.1)&&coorvalue>-1){sprintf_P(value,PSTR("G1 X-0.1F%i"),movespeed);}
-                else {sprintf_P(value,PSTR("G1 X%iF%i"),int(coorvalue),movespeed);}
+                coorvalue=CodeValueFixed();
+                if((coorvalue<=20)&&coorvalue>0){sprintf_P(value,PSTR("G1 X0.1F%i"),movespeed);}
+                else if((coorvalue<=-10)&&coorvalue>-100){sprintf_P(value,PSTR("G1 X-0.1F%i"),movespeed);}
+                else {sprintf_P(value,PSTR("G1 X%iF%i"),int(coorvalue/100),movespeed);}
                 enqueue_and_echo_command(value);
               }
               else if(CodeSeen('Y')) // Move in Y direction
               {
-                coorvalue=CodeValue();
-                if((coorvalue<=0.2)&&coorvalue>0){sprintf_P(value,PSTR("G1 Y0.1F%i"),movespeed);}
-                else if((coorvalue<=-0.1)&&coorvalue>-1){sprintf_P(value,PSTR("G1 Y-0.1F%i"),movespeed);}
-                else {sprintf_P(value,PSTR("G1 Y%iF%i"),int(coorvalue),movespeed);}
+                coorvalue=CodeValueFixed();
+                if((coorvalue<=20)&&coorvalue>0){sprintf_P(value,PSTR("G1 Y0.1F%i"),movespeed);}
+                else if((coorvalue<=-10)&&coorvalue>-100){sprintf_P(value,PSTR("G1 Y-0.1F%i"),movespeed);}
+                else {sprintf_P(value,PSTR("G1 Y%iF%i"),int(coorvalue/100),movespeed);}
                 enqueue_and_echo_command(value);
               }
               else if(CodeSeen('Z')) // Move in Z direction
               {
-                coorvalue=CodeValue();
-                if((coorvalue<=0.2)&&coorvalue>0){sprintf_P(value,PSTR("G1 Z0.1F%i"),movespeed);}
-                else if((coorvalue<=-0.1)&&coorvalue>-1){sprintf_P(value,PSTR("G1 Z-0.1F%i"),movespeed);}
-                else {sprintf_P(value,PSTR("G1 Z%iF%i"),int(coorvalue),movespeed);}
+                coorvalue=CodeValueFixed();
+                if((coorvalue<=20)&&coorvalue>0){sprintf_P(value,PSTR("G1 Z0.1F%i"),movespeed);}
+                else if((coorvalue<=-10)&&coorvalue>-100){sprintf_P(value,PSTR("G1 Z-0.1F%i"),movespeed);}
+                else {sprintf_P(value,PSTR("G1 Z%iF%i"),int(coorvalue/100),movespeed);}
                 enqueue_and_echo_command(value);
               }
               else if(CodeSeen('E')) // Extrude
               {
-                coorvalue=CodeValue();
-                if((coorvalue<=0.2)&&coorvalue>0){sprintf_P(value,PSTR("G1 E0.1F%i"),movespeed);}
-                else if((coorvalue<=-0.1)&&coorvalue>-1){sprintf_P(value,PSTR("G1 E-0.1F%i"),movespeed);}
-                else {sprintf_P(value,PSTR("G1 E%iF500"),int(coorvalue)); }
+                coorvalue=CodeValueFixed();
+                if((coorvalue<=20)&&coorvalue>0){sprintf_P(value,PSTR("G1 E0.1F%i"),movespeed);}
+                else if((coorvalue<=-10)&&coorvalue>-100){sprintf_P(value,PSTR("G1 E-0.1F%i"),movespeed);}
+                else {sprintf_P(value,PSTR("G1 E%iF500"),int(coorvalue/100)); }
                 enqueue_and_echo_command(value);
               }
               enqueue_and_echo_commands_P(PSTR("G90"));  // absolute coordinates
@@ -701,6 +1065,7 @@ void AnycubicTFTClass::GetCommandFromTFT()
             break;
           case 26: // A26 refresh SD
             card.initsd();
+            MyFileNrCnt=GetFileNr(); // Rebuild the directory index now rather than on the next A8
             if(!IS_SD_INSERTED)
             {
               ANYCUBIC_SERIAL_PROTOCOLPGM("J02"); // J02 SD Card initilized
@@ -813,6 +1178,23 @@ void AnycubicTFTClass::GetCommandFromTFT()
             ANYCUBIC_SERIAL_ENTER();
           }
             break;
+          case 34: // A34 get the status fields (A0-A7) changed since the last A34, A34 F for all of them
+          {
+            if(CodeSeen('F')) StatusFieldsChanged=0xFF;
+            char reply[TFT_REPLY_SIZE], *p=AppendTextP(reply, PSTR("A34V"));
+            for (uint8_t field=0; field<8; field++)
+              if(TEST(StatusFieldsChanged, field))
+              {
+                *p++=' ';
+                *p++='A';
+                *p++='0' + field;
+                *p++='V';
+                p=AppendStatusField(p, field);
+              }
+            // A dropped reply leaves the fields flagged for the next A34
+            if(SendReply(reply, p)) StatusFieldsChanged=0;
+          }
+            break;
           default: break;
         }
       }
@@ -832,6 +1214,17 @@ void AnycubicTFTClass::CommandScan()
   CheckHeaterError();
   CheckSDCardChange();
   StateHandler();
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  WriteOutageEEPromData();
+  if(OutageResumeStep) OutageResume();
+#endif
+
+  const unsigned long ms=millis();
+  if(ELAPSED(ms, next_status_refresh_ms))
+  {
+    next_status_refresh_ms=ms+TFT_STATUS_REFRESH_MS;
+    RefreshStatusFrame();
+  }
   
   if(TFTbuflen<(TFTBUFSIZE-1))
     GetCommandFromTFT();
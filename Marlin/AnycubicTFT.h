@@ -28,6 +28,7 @@ char *itostr2(const uint8_t &x);
 #define TFTBUFSIZE 4
 #define TFT_MAX_CMD_SIZE 96
 #define MSG_MY_VERSION "V116"
+#define TFT_STATUS_REFRESH_MS 250   // How often the cached status frame is refreshed
 
 #define ANYCUBIC_TFT_STATE_IDLE           0
 #define ANYCUBIC_TFT_STATE_SDPRINT        1
@@ -56,10 +57,12 @@ private:
   char serial3_char;
   int serial3_count = 0;
   char *TFTstrchr_pointer;
+  char *TFTcmdptr;              // The command being dispatched
+  uint8_t TFTcodebits[4];       // Letters seen in the command (1 bit each)
+  uint8_t TFTparam[26];         // For A-Z, offsets into the command
   char TFTstate=ANYCUBIC_TFT_STATE_IDLE;
   char FlagResumFromOutage=0;
   uint16_t MyFileNrCnt=0;
-  uint16_t fileoutputcnt=0;
   uint16_t filenumber=0;
   unsigned long starttime=0;
   unsigned long stoptime=0;
@@ -67,19 +70,63 @@ private:
   char LastSDstatus=0;
   uint16_t HeaterCheckCount=0;
   
+  // Status values answered to A0-A7 and A34, refreshed every TFT_STATUS_REFRESH_MS
+  struct StatusFrameStruct {
+    int16_t hotend_temp, hotend_target;
+    int16_t bed_temp, bed_target;
+    uint8_t fan_percent;
+    int8_t sd_percent;              // -1 not printing, -2 card error
+    uint16_t print_minutes;         // 0xFFFF if no print was started
+    int32_t position[3];            // XYZ in hundredths of a mm
+  } StatusFrame;
+  uint8_t StatusFieldsChanged=0xFF; // Bit n set if field n changed since the last A34
+  unsigned long next_status_refresh_ms=0;
+
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  // The print in progress. Written at print start, cleared when it ends.
+  struct OutageHeaderStruct {
+    uint8_t OutageDataVersion;
+    uint8_t PrintId;
+    uint8_t Checksum;
+    char FileName[29];              // Absolute path, empty if no print is running
+  } OutageHeader;
+
+  // One journal record. The checksum is the last byte written.
+  // Widest fields first, so there is no padding between fields on any target.
   struct OutageDataStruct {
-    char OutageDataVersion;
-    char OutageFlag;
-    float last_position[XYZE];
-    float last_bed_temp;
-    float last_hotend_temp;
-    long lastSDposition;
+    int32_t lastSDposition;         // Start of the command that was moving
+    float last_position[XYZE];      // ...and where that command started
+    int16_t last_hotend_temp;
+    int16_t last_bed_temp;
+    uint16_t last_feedrate;         // G-code feedrate (mm/min) of that command
+    uint8_t PrintId;                // Matches OutageHeader.PrintId
+    uint8_t Sequence;               // The newest record has the highest sequence
+    uint8_t last_fan_speed;
+    uint8_t last_relative_e;        // M83 was in effect
+    uint8_t Checksum;
   } OutageData;
+
+  uint8_t OutageSlot=0;             // Next record slot to write
+  uint8_t OutageWriteBlock=0;       // 0 idle, 1 header, 2 record
+  uint8_t OutageWriteIndex=0;       // Next byte of the block to write
+  bool OutageHeaderPending=false;
+  unsigned long next_outage_record_ms=0;
+  uint8_t OutageResumeStep=0;       // Position in the A15 resume sequence, 0 if not resuming
+
+  void OutageJournalStart();
+  bool OutageJournalHasOpenFile();
+  void OutageJournalEnd();
+  void OutageJournalDiscard();
+  void OutageJournalWrite();
+  void OutageResume();
+#endif
   
   void WriteOutageEEPromData();
   void ReadOutageEEPromData();
   
-  float CodeValue();
+  void TokenizeCommand(char *cmd);
+  int32_t CodeValueFixed();
+  int16_t CodeValueInt() { return CodeValueFixed() / 100; }
   bool CodeSeen(char);
   uint16_t GetFileNr();
   void Ls();
@@ -90,6 +137,10 @@ private:
   void GetCommandFromTFT();
   void CheckSDCardChange();
   void CheckHeaterError();
+  void RefreshStatusFrame();
+  char *AppendFixed(char *, int32_t);
+  char *AppendStatusField(char *, const uint8_t);
+  bool SendReply(char *, char *);
 
 #if ENABLED(ANYCUBIC_FILAMENT_RUNOUT_SENSOR)
   char FilamentTestStatus=false;
@@ -219,6 +219,11 @@
     #define MAX_STEP_FREQUENCY 40000 // Max step frequency for Ultimaker (5000 pps / half step)
   #endif
 
+  // The stepper ISR takes 2 steps per run above this rate, 4 above twice this rate
+  #ifndef DOUBLE_STEP_FREQUENCY
+    #define DOUBLE_STEP_FREQUENCY 10000
+  #endif
+
   // MS1 MS2 Stepper Driver Microstepping mode table
   #define MICROSTEP1 LOW,LOW
   #define MICROSTEP2 HIGH,LOW
@@ -913,6 +918,9 @@
     #undef PROBE_MANUALLY
   #endif
 
+  // The planner keeps a running total of the queued move time
+  #define HAS_BLOCK_BUFFER_RUNTIME (ENABLED(ULTRA_LCD) || ENABLED(SEGMENT_TIME_BUDGET))
+
   // Parking Extruder
   #if ENABLED(PARKING_EXTRUDER)
     #ifndef PARKING_EXTRUDER_GRAB_DISTANCE
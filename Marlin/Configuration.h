@@ -1574,6 +1574,14 @@
 // duty cycle is attained.
 //#define SOFT_PWM_DITHER
 
+// Drive the heaters, and the fan with FAN_SOFT_PWM, by sigma-delta modulation
+// instead. Each tick of the temperature ISR (976Hz) adds a 16-bit duty to an
+// accumulator and turns the output on when it overflows. The PID output keeps
+// its full resolution instead of 128 steps, and the on-time is spread evenly.
+// Outputs may switch up to 488 times a second, so don't use this with relays.
+// SOFT_PWM_SCALE and SOFT_PWM_DITHER no longer apply.
+//#define SOFT_PWM_SIGMA_DELTA
+
 // Temperature status LEDs that display the hotend and bed temperature.
 // If all hotends, bed temperature, and target temperature are under 54C
 // then the BLUE led is on. Otherwise the RED led is on. (1C hysteresis)
@@ -1718,5 +1726,33 @@
 #define ANYCUBIC_FILAMENT_RUNOUT_SENSOR
 #define ANYCUBIC_TFT_DEBUG
 
+// TFT serial ring buffer sizes. A full file list page needs about 256 bytes.
+// :[16, 32, 64, 128, 256]
+//#define ANYCUBIC_RX_BUFFER_SIZE 64
+//#define ANYCUBIC_TX_BUFFER_SIZE 128
+
+// Count bytes dropped by a full TFT receive buffer (AnycubicSerial.droppedRX())
+// and status replies dropped by a full transmit buffer (droppedTX())
+//#define ANYCUBIC_SERIAL_STATS_DROPPED
+
+/**
+ * Power outage journal
+ *
+ * While printing from SD, record the SD position where the command now being
+ * executed starts, along with the position, target temperatures and fan speed
+ * at that point, with the feedrate and E mode (M82/M83) it ran with.
+ * Records rotate through 31 slots in the top 1K of the EEPROM and are
+ * written one byte per main loop pass, so the steppers are never held up.
+ * After a power loss the TFT's A15 resumes from the last complete record.
+ *
+ * Each slot is rewritten every 31 * ANYCUBIC_OUTAGE_JOURNAL_INTERVAL ms of
+ * printing. At 10s that's about 8,600 hours of printing for 100,000 EEPROM
+ * cycles.
+ */
+#define ANYCUBIC_OUTAGE_JOURNAL
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  #define ANYCUBIC_OUTAGE_JOURNAL_INTERVAL 10000 // (ms) Minimum time between records
+#endif
+
 
 #endif // CONFIGURATION_H
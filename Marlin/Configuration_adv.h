@@ -106,8 +106,35 @@
     #define DEFAULT_Kc (100) //heating power=Kc*(e_speed)
     #define LPQ_MAX_LEN 50
   #endif
+
+  /**
+   * Extrusion Feed-Forward
+   *
+   * Add heater power for the plastic the queued moves are about to melt,
+   * before it starts to flow. The planner queue is read ahead by the lag
+   * between heater and melt zone, and the volumetric flow found there adds
+   * Kf PWM steps per mm³/s to the PID output. Set with M301 F<Kf> A<lag>.
+   */
+  //#define PID_EXTRUSION_FEEDFORWARD
+  #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+    #define DEFAULT_Kf 2.6         // PWM steps per mm³/s. About 0.4J per mm³ of PLA over a 40W heater.
+    #define DEFAULT_Kf_LAG 2000    // (ms) Dead time of the hotend
+  #endif
 #endif
 
+/**
+ * Fixed-Point PID
+ *
+ * Run the hotend and bed PID loops in integer arithmetic. Temperatures are
+ * taken in 1/16 °C, straight from THERMISTOR_INDEX_TABLES where enabled, and
+ * the terms are kept in 1/256 of a PWM step, with the gains scaled to match
+ * whenever they change. The output is the same as the float PID to within a
+ * fraction of a PWM step, at a small part of the cost.
+ * buildroot/share/scripts/check_pid_fixed.py compares the two on a
+ * simulated hotend and bed.
+ */
+#define PID_FIXED_POINT
+
 /**
  * Automatic Temperature:
  * The hotend target temperature is calculated by all the buffered lines of gcode.
@@ -127,6 +154,24 @@
 // Enable for M105 to include ADC values read from temperature sensors.
 //#define SHOW_TEMP_ADC_VALUES
 
+/**
+ * Thermistor Index Tables
+ *
+ * Look up thermistor readings in tables with an entry for every ADC count
+ * (thermistortables_index.h) instead of searching the thermistor table.
+ * Converting a reading takes the same short time at any temperature.
+ * Each thermistor type in use adds up to 2K of flash.
+ *
+ * Near table points that fall between ADC counts the two lookups differ.
+ * Type 6 reads up to 4.7°C apart at its 45/40°C step, and type 66 up to
+ * 4.5°C apart below 80°C and 101°C apart past its 500°C top.
+ * buildroot/share/scripts/check_thermistors.py checks every type.
+ *
+ * After changing a thermistortable_*.h run createTemperatureLookupMarlin.py
+ * with --index (see thermistortables_index.h) to update the index tables.
+ */
+#define THERMISTOR_INDEX_TABLES
+
 /**
  * High Temperature Thermistor Support
  *
@@ -397,7 +442,24 @@
 #define DEFAULT_MINSEGMENTTIME        20000
 
 // If defined the movements slow down when the look ahead buffer is only half full
-#define SLOWDOWN
+//#define SLOWDOWN
+
+// Measure how long the front end (SD, parser, planner) takes to queue each
+// block, and stretch short segments to that time, up to DEFAULT_MINSEGMENTTIME,
+// when the queued moves won't outlast refilling half the buffer.
+// This replaces SLOWDOWN, which must be disabled. Use M40 to report buffer
+// starvation and fill levels.
+#define SEGMENT_TIME_BUDGET
+
+// Join runs of short, nearly collinear segments into one planner block before
+// queueing them, so each buffer slot covers more of the path. To keep E in
+// proportion, only segments that extrude at the same rate per mm are joined.
+// Use M40 to report how many segments were merged.
+//#define SEGMENT_MERGE
+#if ENABLED(SEGMENT_MERGE)
+  #define SEGMENT_MERGE_TOLERANCE  0.01 // (mm) Furthest a merged point may be from the joined segment
+  #define SEGMENT_MERGE_MAX_LENGTH 3.0  // (mm) Longest joined segment
+#endif
 
 // Frequency limit
 // See nophead's blog for more info
@@ -409,6 +471,64 @@
 // if unwanted behavior is observed on a user's machine when running at very slow speeds.
 #define MINIMUM_PLANNER_SPEED 0.05 // (mm/sec)
 
+// Plan junction speeds and trapezoids with integer math on squared speeds.
+// Replotting the buffer needs no float square roots or divisions, which
+// keeps recalculate() short on 8-bit AVR. Speeds are limited to 4096mm/s.
+//#define PLANNER_FIXED_POINT
+
+/**
+ * S-Curve Acceleration
+ *
+ * Ramp the step rate along a 5th-order Bezier curve instead of a straight line,
+ * so acceleration (and jerk) rise and fall smoothly at both ends of each ramp.
+ * Ramps take the same time and distance as the linear profile, with a peak
+ * acceleration 1.875x the configured value.
+ * Costs 20 bytes of RAM per trapezoid. Each stepper ISR on a ramp runs
+ * s_curve_rate(): five 32-bit multiplies and two more by constants, where
+ * the linear ramp does one 24x32 multiply.
+ */
+//#define S_CURVE_ACCELERATION
+
+// Work out step rates in the main loop instead of the stepper ISR. Blocks are
+// cut ahead of time into short segments of constant rate, and the ISR only
+// traces the Bresenham lines and reloads the timer. Not for LIN_ADVANCE.
+//#define STEP_SEGMENT_BUFFER
+#if ENABLED(STEP_SEGMENT_BUFFER)
+  #define STEP_SEGMENT_BUFFER_SIZE 16 // Segments ready for the ISR: 8, 16, or 32. 8 bytes of RAM each
+  #define STEP_SEGMENT_TICKS 4000     // Segment duration in timer ticks (2MHz). 4000 = 2ms
+  // The buffer holds SIZE x TICKS of moves (16 x 2ms = 32ms). When the main
+  // loop is held up longer (SD card init, EEPROM write) the stepper ISR cuts
+  // the segments itself until it's back, so the motors never stop mid-move.
+#endif
+
+/**
+ * Input Shaping
+ *
+ * Cancel the ringing of the X and Y axes at their resonant frequency, so
+ * acceleration can go up without ghosting. Each step of a shaped axis is
+ * split into 2 or 3 impulses spread over about one ringing period, and the
+ * motor steps as the impulses add up. Corners get slightly rounded.
+ *
+ * Shapers: 0 = ZV  (2 impulses over half a period, the least smoothing)
+ *          1 = ZVD (3 impulses over a period, tolerates a wrong frequency)
+ *          2 = MZV (3 impulses over 3/4 of a period, in between)
+ *
+ * Measure the frequency from the spacing of ripples on a test print and
+ * set it with M593. Homing moves are not shaped. Not for LIN_ADVANCE.
+ */
+//#define INPUT_SHAPING
+#if ENABLED(INPUT_SHAPING)
+  #define SHAPING_FREQ_X 50         // (Hz) 20 to 200, or 0 for no shaping
+  #define SHAPING_FREQ_Y 40         // (Hz) The Y axis of a bed-slinger rings at a lower frequency
+  #define SHAPING_ZETA_X 0.1        // Damping ratio, 0 to 0.3
+  #define SHAPING_ZETA_Y 0.1
+  #define SHAPING_TYPE_X 0          // 0 = ZV, 1 = ZVD, 2 = MZV
+  #define SHAPING_TYPE_Y 0
+  #define SHAPING_BUFFER_SIZE 128   // Steps each axis can hold back: 64, 128, or 256. 2 bytes of RAM each
+                                    // 128 lets a ZV shaper at 40Hz step up to ~10000 steps/s. M593 reports the limit,
+                                    // and the X and Y max feedrates are lowered to it.
+#endif
+
 // Microstep setting (Only functional when stepper driver microstep pins are connected to MCU.
 #define MICROSTEP_MODES {16,16,16,16,16} // [1,2,4,8,16]
 
@@ -521,6 +641,42 @@
     #define SDSORT_DYNAMIC_RAM false  // Use dynamic allocation (within SD menus). Least expensive option. Set SDSORT_LIMIT before use!
   #endif
 
+  /**
+   * Index the current directory by entry position.
+   *
+   * Without an index every request for file N (e.g. the Anycubic TFT file list)
+   * re-reads the directory from the start. With this option the position of
+   * each entry is recorded while counting the files, so any file name can be
+   * fetched with a single seek. The index is rebuilt when the card or working
+   * directory changes.
+   */
+  #define SDCARD_DIR_INDEX
+
+  #if ENABLED(SDCARD_DIR_INDEX)
+    #define SDCARD_DIR_INDEX_LIMIT 200  // Maximum number of indexed items (10-1024). Costs 2 bytes each.
+  #endif
+
+  /**
+   * Read the printed file ahead in whole blocks.
+   *
+   * CardReader::get() hands out bytes from a RAM buffer instead of calling
+   * into SdBaseFile for every byte. The buffer is filled with block-aligned
+   * reads that bypass the shared volume cache, and several blocks within a
+   * cluster are fetched with a single multiple-block read (CMD18).
+   * M39 reports the read throughput.
+   *
+   * The print's commands are also scanned from the buffer a run at a time.
+   * This scanner requires SD_READ_AHEAD; without it they're read a byte at
+   * a time. buildroot/share/scripts/check_sd_scanner.py compares the two.
+   *
+   * This costs the buffer plus 18 bytes of RAM: 530 bytes with 1 block.
+   */
+  //#define SD_READ_AHEAD
+
+  #if ENABLED(SD_READ_AHEAD)
+    #define SD_READ_AHEAD_BLOCKS 1      // Blocks to buffer (1-4). Costs 512 bytes each.
+  #endif
+
   // Show a progress bar on HD44780 LCDs for SD printing
   //#define LCD_PROGRESS_BAR
 
@@ -707,6 +863,23 @@
 // Set this if you find stepping unreliable, or if using a very fast CPU.
 #define MINIMUM_STEPPER_PULSE 0 // (µs) The smallest stepper pulse allowed
 
+// At high step rates the stepper ISR takes 2 or 4 steps per run. Split each
+// ISR period in two and send half the steps at the start of each half,
+// instead of all of them in one burst. Double stepping becomes evenly spaced
+// single steps, and quad stepping becomes evenly spaced pairs. The second
+// half gets a short timer interrupt of its own, without the step rate math,
+// so the ISR runs up to 2 x DOUBLE_STEP_FREQUENCY times per second instead of
+// DOUBLE_STEP_FREQUENCY. That is an ISR count from the native simulation,
+// which doesn't model ISR run time. The cost in AVR cycles is unmeasured.
+//#define UNIFORM_STEP_PULSES
+#if ENABLED(UNIFORM_STEP_PULSES)
+  #define DOUBLE_STEP_FREQUENCY 10000 // (steps/s) Take 2 steps per ISR above this rate, 4 above twice it
+#endif
+
+// Track the longest delay between the stepper timer firing and its ISR
+// running, i.e. the longest time interrupts were held off. Report it with M38.
+//#define STEPPER_ISR_LATENCY
+
 // @section temperature
 
 // Control heater 0 and heater 1 in parallel.
@@ -732,6 +905,19 @@
 #define MAX_CMD_SIZE 96
 #define BUFSIZE 4
 
+// Parse G0-G3 moves once, as they are queued, into 32 bytes instead of a
+// MAX_CMD_SIZE text slot. The BUFSIZE * MAX_CMD_SIZE bytes of the queue are
+// shared in 32-byte cells: a move takes one, other commands as many as their
+// text needs. The queue then holds up to GCODE_PREPARSE_BUFSIZE commands, as
+// many moves as fit with a full command's cells still free (10 by default).
+// RAM grows by a byte per command, plus a byte more per command past BUFSIZE
+// (6 with ANYCUBIC_OUTAGE_JOURNAL): 13 bytes by default.
+// Requires FASTER_GCODE_PARSER.
+//#define GCODE_PREPARSE
+#if ENABLED(GCODE_PREPARSE)
+  #define GCODE_PREPARSE_BUFSIZE 8
+#endif
+
 // Transmission to Host Buffer Size
 // To save 386 bytes of PROGMEM (and TX_BUFFER_SIZE+3 bytes of RAM) set to 0.
 // To buffer a simple "ok" you need 4 bytes.
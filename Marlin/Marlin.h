@@ -193,6 +193,13 @@ extern uint8_t marlin_debug_flags;
 #define DEBUGGING(F) (marlin_debug_flags & (DEBUG_## F))
 
 extern bool Running;
+
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  extern bool current_command_from_sd;
+  extern uint32_t current_command_sdpos;
+  extern bool current_command_relative_e;
+  extern float feedrate_mm_s;
+#endif
 inline bool IsRunning() { return  Running; }
 inline bool IsStopped() { return !Running; }
 
@@ -99,6 +99,9 @@
  *        The '#' is necessary when calling from within sd files, as it stops buffer prereading
  * M33  - Get the longname version of a path. (Requires LONG_FILENAME_HOST_SUPPORT)
  * M34  - Set SD Card sorting options. (Requires SDCARD_SORT_ALPHA)
+ * M38  - Report the longest stepper ISR latency. "M38 R" to reset. (Requires STEPPER_ISR_LATENCY)
+ * M39  - Report SD read throughput. "M39 R" to reset. (Requires SD_READ_AHEAD)
+ * M40  - Report planner buffer statistics. "M40 R" to reset. (Requires SEGMENT_TIME_BUDGET or SEGMENT_MERGE)
  * M42  - Change pin status via gcode: M42 P<pin> S<value>. LED pin assumed if P is omitted.
  * M43  - Display pin status, watch pins for changes, watch endstops & toggle LED, Z servo probe test, toggle pins
  * M48  - Measure Z Probe repeatability: M48 P<points> X<pos> Y<pos> V<level> E<engage> L<legs>. (Requires Z_MIN_PROBE_REPEATABILITY_TEST)
@@ -199,6 +202,7 @@
  * M502 - Revert to the default "factory settings". ** Does not write them to EEPROM! **
  * M503 - Print the current settings (in memory): "M503 S<verbose>". S0 specifies compact output.
  * M540 - Enable/disable SD card abort on endstop hit: "M540 S<state>". (Requires ABORT_ON_ENDSTOP_HIT_FEATURE_ENABLED)
+ * M593 - Set or report input shaping: "M593 [X|Y] F<hz> D<zeta> T<type>". (Requires INPUT_SHAPING)
  * M600 - Pause for filament change: "M600 X<pos> Y<pos> Z<raise> E<first_retract> L<later_retract>". (Requires ADVANCED_PAUSE_FEATURE)
  * M665 - Set delta configurations: "M665 L<diagonal rod> R<delta radius> S<segments/s> A<rod A trim mm> B<rod B trim mm> C<rod C trim mm> I<tower A trim angle> J<tower B trim angle> K<tower C trim angle>" (Requires DELTA)
  * M666 - Set delta endstop adjustment. (Requires DELTA)
@@ -413,7 +417,19 @@ static long gcode_N, gcode_LastN, Stopped_gcode_LastN = 0;
  * (immediate, serial, sd card) and they are processed sequentially by
  * the main loop. The process_next_command function parses the next
  * command and hands off execution to individual handler functions.
+ *
+ * With GCODE_PREPARSE the queue holds GCODE_PREPARSE_BUFSIZE commands.
+ * command_queue becomes a ring of cells the size of a packed move, shared
+ * by all of them. Each command is read in at cmd_cell_w, which always has
+ * room for MAX_CMD_SIZE before the end. G0-G3 moves are parsed as they are
+ * committed and packed into their first cell. Other commands keep their
+ * text, in as many cells as it takes.
  */
+#if ENABLED(GCODE_PREPARSE)
+  #define CMD_QUEUE_SIZE GCODE_PREPARSE_BUFSIZE
+#else
+  #define CMD_QUEUE_SIZE BUFSIZE
+#endif
 uint8_t commands_in_queue = 0; // Count of commands in the queue
 static uint8_t cmd_queue_index_r = 0, // Ring buffer read position
                cmd_queue_index_w = 0; // Ring buffer write position
@@ -422,6 +438,32 @@ static uint8_t cmd_queue_index_r = 0, // Ring buffer read position
 #else                                         // This can be collapsed back to the way it was soon.
 static char command_queue[BUFSIZE][MAX_CMD_SIZE];
 #endif
+#if ENABLED(GCODE_PREPARSE)
+  #define CMD_CELL_SIZE sizeof(gcode_packed_t)
+  #define CMD_CELLS (sizeof(command_queue) / CMD_CELL_SIZE)
+  #define CMD_TEXT_CELLS ((MAX_CMD_SIZE + CMD_CELL_SIZE - 1) / CMD_CELL_SIZE)
+  #define CMD_IS_TEXT 0x80
+  static_assert(CMD_CELLS < CMD_IS_TEXT, "BUFSIZE * MAX_CMD_SIZE is too large for GCODE_PREPARSE.");
+  static uint8_t command_cell[CMD_QUEUE_SIZE], // First cell of each command, plus CMD_IS_TEXT if it's text
+                 cmd_cell_w = 0;               // Cell where the next command is read in
+  #define CMD_CELL(I) (&command_queue[0][0] + (I) * CMD_CELL_SIZE)
+  #define CMD_CELL_R (command_cell[cmd_queue_index_r] & ~CMD_IS_TEXT)
+  #define CMD_R_IS_TEXT (command_cell[cmd_queue_index_r] & CMD_IS_TEXT)
+  #define CMD_TEXT_R CMD_CELL(CMD_CELL_R)
+  #define CMD_TEXT_W CMD_CELL(cmd_cell_w)
+  #define CMD_QUEUE_HAS_ROOM() cmd_queue_has_room()
+  static bool cmd_queue_has_room() {
+    if (!commands_in_queue) return true;
+    if (commands_in_queue >= CMD_QUEUE_SIZE) return false;
+    // The commands take the cells from the oldest one's up to cmd_cell_w, wrapping around
+    const uint8_t r = CMD_CELL_R;
+    return cmd_cell_w > r || r - cmd_cell_w >= CMD_TEXT_CELLS;
+  }
+#else
+  #define CMD_TEXT_R command_queue[cmd_queue_index_r]
+  #define CMD_TEXT_W command_queue[cmd_queue_index_w]
+  #define CMD_QUEUE_HAS_ROOM() (commands_in_queue < BUFSIZE)
+#endif
 
 /**
  * Next Injected Command pointer. NULL if no commands are being injected.
@@ -668,7 +710,15 @@ float cartes[XYZ] = { 0 };
   #endif
 #endif
 
-static bool send_ok[BUFSIZE];
+static bool send_ok[CMD_QUEUE_SIZE];
+
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  static bool command_from_sd[CMD_QUEUE_SIZE];   // Each queued command read from the SD print file...
+  static uint32_t command_sdpos[CMD_QUEUE_SIZE]; // ...and where it starts in the file
+  bool current_command_from_sd;           // The same for the command being executed
+  uint32_t current_command_sdpos;
+  bool current_command_relative_e;        // E is relative (M83 or G91) for the command being executed
+#endif
 
 #if HAS_SERVOS
   Servo servo[NUM_SERVOS];
@@ -872,8 +922,30 @@ void clear_command_queue() {
  * Once a new command is in the ring buffer, call this to commit it
  */
 inline void _commit_command(bool say_ok) {
+  #ifdef __MARLIN_NATIVE__
+    if (native_command_hook) native_command_hook(CMD_TEXT_W);
+  #endif
   send_ok[cmd_queue_index_w] = say_ok;
-  if (++cmd_queue_index_w >= BUFSIZE) cmd_queue_index_w = 0;
+  #if ENABLED(GCODE_PREPARSE)
+    // Moves are parsed now. Commands written to SD by M28 stay as they are.
+    gcode_packed_t packed;
+    const bool is_text = (
+      #if ENABLED(SDSUPPORT)
+        card.saving ||
+      #endif
+      !parser.pack(CMD_TEXT_W, packed)
+    );
+    command_cell[cmd_queue_index_w] = cmd_cell_w | (is_text ? CMD_IS_TEXT : 0);
+    if (is_text)
+      cmd_cell_w += (strlen(CMD_TEXT_W) + CMD_CELL_SIZE) / CMD_CELL_SIZE; // The cells up to the nul
+    else {
+      memcpy(CMD_TEXT_W, &packed, sizeof(packed));
+      cmd_cell_w++;
+    }
+    // Leave room for a full command before the end, or start over
+    if (cmd_cell_w > CMD_CELLS - CMD_TEXT_CELLS) cmd_cell_w = 0;
+  #endif
+  if (++cmd_queue_index_w >= CMD_QUEUE_SIZE) cmd_queue_index_w = 0;
   commands_in_queue++;
 }
 
@@ -883,8 +955,11 @@ inline void _commit_command(bool say_ok) {
  * Return false for a full buffer, or if the 'command' is a comment.
  */
 inline bool _enqueuecommand(const char* cmd, bool say_ok=false) {
-  if (*cmd == ';' || commands_in_queue >= BUFSIZE) return false;
-  strcpy(command_queue[cmd_queue_index_w], cmd);
+  if (*cmd == ';' || !CMD_QUEUE_HAS_ROOM()) return false;
+  strcpy(CMD_TEXT_W, cmd);
+  #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+    command_from_sd[cmd_queue_index_w] = false;
+  #endif
   _commit_command(say_ok);
   return true;
 }
@@ -1119,7 +1194,7 @@ inline void get_serial_commands() {
    * Loop while serial characters are incoming and the queue is not full
    */
   int c;
-  while (commands_in_queue < BUFSIZE && (c = MYSERIAL.read()) >= 0) {
+  while (CMD_QUEUE_HAS_ROOM() && (c = MYSERIAL.read()) >= 0) {
 
     char serial_char = c;
 
@@ -1238,6 +1313,25 @@ inline void get_serial_commands() {
 
 #if ENABLED(SDSUPPORT)
 
+  /**
+   * The end of the file was reached while reading commands
+   */
+  inline void sd_file_printed() {
+    SERIAL_PROTOCOLLNPGM(MSG_FILE_PRINTED);
+    card.printingHasFinished();
+    #if ENABLED(PRINTER_EVENT_LEDS)
+      LCD_MESSAGEPGM(MSG_INFO_COMPLETED_PRINTS);
+      set_led_color(0, 255, 0); // Green
+      #if HAS_RESUME_CONTINUE
+        enqueue_and_echo_commands_P(PSTR("M0")); // end of the queue!
+      #else
+        safe_delay(1000);
+      #endif
+      set_led_color(0, 0, 0);   // OFF
+    #endif
+    card.checkautostart(true);
+  }
+
   /**
    * Get commands from the SD Card until the command buffer is full
    * or until the end of the file is reached. The special character '#'
@@ -1259,56 +1353,132 @@ inline void get_serial_commands() {
     if (commands_in_queue == 0) stop_buffering = false;
 
     uint16_t sd_count = 0;
-    bool card_eof = card.eof();
-    while (commands_in_queue < BUFSIZE && !card_eof && !stop_buffering) {
-      const int16_t n = card.get();
-      char sd_char = (char)n;
-      card_eof = card.eof();
-      if (card_eof || n == -1
-          || sd_char == '\n' || sd_char == '\r'
-          || ((sd_char == '#' || sd_char == ':') && !sd_comment_mode)
-      ) {
-        if (card_eof) {
-          SERIAL_PROTOCOLLNPGM(MSG_FILE_PRINTED);
-          card.printingHasFinished();
-          #if ENABLED(PRINTER_EVENT_LEDS)
-            LCD_MESSAGEPGM(MSG_INFO_COMPLETED_PRINTS);
-            set_led_color(0, 255, 0); // Green
-            #if HAS_RESUME_CONTINUE
-              enqueue_and_echo_commands_P(PSTR("M0")); // end of the queue!
-            #else
-              safe_delay(1000);
-            #endif
-            set_led_color(0, 0, 0);   // OFF
-          #endif
-          card.checkautostart(true);
-        }
-        else if (n == -1) {
-          SERIAL_ERROR_START();
-          SERIAL_ECHOLNPGM(MSG_SD_ERR_READ);
+
+    #if ENABLED(SD_READ_AHEAD)
+
+      /**
+       * Work on the read-ahead buffer a run at a time: comments are skipped
+       * to the end of the line, leading and trailing blanks are dropped and
+       * each run of payload is copied into the queue with one memcpy.
+       */
+      #define SD_IS_EOL(C) ((C) == '\n' || (C) == '\r')
+      #define SD_ENDS_PAYLOAD(C) (SD_IS_EOL(C) || (C) == '#' || (C) == ':' || (C) == ';')
+
+      // Stop at the end, or the idle() calls made while sd_file_printed()
+      // waits for the moves to finish would end the print over again
+      while (CMD_QUEUE_HAS_ROOM() && !stop_buffering && !card.eof()) {
+        const char *data;
+        const uint16_t len = card.fetch(data);
+        if (!len) {
+          if (card.eof())
+            sd_file_printed();
+          else {
+            SERIAL_ERROR_START();
+            SERIAL_ECHOLNPGM(MSG_SD_ERR_READ);
+          }
+          sd_comment_mode = false;
+          if (sd_count) {
+            CMD_TEXT_W[sd_count] = '\0';
+            _commit_command(false);
+          }
+          break;
         }
-        if (sd_char == '#') stop_buffering = true;
 
-        sd_comment_mode = false; // for new command
+        const char *p = data, * const end = data + len;
+        while (p < end) {
+          if (sd_comment_mode) {
+            while (p < end && !SD_IS_EOL(*p)) p++;
+            if (p == end) break;
+          }
+          else {
+            if (!sd_count) while (p < end && (*p == ' ' || *p == '\t')) p++;
+            const char * const run = p;
+            while (p < end && !SD_ENDS_PAYLOAD(*p)) p++;
+            if (p > run) {
+              #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+                if (!sd_count) {
+                  command_from_sd[cmd_queue_index_w] = true;
+                  command_sdpos[cmd_queue_index_w] = card.fetchIndex() + (run - data);
+                }
+              #endif
+              // Characters beyond the max length are dropped
+              uint16_t n = p - run;
+              NOMORE(n, MAX_CMD_SIZE - 1 - sd_count);
+              memcpy(&CMD_TEXT_W[sd_count], run, n);
+              sd_count += n;
+            }
+            if (p == end) break;
+            if (*p == ';') {
+              sd_comment_mode = true;
+              p++;
+              continue;
+            }
+          }
 
-        if (!sd_count) continue; // skip empty lines (and comment lines)
+          // End of the line
+          if (*p++ == '#') stop_buffering = true;
+          sd_comment_mode = false;
+          if (!sd_count) continue; // skip empty lines (and comment lines)
 
-        command_queue[cmd_queue_index_w][sd_count] = '\0'; // terminate string
-        sd_count = 0; // clear sd line buffer
+          while (CMD_TEXT_W[sd_count - 1] == ' ') sd_count--;
+          CMD_TEXT_W[sd_count] = '\0'; // terminate string
+          sd_count = 0; // clear sd line buffer
 
-        _commit_command(false);
-      }
-      else if (sd_count >= MAX_CMD_SIZE - 1) {
-        /**
-         * Keep fetching, but ignore normal characters beyond the max length
-         * The command will be injected when EOL is reached
-         */
+          _commit_command(false);
+          if (!CMD_QUEUE_HAS_ROOM() || stop_buffering) break;
+        }
+        card.consume(p - data);
       }
-      else {
-        if (sd_char == ';') sd_comment_mode = true;
-        if (!sd_comment_mode) command_queue[cmd_queue_index_w][sd_count++] = sd_char;
+
+    #else
+
+      bool card_eof = card.eof();
+      while (CMD_QUEUE_HAS_ROOM() && !card_eof && !stop_buffering) {
+        const int16_t n = card.get();
+        char sd_char = (char)n;
+        card_eof = card.eof();
+        if (card_eof || n == -1
+            || sd_char == '\n' || sd_char == '\r'
+            || ((sd_char == '#' || sd_char == ':') && !sd_comment_mode)
+        ) {
+          if (card_eof)
+            sd_file_printed();
+          else if (n == -1) {
+            SERIAL_ERROR_START();
+            SERIAL_ECHOLNPGM(MSG_SD_ERR_READ);
+          }
+          if (sd_char == '#') stop_buffering = true;
+
+          sd_comment_mode = false; // for new command
+
+          if (!sd_count) continue; // skip empty lines (and comment lines)
+
+          CMD_TEXT_W[sd_count] = '\0'; // terminate string
+          sd_count = 0; // clear sd line buffer
+
+          _commit_command(false);
+        }
+        else if (sd_count >= MAX_CMD_SIZE - 1) {
+          /**
+           * Keep fetching, but ignore normal characters beyond the max length
+           * The command will be injected when EOL is reached
+           */
+        }
+        else {
+          if (sd_char == ';') sd_comment_mode = true;
+          if (!sd_comment_mode) {
+            #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+              if (!sd_count) {
+                command_from_sd[cmd_queue_index_w] = true;
+                command_sdpos[cmd_queue_index_w] = card.getIndex();
+              }
+            #endif
+            CMD_TEXT_W[sd_count++] = sd_char;
+          }
+        }
       }
-    }
+
+    #endif // !SD_READ_AHEAD
   }
 
 #endif // SDSUPPORT
@@ -6647,6 +6817,18 @@ inline void gcode_M31() {
     }
   #endif // SDCARD_SORT_ALPHA && SDSORT_GCODE
 
+  #if ENABLED(SD_READ_AHEAD)
+    /**
+     * M39: Report SD read throughput since the file was opened
+     *
+     *   R  Reset the counters after reporting
+     */
+    inline void gcode_M39() {
+      card.reportReadStats();
+      if (parser.seen('R')) card.resetReadStats();
+    }
+  #endif
+
   /**
    * M928: Start SD Write
    */
@@ -6666,6 +6848,53 @@ static bool pin_is_protected(const int8_t pin) {
   return false;
 }
 
+#if ENABLED(STEPPER_ISR_LATENCY)
+
+  /**
+   * M38: Report the longest delay between the stepper timer firing
+   *      and its ISR running, since startup or the last reset
+   *
+   *   R  Reset it after reporting
+   */
+  inline void gcode_M38() {
+    CRITICAL_SECTION_START;
+    const uint16_t ticks = stepper.isr_latency_max;
+    if (parser.seen('R')) stepper.isr_latency_max = 0;
+    CRITICAL_SECTION_END;
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPAIR("Stepper ISR latency max ", ticks * (8000000.0 / (F_CPU))); // Timer1 runs at F_CPU / 8
+    SERIAL_ECHOLNPGM("us");
+  }
+
+#endif
+
+#if ENABLED(SEGMENT_TIME_BUDGET) || ENABLED(SEGMENT_MERGE)
+
+  /**
+   * M40: Report planner buffer statistics
+   *
+   *  With SEGMENT_TIME_BUDGET: how fast blocks are queued, how often the
+   *  buffer ran dry, and how full it was predicted and found to be.
+   *
+   *  With SEGMENT_MERGE: how many segments were merged into the one before.
+   *
+   *   R  Reset the counters after reporting
+   */
+  inline void gcode_M40() {
+    const bool reset = parser.seen('R');
+    #if ENABLED(SEGMENT_TIME_BUDGET)
+      planner.report_segment_budget();
+      if (reset) planner.reset_segment_budget();
+    #endif
+    #if ENABLED(SEGMENT_MERGE)
+      SERIAL_ECHO_START();
+      SERIAL_ECHOLNPAIR("Merged segments ", planner.merged_segments);
+      if (reset) planner.merged_segments = 0;
+    #endif
+  }
+
+#endif
+
 /**
  * M42: Change pin status via GCode
  *
@@ -7654,6 +7883,10 @@ inline void gcode_M109() {
 
   } while (wait_for_heatup && TEMP_CONDITIONS);
 
+  #if ENABLED(SEGMENT_TIME_BUDGET)
+    planner.end_block_stream(); // The buffer may have run dry while heating
+  #endif
+
   if (wait_for_heatup) {
     LCD_MESSAGEPGM(MSG_HEATING_COMPLETE);
     #if ENABLED(PRINTER_EVENT_LEDS)
@@ -7806,6 +8039,10 @@ inline void gcode_M109() {
 
     } while (wait_for_heatup && TEMP_BED_CONDITIONS);
 
+    #if ENABLED(SEGMENT_TIME_BUDGET)
+      planner.end_block_stream(); // The buffer may have run dry while heating
+    #endif
+
     #ifdef ANYCUBIC_TFT_MODEL
     AnycubicTFT.HotbedHeatingDone();
     #endif
@@ -7855,7 +8092,7 @@ inline void gcode_M111() {
     for (uint8_t i = 0; i < COUNT(debug_strings); i++) {
       if (TEST(marlin_debug_flags, i)) {
         if (comma++) SERIAL_CHAR(',');
-        serialprintPGM((char*)pgm_read_word(&debug_strings[i]));
+        serialprintPGM((char*)pgm_read_ptr(&debug_strings[i]));
       }
     }
   }
@@ -8528,6 +8765,10 @@ inline void gcode_M203() {
       const uint8_t a = i + (i == E_AXIS ? TARGET_EXTRUDER : 0);
       planner.max_feedrate_mm_s[a] = parser.value_axis_units((AxisEnum)a);
     }
+
+  #if ENABLED(INPUT_SHAPING)
+    stepper.update_shaping(); // Keep X and Y within the shaper limits
+  #endif
 }
 
 /**
@@ -8967,7 +9208,7 @@ inline void gcode_M226() {
 #if ENABLED(PIDTEMP)
 
   /**
-   * M301: Set PID parameters P I D (and optionally C, L)
+   * M301: Set PID parameters P I D (and optionally C, L, F, A)
    *
    *   P[float] Kp term
    *   I[float] Ki term (unscaled)
@@ -8977,6 +9218,11 @@ inline void gcode_M226() {
    *
    *   C[float] Kc term
    *   L[float] LPQ length
+   *
+   * With PID_EXTRUSION_FEEDFORWARD:
+   *
+   *   F[float] Kf term, PWM steps per mm³/s of flow
+   *   A[int]   Feed-forward lag (ms)
    */
   inline void gcode_M301() {
 
@@ -8993,6 +9239,10 @@ inline void gcode_M226() {
         if (parser.seen('L')) lpq_len = parser.value_float();
         NOMORE(lpq_len, LPQ_MAX_LEN);
       #endif
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        if (parser.seen('F')) PID_PARAM(Kf, e) = parser.value_float();
+        if (parser.seen('A')) thermalManager.feedforward_lag = parser.value_ushort();
+      #endif
 
       thermalManager.updatePID();
       SERIAL_ECHO_START();
@@ -9006,6 +9256,10 @@ inline void gcode_M226() {
         //Kc does not have scaling applied above, or in resetting defaults
         SERIAL_ECHOPAIR(" c:", PID_PARAM(Kc, e));
       #endif
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        SERIAL_ECHOPAIR(" f:", PID_PARAM(Kf, e));
+        SERIAL_ECHOPAIR(" a:", thermalManager.feedforward_lag);
+      #endif
       SERIAL_EOL();
     }
     else {
@@ -9648,6 +9902,50 @@ inline void gcode_M502() {
 
 #endif // ABORT_ON_ENDSTOP_HIT_FEATURE_ENABLED
 
+#if ENABLED(INPUT_SHAPING)
+
+  /**
+   * M593: Set or report input shaping
+   *
+   *  X / Y     Set this axis only (default both)
+   *  F<hz>     Resonant frequency, 20 to 200, or 0 for no shaping
+   *  D<zeta>   Damping ratio, 0 to 0.3
+   *  T<type>   Shaper: 0 = ZV, 1 = ZVD, 2 = MZV
+   *
+   * Also reports the highest speed each shaper can keep up with. The X and
+   * Y max feedrates (M203) are lowered to it.
+   */
+  inline void gcode_M593() {
+    const bool seen_x = parser.seen('X'), seen_y = parser.seen('Y');
+    if (parser.seen('F') || parser.seen('D') || parser.seen('T')) {
+      LOOP_L_N(i, 2) {
+        if ((seen_x || seen_y) && !(i ? seen_y : seen_x)) continue;
+        if (parser.seen('F')) {
+          const float f = parser.value_float();
+          stepper.shaping_frequency[i] = f > 0 ? constrain(f, 20, 200) : 0;
+        }
+        if (parser.seen('D')) stepper.shaping_zeta[i] = constrain(parser.value_float(), 0, 0.3);
+        if (parser.seen('T')) stepper.shaping_type[i] = constrain(parser.value_int(), 0, 2);
+      }
+      stepper.update_shaping();
+    }
+
+    LOOP_L_N(i, 2) {
+      SERIAL_ECHO_START();
+      SERIAL_CHAR(axis_codes[i]);
+      if (stepper.shaping_frequency[i]) {
+        SERIAL_ECHOPAIR(" shaping F", stepper.shaping_frequency[i]);
+        SERIAL_ECHOPAIR(" D", stepper.shaping_zeta[i]);
+        SERIAL_ECHOPAIR(" T", stepper.shaping_type[i]);
+        SERIAL_ECHOLNPAIR(" up to mm/s:", stepper.shaping_max_rate((AxisEnum)i) * planner.steps_to_mm[i]);
+      }
+      else
+        SERIAL_ECHOLNPGM(" shaping off");
+    }
+  }
+
+#endif // INPUT_SHAPING
+
 #if HAS_BED_PROBE
 
   void refresh_zprobe_zoffset(const bool no_babystep/*=false*/) {
@@ -10875,11 +11173,24 @@ inline void gcode_T(uint8_t tmp_extruder) {
  * This is called from the main loop()
  */
 void process_next_command() {
-  char * const current_command = command_queue[cmd_queue_index_r];
+  char * const current_command = CMD_TEXT_R;
+  #if ENABLED(GCODE_PREPARSE)
+    const bool is_packed = !CMD_R_IS_TEXT;
+    gcode_packed_t packed; // Copied out of its cell, which may not be aligned
+    if (is_packed) memcpy(&packed, current_command, sizeof(packed));
+  #endif
 
   if (DEBUGGING(ECHO)) {
     SERIAL_ECHO_START();
-    SERIAL_ECHOLN(current_command);
+    #if ENABLED(GCODE_PREPARSE)
+      if (is_packed) {
+        char packed_text[MAX_CMD_SIZE];
+        parser.packed_to_text(packed, packed_text);
+        SERIAL_ECHOLN(packed_text);
+      }
+      else
+    #endif
+        SERIAL_ECHOLN(current_command);
     #if ENABLED(M100_FREE_MEMORY_WATCHER)
       SERIAL_ECHOPAIR("slot:", cmd_queue_index_r);
       M100_dump_routine("   Command Queue:", (const char*)command_queue, (const char*)(command_queue + sizeof(command_queue)));
@@ -10888,8 +11199,24 @@ void process_next_command() {
 
   KEEPALIVE_STATE(IN_HANDLER);
 
+  #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+    current_command_from_sd = command_from_sd[cmd_queue_index_r];
+    current_command_sdpos = command_sdpos[cmd_queue_index_r];
+    current_command_relative_e = relative_mode || axis_relative_modes[E_AXIS];
+  #endif
+
   // Parse the next command in the queue
-  parser.parse(current_command);
+  #if ENABLED(GCODE_PREPARSE)
+    if (is_packed)
+      parser.load(packed);
+    else
+  #endif
+      parser.parse(current_command);
+
+  #if ENABLED(SEGMENT_MERGE)
+    // Only G0-G3 may join a held segment. Other commands act after it.
+    if (parser.command_letter != 'G' || parser.codenum > 3) planner.flush_merged_segment();
+  #endif
 
   // Handle a known G, M, or T
   switch (parser.command_letter) {
@@ -11107,6 +11434,11 @@ void process_next_command() {
             gcode_M34(); break;
         #endif // SDCARD_SORT_ALPHA && SDSORT_GCODE
 
+        #if ENABLED(SD_READ_AHEAD)
+          case 39: // M39: Report SD read throughput
+            gcode_M39(); break;
+        #endif
+
         case 928: // M928: Start SD write
           gcode_M928(); break;
       #endif // SDSUPPORT
@@ -11114,6 +11446,16 @@ void process_next_command() {
       case 31: // M31: Report time since the start of SD print or last M109
         gcode_M31(); break;
 
+      #if ENABLED(STEPPER_ISR_LATENCY)
+        case 38: // M38: Report stepper ISR latency
+          gcode_M38(); break;
+      #endif
+
+      #if ENABLED(SEGMENT_TIME_BUDGET) || ENABLED(SEGMENT_MERGE)
+        case 40: // M40: Report planner buffer statistics
+          gcode_M40(); break;
+      #endif
+
       case 42: // M42: Change pin state
         gcode_M42(); break;
 
@@ -11553,6 +11895,12 @@ void process_next_command() {
           break;
       #endif
 
+      #if ENABLED(INPUT_SHAPING)
+        case 593: // M593: Set or report input shaping
+          gcode_M593();
+          break;
+      #endif
+
       #if HAS_BED_PROBE
         case 851: // M851: Set Z Probe Z Offset
           gcode_M851();
@@ -11745,15 +12093,20 @@ void ok_to_send() {
   if (!send_ok[cmd_queue_index_r]) return;
   SERIAL_PROTOCOLPGM(MSG_OK);
   #if ENABLED(ADVANCED_OK)
-    char* p = command_queue[cmd_queue_index_r];
-    if (*p == 'N') {
+    char* p = CMD_TEXT_R;
+    if (
+      #if ENABLED(GCODE_PREPARSE)
+        CMD_R_IS_TEXT && // Packed moves have no line number
+      #endif
+      *p == 'N'
+    ) {
       SERIAL_PROTOCOL(' ');
       SERIAL_ECHO(*p++);
       while (NUMERIC_SIGNED(*p))
         SERIAL_ECHO(*p++);
     }
     SERIAL_PROTOCOLPGM(" P"); SERIAL_PROTOCOL(int(BLOCK_BUFFER_SIZE - planner.movesplanned() - 1));
-    SERIAL_PROTOCOLPGM(" B"); SERIAL_PROTOCOL(BUFSIZE - commands_in_queue);
+    SERIAL_PROTOCOLPGM(" B"); SERIAL_PROTOCOL(CMD_QUEUE_SIZE - commands_in_queue);
   #endif
   SERIAL_EOL();
 }
@@ -13129,7 +13482,7 @@ void manage_inactivity(bool ignore_stepper_queue/*=false*/) {
   AnycubicTFT.FilamentRunout();
   #endif
 
-  if (commands_in_queue < BUFSIZE) get_available_commands();
+  if (CMD_QUEUE_HAS_ROOM()) get_available_commands();
 
   const millis_t ms = millis();
 
@@ -13299,6 +13652,10 @@ void idle(
     bool no_stepper_sleep/*=false*/
   #endif
 ) {
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+    stepper.prep_segments();
+  #endif
+
   #if ENABLED(MAX7219_DEBUG)
     Max7219_idle_tasks();
   #endif  // MAX7219_DEBUG
@@ -13323,6 +13680,10 @@ void idle(
 
   thermalManager.manage_heater();
 
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+    stepper.prep_segments(); // Top up after the slowest tasks
+  #endif
+
   #if ENABLED(PRINTCOUNTER)
     print_job_timer.tick();
   #endif
@@ -13482,7 +13843,7 @@ void setup() {
   SERIAL_ECHOLNPAIR(MSG_PLANNER_BUFFER_BYTES, (int)sizeof(block_t)*BLOCK_BUFFER_SIZE);
 
   // Send "ok" after commands by default
-  for (int8_t i = 0; i < BUFSIZE; i++) send_ok[i] = true;
+  for (int8_t i = 0; i < CMD_QUEUE_SIZE; i++) send_ok[i] = true;
 
   // Load data from EEPROM if available (or use defaults)
   // This also updates variables in the planner, elsewhere
@@ -13675,7 +14036,7 @@ void setup() {
  *  - Call LCD update
  */
 void loop() {
-  if (commands_in_queue < BUFSIZE) get_available_commands();
+  if (CMD_QUEUE_HAS_ROOM()) get_available_commands();
 
   #if ENABLED(SDSUPPORT)
     card.checkautostart(false);
@@ -13686,7 +14047,16 @@ void loop() {
     #if ENABLED(SDSUPPORT)
 
       if (card.saving) {
-        char* command = command_queue[cmd_queue_index_r];
+        char* command = CMD_TEXT_R;
+        #if ENABLED(GCODE_PREPARSE)
+          char packed_text[MAX_CMD_SIZE];
+          if (!CMD_R_IS_TEXT) {
+            gcode_packed_t packed;
+            memcpy(&packed, command, sizeof(packed));
+            parser.packed_to_text(packed, packed_text);
+            command = packed_text;
+          }
+        #endif
         if (strstr_P(command, PSTR("M29"))) {
           // M29 closes the file
           card.closefile();
@@ -13723,9 +14093,13 @@ void loop() {
     // The queue may be reset by a command handler or by code invoked by idle() within a handler
     if (commands_in_queue) {
       --commands_in_queue;
-      if (++cmd_queue_index_r >= BUFSIZE) cmd_queue_index_r = 0;
+      if (++cmd_queue_index_r >= CMD_QUEUE_SIZE) cmd_queue_index_r = 0;
     }
   }
+  #if ENABLED(SEGMENT_MERGE)
+    else
+      planner.flush_merged_segment(); // Nothing left to merge with
+  #endif
   endstops.report_state();
   idle();
 
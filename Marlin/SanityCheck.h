@@ -284,6 +284,105 @@ static_assert(X_MAX_LENGTH >= X_BED_SIZE && Y_MAX_LENGTH >= Y_BED_SIZE,
   #endif
 #endif
 
+/**
+ * SD Directory Index
+ */
+#if ENABLED(SDCARD_DIR_INDEX)
+  #if SDCARD_DIR_INDEX_LIMIT > 1024
+    #error "SDCARD_DIR_INDEX_LIMIT must be 1024 or smaller."
+  #elif SDCARD_DIR_INDEX_LIMIT < 10
+    #error "SDCARD_DIR_INDEX_LIMIT should be greater than 9 to be useful."
+  #endif
+#endif
+
+/**
+ * Pre-parsed command queue
+ */
+#if ENABLED(GCODE_PREPARSE)
+  #if DISABLED(FASTER_GCODE_PARSER)
+    #error "GCODE_PREPARSE requires FASTER_GCODE_PARSER."
+  #elif !WITHIN(GCODE_PREPARSE_BUFSIZE, BUFSIZE, (BUFSIZE) * (MAX_CMD_SIZE) / 32 - ((MAX_CMD_SIZE) + 31) / 32 + 1)
+    #error "GCODE_PREPARSE_BUFSIZE must be from BUFSIZE to the moves the queue can hold. See Configuration_adv.h."
+  #endif
+#endif
+
+/**
+ * SD Read Ahead
+ */
+#if ENABLED(SD_READ_AHEAD) && !WITHIN(SD_READ_AHEAD_BLOCKS, 1, 4)
+  #error "SD_READ_AHEAD_BLOCKS must be from 1 to 4."
+#endif
+
+/**
+ * Segment time budget
+ */
+#if ENABLED(SEGMENT_TIME_BUDGET) && ENABLED(SLOWDOWN)
+  #error "SEGMENT_TIME_BUDGET replaces SLOWDOWN. Disable SLOWDOWN."
+#endif
+
+/**
+ * Segment merging
+ */
+#if ENABLED(SEGMENT_MERGE)
+  #if IS_KINEMATIC
+    #error "SEGMENT_MERGE is not compatible with DELTA or SCARA."
+  #endif
+  static_assert(SEGMENT_MERGE_TOLERANCE > 0 && SEGMENT_MERGE_MAX_LENGTH > 0, "SEGMENT_MERGE_TOLERANCE and SEGMENT_MERGE_MAX_LENGTH must be greater than 0.");
+#endif
+
+/**
+ * Uniform step pulses
+ */
+#if ENABLED(UNIFORM_STEP_PULSES) && !WITHIN(DOUBLE_STEP_FREQUENCY, 5000, 20000)
+  #error "DOUBLE_STEP_FREQUENCY must be from 5000 to 20000."
+#endif
+
+/**
+ * Step segment buffer
+ */
+#if ENABLED(STEP_SEGMENT_BUFFER)
+  #if ENABLED(LIN_ADVANCE)
+    #error "STEP_SEGMENT_BUFFER is not compatible with LIN_ADVANCE."
+  #elif STEP_SEGMENT_BUFFER_SIZE != 8 && STEP_SEGMENT_BUFFER_SIZE != 16 && STEP_SEGMENT_BUFFER_SIZE != 32
+    #error "STEP_SEGMENT_BUFFER_SIZE must be 8, 16, or 32."
+  #elif !WITHIN(STEP_SEGMENT_TICKS, 200, 20000)
+    #error "STEP_SEGMENT_TICKS must be from 200 to 20000."
+  #endif
+#endif
+
+/**
+ * Input shaping
+ */
+#if ENABLED(INPUT_SHAPING)
+  #if ENABLED(LIN_ADVANCE)
+    #error "INPUT_SHAPING is not compatible with LIN_ADVANCE."
+  #elif ENABLED(UNIFORM_STEP_PULSES)
+    #error "INPUT_SHAPING is not compatible with UNIFORM_STEP_PULSES."
+  #elif SHAPING_BUFFER_SIZE != 64 && SHAPING_BUFFER_SIZE != 128 && SHAPING_BUFFER_SIZE != 256
+    #error "SHAPING_BUFFER_SIZE must be 64, 128, or 256."
+  #elif !WITHIN(SHAPING_TYPE_X, 0, 2) || !WITHIN(SHAPING_TYPE_Y, 0, 2)
+    #error "SHAPING_TYPE_X and SHAPING_TYPE_Y must be 0 (ZV), 1 (ZVD), or 2 (MZV)."
+  #endif
+  static_assert(SHAPING_FREQ_X == 0 || WITHIN(SHAPING_FREQ_X, 20, 200), "SHAPING_FREQ_X must be 0 or from 20 to 200.");
+  static_assert(SHAPING_FREQ_Y == 0 || WITHIN(SHAPING_FREQ_Y, 20, 200), "SHAPING_FREQ_Y must be 0 or from 20 to 200.");
+  static_assert(WITHIN(SHAPING_ZETA_X, 0, 0.3) && WITHIN(SHAPING_ZETA_Y, 0, 0.3), "SHAPING_ZETA_X and SHAPING_ZETA_Y must be from 0 to 0.3.");
+#endif
+
+/**
+ * Anycubic TFT power outage journal
+ */
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  #if DISABLED(ANYCUBIC_TFT_MODEL)
+    #error "ANYCUBIC_OUTAGE_JOURNAL requires ANYCUBIC_TFT_MODEL."
+  #elif DISABLED(SDSUPPORT)
+    #error "ANYCUBIC_OUTAGE_JOURNAL requires SDSUPPORT."
+  #elif IS_KINEMATIC || CORE_IS_XY || CORE_IS_XZ || CORE_IS_YZ
+    #error "ANYCUBIC_OUTAGE_JOURNAL only supports plain Cartesian machines."
+  #elif ENABLED(AUTO_BED_LEVELING_UBL)
+    #error "ANYCUBIC_OUTAGE_JOURNAL uses the top 1K of the EEPROM, where UBL keeps its meshes."
+  #endif
+#endif
+
 /**
  * I2C Position Encoders
  */
@@ -490,6 +589,21 @@ static_assert(X_MAX_LENGTH >= X_BED_SIZE && Y_MAX_LENGTH >= Y_BED_SIZE,
   #error "To use BED_LIMIT_SWITCHING you must disable PIDTEMPBED."
 #endif
 
+#if ENABLED(PID_EXTRUSION_FEEDFORWARD) && DISABLED(PIDTEMP)
+  #error "PID_EXTRUSION_FEEDFORWARD requires PIDTEMP."
+#endif
+
+/**
+ * Sigma-delta soft PWM
+ */
+#if ENABLED(SOFT_PWM_SIGMA_DELTA)
+  #if ENABLED(SLOW_PWM_HEATERS)
+    #error "SOFT_PWM_SIGMA_DELTA is not compatible with SLOW_PWM_HEATERS."
+  #elif ENABLED(SOFT_PWM_DITHER)
+    #error "SOFT_PWM_SIGMA_DELTA replaces SOFT_PWM_DITHER. Please disable one of them."
+  #endif
+#endif
+
 /**
  * Kinematics
  */
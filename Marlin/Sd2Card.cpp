@@ -423,6 +423,28 @@ bool Sd2Card::readBlock(uint32_t blockNumber, uint8_t* dst) {
   return false;
 }
 //------------------------------------------------------------------------------
+/**
+ * Read consecutive 512 byte blocks with a single multiple block read.
+ * If the sequence fails the blocks are read one by one instead.
+ *
+ * \param[in] blockNumber Logical block of the first block.
+ * \param[out] dst Pointer to the location that will receive the data.
+ * \param[in] count Number of blocks to read.
+ * \return The value one, true, is returned for success and
+ * the value zero, false, is returned for failure.
+ */
+bool Sd2Card::readBlocks(uint32_t blockNumber, uint8_t* dst, uint8_t count) {
+  if (readStart(blockNumber)) {
+    uint8_t i = 0;
+    while (i < count && readData(dst + 512U * i)) i++;
+    if (readStop() && i == count) return true;
+  }
+  errorCode_ = 0;
+  for (uint8_t i = 0; i < count; i++)
+    if (!readBlock(blockNumber + i, dst + 512U * i)) return false;
+  return true;
+}
+//------------------------------------------------------------------------------
 /** Read one data block in a multiple block read sequence
  *
  * \param[in] dst Pointer to the location for the data to be read.
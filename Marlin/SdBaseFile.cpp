@@ -1089,6 +1089,19 @@ int16_t SdBaseFile::read(void* buf, uint16_t nbyte) {
 
     // no buffering needed if n == 512
     if (n == 512 && block != vol_->cacheBlockNumber()) {
+      #if ENABLED(SD_READ_AHEAD)
+        // Whole blocks left in this cluster are read in one sequence
+        uint8_t count = 1;
+        if (type_ != FAT_FILE_TYPE_ROOT_FIXED) {
+          const uint8_t left = vol_->blocksPerCluster() - vol_->blockOfCluster(curPosition_);
+          while (count < left && toRead >= 512U * (count + 1) && block + count != vol_->cacheBlockNumber()) count++;
+        }
+        if (count > 1) {
+          if (!vol_->readBlocks(block, dst, count)) goto FAIL;
+          n = 512U * count;
+        }
+        else
+      #endif
       if (!vol_->readBlock(block, dst)) goto FAIL;
     }
     else {
@@ -201,6 +201,9 @@ class SdVolume {
   bool readBlock(uint32_t block, uint8_t* dst) {
     return sdCard_->readBlock(block, dst);
   }
+  bool readBlocks(uint32_t block, uint8_t* dst, uint8_t count) {
+    return sdCard_->readBlocks(block, dst, count);
+  }
   bool writeBlock(uint32_t block, const uint8_t* dst) {
     return sdCard_->writeBlock(block, dst);
   }
@@ -41,9 +41,18 @@ CardReader::CardReader() {
       //sort_reverse = false;
     #endif
   #endif
+  #if ENABLED(SDCARD_DIR_INDEX)
+    dir_index_valid = false;
+    dir_index_count = 0;
+  #endif
   sdprinting = cardOK = saving = logging = false;
   filesize = 0;
   sdpos = 0;
+  #if ENABLED(SD_READ_AHEAD)
+    read_ahead_pos = 0;
+    flush_read_ahead();
+    resetReadStats();
+  #endif
   workDirDepth = 0;
   file_subcall_ctr = 0;
   ZERO(workDirParents);
@@ -75,16 +84,17 @@ char *createFilename(char *buffer, const dir_t &p) { //buffer > 12characters
  *   LS_Count       - Add +1 to nrFiles for every file within the parent
  *   LS_GetFilename - Get the filename of the file indexed by nrFiles
  *   LS_SerialPrint - Print the full path and size of each file to serial output
+ *   LS_Index       - Like LS_Count, also storing the position of each entry in dir_index
  */
 void CardReader::lsDive(const char *prepend, SdFile parent, const char * const match/*=NULL*/) {
   dir_t p;
   uint8_t cnt = 0;
 
-  // Read the next entry from a directory
-  while (parent.readDir(p, longFilename) > 0) {
+  // Read the next entry from a directory, noting where it begins
+  for (uint32_t entry_pos = parent.curPosition(); parent.readDir(p, longFilename) > 0; entry_pos = parent.curPosition()) {
 
     // If the entry is a directory and the action is LS_SerialPrint
-    if (DIR_IS_SUBDIR(&p) && lsAction != LS_Count && lsAction != LS_GetFilename) {
+    if (DIR_IS_SUBDIR(&p) && lsAction == LS_SerialPrint) {
 
       // Get the short name for the item, which we know is a folder
       char lfilename[FILENAME_LENGTH];
@@ -134,6 +144,13 @@ void CardReader::lsDive(const char *prepend, SdFile parent, const char * const m
           nrFiles++;
           break;
 
+        case LS_Index:
+          #if ENABLED(SDCARD_DIR_INDEX)
+            if (nrFiles < SDCARD_DIR_INDEX_LIMIT) dir_index[nrFiles] = entry_pos >> 5;
+          #endif
+          nrFiles++;
+          break;
+
         case LS_SerialPrint:
           createFilename(filename, p);
           SERIAL_PROTOCOL(prepend);
@@ -227,6 +244,9 @@ void CardReader::ls() {
 
 void CardReader::initsd() {
   cardOK = false;
+  #if ENABLED(SDCARD_DIR_INDEX)
+    flush_dir_index();
+  #endif
   if (root.isOpen()) root.close();
 
   #ifndef SPI_SPEED
@@ -273,6 +293,9 @@ void CardReader::setroot() {
   }*/
   workDir = root;
   curDir = &workDir;
+  #if ENABLED(SDCARD_DIR_INDEX)
+    flush_dir_index();
+  #endif
   #if ENABLED(SDCARD_SORT_ALPHA)
     presort();
   #endif
@@ -294,6 +317,9 @@ void CardReader::openAndPrintFile(const char *name) {
 void CardReader::startFileprint() {
   if (cardOK) {
     sdprinting = true;
+    #if ENABLED(SEGMENT_TIME_BUDGET)
+      planner.end_block_stream(); // Don't count the pause as starvation
+    #endif
     #if ENABLED(SDCARD_SORT_ALPHA)
       flush_presort();
     #endif
@@ -413,6 +439,10 @@ void CardReader::openFile(char* name, bool read, bool push_current/*=false*/) {
       SERIAL_PROTOCOLPAIR(MSG_SD_FILE_OPENED, fname);
       SERIAL_PROTOCOLLNPAIR(MSG_SD_SIZE, filesize);
       sdpos = 0;
+      #if ENABLED(SD_READ_AHEAD)
+        flush_read_ahead();
+        resetReadStats();
+      #endif
 
       SERIAL_PROTOCOLLNPGM(MSG_SD_FILE_SELECTED);
       getfilename(0, fname);
@@ -432,6 +462,9 @@ void CardReader::openFile(char* name, bool read, bool push_current/*=false*/) {
     }
     else {
       saving = true;
+      #if ENABLED(SDCARD_DIR_INDEX)
+        flush_dir_index();
+      #endif
       SERIAL_PROTOCOLLNPAIR(MSG_SD_WRITE_TO_FILE, name);
       lcd_setstatus(fname);
     }
@@ -488,6 +521,9 @@ void CardReader::removeFile(char* name) {
     SERIAL_PROTOCOLPGM("File deleted:");
     SERIAL_PROTOCOLLN(fname);
     sdpos = 0;
+    #if ENABLED(SDCARD_DIR_INDEX)
+      flush_dir_index();
+    #endif
     #if ENABLED(SDCARD_SORT_ALPHA)
       presort();
     #endif
@@ -511,6 +547,37 @@ void CardReader::getStatus() {
   }
 }
 
+#if ENABLED(SD_READ_AHEAD)
+
+  /**
+   * Refill the read-ahead buffer from the current file position.
+   * The first read after a seek stops at a block boundary, so later
+   * reads are whole blocks that go straight from the card to the buffer.
+   */
+  bool CardReader::fill_read_ahead() {
+    read_ahead_pos = file.curPosition();
+    read_ahead_index = read_ahead_count = 0;
+    const uint32_t us = micros();
+    const int16_t n = file.read(read_ahead, sizeof(read_ahead) - (read_ahead_pos & 0x1FF));
+    if (n <= 0) return false;
+    read_stat_us += micros() - us;
+    read_stat_bytes += n;
+    read_stat_fills++;
+    read_ahead_count = n;
+    return true;
+  }
+
+  void CardReader::reportReadStats() {
+    SERIAL_ECHOPAIR("SD read ", read_stat_bytes);
+    SERIAL_ECHOPAIR(" bytes in ", read_stat_fills);
+    SERIAL_ECHOPAIR(" reads, ", read_stat_us / 1000UL);
+    SERIAL_ECHOPGM(" ms");
+    if (read_stat_us) SERIAL_ECHOPAIR(", ", (uint32_t)(read_stat_bytes * 1000000.0 / read_stat_us));
+    SERIAL_ECHOLNPGM(" bytes/s");
+  }
+
+#endif // SD_READ_AHEAD
+
 void CardReader::write_command(char *buf) {
   char* begin = buf;
   char* npos = 0;
@@ -594,6 +661,18 @@ void CardReader::getfilename(uint16_t nr, const char * const match/*=NULL*/) {
     }
   #endif // SDSORT_CACHE_NAMES
   curDir = &workDir;
+  #if ENABLED(SDCARD_DIR_INDEX)
+    // Seek straight to an indexed entry and read it (with its long name)
+    if (match == NULL && dir_index_valid && nr < dir_index_count && nr < SDCARD_DIR_INDEX_LIMIT) {
+      dir_t p;
+      if (curDir->seekSet((uint32_t)dir_index[nr] << 5) && curDir->readDir(p, longFilename) > 0) {
+        createFilename(filename, p);
+        filenameIsDir = DIR_IS_SUBDIR(&p);
+        return;
+      }
+      flush_dir_index(); // Directory changed under us. Fall back to a full scan.
+    }
+  #endif
   lsAction = LS_GetFilename;
   nrFiles = nr;
   curDir->rewind();
@@ -602,11 +681,20 @@ void CardReader::getfilename(uint16_t nr, const char * const match/*=NULL*/) {
 
 uint16_t CardReader::getnrfilenames() {
   curDir = &workDir;
-  lsAction = LS_Count;
+  #if ENABLED(SDCARD_DIR_INDEX)
+    if (dir_index_valid) return dir_index_count;
+    lsAction = LS_Index;
+  #else
+    lsAction = LS_Count;
+  #endif
   nrFiles = 0;
   curDir->rewind();
   lsDive("", *curDir);
   //SERIAL_ECHOLN(nrFiles);
+  #if ENABLED(SDCARD_DIR_INDEX)
+    dir_index_count = nrFiles;
+    dir_index_valid = true;
+  #endif
   return nrFiles;
 }
 
@@ -625,6 +713,9 @@ void CardReader::chdir(const char * relpath) {
     if (workDirDepth < MAX_DIR_DEPTH)
       workDirParents[workDirDepth++] = *parent;
     workDir = newfile;
+    #if ENABLED(SDCARD_DIR_INDEX)
+      flush_dir_index();
+    #endif
     #if ENABLED(SDCARD_SORT_ALPHA)
       presort();
     #endif
@@ -634,6 +725,9 @@ void CardReader::chdir(const char * relpath) {
 void CardReader::updir() {
   if (workDirDepth > 0) {
     workDir = workDirParents[--workDirDepth];
+    #if ENABLED(SDCARD_DIR_INDEX)
+      flush_dir_index();
+    #endif
     #if ENABLED(SDCARD_SORT_ALPHA)
       presort();
     #endif
@@ -69,6 +69,10 @@ public:
   void updir();
   void setroot();
 
+  #if ENABLED(SDCARD_DIR_INDEX)
+    FORCE_INLINE void flush_dir_index() { dir_index_valid = false; }
+  #endif
+
   #if ENABLED(SDCARD_SORT_ALPHA)
     void presort();
     void getfilename_sorted(const uint16_t nr);
@@ -82,8 +86,38 @@ public:
   FORCE_INLINE void pauseSDPrint() { sdprinting = false; }
   FORCE_INLINE bool isFileOpen() { return file.isOpen(); }
   FORCE_INLINE bool eof() { return sdpos >= filesize; }
-  FORCE_INLINE int16_t get() { sdpos = file.curPosition(); return (int16_t)file.read(); }
-  FORCE_INLINE void setIndex(long index) { sdpos = index; file.seekSet(index); }
+  #if ENABLED(SD_READ_AHEAD)
+    FORCE_INLINE int16_t get() {
+      if (read_ahead_index >= read_ahead_count && !fill_read_ahead()) {
+        sdpos = read_ahead_pos;
+        return -1;
+      }
+      sdpos = read_ahead_pos + read_ahead_index;
+      return read_ahead[read_ahead_index++];
+    }
+    FORCE_INLINE void setIndex(long index) { sdpos = index; flush_read_ahead(); file.seekSet(index); }
+    FORCE_INLINE void flush_read_ahead() { read_ahead_index = read_ahead_count = 0; }
+
+    // Bulk reading: point at the unread bytes (refilling if none) and return
+    // how many there are, then consume() what was used. sdpos is kept as get()
+    // would leave it, on the last byte consumed.
+    FORCE_INLINE uint16_t fetch(const char* &data) {
+      if (read_ahead_index >= read_ahead_count && !fill_read_ahead()) {
+        sdpos = read_ahead_pos;
+        return 0;
+      }
+      data = (const char*)&read_ahead[read_ahead_index];
+      return read_ahead_count - read_ahead_index;
+    }
+    FORCE_INLINE uint32_t fetchIndex() { return read_ahead_pos + read_ahead_index; }
+    FORCE_INLINE void consume(const uint16_t n) { read_ahead_index += n; sdpos = read_ahead_pos + read_ahead_index - 1; }
+    void reportReadStats();
+    FORCE_INLINE void resetReadStats() { read_stat_bytes = read_stat_us = 0; read_stat_fills = 0; }
+  #else
+    FORCE_INLINE int16_t get() { sdpos = file.curPosition(); return (int16_t)file.read(); }
+    FORCE_INLINE void setIndex(long index) { sdpos = index; file.seekSet(index); }
+  #endif
+  FORCE_INLINE uint32_t getIndex() { return sdpos; }
   FORCE_INLINE uint8_t percentDone() { return (isFileOpen() && filesize) ? sdpos / ((filesize + 99) / 100) : 0; }
   FORCE_INLINE char* getWorkDirName() { workDir.getFilename(filename); return filename; }
 
@@ -139,10 +173,27 @@ private:
 
   #endif // SDCARD_SORT_ALPHA
 
+  // Position of each entry in the working directory, in 32-byte dir_t units
+  #if ENABLED(SDCARD_DIR_INDEX)
+    bool dir_index_valid;
+    uint16_t dir_index_count;   // Count of all files in the directory (may exceed the limit)
+    uint16_t dir_index[SDCARD_DIR_INDEX_LIMIT];
+  #endif
+
   Sd2Card card;
   SdVolume volume;
   SdFile file;
 
+  // Blocks of the open file read ahead of get()
+  #if ENABLED(SD_READ_AHEAD)
+    uint8_t read_ahead[SD_READ_AHEAD_BLOCKS * 512];
+    uint16_t read_ahead_index, read_ahead_count;  // Next byte to hand out, bytes in the buffer
+    uint32_t read_ahead_pos;                      // File position of read_ahead[0]
+    uint32_t read_stat_bytes, read_stat_us;       // Bytes read and time spent reading since the last reset
+    uint16_t read_stat_fills;
+    bool fill_read_ahead();
+  #endif
+
   #define SD_PROCEDURE_DEPTH 1
   #define MAXPATHNAMELENGTH (FILENAME_LENGTH*MAX_DIR_DEPTH + MAX_DIR_DEPTH + 1)
   uint8_t file_subcall_ctr;
@@ -36,7 +36,7 @@
  *
  */
 
-#define EEPROM_VERSION "V41"
+#define EEPROM_VERSION "V43"
 
 // Change EEPROM version if these are changed:
 #define EEPROM_OFFSET 100
@@ -162,8 +162,17 @@
  *  596  M907 Z    Stepper Z current                (uint32_t)
  *  600  M907 E    Stepper E current                (uint32_t)
  *
- *  604                                Minimum end-point
- * 1925 (604 + 36 + 9 + 288 + 988)     Maximum end-point
+ * INPUT_SHAPING:                                   18 bytes
+ *  604  M593 XY F stepper.shaping_frequency        (float x2)
+ *  612  M593 XY D stepper.shaping_zeta             (float x2)
+ *  620  M593 XY T stepper.shaping_type             (uint8_t x2)
+ *
+ * PID_EXTRUSION_FEEDFORWARD:                       22 bytes
+ *  622  M301 E0-4 F  Kf[0-4]                       (float x5)
+ *  642  M301 A    thermalManager.feedforward_lag   (uint16_t)
+ *
+ *  644                                Minimum end-point
+ * 1965 (644 + 36 + 9 + 288 + 988)     Maximum end-point
  *
  * ========================================================================
  * meshes_begin (between max and min end-point, directly above)
@@ -249,6 +258,10 @@ void MarlinSettings::postprocess() {
   #if HAS_MOTOR_CURRENT_PWM
     stepper.refresh_motor_power();
   #endif
+
+  #if ENABLED(INPUT_SHAPING)
+    stepper.update_shaping();
+  #endif
 }
 
 #if ENABLED(EEPROM_SETTINGS)
@@ -644,6 +657,40 @@ void MarlinSettings::postprocess() {
       for (uint8_t q = 3; q--;) EEPROM_WRITE(dummyui32);
     #endif
 
+    //
+    // Input Shaping
+    //
+
+    #if ENABLED(INPUT_SHAPING)
+      EEPROM_WRITE(stepper.shaping_frequency);
+      EEPROM_WRITE(stepper.shaping_zeta);
+      EEPROM_WRITE(stepper.shaping_type);
+    #else
+      dummy = 0.0f;
+      for (uint8_t q = 4; q--;) EEPROM_WRITE(dummy);
+      const uint8_t shaping_type[2] = { 0 };
+      EEPROM_WRITE(shaping_type);
+    #endif
+
+    //
+    // Extrusion Feed-Forward
+    //
+
+    for (uint8_t e = 0; e < MAX_EXTRUDERS; e++) {
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        dummy = e < HOTENDS ? PID_PARAM(Kf, e) : 0.0f;
+      #else
+        dummy = 0.0f;
+      #endif
+      EEPROM_WRITE(dummy);
+    }
+    #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+      EEPROM_WRITE(thermalManager.feedforward_lag);
+    #else
+      const uint16_t feedforward_lag = 0;
+      EEPROM_WRITE(feedforward_lag);
+    #endif
+
     if (!eeprom_error) {
       const int eeprom_size = eeprom_index;
 
@@ -1004,6 +1051,37 @@ void MarlinSettings::postprocess() {
         for (uint8_t q = 3; q--;) EEPROM_READ(dummyui32);
       #endif
 
+      //
+      // Input Shaping
+      //
+
+      #if ENABLED(INPUT_SHAPING)
+        EEPROM_READ(stepper.shaping_frequency);
+        EEPROM_READ(stepper.shaping_zeta);
+        EEPROM_READ(stepper.shaping_type);
+      #else
+        for (uint8_t q = 4; q--;) EEPROM_READ(dummy);
+        uint8_t shaping_type[2];
+        EEPROM_READ(shaping_type);
+      #endif
+
+      //
+      // Extrusion Feed-Forward
+      //
+
+      for (uint8_t e = 0; e < MAX_EXTRUDERS; e++) {
+        EEPROM_READ(dummy);
+        #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+          if (e < HOTENDS) PID_PARAM(Kf, e) = dummy;
+        #endif
+      }
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        EEPROM_READ(thermalManager.feedforward_lag);
+      #else
+        uint16_t feedforward_lag;
+        EEPROM_READ(feedforward_lag);
+      #endif
+
       if (working_crc == stored_crc) {
         postprocess();
         #if ENABLED(EEPROM_CHITCHAT)
@@ -1272,10 +1350,16 @@ void MarlinSettings::reset() {
       #if ENABLED(PID_EXTRUSION_SCALING)
         PID_PARAM(Kc, e) = DEFAULT_Kc;
       #endif
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        PID_PARAM(Kf, e) = DEFAULT_Kf;
+      #endif
     }
     #if ENABLED(PID_EXTRUSION_SCALING)
       lpq_len = 20; // default last-position-queue size
     #endif
+    #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+      thermalManager.feedforward_lag = DEFAULT_Kf_LAG;
+    #endif
   #endif // PIDTEMP
 
   #if ENABLED(PIDTEMPBED)
@@ -1358,6 +1442,15 @@ void MarlinSettings::reset() {
       stepper.digipot_current(q, (stepper.motor_current_setting[q] = tmp_motor_current_setting[q]));
   #endif
 
+  #if ENABLED(INPUT_SHAPING)
+    stepper.shaping_frequency[X_AXIS] = SHAPING_FREQ_X;
+    stepper.shaping_frequency[Y_AXIS] = SHAPING_FREQ_Y;
+    stepper.shaping_zeta[X_AXIS] = SHAPING_ZETA_X;
+    stepper.shaping_zeta[Y_AXIS] = SHAPING_ZETA_Y;
+    stepper.shaping_type[X_AXIS] = SHAPING_TYPE_X;
+    stepper.shaping_type[Y_AXIS] = SHAPING_TYPE_Y;
+  #endif
+
   #if ENABLED(AUTO_BED_LEVELING_UBL)
     ubl.reset();
   #endif
@@ -1700,6 +1793,10 @@ void MarlinSettings::reset() {
                 SERIAL_ECHOPAIR(" C", PID_PARAM(Kc, e));
                 if (e == 0) SERIAL_ECHOPAIR(" L", lpq_len);
               #endif
+              #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+                SERIAL_ECHOPAIR(" F", PID_PARAM(Kf, e));
+                if (e == 0) SERIAL_ECHOPAIR(" A", thermalManager.feedforward_lag);
+              #endif
               SERIAL_EOL();
             }
           }
@@ -1715,6 +1812,10 @@ void MarlinSettings::reset() {
             SERIAL_ECHOPAIR(" C", PID_PARAM(Kc, 0));
             SERIAL_ECHOPAIR(" L", lpq_len);
           #endif
+          #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+            SERIAL_ECHOPAIR(" F", PID_PARAM(Kf, 0));
+            SERIAL_ECHOPAIR(" A", thermalManager.feedforward_lag);
+          #endif
           SERIAL_EOL();
         }
       #endif // PIDTEMP
@@ -1847,6 +1948,24 @@ void MarlinSettings::reset() {
       SERIAL_ECHOPAIR(" E", stepper.motor_current_setting[2]);
       SERIAL_EOL();
     #endif
+
+    /**
+     * Input Shaping
+     */
+    #if ENABLED(INPUT_SHAPING)
+      if (!forReplay) {
+        CONFIG_ECHO_START;
+        SERIAL_ECHOLNPGM("Input Shaping:");
+      }
+      CONFIG_ECHO_START;
+      SERIAL_ECHOPAIR("  M593 X F", stepper.shaping_frequency[X_AXIS]);
+      SERIAL_ECHOPAIR(" D", stepper.shaping_zeta[X_AXIS]);
+      SERIAL_ECHOLNPAIR(" T", stepper.shaping_type[X_AXIS]);
+      CONFIG_ECHO_START;
+      SERIAL_ECHOPAIR("  M593 Y F", stepper.shaping_frequency[Y_AXIS]);
+      SERIAL_ECHOPAIR(" D", stepper.shaping_zeta[Y_AXIS]);
+      SERIAL_ECHOLNPAIR(" T", stepper.shaping_type[Y_AXIS]);
+    #endif
   }
 
 #endif // !DISABLE_M503
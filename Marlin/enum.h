@@ -154,7 +154,7 @@ enum EndstopEnum {
 /**
  * SD Card
  */
-enum LsAction { LS_SerialPrint, LS_Count, LS_GetFilename };
+enum LsAction { LS_SerialPrint, LS_Count, LS_GetFilename, LS_Index };
 
 /**
  * Ultra LCD
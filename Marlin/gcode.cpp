@@ -57,6 +57,12 @@ int GCodeParser::codenum;
   char *GCodeParser::command_args; // start of parameters
 #endif
 
+#if ENABLED(GCODE_PREPARSE)
+  const float *GCodeParser::packed_values,
+              *GCodeParser::packed_value;
+  static char packed_command[GCODE_PACKED_VALUES + 2]; // "G1" for echo, with room for value_ptr
+#endif
+
 // Create a global instance of the GCode parser singleton
 GCodeParser parser;
 
@@ -77,6 +83,60 @@ void GCodeParser::reset() {
     ZERO(codebits);                     // No codes yet
     //ZERO(param);                      // No parameters (should be safe to comment out this line)
   #endif
+  #if ENABLED(GCODE_PREPARSE)
+    packed_values = NULL;               // Parsing text
+  #endif
+}
+
+/**
+ * Parse a decimal number as strtod() would, without the exponent.
+ *
+ * Up to 7 significant digits are gathered exactly in an integer below 2^24,
+ * so a single division by an exact power of ten gives the correctly rounded
+ * float. That covers slicer output ("-123.456", "0.02174") in a fraction of
+ * the time of strtod(). Longer numbers fall back to strtod(), with 'E' cut
+ * off to prevent scientific notation interpretation.
+ */
+float GCodeParser::parse_float(char * const p) {
+  static const float pow10[] PROGMEM = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10 };
+
+  const char *s = p;
+  const bool negative = (*s == '-');
+  if (negative || *s == '+') ++s;
+
+  uint32_t mantissa = 0;
+  int8_t decimals = -1;                 // No decimal point yet
+  for (;; ++s) {
+    const char c = *s;
+    if (NUMERIC(c)) {
+      mantissa = mantissa * 10 + (c - '0');
+      if (mantissa >= 0x1000000UL) break; // Too many digits for an exact float
+      if (decimals >= 0) ++decimals;
+    }
+    else if (c == '.' && decimals < 0)
+      decimals = 0;
+    else {
+      if (decimals >= (int8_t)COUNT(pow10)) break;
+      float f = mantissa;
+      if (decimals > 0) f /= pgm_read_float(&pow10[decimals]);
+      return negative ? -f : f;
+    }
+  }
+
+  // The slow way
+  char *e = p;
+  for (;;) {
+    const char c = *e;
+    if (c == '\0' || c == ' ') break;
+    if (c == 'E' || c == 'e') {
+      *e = '\0';
+      const float ret = strtod(p, NULL);
+      *e = c;
+      return ret;
+    }
+    ++e;
+  }
+  return strtod(p, NULL);
 }
 
 // Populate all fields by parsing a single line of GCode
@@ -228,6 +288,82 @@ void GCodeParser::parse(char *p) {
   }
 }
 
+#if ENABLED(GCODE_PREPARSE)
+
+  /**
+   * Parse a G0-G3 move into its packed form, giving the values that
+   * value_float() would give for the text. Anything else stays text:
+   * other commands, line numbers (with ADVANCED_OK), parameters that
+   * aren't A-Z with a number, repeated letters, or too many values.
+   */
+  bool GCodeParser::pack(const char *p, gcode_packed_t &packed) {
+    while (*p == ' ') ++p;
+    if (*p == 'N' && NUMERIC_SIGNED(p[1])) {
+      #if ENABLED(ADVANCED_OK)
+        return false;                           // "ok" reports the line number from the text
+      #endif
+      p += 2;
+      while (NUMERIC(*p)) ++p;
+      while (*p == ' ') ++p;
+    }
+
+    if (p[0] != 'G' || !WITHIN(p[1], '0', '3') || DECIMAL(p[2])) return false;
+    packed.codenum = p[1] - '0';
+    packed.count = 0;
+    p += 2;
+
+    for (;;) {
+      while (*p == ' ') ++p;
+      const char code = *p++;
+      if (code == '\0' || code == '*') return true;
+      if (!WITHIN(code, 'A', 'Z') || packed.count >= GCODE_PACKED_VALUES) return false;
+      for (uint8_t i = 0; i < packed.count; i++) if (packed.letter[i] == code) return false;
+
+      while (*p == ' ') ++p;
+      char num[16];
+      uint8_t n = 0;
+      while (DECIMAL_SIGNED(*p)) {
+        if (n >= sizeof(num) - 1) return false;
+        num[n++] = *p++;
+      }
+      if (!n) return false;
+      num[n] = '\0';
+
+      packed.letter[packed.count] = code;
+      packed.value[packed.count++] = parse_float(num);
+    }
+  }
+
+  void GCodeParser::load(const gcode_packed_t &packed) {
+    reset();
+    packed_command[0] = command_letter = 'G';
+    packed_command[1] = '0' + (codenum = packed.codenum);
+    packed_command[2] = '\0';
+    command_ptr = packed_command;
+    for (uint8_t i = 0; i < packed.count; i++) {
+      const uint8_t ind = LETTER_OFF(packed.letter[i]);
+      SBI(codebits[PARAM_IND(ind)], PARAM_BIT(ind));
+      param[ind] = i + 1;                       // Value index + 1, so value_ptr is never NULL
+    }
+    packed_values = packed.value;
+  }
+
+  void GCodeParser::packed_to_text(const gcode_packed_t &packed, char *buf) {
+    *buf++ = 'G';
+    *buf++ = '0' + packed.codenum;
+    for (uint8_t i = 0; i < packed.count; i++) {
+      *buf++ = ' ';
+      *buf++ = packed.letter[i];
+      dtostrf(packed.value[i], 1, 5, buf);
+      buf += strlen(buf);
+      while (buf[-1] == '0') --buf;             // Drop trailing zeros
+      if (buf[-1] == '.') --buf;
+    }
+    *buf = '\0';
+  }
+
+#endif // GCODE_PREPARSE
+
 void GCodeParser::unknown_command_error() {
   SERIAL_ECHO_START();
   SERIAL_ECHOPAIR(MSG_UNKNOWN_COMMAND, command_ptr);
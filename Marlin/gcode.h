@@ -48,6 +48,22 @@
   extern bool volumetric_enabled;
 #endif
 
+#if ENABLED(GCODE_PREPARSE)
+
+  #define GCODE_PACKED_VALUES 6
+
+  /**
+   * A G0-G3 move, parsed once as it is queued
+   */
+  typedef struct {
+    uint8_t codenum,                        // 0-3
+            count;                          // Number of parameters
+    char letter[GCODE_PACKED_VALUES];       // Parameter letters, in command order
+    float value[GCODE_PACKED_VALUES];       // ...and their values
+  } gcode_packed_t;
+
+#endif
+
 /**
  * GCode parser
  *
@@ -55,6 +71,9 @@
  *  - FASTER_GCODE_PARSER:
  *    - Flags existing params (1 bit each)
  *    - Stores value offsets (1 byte each)
+ *  - GCODE_PREPARSE:
+ *    - Packs G0-G3 moves into values once, when queued
+ *    - Loads packed moves for the same accessors
  *  - Provide accessors for parameters:
  *    - Parameter exists
  *    - Parameter has value
@@ -72,6 +91,11 @@ private:
     static char *command_args;      // Args start here, for slow scan
   #endif
 
+  #if ENABLED(GCODE_PREPARSE)
+    static const float *packed_values,  // Values of a loaded packed command, NULL for text
+                       *packed_value;   // Set by seen, used to fetch the value
+  #endif
+
 public:
 
   // Global states for GCode-level units features
@@ -135,7 +159,12 @@ public:
       const uint8_t ind = LETTER_OFF(c);
       if (ind >= COUNT(param)) return false; // Only A-Z
       const bool b = TEST(codebits[PARAM_IND(ind)], PARAM_BIT(ind));
-      if (b) value_ptr = param[ind] ? command_ptr + param[ind] : (char*)NULL;
+      if (b) {
+        #if ENABLED(GCODE_PREPARSE)
+          if (packed_values) packed_value = &packed_values[param[ind] - 1];
+        #endif
+        value_ptr = param[ind] ? command_ptr + param[ind] : (char*)NULL;
+      }
       return b;
     }
 
@@ -169,35 +198,45 @@ public:
   // This uses 54 bytes of SRAM to speed up seen/value
   static void parse(char * p);
 
+  #if ENABLED(GCODE_PREPARSE)
+    // Parse a G0-G3 move without touching the parser state. False if it must stay text.
+    static bool pack(const char *p, gcode_packed_t &packed);
+    // Populate all fields from a packed move, which must outlive the command
+    static void load(const gcode_packed_t &packed);
+    // Write a packed move back out as GCode
+    static void packed_to_text(const gcode_packed_t &packed, char *buf);
+  #endif
+
   // The code value pointer was set
   FORCE_INLINE static bool has_value() { return value_ptr != NULL; }
 
   // Seen a parameter with a value
   inline static bool seenval(const char c) { return seen(c) && has_value(); }
 
-  // Float removes 'E' to prevent scientific notation interpretation
+  // Parse the number at p, stopping at 'E' (no scientific notation)
+  static float parse_float(char * const p);
+
   inline static float value_float() {
-    if (value_ptr) {
-      char *e = value_ptr;
-      for (;;) {
-        const char c = *e;
-        if (c == '\0' || c == ' ') break;
-        if (c == 'E' || c == 'e') {
-          *e = '\0';
-          const float ret = strtod(value_ptr, NULL);
-          *e = c;
-          return ret;
-        }
-        ++e;
-      }
-      return strtod(value_ptr, NULL);
-    }
-    return 0.0;
+    #if ENABLED(GCODE_PREPARSE)
+      if (packed_values) return value_ptr ? *packed_value : 0.0;
+    #endif
+    return value_ptr ? parse_float(value_ptr) : 0.0;
   }
 
   // Code value as a long or ulong
-  inline static int32_t value_long() { return value_ptr ? strtol(value_ptr, NULL, 10) : 0L; }
-  inline static uint32_t value_ulong() { return value_ptr ? strtoul(value_ptr, NULL, 10) : 0UL; }
+  #if ENABLED(GCODE_PREPARSE)
+    inline static int32_t value_long() {
+      if (packed_values) return value_ptr ? (int32_t)*packed_value : 0L;
+      return value_ptr ? strtol(value_ptr, NULL, 10) : 0L;
+    }
+    inline static uint32_t value_ulong() {
+      if (packed_values) return value_ptr ? (uint32_t)(int32_t)*packed_value : 0UL;
+      return value_ptr ? strtoul(value_ptr, NULL, 10) : 0UL;
+    }
+  #else
+    inline static int32_t value_long() { return value_ptr ? strtol(value_ptr, NULL, 10) : 0L; }
+    inline static uint32_t value_ulong() { return value_ptr ? strtoul(value_ptr, NULL, 10) : 0UL; }
+  #endif
 
   // Code value for use as time
   FORCE_INLINE static millis_t value_millis() { return value_ulong(); }
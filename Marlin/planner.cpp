@@ -81,7 +81,12 @@ Planner planner;
  */
 block_t Planner::block_buffer[BLOCK_BUFFER_SIZE];
 volatile uint8_t Planner::block_buffer_head = 0,           // Index of the next block to be pushed
-                 Planner::block_buffer_tail = 0;
+                 Planner::block_buffer_tail = 0,
+                 Planner::block_buffer_planned = 0;        // Index of the last block with a settled plan
+
+#if ENABLED(STEP_SEGMENT_BUFFER)
+  volatile uint8_t Planner::block_buffer_prep = 0; // Index of the next block for the step segment generator
+#endif
 
 float Planner::max_feedrate_mm_s[XYZE_N], // Max speeds in mm per second
       Planner::axis_steps_per_mm[XYZE_N],
@@ -150,10 +155,32 @@ float Planner::previous_speed[NUM_AXIS],
         Planner::position_float[NUM_AXIS] = { 0 };
 #endif
 
-#if ENABLED(ULTRA_LCD)
+#if HAS_BLOCK_BUFFER_RUNTIME
   volatile uint32_t Planner::block_buffer_runtime_us = 0;
 #endif
 
+#if ENABLED(SEGMENT_MERGE)
+  bool Planner::merge_pending = false;
+  float Planner::merge_start[XYZE],
+        Planner::merge_end[XYZE],
+        Planner::merge_fr_mm_s,
+        Planner::merge_error;
+  uint8_t Planner::merge_extruder;
+  uint32_t Planner::merged_segments = 0;
+#endif
+
+#if ENABLED(SEGMENT_TIME_BUDGET)
+  uint32_t Planner::block_interval_us = 0,
+           Planner::last_block_us;
+  bool Planner::block_stream = false;
+  uint16_t Planner::starved_count = 0,
+           Planner::slowed_count = 0;
+  uint8_t Planner::fill_actual = 0,
+          Planner::fill_actual_min = BLOCK_BUFFER_SIZE,
+          Planner::fill_predicted = 0,
+          Planner::fill_predicted_min = 255;
+#endif
+
 /**
  * Class and Instance Methods
  */
@@ -161,7 +188,10 @@ float Planner::previous_speed[NUM_AXIS],
 Planner::Planner() { init(); }
 
 void Planner::init() {
-  block_buffer_head = block_buffer_tail = 0;
+  block_buffer_head = block_buffer_tail = block_buffer_planned = 0;
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+    block_buffer_prep = 0;
+  #endif
   ZERO(position);
   #if ENABLED(LIN_ADVANCE)
     ZERO(position_float);
@@ -175,44 +205,189 @@ void Planner::init() {
 
 #define MINIMAL_STEP_RATE 120
 
+#if ENABLED(PLANNER_FIXED_POINT)
+
+  // sqrt(n * 2^26) for n = 16..64, the range of the top bits in sqrt_u32()
+  static const uint16_t sqrt_table[49] PROGMEM = {
+    32768, 33776, 34756, 35708, 36636, 37540, 38424, 39287,
+    40132, 40960, 41771, 42567, 43348, 44115, 44869, 45611,
+    46341, 47059, 47767, 48465, 49152, 49830, 50499, 51159,
+    51811, 52454, 53090, 53719, 54340, 54954, 55561, 56162,
+    56756, 57344, 57926, 58503, 59073, 59639, 60199, 60753,
+    61303, 61848, 62388, 62924, 63455, 63982, 64504, 65022,
+    65535
+  };
+
+  /**
+   * Square root of a 32-bit integer, rounded down (to within 1 part in 8000).
+   * x is shifted up by an even number of bits into [2^30, 2^32), its top 6 bits
+   * pick a table entry and the next 16 bits interpolate to the one after.
+   */
+  uint16_t Planner::sqrt_u32(uint32_t x) {
+    if (!x) return 0;
+    uint8_t shift = 0;
+    while (x < 0x40000000UL) { x <<= 2; shift++; }
+    const uint8_t i = (x >> 26) - 16;
+    const uint16_t lo = pgm_read_word(&sqrt_table[i]), hi = pgm_read_word(&sqrt_table[i + 1]);
+    return (lo + (((uint32_t)(hi - lo) * (uint16_t)(x >> 10)) >> 16)) >> shift;
+  }
+
+  /**
+   * The trapezoid's 32x32 products, from four 16x16 multiplies each.
+   * avr-gcc has no widening 32-bit multiply and would do a uint64_t one
+   * with the full 64x64 __muldi3 routine.
+   */
+
+  // a * b / 2^32, rounded down
+  static uint32_t mul_hi32(const uint32_t a, const uint32_t b) {
+    const uint16_t ah = a >> 16, al = a, bh = b >> 16, bl = b;
+    const uint32_t ll = (uint32_t)al * bl, lh = (uint32_t)al * bh, hl = (uint32_t)ah * bl,
+                   mid = (ll >> 16) + (uint16_t)lh + (uint16_t)hl;
+    return (uint32_t)ah * bh + (lh >> 16) + (hl >> 16) + (mid >> 16);
+  }
+
+  // a * b / 2^32, rounded up
+  FORCE_INLINE static uint32_t mul_hi32_ceil(const uint32_t a, const uint32_t b) { return mul_hi32(a, b) + (a * b != 0); }
+
+  // a * b / 2^16, rounded down. The result must fit in 32 bits.
+  FORCE_INLINE static uint32_t mul_shr16(const uint32_t a, const uint32_t b) { return (mul_hi32(a, b) << 16) | ((a * b) >> 16); }
+
+  // Squared step rate for a squared speed, v2 * factor / 2^16 rounded up, at most cap
+  static uint32_t rate_sqr(const uint32_t v2, const uint32_t factor, const uint32_t cap) {
+    const uint32_t hi = mul_hi32(v2, factor), lo = v2 * factor;
+    if (hi >> 16) return cap;
+    const uint32_t r = (hi << 16) | (lo >> 16);
+    return r < cap ? r + ((uint16_t)lo != 0) : cap;
+  }
+
+#endif // PLANNER_FIXED_POINT
+
 /**
  * Calculate trapezoid parameters, multiplying the entry- and exit-speeds
  * by the provided factors.
+ *
+ * With PLANNER_FIXED_POINT the squared entry and exit speeds are given and
+ * it's all integer math: squared step rates are the squared speeds times the
+ * block's rate_sqr_factor, and step counts are their differences over 2*accel.
  */
-void Planner::calculate_trapezoid_for_block(block_t* const block, const float &entry_factor, const float &exit_factor) {
-  uint32_t initial_rate = CEIL(block->nominal_rate * entry_factor),
-           final_rate = CEIL(block->nominal_rate * exit_factor); // (steps per second)
-
-  // Limit minimal step rate (Otherwise the timer will overflow.)
-  NOLESS(initial_rate, MINIMAL_STEP_RATE);
-  NOLESS(final_rate, MINIMAL_STEP_RATE);
-
-  int32_t accel = block->acceleration_steps_per_s2,
-          accelerate_steps = CEIL(estimate_acceleration_distance(initial_rate, block->nominal_rate, accel)),
-          decelerate_steps = FLOOR(estimate_acceleration_distance(block->nominal_rate, final_rate, -accel)),
-          plateau_steps = block->step_event_count - accelerate_steps - decelerate_steps;
-
-  // Is the Plateau of Nominal Rate smaller than nothing? That means no cruising, and we will
-  // have to use intersection_distance() to calculate when to abort accel and start braking
-  // in order to reach the final_rate exactly at the end of this block.
-  if (plateau_steps < 0) {
-    accelerate_steps = CEIL(intersection_distance(initial_rate, final_rate, accel, block->step_event_count));
-    NOLESS(accelerate_steps, 0); // Check limits due to numerical round-off
-    accelerate_steps = min((uint32_t)accelerate_steps, block->step_event_count);//(We can cast here to unsigned, because the above line ensures that we are above zero)
-    plateau_steps = 0;
-  }
+#if ENABLED(PLANNER_FIXED_POINT)
+  void Planner::calculate_trapezoid_for_block(block_t* const block, const uint32_t entry_speed_sqr, const uint32_t exit_speed_sqr) {
+#else
+  void Planner::calculate_trapezoid_for_block(block_t* const block, const float &entry_factor, const float &exit_factor) {
+#endif
+
+  #if ENABLED(PLANNER_FIXED_POINT)
 
-  // block->accelerate_until = accelerate_steps;
-  // block->decelerate_after = accelerate_steps+plateau_steps;
+    const uint32_t nominal_rate = min(block->nominal_rate, 65535UL),
+                   nominal_rate_sqr = nominal_rate * nominal_rate,
+                   factor = block->rate_sqr_factor;
 
-  CRITICAL_SECTION_START;  // Fill variables used by the stepper in a critical section
+    // Rounded up like CEIL() and limited like below
+    #define _RATE(V2) min(nominal_rate, max(uint32_t(MINIMAL_STEP_RATE), \
+      uint32_t(sqrt_u32(rate_sqr(V2, factor, nominal_rate_sqr)) + 1)))
+    const uint32_t initial_rate = _RATE(entry_speed_sqr), // (steps per second)
+                   final_rate = _RATE(exit_speed_sqr),
+                   initial_rate_sqr = initial_rate * initial_rate,
+                   final_rate_sqr = final_rate * final_rate;
+    #undef _RATE
+
+    const uint32_t inverse = block->inverse_2_accel; // 2^32 / (2 * accel)
+    int32_t accelerate_steps = mul_hi32_ceil(nominal_rate_sqr - initial_rate_sqr, inverse),
+            decelerate_steps = mul_hi32(nominal_rate_sqr - final_rate_sqr, inverse),
+            plateau_steps = block->step_event_count - accelerate_steps - decelerate_steps;
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+      uint32_t cruise_rate = nominal_rate;
+    #endif
+
+    // No cruising: accelerate up to where braking must start to reach final_rate at the end
+    if (plateau_steps < 0) {
+      // (final_rate_sqr - initial_rate_sqr) / (2 * accel), rounded down
+      const int32_t rate_steps = final_rate_sqr >= initial_rate_sqr
+        ? int32_t(mul_hi32(final_rate_sqr - initial_rate_sqr, inverse))
+        : -int32_t(mul_hi32_ceil(initial_rate_sqr - final_rate_sqr, inverse));
+      #if ENABLED(S_CURVE_ACCELERATION)
+        // Fewer steps than the full ramp can't reach nominal_rate_sqr, or overflow
+        const bool below_nominal = accelerate_steps > (int32_t(block->step_event_count) + rate_steps + 1) >> 1;
+      #endif
+      accelerate_steps = (int32_t(block->step_event_count) + rate_steps + 1) >> 1;
+      accelerate_steps = constrain(accelerate_steps, 0, int32_t(block->step_event_count));
+      plateau_steps = 0;
+      #if ENABLED(S_CURVE_ACCELERATION)
+        if (below_nominal) cruise_rate = sqrt_u32(initial_rate_sqr + 2 * uint32_t(accelerate_steps) * block->acceleration_steps_per_s2);
+      #endif
+    }
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+      // Timer ticks for a rate change: (rate change) / accel * F_CPU / 8
+      #define _TICKS(DR) mul_shr16(mul_shr16(DR, inverse), (F_CPU) / 4)
+    #endif
+
+  #else
+
+    uint32_t initial_rate = CEIL(block->nominal_rate * entry_factor),
+             final_rate = CEIL(block->nominal_rate * exit_factor); // (steps per second)
+
+    // Limit minimal step rate (Otherwise the timer will overflow.)
+    NOLESS(initial_rate, MINIMAL_STEP_RATE);
+    NOLESS(final_rate, MINIMAL_STEP_RATE);
+
+    int32_t accel = block->acceleration_steps_per_s2,
+            accelerate_steps = CEIL(estimate_acceleration_distance(initial_rate, block->nominal_rate, accel)),
+            decelerate_steps = FLOOR(estimate_acceleration_distance(block->nominal_rate, final_rate, -accel)),
+            plateau_steps = block->step_event_count - accelerate_steps - decelerate_steps;
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+      uint32_t cruise_rate = block->nominal_rate;
+    #endif
+
+    // Is the Plateau of Nominal Rate smaller than nothing? That means no cruising, and we will
+    // have to use intersection_distance() to calculate when to abort accel and start braking
+    // in order to reach the final_rate exactly at the end of this block.
+    if (plateau_steps < 0) {
+      accelerate_steps = CEIL(intersection_distance(initial_rate, final_rate, accel, block->step_event_count));
+      NOLESS(accelerate_steps, 0); // Check limits due to numerical round-off
+      accelerate_steps = min((uint32_t)accelerate_steps, block->step_event_count);//(We can cast here to unsigned, because the above line ensures that we are above zero)
+      plateau_steps = 0;
+      #if ENABLED(S_CURVE_ACCELERATION)
+        cruise_rate = min(block->nominal_rate, uint32_t(SQRT(sq(float(initial_rate)) + 2.0 * accel * accelerate_steps)));
+      #endif
+    }
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+      // Timer ticks for a rate change: (rate change) / accel * F_CPU / 8
+      #define _TICKS(DR) uint32_t(float(DR) * ((F_CPU) * 0.125) / accel)
+    #endif
+
+  #endif
+
+  #if ENABLED(S_CURVE_ACCELERATION)
+    // The S-curve takes as long as the linear ramp it replaces, and covers the same steps
+    NOLESS(cruise_rate, max(initial_rate, final_rate));
+    const uint32_t acceleration_time = _TICKS(cruise_rate - initial_rate),
+                   deceleration_time = _TICKS(cruise_rate - final_rate);
+    #undef _TICKS
+  #endif
+
+  // Fill the spare trapezoid and then make it current with one byte write.
+  // A block the stepper takes in between keeps the trapezoid it started with.
   if (!TEST(block->flag, BLOCK_BIT_BUSY)) { // Don't update variables if block is busy.
-    block->accelerate_until = accelerate_steps;
-    block->decelerate_after = accelerate_steps + plateau_steps;
-    block->initial_rate = initial_rate;
-    block->final_rate = final_rate;
+    const uint8_t spare = block->trapezoid_index ^ 1;
+    trapezoid_t * const trap = &block->trapezoid[spare];
+    trap->accelerate_until = accelerate_steps;
+    trap->decelerate_after = accelerate_steps + plateau_steps;
+    trap->initial_rate = initial_rate;
+    trap->final_rate = final_rate;
+    #if ENABLED(S_CURVE_ACCELERATION)
+      trap->cruise_rate = cruise_rate;
+      trap->acceleration_time = acceleration_time;
+      trap->deceleration_time = deceleration_time;
+      trap->acceleration_time_inverse = acceleration_time ? 0xFFFFFFFFUL / acceleration_time : 0;
+      trap->deceleration_time_inverse = deceleration_time ? 0xFFFFFFFFUL / deceleration_time : 0;
+    #endif
+    __asm__ __volatile__ ("" ::: "memory"); // All of the above before the switch
+    block->trapezoid_index = spare;
   }
-  CRITICAL_SECTION_END;
 }
 
 // "Junction jerk" in this context is the immediate change in speed at the junction of two blocks.
@@ -230,89 +405,113 @@ void Planner::reverse_pass_kernel(block_t* const current, const block_t *next) {
   // If entry speed is already at the maximum entry speed, no need to recheck. Block is cruising.
   // If not, block in state of acceleration or deceleration. Reset entry speed to maximum and
   // check for maximum allowable speed reductions to ensure maximum possible planned speed.
-  float max_entry_speed = current->max_entry_speed;
-  if (current->entry_speed != max_entry_speed) {
-    // If nominal length true, max junction speed is guaranteed to be reached. Only compute
-    // for max allowable speed if block is decelerating and nominal length is false.
-    current->entry_speed = (TEST(current->flag, BLOCK_BIT_NOMINAL_LENGTH) || max_entry_speed <= next->entry_speed)
-      ? max_entry_speed
-      : min(max_entry_speed, max_allowable_speed(-current->acceleration, next->entry_speed, current->millimeters));
-    SBI(current->flag, BLOCK_BIT_RECALCULATE);
-  }
+  #if ENABLED(PLANNER_FIXED_POINT)
+    const uint32_t max_entry_speed_sqr = current->max_entry_speed_sqr;
+    if (current->entry_speed_sqr != max_entry_speed_sqr) {
+      current->entry_speed_sqr = (TEST(current->flag, BLOCK_BIT_NOMINAL_LENGTH) || max_entry_speed_sqr <= next->entry_speed_sqr)
+        ? max_entry_speed_sqr
+        : min(max_entry_speed_sqr, next->entry_speed_sqr + current->accel_distance_sqr);
+      SBI(current->flag, BLOCK_BIT_RECALCULATE);
+    }
+  #else
+    float max_entry_speed = current->max_entry_speed;
+    if (current->entry_speed != max_entry_speed) {
+      // If nominal length true, max junction speed is guaranteed to be reached. Only compute
+      // for max allowable speed if block is decelerating and nominal length is false.
+      current->entry_speed = (TEST(current->flag, BLOCK_BIT_NOMINAL_LENGTH) || max_entry_speed <= next->entry_speed)
+        ? max_entry_speed
+        : min(max_entry_speed, max_allowable_speed(-current->acceleration, next->entry_speed, current->millimeters));
+      SBI(current->flag, BLOCK_BIT_RECALCULATE);
+    }
+  #endif
 }
 
 /**
  * recalculate() needs to go over the current plan twice.
- * Once in reverse and once forward. This implements the reverse pass.
+ * Once in reverse and once forward. This implements the reverse pass,
+ * from the newest block back to the last planned one (not included).
  */
-void Planner::reverse_pass() {
-
-  if (movesplanned() > 3) {
-
-    block_t* block[3] = { NULL, NULL, NULL };
-
-    // Make a local copy of block_buffer_tail, because the interrupt can alter it
-    // Is a critical section REALLY needed for a single byte change?
-    //CRITICAL_SECTION_START;
-    uint8_t tail = block_buffer_tail;
-    //CRITICAL_SECTION_END
-
-    uint8_t b = BLOCK_MOD(block_buffer_head - 3);
-    while (b != tail) {
-      if (block[0] && TEST(block[0]->flag, BLOCK_BIT_START_FROM_FULL_HALT)) break;
-      b = prev_block_index(b);
-      block[2] = block[1];
-      block[1] = block[0];
-      block[0] = &block_buffer[b];
-      reverse_pass_kernel(block[1], block[2]);
-    }
+void Planner::reverse_pass(const uint8_t planned) {
+  // The newest block's entry speed was set by buffer_line and has no next block
+  uint8_t b = prev_block_index(block_buffer_head);
+  if (b == planned) return;
+
+  const block_t *next = &block_buffer[b];
+  for (b = prev_block_index(b); b != planned; b = prev_block_index(b)) {
+    block_t* const current = &block_buffer[b];
+    reverse_pass_kernel(current, next);
+    if (TEST(current->flag, BLOCK_BIT_START_FROM_FULL_HALT)) break;
+    next = current;
   }
 }
 
 // The kernel called by recalculate() when scanning the plan from first to last entry.
-void Planner::forward_pass_kernel(const block_t* previous, block_t* const current) {
-  if (!previous) return;
-
+// Return true if the entry speed of 'current' can never change again.
+bool Planner::forward_pass_kernel(const block_t* previous, block_t* const current) {
   // If the previous block is an acceleration block, but it is not long enough to complete the
   // full speed change within the block, we need to adjust the entry speed accordingly. Entry
   // speeds have already been reset, maximized, and reverse planned by reverse planner.
   // If nominal length is true, max junction speed is guaranteed to be reached. No need to recheck.
-  if (!TEST(previous->flag, BLOCK_BIT_NOMINAL_LENGTH)) {
-    if (previous->entry_speed < current->entry_speed) {
-      float entry_speed = min(current->entry_speed,
-                               max_allowable_speed(-previous->acceleration, previous->entry_speed, previous->millimeters));
-      // Check for junction speed change
-      if (current->entry_speed != entry_speed) {
-        current->entry_speed = entry_speed;
-        SBI(current->flag, BLOCK_BIT_RECALCULATE);
+  #if ENABLED(PLANNER_FIXED_POINT)
+    if (!TEST(previous->flag, BLOCK_BIT_NOMINAL_LENGTH)) {
+      if (previous->entry_speed_sqr < current->entry_speed_sqr) {
+        const uint32_t entry_speed_sqr = min(current->entry_speed_sqr, previous->entry_speed_sqr + previous->accel_distance_sqr);
+        // Check for junction speed change
+        if (current->entry_speed_sqr != entry_speed_sqr) {
+          current->entry_speed_sqr = entry_speed_sqr;
+          SBI(current->flag, BLOCK_BIT_RECALCULATE);
+          return true; // Full acceleration from a settled block is as fast as it gets
+        }
       }
     }
-  }
+    // A junction at its maximum speed can't go any faster
+    return current->entry_speed_sqr == current->max_entry_speed_sqr;
+  #else
+    if (!TEST(previous->flag, BLOCK_BIT_NOMINAL_LENGTH)) {
+      if (previous->entry_speed < current->entry_speed) {
+        float entry_speed = min(current->entry_speed,
+                                 max_allowable_speed(-previous->acceleration, previous->entry_speed, previous->millimeters));
+        // Check for junction speed change
+        if (current->entry_speed != entry_speed) {
+          current->entry_speed = entry_speed;
+          SBI(current->flag, BLOCK_BIT_RECALCULATE);
+          return true; // Full acceleration from a settled block is as fast as it gets
+        }
+      }
+    }
+    // A junction at its maximum speed can't go any faster
+    return current->entry_speed == current->max_entry_speed;
+  #endif
 }
 
 /**
  * recalculate() needs to go over the current plan twice.
- * Once in reverse and once forward. This implements the forward pass.
+ * Once in reverse and once forward. This implements the forward pass,
+ * which also moves block_buffer_planned up to the last settled block.
  */
-void Planner::forward_pass() {
-  block_t* block[3] = { NULL, NULL, NULL };
-
-  for (uint8_t b = block_buffer_tail; b != block_buffer_head; b = next_block_index(b)) {
-    block[0] = block[1];
-    block[1] = block[2];
-    block[2] = &block_buffer[b];
-    forward_pass_kernel(block[0], block[1]);
+void Planner::forward_pass(uint8_t planned) {
+  const block_t *previous = &block_buffer[planned];
+  for (uint8_t b = next_block_index(planned); b != block_buffer_head; b = next_block_index(b)) {
+    block_t* const current = &block_buffer[b];
+    if (forward_pass_kernel(previous, current)) planned = b;
+    previous = current;
   }
-  forward_pass_kernel(block[1], block[2]);
+
+  // The stepper ISR moves block_buffer_planned along as it takes blocks,
+  // so only keep the new index if that block is still in the queue.
+  CRITICAL_SECTION_START;
+  if (BLOCK_MOD(planned - block_buffer_tail) < BLOCK_MOD(block_buffer_head - block_buffer_tail))
+    block_buffer_planned = planned;
+  CRITICAL_SECTION_END;
 }
 
 /**
- * Recalculate the trapezoid speed profiles for all blocks in the plan
- * according to the entry_factor for each junction. Must be called by
+ * Recalculate the trapezoid speed profiles for the blocks from 'planned'
+ * on according to the entry_factor for each junction. Must be called by
  * recalculate() after updating the blocks.
  */
-void Planner::recalculate_trapezoids() {
-  int8_t block_index = block_buffer_tail;
+void Planner::recalculate_trapezoids(const uint8_t planned) {
+  uint8_t block_index = planned;
   block_t *current, *next = NULL;
 
   while (block_index != block_buffer_head) {
@@ -321,9 +520,13 @@ void Planner::recalculate_trapezoids() {
     if (current) {
       // Recalculate if current block entry or exit junction speed has changed.
       if (TEST(current->flag, BLOCK_BIT_RECALCULATE) || TEST(next->flag, BLOCK_BIT_RECALCULATE)) {
-        // NOTE: Entry and exit factors always > 0 by all previous logic operations.
-        float nom = current->nominal_speed;
-        calculate_trapezoid_for_block(current, current->entry_speed / nom, next->entry_speed / nom);
+        #if ENABLED(PLANNER_FIXED_POINT)
+          calculate_trapezoid_for_block(current, current->entry_speed_sqr, next->entry_speed_sqr);
+        #else
+          // NOTE: Entry and exit factors always > 0 by all previous logic operations.
+          float nom = current->nominal_speed;
+          calculate_trapezoid_for_block(current, current->entry_speed / nom, next->entry_speed / nom);
+        #endif
         CBI(current->flag, BLOCK_BIT_RECALCULATE); // Reset current only to ensure next trapezoid is computed
       }
     }
@@ -331,8 +534,12 @@ void Planner::recalculate_trapezoids() {
   }
   // Last/newest block in buffer. Exit speed is set with MINIMUM_PLANNER_SPEED. Always recalculated.
   if (next) {
-    float nom = next->nominal_speed;
-    calculate_trapezoid_for_block(next, next->entry_speed / nom, (MINIMUM_PLANNER_SPEED) / nom);
+    #if ENABLED(PLANNER_FIXED_POINT)
+      calculate_trapezoid_for_block(next, next->entry_speed_sqr, speed_sqr(MINIMUM_PLANNER_SPEED));
+    #else
+      float nom = next->nominal_speed;
+      calculate_trapezoid_for_block(next, next->entry_speed / nom, (MINIMUM_PLANNER_SPEED) / nom);
+    #endif
     CBI(next->flag, BLOCK_BIT_RECALCULATE);
   }
 }
@@ -360,11 +567,20 @@ void Planner::recalculate_trapezoids() {
  * jerk is jerkier than the set limit, Jerky. Finally it will:
  *
  *   3. Recalculate "trapezoids" for all blocks.
+ *
+ * Like grbl, only the blocks after block_buffer_planned are visited. The
+ * entry speeds up to it are final: the junction is at its maximum speed,
+ * or as fast as full acceleration from the settled block before it allows.
+ * So the cost per new block doesn't grow with BLOCK_BUFFER_SIZE.
  */
 void Planner::recalculate() {
-  reverse_pass();
-  forward_pass();
-  recalculate_trapezoids();
+  // The ISR may move it along meanwhile. Go by the index from the start,
+  // so the trapezoids of the blocks settled by this pass are updated too.
+  const uint8_t planned = block_buffer_planned;
+  if (planned == block_buffer_head) return; // All taken by the stepper already
+  reverse_pass(planned);
+  forward_pass(planned);
+  recalculate_trapezoids(planned);
 }
 
 
@@ -394,6 +610,64 @@ void Planner::recalculate() {
 
 #endif // AUTOTEMP
 
+#if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+
+  /**
+   * The volumetric flow (mm³/s) the queued moves will be extruding on the
+   * given hotend 'ms' milliseconds from now. Blocks are timed at their
+   * nominal speed and the running block is counted whole, so this looks
+   * ahead by up to one block more than asked. When the queue runs out
+   * first, its last block gives the flow.
+   */
+  float Planner::flow_ahead(const uint8_t e, const uint16_t ms) {
+    float ahead = ms * 0.001, flow = 0;
+    for (uint8_t b = block_buffer_tail; b != block_buffer_head; b = next_block_index(b)) {
+      const block_t * const block = &block_buffer[b];
+      const float seconds = block->millimeters / block->nominal_speed;
+      flow = 0;
+      #if HOTENDS > 1
+        if (block->active_extruder == e)
+      #endif
+      if ((block->steps[X_AXIS] || block->steps[Y_AXIS] || block->steps[Z_AXIS]) && !TEST(block->direction_bits, E_AXIS)) {
+        #if ENABLED(DISTINCT_E_FACTORS)
+          const uint8_t extruder = block->active_extruder;
+        #endif
+        const float dia = filament_size[block->active_extruder] ? filament_size[block->active_extruder] : DEFAULT_NOMINAL_FILAMENT_DIA;
+        flow = block->steps[E_AXIS] * steps_to_mm[E_AXIS_N] * (M_PI * 0.25) * sq(dia) / seconds;
+      }
+      ahead -= seconds;
+      if (ahead <= 0) break;
+    }
+    #if HOTENDS == 1
+      UNUSED(e);
+    #endif
+    return flow;
+  }
+
+#endif // PID_EXTRUSION_FEEDFORWARD
+
+#if ENABLED(SEGMENT_TIME_BUDGET)
+
+  void Planner::report_segment_budget() {
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPAIR("Block interval ", block_interval_us);
+    SERIAL_ECHOPAIR("us, starved ", starved_count);
+    SERIAL_ECHOLNPAIR(", slowed ", slowed_count);
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPAIR("Fill predicted ", fill_predicted);
+    SERIAL_ECHOPAIR(" min ", fill_predicted_min);
+    SERIAL_ECHOPAIR(", actual ", fill_actual);
+    SERIAL_ECHOLNPAIR(" min ", fill_actual_min);
+  }
+
+  void Planner::reset_segment_budget() {
+    starved_count = slowed_count = 0;
+    fill_actual_min = fill_actual;
+    fill_predicted_min = fill_predicted;
+  }
+
+#endif // SEGMENT_TIME_BUDGET
+
 /**
  * Maintain fans, paste extruder pressure,
  */
@@ -675,9 +949,9 @@ void Planner::check_axes_activity() {
 #endif // PLANNER_LEVELING
 
 /**
- * Planner::_buffer_line
+ * Planner::_queue_line
  *
- * Add a new linear movement to the buffer.
+ * Add a new linear movement to the buffer. Called by _buffer_line.
  *
  * Leveling and kinematics should be applied ahead of calling this.
  *
@@ -685,7 +959,7 @@ void Planner::check_axes_activity() {
  *  fr_mm_s     - (target) speed of the move
  *  extruder    - target extruder
  */
-void Planner::_buffer_line(const float &a, const float &b, const float &c, const float &e, float fr_mm_s, const uint8_t extruder) {
+void Planner::_queue_line(const float &a, const float &b, const float &c, const float &e, float fr_mm_s, const uint8_t extruder) {
 
   // The target position of the tool in absolute steps
   // Calculate target position in absolute steps
@@ -812,7 +1086,13 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
 
   // If the buffer is full: good! That means we are well ahead of the robot.
   // Rest here until there is room in the buffer.
+  #if ENABLED(SEGMENT_TIME_BUDGET)
+    const uint32_t wait_start_us = micros();
+  #endif
   while (block_buffer_tail == next_buffer_head) idle();
+  #if ENABLED(SEGMENT_TIME_BUDGET)
+    last_block_us += uint32_t(micros()) - wait_start_us; // Waiting for room isn't front end time
+  #endif
 
   // Prepare to set up new block
   block_t* block = &block_buffer[block_buffer_head];
@@ -867,6 +1147,15 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
 
   block->active_extruder = extruder;
 
+  #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+    if (current_command_from_sd) {
+      SBI(block->flag, BLOCK_BIT_FROM_SD);
+      if (current_command_relative_e) SBI(block->flag, BLOCK_BIT_RELATIVE_E);
+      block->sdpos = current_command_sdpos;
+      block->feedrate = MMS_TO_MMM(min(feedrate_mm_s, 1000.0f)); // The A15 resume restores it
+    }
+  #endif
+
   //enable active axes
   #if CORE_IS_XY
     if (block->steps[A_AXIS] || block->steps[B_AXIS]) {
@@ -1057,7 +1346,7 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
   const uint8_t moves_queued = movesplanned();
 
   // Slow down when the buffer starts to empty, rather than wait at the corner for a buffer refill
-  #if ENABLED(SLOWDOWN) || ENABLED(ULTRA_LCD) || defined(XY_FREQUENCY_LIMIT)
+  #if ENABLED(SLOWDOWN) || HAS_BLOCK_BUFFER_RUNTIME || defined(XY_FREQUENCY_LIMIT)
     // Segment time im micro seconds
     unsigned long segment_time = LROUND(1000000.0 / inverse_mm_s);
   #endif
@@ -1066,14 +1355,56 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
       if (segment_time < min_segment_time) {
         // buffer is draining, add extra time.  The amount of time added increases if the buffer is still emptied more.
         inverse_mm_s = 1000000.0 / (segment_time + LROUND(2 * (min_segment_time - segment_time) / moves_queued));
-        #if defined(XY_FREQUENCY_LIMIT) || ENABLED(ULTRA_LCD)
+        #if defined(XY_FREQUENCY_LIMIT) || HAS_BLOCK_BUFFER_RUNTIME
           segment_time = LROUND(1000000.0 / inverse_mm_s);
         #endif
       }
     }
   #endif
 
-  #if ENABLED(ULTRA_LCD)
+  #if ENABLED(SEGMENT_TIME_BUDGET)
+    {
+      const uint32_t now_us = micros();
+      if (block_stream) {
+        // Smooth the time the front end took to produce this block. Long pauses
+        // are clipped, since the budget never exceeds min_segment_time anyway.
+        const uint32_t interval_us = min(now_us - last_block_us, min_segment_time);
+        block_interval_us = (block_interval_us * 7 + interval_us) >> 3;
+
+        // An empty buffer here means the steppers outran the front end
+        if (!moves_queued) starved_count++;
+      }
+
+      CRITICAL_SECTION_START
+        const uint32_t queued_us = block_buffer_runtime_us;
+      CRITICAL_SECTION_END
+
+      // Compare the blocks on hand with how many the front end can queue before they run out
+      fill_actual = moves_queued;
+      fill_predicted = min(queued_us / max(block_interval_us, 1UL), 255UL);
+      NOMORE(fill_actual_min, fill_actual);
+      NOMORE(fill_predicted_min, fill_predicted);
+
+      // Segments shorter than the time to produce them will drain the buffer.
+      // Once the queued time won't cover refilling half the buffer, give each
+      // new segment at least the production time, plus a margin.
+      if (moves_queued) {
+        uint32_t budget_us = block_interval_us + (block_interval_us >> 2);
+        NOMORE(budget_us, min_segment_time);
+        if (segment_time < budget_us && queued_us < budget_us * ((BLOCK_BUFFER_SIZE) / 2)) {
+          segment_time = budget_us;
+          inverse_mm_s = 1000000.0 / segment_time;
+          slowed_count++;
+        }
+      }
+
+      last_block_us = now_us;
+      block_stream = true;
+    }
+  #endif
+
+  #if HAS_BLOCK_BUFFER_RUNTIME
+    block->segment_time = segment_time; // get_current_block() takes it back out of the total
     CRITICAL_SECTION_START
       block_buffer_runtime_us += segment_time;
     CRITICAL_SECTION_END
@@ -1349,12 +1680,39 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
     vmax_junction = safe_speed;
   }
 
-  // Max entry speed of this block equals the max exit speed of the previous block.
-  block->max_entry_speed = vmax_junction;
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+    // A block already cut into segments ends at the speed it was prepared with
+    if (block_buffer_prep == block_buffer_head && block_buffer_prep != block_buffer_tail) {
+      const block_t * const prev = &block_buffer[prev_block_index(block_buffer_head)];
+      NOMORE(vmax_junction, prev->nominal_speed * prev->trapezoid[prev->trapezoid_index].final_rate / prev->nominal_rate);
+    }
+  #endif
+
+  #if ENABLED(PLANNER_FIXED_POINT)
+
+    // Per-block constants for the integer passes and trapezoids
+    block->nominal_speed_sqr = speed_sqr(block->nominal_speed);
+    block->accel_distance_sqr = min(2 * block->acceleration * block->millimeters * float(1UL << SPEED_SQR_FRACT), 2147483647.0);
+    block->rate_sqr_factor = min(sq(float(block->nominal_rate)) / max(block->nominal_speed_sqr, 1UL) * 65536.0, 4294967295.0);
+    block->inverse_2_accel = 0x80000000UL / max(accel, 1UL);
+
+    // Max entry speed of this block equals the max exit speed of the previous block.
+    block->max_entry_speed_sqr = speed_sqr(vmax_junction);
+
+    // Initialize block entry speed. Compute based on deceleration to user-defined MINIMUM_PLANNER_SPEED.
+    const uint32_t v_allowable_sqr = speed_sqr(MINIMUM_PLANNER_SPEED) + block->accel_distance_sqr;
+    block->entry_speed_sqr = min(block->max_entry_speed_sqr, v_allowable_sqr);
+
+  #else
+
+    // Max entry speed of this block equals the max exit speed of the previous block.
+    block->max_entry_speed = vmax_junction;
+
+    // Initialize block entry speed. Compute based on deceleration to user-defined MINIMUM_PLANNER_SPEED.
+    const float v_allowable = max_allowable_speed(-block->acceleration, MINIMUM_PLANNER_SPEED, block->millimeters);
+    block->entry_speed = min(vmax_junction, v_allowable);
 
-  // Initialize block entry speed. Compute based on deceleration to user-defined MINIMUM_PLANNER_SPEED.
-  const float v_allowable = max_allowable_speed(-block->acceleration, MINIMUM_PLANNER_SPEED, block->millimeters);
-  block->entry_speed = min(vmax_junction, v_allowable);
+  #endif
 
   // Initialize planner efficiency flags
   // Set flag if block will always reach maximum junction speed regardless of entry/exit speeds.
@@ -1364,7 +1722,11 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
   // block nominal speed limits both the current and next maximum junction speeds. Hence, in both
   // the reverse and forward planners, the corresponding block junction speed will always be at the
   // the maximum junction speed and may always be ignored for any speed reduction checks.
-  block->flag |= BLOCK_FLAG_RECALCULATE | (block->nominal_speed <= v_allowable ? BLOCK_FLAG_NOMINAL_LENGTH : 0);
+  #if ENABLED(PLANNER_FIXED_POINT)
+    block->flag |= BLOCK_FLAG_RECALCULATE | (block->nominal_speed_sqr <= v_allowable_sqr ? BLOCK_FLAG_NOMINAL_LENGTH : 0);
+  #else
+    block->flag |= BLOCK_FLAG_RECALCULATE | (block->nominal_speed <= v_allowable ? BLOCK_FLAG_NOMINAL_LENGTH : 0);
+  #endif
 
   // Update previous path unit_vector and nominal speed
   COPY(previous_speed, current_speed);
@@ -1403,7 +1765,11 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
 
   #endif // LIN_ADVANCE
 
-  calculate_trapezoid_for_block(block, block->entry_speed / block->nominal_speed, safe_speed / block->nominal_speed);
+  #if ENABLED(PLANNER_FIXED_POINT)
+    calculate_trapezoid_for_block(block, block->entry_speed_sqr, speed_sqr(safe_speed));
+  #else
+    calculate_trapezoid_for_block(block, block->entry_speed / block->nominal_speed, safe_speed / block->nominal_speed);
+  #endif
 
   // Move buffer head
   block_buffer_head = next_buffer_head;
@@ -1421,7 +1787,78 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
 
   stepper.wake_up();
 
-} // buffer_line()
+} // _queue_line()
+
+#if ENABLED(SEGMENT_MERGE)
+
+  /**
+   * Hold each segment back until the next one arrives, and join the two
+   * when they make one straight move. The new segment joins the held one if:
+   *
+   *  - It has the same feedrate and extruder, and carries on forward.
+   *  - The held end point is within SEGMENT_MERGE_TOLERANCE of the joined
+   *    segment. Deviations add up over a run, so no merged point strays further.
+   *  - It extrudes the same amount per mm, within 2%.
+   *  - The joined segment is no longer than SEGMENT_MERGE_MAX_LENGTH.
+   *
+   * While the buffer is nearly empty the held segment goes straight on,
+   * since the steppers need it more than the look-ahead does.
+   */
+  void Planner::merge_line(const float &a, const float &b, const float &c, const float &e, const float &fr_mm_s, const uint8_t extruder) {
+    if (merge_pending && fr_mm_s == merge_fr_mm_s && extruder == merge_extruder) {
+      const float held[XYZ] = {
+                    merge_end[X_AXIS] - merge_start[X_AXIS],
+                    merge_end[Y_AXIS] - merge_start[Y_AXIS],
+                    merge_end[Z_AXIS] - merge_start[Z_AXIS]
+                  },
+                  next[XYZ] = { a - merge_end[X_AXIS], b - merge_end[Y_AXIS], c - merge_end[Z_AXIS] },
+                  joined[XYZ] = { held[X_AXIS] + next[X_AXIS], held[Y_AXIS] + next[Y_AXIS], held[Z_AXIS] + next[Z_AXIS] },
+                  joined_sq = sq(joined[X_AXIS]) + sq(joined[Y_AXIS]) + sq(joined[Z_AXIS]);
+
+      if (joined_sq <= sq(SEGMENT_MERGE_MAX_LENGTH)
+        && held[X_AXIS] * next[X_AXIS] + held[Y_AXIS] * next[Y_AXIS] + held[Z_AXIS] * next[Z_AXIS] > 0
+      ) {
+        // Distance of the held end point from the joined segment
+        const float cross_sq = sq(held[Y_AXIS] * joined[Z_AXIS] - held[Z_AXIS] * joined[Y_AXIS])
+                             + sq(held[Z_AXIS] * joined[X_AXIS] - held[X_AXIS] * joined[Z_AXIS])
+                             + sq(held[X_AXIS] * joined[Y_AXIS] - held[Y_AXIS] * joined[X_AXIS]),
+                    error = merge_error + SQRT(cross_sq / joined_sq);
+
+        if (error <= SEGMENT_MERGE_TOLERANCE) {
+          const float held_mm = SQRT(sq(held[X_AXIS]) + sq(held[Y_AXIS]) + sq(held[Z_AXIS])),
+                      next_mm = SQRT(sq(next[X_AXIS]) + sq(next[Y_AXIS]) + sq(next[Z_AXIS])),
+                      held_e = (merge_end[E_AXIS] - merge_start[E_AXIS]) * next_mm,
+                      next_e = (e - merge_end[E_AXIS]) * held_mm;
+          // Compare E per mm, cross-multiplied to save two divisions
+          if (FABS(held_e - next_e) <= 0.02 * max(FABS(held_e), FABS(next_e))) {
+            merge_error = error;
+            merge_end[X_AXIS] = a;
+            merge_end[Y_AXIS] = b;
+            merge_end[Z_AXIS] = c;
+            merge_end[E_AXIS] = e;
+            merged_segments++;
+            if (movesplanned() < 2) flush_merged_segment();
+            return;
+          }
+        }
+      }
+    }
+
+    // Queue what was held and hold this segment instead
+    flush_merged_segment();
+    COPY(merge_start, merge_end);
+    merge_end[X_AXIS] = a;
+    merge_end[Y_AXIS] = b;
+    merge_end[Z_AXIS] = c;
+    merge_end[E_AXIS] = e;
+    merge_fr_mm_s = fr_mm_s;
+    merge_extruder = extruder;
+    merge_error = 0;
+    merge_pending = true;
+    if (movesplanned() < 2) flush_merged_segment();
+  }
+
+#endif // SEGMENT_MERGE
 
 /**
  * Directly set the planner XYZ position (and stepper positions)
@@ -1431,6 +1868,13 @@ void Planner::_buffer_line(const float &a, const float &b, const float &c, const
  */
 
 void Planner::_set_position_mm(const float &a, const float &b, const float &c, const float &e) {
+  #if ENABLED(SEGMENT_MERGE)
+    flush_merged_segment();
+    merge_end[X_AXIS] = a;
+    merge_end[Y_AXIS] = b;
+    merge_end[Z_AXIS] = c;
+    merge_end[E_AXIS] = e;
+  #endif
   #if ENABLED(DISTINCT_E_FACTORS)
     #define _EINDEX (E_AXIS + active_extruder)
     last_extruder = active_extruder;
@@ -1473,13 +1917,19 @@ void Planner::set_position_mm_kinematic(const float position[NUM_AXIS]) {
 void Planner::sync_from_steppers() {
   LOOP_XYZE(i) {
     position[i] = stepper.position((AxisEnum)i);
-    #if ENABLED(LIN_ADVANCE)
-      position_float[i] = position[i] * steps_to_mm[i
+    #if ENABLED(LIN_ADVANCE) || ENABLED(SEGMENT_MERGE)
+      const float pos_mm = position[i] * steps_to_mm[i
         #if ENABLED(DISTINCT_E_FACTORS)
           + (i == E_AXIS ? active_extruder : 0)
         #endif
       ];
     #endif
+    #if ENABLED(LIN_ADVANCE)
+      position_float[i] = pos_mm;
+    #endif
+    #if ENABLED(SEGMENT_MERGE)
+      merge_end[i] = pos_mm;
+    #endif
   }
 }
 
@@ -1487,6 +1937,10 @@ void Planner::sync_from_steppers() {
  * Setters for planner position (also setting stepper position).
  */
 void Planner::set_position_mm(const AxisEnum axis, const float &v) {
+  #if ENABLED(SEGMENT_MERGE)
+    flush_merged_segment();
+    merge_end[axis] = v;
+  #endif
   #if ENABLED(DISTINCT_E_FACTORS)
     const uint8_t axis_index = axis + (axis == E_AXIS ? active_extruder : 0);
     last_extruder = active_extruder;
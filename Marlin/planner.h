@@ -53,16 +53,45 @@ enum BlockFlagBit {
   BLOCK_BIT_START_FROM_FULL_HALT,
 
   // The block is busy
-  BLOCK_BIT_BUSY
+  BLOCK_BIT_BUSY,
+
+  // The block comes from a command read from the SD print file, at sdpos
+  BLOCK_BIT_FROM_SD,
+
+  // The command that made this block took E as relative
+  BLOCK_BIT_RELATIVE_E
 };
 
 enum BlockFlag {
   BLOCK_FLAG_RECALCULATE          = _BV(BLOCK_BIT_RECALCULATE),
   BLOCK_FLAG_NOMINAL_LENGTH       = _BV(BLOCK_BIT_NOMINAL_LENGTH),
   BLOCK_FLAG_START_FROM_FULL_HALT = _BV(BLOCK_BIT_START_FROM_FULL_HALT),
-  BLOCK_FLAG_BUSY                 = _BV(BLOCK_BIT_BUSY)
+  BLOCK_FLAG_BUSY                 = _BV(BLOCK_BIT_BUSY),
+  BLOCK_FLAG_FROM_SD              = _BV(BLOCK_BIT_FROM_SD),
+  BLOCK_FLAG_RELATIVE_E           = _BV(BLOCK_BIT_RELATIVE_E)
 };
 
+/**
+ * struct trapezoid_t
+ *
+ * The speed profile the stepper follows through a block. Each block has two:
+ * the planner fills the one not in use, then switches trapezoid_index over to
+ * it, so the stepper ISR always gets a complete one and never has to wait.
+ */
+typedef struct {
+  int32_t accelerate_until,                 // The index of the step event on which to stop acceleration
+          decelerate_after;                 // The index of the step event on which to start decelerating
+  uint32_t initial_rate,                    // The jerk-adjusted step rate at start of block
+           final_rate;                      // The minimal rate at exit
+  #if ENABLED(S_CURVE_ACCELERATION)
+    uint32_t cruise_rate,                   // The highest rate reached, where acceleration ends
+             acceleration_time,             // Timer ticks spent accelerating
+             deceleration_time,             // Timer ticks spent decelerating
+             acceleration_time_inverse,     // 2^32 / acceleration_time
+             deceleration_time_inverse;     // 2^32 / deceleration_time
+  #endif
+} trapezoid_t;
+
 /**
  * struct block_t
  *
@@ -86,9 +115,10 @@ typedef struct {
     uint32_t mix_event_count[MIXING_STEPPERS]; // Scaled step_event_count for the mixing steppers
   #endif
 
-  int32_t accelerate_until,                 // The index of the step event on which to stop acceleration
-          decelerate_after,                 // The index of the step event on which to start decelerating
-          acceleration_rate;                // The acceleration rate used for acceleration calculation
+  int32_t acceleration_rate;                // The acceleration rate used for acceleration calculation
+
+  trapezoid_t trapezoid[2];                 // Current and spare speed profile
+  volatile uint8_t trapezoid_index;         // Which one the stepper should use
 
   uint8_t direction_bits;                   // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
 
@@ -100,15 +130,24 @@ typedef struct {
 
   // Fields used by the motion planner to manage acceleration
   float nominal_speed,                      // The nominal speed for this block in mm/sec
-        entry_speed,                        // Entry speed at previous-current junction in mm/sec
-        max_entry_speed,                    // Maximum allowable junction entry speed in mm/sec
         millimeters,                        // The total travel of this block in mm
         acceleration;                       // acceleration mm/sec^2
 
+  #if ENABLED(PLANNER_FIXED_POINT)
+    // Squared speeds in (mm/sec)^2, fixed point (see SPEED_SQR_FRACT)
+    uint32_t nominal_speed_sqr,
+             entry_speed_sqr,               // Entry speed at previous-current junction
+             max_entry_speed_sqr,           // Maximum allowable junction entry speed
+             accel_distance_sqr;            // 2 * acceleration * millimeters, the most the speed^2 can change
+    uint32_t rate_sqr_factor,               // (steps/sec)^2 per speed^2 unit, 16 fraction bits
+             inverse_2_accel;               // 2^32 / (2 * acceleration_steps_per_s2)
+  #else
+    float entry_speed,                      // Entry speed at previous-current junction in mm/sec
+          max_entry_speed;                  // Maximum allowable junction entry speed in mm/sec
+  #endif
+
   // Settings for the trapezoid generator
   uint32_t nominal_rate,                    // The nominal step rate for this block in step_events/sec
-           initial_rate,                    // The jerk-adjusted step rate at start of block
-           final_rate,                      // The minimal rate at exit
            acceleration_steps_per_s2;       // acceleration steps/sec^2
 
   #if FAN_COUNT > 0
@@ -121,6 +160,11 @@ typedef struct {
 
   uint32_t segment_time;
 
+  #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+    uint32_t sdpos;                         // SD position of the command that made this block, with BLOCK_BIT_FROM_SD
+    uint16_t feedrate;                      // G-code feedrate (mm/min) in effect for that command
+  #endif
+
 } block_t;
 
 #define BLOCK_MOD(n) ((n)&(BLOCK_BUFFER_SIZE-1))
@@ -134,7 +178,12 @@ class Planner {
      */
     static block_t block_buffer[BLOCK_BUFFER_SIZE];
     static volatile uint8_t block_buffer_head,  // Index of the next block to be pushed
-                            block_buffer_tail;
+                            block_buffer_tail,
+                            block_buffer_planned; // Index of the last block with a settled plan
+
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+      static volatile uint8_t block_buffer_prep; // Index of the next block for the step segment generator
+    #endif
 
     #if ENABLED(DISTINCT_E_FACTORS)
       static uint8_t last_extruder;             // Respond to extruder change
@@ -212,10 +261,29 @@ class Planner {
       static float position_float[NUM_AXIS];
     #endif
 
-    #if ENABLED(ULTRA_LCD)
+    #if HAS_BLOCK_BUFFER_RUNTIME
       volatile static uint32_t block_buffer_runtime_us; //Theoretical block buffer runtime in µs
     #endif
 
+    #if ENABLED(SEGMENT_MERGE)
+      static bool merge_pending;            // A segment is being held to merge with the next
+      static float merge_start[XYZE],       // Where the held segment starts
+                   merge_end[XYZE],         // Where the last segment given ends, held or not
+                   merge_fr_mm_s,
+                   merge_error;             // Bound on how far the merged points stray from it
+      static uint8_t merge_extruder;
+    #endif
+
+    #if ENABLED(SEGMENT_TIME_BUDGET)
+      static uint32_t block_interval_us,    // Smoothed time the front end takes to queue a block
+                      last_block_us;        // When the last block was queued, not counting waits for room
+      static bool block_stream;             // Moves are streaming. Cleared when the buffer is drained on purpose.
+      static uint16_t starved_count,        // Times the buffer ran dry mid-stream
+                      slowed_count;         // Segments stretched to the budget
+      static uint8_t fill_actual, fill_actual_min,          // Blocks queued when a block is added
+                     fill_predicted, fill_predicted_min;    // Blocks the front end can queue before the buffer drains
+    #endif
+
   public:
 
     /**
@@ -276,7 +344,33 @@ class Planner {
      *  fr_mm_s   - (target) speed of the move (mm/s)
      *  extruder  - target extruder
      */
-    static void _buffer_line(const float &a, const float &b, const float &c, const float &e, float fr_mm_s, const uint8_t extruder);
+    static FORCE_INLINE void _buffer_line(const float &a, const float &b, const float &c, const float &e, const float &fr_mm_s, const uint8_t extruder) {
+      #if ENABLED(SEGMENT_MERGE)
+        merge_line(a, b, c, e, fr_mm_s, extruder);
+      #else
+        _queue_line(a, b, c, e, fr_mm_s, extruder);
+      #endif
+    }
+
+    #if ENABLED(SEGMENT_MERGE)
+
+      static uint32_t merged_segments;  // Segments joined onto the one before
+
+      /**
+       * Queue the segment held back for merging, if any.
+       * Called before anything that needs the planner to be up to date.
+       */
+      static void flush_merged_segment() {
+        if (merge_pending) {
+          merge_pending = false;
+          _queue_line(merge_end[X_AXIS], merge_end[Y_AXIS], merge_end[Z_AXIS], merge_end[E_AXIS], merge_fr_mm_s, merge_extruder);
+        }
+      }
+
+      // Forget the held segment, as when the steppers are stopped
+      FORCE_INLINE static void discard_merged_segment() { merge_pending = false; }
+
+    #endif
 
     static void _set_position_mm(const float &a, const float &b, const float &c, const float &e);
 
@@ -358,8 +452,15 @@ class Planner {
      * Called when the current block is no longer needed.
      */
     static void discard_current_block() {
-      if (blocks_queued())
-        block_buffer_tail = BLOCK_MOD(block_buffer_tail + 1);
+      if (blocks_queued()) {
+        const uint8_t block_index = block_buffer_tail;
+        // The plan can't start at a block that is gone
+        if (block_index == block_buffer_planned) block_buffer_planned = next_block_index(block_index);
+        #if ENABLED(STEP_SEGMENT_BUFFER)
+          if (block_index == block_buffer_prep) block_buffer_prep = next_block_index(block_index);
+        #endif
+        block_buffer_tail = next_block_index(block_index);
+      }
     }
 
     /**
@@ -369,21 +470,53 @@ class Planner {
     static block_t* get_current_block() {
       if (blocks_queued()) {
         block_t* block = &block_buffer[block_buffer_tail];
-        #if ENABLED(ULTRA_LCD)
+        #if HAS_BLOCK_BUFFER_RUNTIME
           block_buffer_runtime_us -= block->segment_time; //We can't be sure how long an active block will take, so don't count it.
         #endif
         SBI(block->flag, BLOCK_BIT_BUSY);
         return block;
       }
       else {
-        #if ENABLED(ULTRA_LCD)
+        #if HAS_BLOCK_BUFFER_RUNTIME
           clear_block_buffer_runtime(); // paranoia. Buffer is empty now - so reset accumulated time to zero.
         #endif
         return NULL;
       }
     }
 
-    #if ENABLED(ULTRA_LCD)
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+
+      /**
+       * The next block for the step segment generator. NULL if there are none.
+       * This also marks the block as busy.
+       *
+       * Its trapezoid is final from now on, and so is the entry speed of
+       * the block after it, so the plan is settled up to that one.
+       */
+      static block_t* get_prep_block() {
+        if (block_buffer_prep == block_buffer_head) return NULL;
+        block_t* block = &block_buffer[block_buffer_prep];
+        #if HAS_BLOCK_BUFFER_RUNTIME
+          block_buffer_runtime_us -= block->segment_time;
+        #endif
+        SBI(block->flag, BLOCK_BIT_BUSY);
+        CRITICAL_SECTION_START;
+          block_buffer_prep = next_block_index(block_buffer_prep);
+          if (BLOCK_MOD(block_buffer_planned - block_buffer_tail) < BLOCK_MOD(block_buffer_prep - block_buffer_tail))
+            block_buffer_planned = block_buffer_prep;
+        CRITICAL_SECTION_END;
+        return block;
+      }
+
+      /**
+       * Is the last block from get_prep_block() still in the buffer?
+       * Not if the stepper cut it short and discarded it.
+       */
+      static bool prep_block_queued() { return block_buffer_prep != block_buffer_tail; }
+
+    #endif
+
+    #if HAS_BLOCK_BUFFER_RUNTIME
 
       static uint16_t block_buffer_runtime() {
         CRITICAL_SECTION_START
@@ -406,6 +539,20 @@ class Planner {
 
     #endif
 
+    #if ENABLED(SEGMENT_TIME_BUDGET)
+
+      /**
+       * Called when the buffer is drained on purpose (M400, G4, homing...)
+       * or may have drained during a wait (M109, M190, an SD pause), so the
+       * next block to arrive isn't counted as starvation.
+       */
+      FORCE_INLINE static void end_block_stream() { block_stream = false; }
+
+      static void report_segment_budget();
+      static void reset_segment_budget();
+
+    #endif
+
     #if ENABLED(AUTOTEMP)
       static float autotemp_min, autotemp_max, autotemp_factor;
       static bool autotemp_enabled;
@@ -413,6 +560,10 @@ class Planner {
       static void autotemp_M104_M109();
     #endif
 
+    #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+      static float flow_ahead(const uint8_t e, const uint16_t ms);
+    #endif
+
   private:
 
     /**
@@ -452,15 +603,39 @@ class Planner {
       return SQRT(sq(target_velocity) - 2 * accel * distance);
     }
 
-    static void calculate_trapezoid_for_block(block_t* const block, const float &entry_factor, const float &exit_factor);
+    #if ENABLED(PLANNER_FIXED_POINT)
+
+      /**
+       * Squared speeds are kept in (mm/sec)^2 with SPEED_SQR_FRACT fraction
+       * bits. That covers up to 4096mm/s, and a junction speed change is an
+       * addition rather than a square root.
+       */
+      #define SPEED_SQR_FRACT 8
+      static uint32_t speed_sqr(const float &v) { return LROUND(sq(v) * float(1UL << SPEED_SQR_FRACT)); }
+
+      static uint16_t sqrt_u32(uint32_t x);
+
+      static void calculate_trapezoid_for_block(block_t* const block, const uint32_t entry_speed_sqr, const uint32_t exit_speed_sqr);
+
+    #else
+
+      static void calculate_trapezoid_for_block(block_t* const block, const float &entry_factor, const float &exit_factor);
+
+    #endif
+
+    static void _queue_line(const float &a, const float &b, const float &c, const float &e, float fr_mm_s, const uint8_t extruder);
+
+    #if ENABLED(SEGMENT_MERGE)
+      static void merge_line(const float &a, const float &b, const float &c, const float &e, const float &fr_mm_s, const uint8_t extruder);
+    #endif
 
     static void reverse_pass_kernel(block_t* const current, const block_t *next);
-    static void forward_pass_kernel(const block_t *previous, block_t* const current);
+    static bool forward_pass_kernel(const block_t *previous, block_t* const current);
 
-    static void reverse_pass();
-    static void forward_pass();
+    static void reverse_pass(const uint8_t planned);
+    static void forward_pass(uint8_t planned);
 
-    static void recalculate_trapezoids();
+    static void recalculate_trapezoids(const uint8_t planned);
 
     static void recalculate();
 
@@ -67,6 +67,20 @@ Stepper stepper; // Singleton
 #endif
 
 block_t* Stepper::current_block = NULL;  // A pointer to the block currently being traced
+const trapezoid_t* Stepper::current_trapezoid = NULL;
+
+#if ENABLED(STEPPER_ISR_LATENCY)
+  volatile uint16_t Stepper::isr_latency_max = 0;
+#endif
+
+#if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+  volatile bool Stepper::command_start_changed = false;
+  bool Stepper::command_start_from_sd = false;
+  uint32_t Stepper::command_start_sdpos = 0;
+  uint16_t Stepper::command_start_feedrate = 0;
+  bool Stepper::command_start_relative_e = false;
+  long Stepper::command_start_position[NUM_AXIS] = { 0 };
+#endif
 
 #if ENABLED(ABORT_ON_ENDSTOP_HIT_FEATURE_ENABLED)
   bool Stepper::abort_on_endstop_hit = false;
@@ -125,8 +139,35 @@ volatile uint32_t Stepper::step_events_completed = 0; // The number of step even
     return ADV_NEVER;
   }
 
+#elif ENABLED(INPUT_SHAPING)
+
+  uint16_t Stepper::nextMainISR = 0,
+           Stepper::nextShapingISR = 0xFFFF;
+  uint32_t Stepper::shaping_ticks = 0;
+  shaper_t Stepper::shaper[2];
+  float Stepper::shaping_frequency[2] = { SHAPING_FREQ_X, SHAPING_FREQ_Y },
+        Stepper::shaping_zeta[2] = { SHAPING_ZETA_X, SHAPING_ZETA_Y };
+  uint8_t Stepper::shaping_type[2] = { SHAPING_TYPE_X, SHAPING_TYPE_Y };
+
 #endif // LIN_ADVANCE
 
+// A shaped axis sets its DIR pin and steps from shaping_isr()
+#if ENABLED(INPUT_SHAPING)
+  #define SHAPED_X shaper[X_AXIS].active
+  #define SHAPED_Y shaper[Y_AXIS].active
+  #define SHAPE_X_STEP() shape_step(shaper[X_AXIS], count_direction[X_AXIS] < 0)
+  #define SHAPE_Y_STEP() shape_step(shaper[Y_AXIS], count_direction[Y_AXIS] < 0)
+#else
+  #define SHAPED_X false
+  #define SHAPED_Y false
+  #define SHAPE_X_STEP() NOOP
+  #define SHAPE_Y_STEP() NOOP
+#endif
+#define SHAPED_Z false
+#define SHAPED_E false
+#define SHAPE_Z_STEP() NOOP
+#define SHAPE_E_STEP() NOOP
+
 long Stepper::acceleration_time, Stepper::deceleration_time;
 
 volatile long Stepper::count_position[NUM_AXIS] = { 0 };
@@ -138,10 +179,27 @@ volatile signed char Stepper::count_direction[NUM_AXIS] = { 1, 1, 1, 1 };
 
 unsigned short Stepper::acc_step_rate; // needed for deceleration start point
 uint8_t Stepper::step_loops, Stepper::step_loops_nominal;
+#if ENABLED(UNIFORM_STEP_PULSES)
+  uint16_t Stepper::step_spacing;
+  uint8_t Stepper::uniform_steps;
+#endif
 unsigned short Stepper::OCR1A_nominal;
 
 volatile long Stepper::endstops_trigsteps[XYZ];
 
+#if ENABLED(STEP_SEGMENT_BUFFER)
+  step_segment_t Stepper::segment_buffer[STEP_SEGMENT_BUFFER_SIZE];
+  volatile uint8_t Stepper::segment_buffer_head = 0,
+                   Stepper::segment_buffer_tail = 0;
+  uint16_t Stepper::segment_interval, Stepper::segment_isrs = 0;
+  uint8_t Stepper::segment_loops;
+  block_t* Stepper::prep_block = NULL;
+  const trapezoid_t* Stepper::prep_trapezoid;
+  uint32_t Stepper::prep_events;
+  uint16_t Stepper::prep_interval;
+  volatile bool Stepper::prepping = false;
+#endif
+
 #if ENABLED(X_DUAL_STEPPER_DRIVERS)
   #define X_APPLY_DIR(v,Q) do{ X_DIR_WRITE(v); X2_DIR_WRITE((v) != INVERT_X2_VS_X_DIR); }while(0)
   #define X_APPLY_STEP(v,Q) do{ X_STEP_WRITE(v); X2_STEP_WRITE(v); }while(0)
@@ -205,61 +263,91 @@ volatile long Stepper::endstops_trigsteps[XYZ];
   #define E_APPLY_STEP(v,Q) E_STEP_WRITE(v)
 #endif
 
-// intRes = longIn1 * longIn2 >> 24
-// uses:
-// r26 to store 0
-// r27 to store bits 16-23 of the 48bit result. The top bit is used to round the two byte result.
-// note that the lower two bytes and the upper byte of the 48bit result are not calculated.
-// this can cause the result to be out by one as the lower bytes may cause carries into the upper ones.
-// B0 A0 are bits 24-39 and are the returned value
-// C1 B1 A1 is longIn1
-// D2 C2 B2 A2 is longIn2
-//
-#define MultiU24X32toH16(intRes, longIn1, longIn2) \
-  asm volatile ( \
-                 "clr r26 \n\t" \
-                 "mul %A1, %B2 \n\t" \
-                 "mov r27, r1 \n\t" \
-                 "mul %B1, %C2 \n\t" \
-                 "movw %A0, r0 \n\t" \
-                 "mul %C1, %C2 \n\t" \
-                 "add %B0, r0 \n\t" \
-                 "mul %C1, %B2 \n\t" \
-                 "add %A0, r0 \n\t" \
-                 "adc %B0, r1 \n\t" \
-                 "mul %A1, %C2 \n\t" \
-                 "add r27, r0 \n\t" \
-                 "adc %A0, r1 \n\t" \
-                 "adc %B0, r26 \n\t" \
-                 "mul %B1, %B2 \n\t" \
-                 "add r27, r0 \n\t" \
-                 "adc %A0, r1 \n\t" \
-                 "adc %B0, r26 \n\t" \
-                 "mul %C1, %A2 \n\t" \
-                 "add r27, r0 \n\t" \
-                 "adc %A0, r1 \n\t" \
-                 "adc %B0, r26 \n\t" \
-                 "mul %B1, %A2 \n\t" \
-                 "add r27, r1 \n\t" \
-                 "adc %A0, r26 \n\t" \
-                 "adc %B0, r26 \n\t" \
-                 "lsr r27 \n\t" \
-                 "adc %A0, r26 \n\t" \
-                 "adc %B0, r26 \n\t" \
-                 "mul %D2, %A1 \n\t" \
-                 "add %A0, r0 \n\t" \
-                 "adc %B0, r1 \n\t" \
-                 "mul %D2, %B1 \n\t" \
-                 "add %B0, r0 \n\t" \
-                 "clr r1 \n\t" \
-                 : \
-                 "=&r" (intRes) \
-                 : \
-                 "d" (longIn1), \
-                 "d" (longIn2) \
-                 : \
-                 "r26" , "r27" \
-               )
+#ifdef __MARLIN_NATIVE__
+
+  // Host build: the same partial products, carries and rounding as the
+  // AVR code below, so the native simulator sees identical step rates.
+  static FORCE_INLINE uint16_t MultiU24X32toH16_C(const uint32_t longIn1, const uint32_t longIn2) {
+    const uint8_t a1 = longIn1, b1 = longIn1 >> 8, c1 = longIn1 >> 16,
+                  a2 = longIn2, b2 = longIn2 >> 8, c2 = longIn2 >> 16, d2 = longIn2 >> 24;
+    uint8_t r27 = (uint16_t)(a1 * b2) >> 8;
+    uint16_t intRes = b1 * c2, p, s;
+    intRes += (uint16_t)(c1 * c2) << 8;
+    intRes += c1 * b2;
+    #define _ADD_R27(P) do{ p = P; s = r27 + (uint8_t)p; r27 = s; intRes += (p >> 8) + (s >> 8); }while(0)
+    _ADD_R27(a1 * c2);
+    _ADD_R27(b1 * b2);
+    _ADD_R27(c1 * a2);
+    #undef _ADD_R27
+    s = r27 + ((uint16_t)(b1 * a2) >> 8);
+    r27 = s;
+    intRes += s >> 8;
+    intRes += r27 & 1;
+    intRes += d2 * a1;
+    intRes += (uint16_t)(d2 * b1) << 8;
+    return intRes;
+  }
+  #define MultiU24X32toH16(intRes, longIn1, longIn2) intRes = MultiU24X32toH16_C(longIn1, longIn2)
+
+#else
+
+  // intRes = longIn1 * longIn2 >> 24
+  // uses:
+  // r26 to store 0
+  // r27 to store bits 16-23 of the 48bit result. The top bit is used to round the two byte result.
+  // note that the lower two bytes and the upper byte of the 48bit result are not calculated.
+  // this can cause the result to be out by one as the lower bytes may cause carries into the upper ones.
+  // B0 A0 are bits 24-39 and are the returned value
+  // C1 B1 A1 is longIn1
+  // D2 C2 B2 A2 is longIn2
+  //
+  #define MultiU24X32toH16(intRes, longIn1, longIn2) \
+    asm volatile ( \
+                   "clr r26 \n\t" \
+                   "mul %A1, %B2 \n\t" \
+                   "mov r27, r1 \n\t" \
+                   "mul %B1, %C2 \n\t" \
+                   "movw %A0, r0 \n\t" \
+                   "mul %C1, %C2 \n\t" \
+                   "add %B0, r0 \n\t" \
+                   "mul %C1, %B2 \n\t" \
+                   "add %A0, r0 \n\t" \
+                   "adc %B0, r1 \n\t" \
+                   "mul %A1, %C2 \n\t" \
+                   "add r27, r0 \n\t" \
+                   "adc %A0, r1 \n\t" \
+                   "adc %B0, r26 \n\t" \
+                   "mul %B1, %B2 \n\t" \
+                   "add r27, r0 \n\t" \
+                   "adc %A0, r1 \n\t" \
+                   "adc %B0, r26 \n\t" \
+                   "mul %C1, %A2 \n\t" \
+                   "add r27, r0 \n\t" \
+                   "adc %A0, r1 \n\t" \
+                   "adc %B0, r26 \n\t" \
+                   "mul %B1, %A2 \n\t" \
+                   "add r27, r1 \n\t" \
+                   "adc %A0, r26 \n\t" \
+                   "adc %B0, r26 \n\t" \
+                   "lsr r27 \n\t" \
+                   "adc %A0, r26 \n\t" \
+                   "adc %B0, r26 \n\t" \
+                   "mul %D2, %A1 \n\t" \
+                   "add %A0, r0 \n\t" \
+                   "adc %B0, r1 \n\t" \
+                   "mul %D2, %B1 \n\t" \
+                   "add %B0, r0 \n\t" \
+                   "clr r1 \n\t" \
+                   : \
+                   "=&r" (intRes) \
+                   : \
+                   "d" (longIn1), \
+                   "d" (longIn2) \
+                   : \
+                   "r26" , "r27" \
+                 )
+
+#endif
 
 // Some useful constants
 
@@ -278,9 +366,9 @@ volatile long Stepper::endstops_trigsteps[XYZ];
  *
  *                           time ----->
  *
- *  The trapezoid is the shape the speed curve over time. It starts at block->initial_rate, accelerates
- *  first block->accelerate_until step_events_completed, then keeps going at constant speed until
- *  step_events_completed reaches block->decelerate_after after which it decelerates until the trapezoid generator is reset.
+ *  The trapezoid is the shape the speed curve over time. It starts at trapezoid->initial_rate, accelerates
+ *  first trapezoid->accelerate_until step_events_completed, then keeps going at constant speed until
+ *  step_events_completed reaches trapezoid->decelerate_after after which it decelerates until the trapezoid generator is reset.
  *  The slope of acceleration is calculated using v = u + at where t is the accumulated timer values of the steps so far.
  */
 void Stepper::wake_up() {
@@ -299,11 +387,11 @@ void Stepper::set_directions() {
 
   #define SET_STEP_DIR(AXIS) \
     if (motor_direction(AXIS ##_AXIS)) { \
-      AXIS ##_APPLY_DIR(INVERT_## AXIS ##_DIR, false); \
+      if (!SHAPED_## AXIS) AXIS ##_APPLY_DIR(INVERT_## AXIS ##_DIR, false); \
       count_direction[AXIS ##_AXIS] = -1; \
     } \
     else { \
-      AXIS ##_APPLY_DIR(!INVERT_## AXIS ##_DIR, false); \
+      if (!SHAPED_## AXIS) AXIS ##_APPLY_DIR(!INVERT_## AXIS ##_DIR, false); \
       count_direction[AXIS ##_AXIS] = 1; \
     }
 
@@ -348,13 +436,73 @@ void Stepper::set_directions() {
  *  4000   500  Hz - init rate
  */
 ISR(TIMER1_COMPA_vect) {
+  #if ENABLED(STEPPER_ISR_LATENCY)
+    // Timer1 restarts from 0 on the compare match, so it counts the delay
+    const uint16_t latency = TCNT1;
+    if (latency > Stepper::isr_latency_max) Stepper::isr_latency_max = latency;
+  #endif
   #if ENABLED(LIN_ADVANCE)
     Stepper::advance_isr_scheduler();
+  #elif ENABLED(INPUT_SHAPING)
+    Stepper::shaping_isr_scheduler();
   #else
     Stepper::isr();
   #endif
 }
 
+FORCE_INLINE uint16_t Stepper::ramp_up_rate(const block_t* const block, const trapezoid_t* const trap) {
+  uint16_t step_rate;
+  #if ENABLED(S_CURVE_ACCELERATION)
+    step_rate = (uint32_t)acceleration_time < trap->acceleration_time
+      ? trap->initial_rate + s_curve_rate(acceleration_time, trap->acceleration_time_inverse, trap->cruise_rate - trap->initial_rate)
+      : trap->cruise_rate;
+  #else
+    MultiU24X32toH16(step_rate, acceleration_time, block->acceleration_rate);
+    step_rate += trap->initial_rate;
+  #endif
+
+  // upper limit
+  NOMORE(step_rate, block->nominal_rate);
+  return step_rate;
+}
+
+FORCE_INLINE uint16_t Stepper::ramp_down_rate(const block_t* const block, const trapezoid_t* const trap) {
+  uint16_t step_rate;
+  #if ENABLED(S_CURVE_ACCELERATION)
+    UNUSED(block);
+    // Brake from the cruise rate, which acc_step_rate reached unless the block was cut short
+    if ((uint32_t)deceleration_time < trap->deceleration_time) {
+      step_rate = trap->cruise_rate - s_curve_rate(deceleration_time, trap->deceleration_time_inverse, trap->cruise_rate - trap->final_rate);
+      NOMORE(step_rate, acc_step_rate);
+      NOLESS(step_rate, trap->final_rate);
+    }
+    else
+      step_rate = trap->final_rate;
+  #else
+    MultiU24X32toH16(step_rate, deceleration_time, block->acceleration_rate);
+
+    if (step_rate < acc_step_rate) { // Still decelerating?
+      step_rate = acc_step_rate - step_rate;
+      NOLESS(step_rate, trap->final_rate);
+    }
+    else
+      step_rate = trap->final_rate;
+  #endif
+  return step_rate;
+}
+
+#if ENABLED(INPUT_SHAPING)
+
+  // Log a block step, and owe its first impulse right away
+  FORCE_INLINE void Stepper::shape_step(shaper_t &s, const bool backward) {
+    s.history[s.head] = ((uint16_t)(shaping_ticks >> 2) & ~1) | backward;
+    s.head = SHAPING_MOD(s.head + 1);
+    s.owed += backward ? -s.amplitude[0] : s.amplitude[0];
+    nextShapingISR = 0;
+  }
+
+#endif
+
 #define _ENABLE_ISRs() do { cli(); if (thermalManager.in_temp_isr) CBI(TIMSK0, OCIE0B); else SBI(TIMSK0, OCIE0B); ENABLE_STEPPER_DRIVER_INTERRUPT(); } while(0)
 
 void Stepper::isr() {
@@ -364,7 +512,7 @@ void Stepper::isr() {
   #define ENDSTOP_NOMINAL_OCR_VAL 3000    // check endstops every 1.5ms to guarantee two stepper ISRs within 5ms for BLTouch
   #define OCR_VAL_TOLERANCE 1000          // First max delay is 2.0ms, last min delay is 0.5ms, all others 1.5ms
 
-  #if DISABLED(LIN_ADVANCE)
+  #if DISABLED(LIN_ADVANCE) && DISABLED(INPUT_SHAPING)
     // Disable Timer0 ISRs and enable global ISR again to capture UART events (incoming chars)
     CBI(TIMSK0, OCIE0B); // Temperature ISR
     DISABLE_STEPPER_DRIVER_INTERRUPT();
@@ -386,7 +534,7 @@ void Stepper::isr() {
     }while(0)
 
     if (step_remaining && ENDSTOPS_ENABLED) {   // Just check endstops - not yet time for a step
-      endstops.update();
+      if (current_block) endstops.update();     // The block may have ended (or been stopped) already
       if (step_remaining > ENDSTOP_NOMINAL_OCR_VAL) {
         step_remaining -= ENDSTOP_NOMINAL_OCR_VAL;
         ocr_val = ENDSTOP_NOMINAL_OCR_VAL;
@@ -409,6 +557,10 @@ void Stepper::isr() {
     --cleaning_buffer_counter;
     current_block = NULL;
     planner.discard_current_block();
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+      segment_buffer_tail = segment_buffer_head;
+      segment_isrs = 0;
+    #endif
     #ifdef SD_FINISHED_RELEASECOMMAND
       if (!cleaning_buffer_counter && (SD_FINISHED_STEPPERRELEASE)) enqueue_and_echo_commands_P(PSTR(SD_FINISHED_RELEASECOMMAND));
     #endif
@@ -420,12 +572,63 @@ void Stepper::isr() {
   // If there is no current block, attempt to pop one from the buffer
   if (!current_block) {
     // Anything in the buffer?
-    current_block = planner.get_current_block();
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+      // Skip what is left of a block that an endstop cut short
+      while (segment_buffer_tail != segment_buffer_head && !segment_buffer[segment_buffer_tail].first)
+        segment_buffer_tail = SEGMENT_MOD(segment_buffer_tail + 1);
+      // Don't stop at a block boundary because the main loop is held up
+      if (segment_buffer_tail == segment_buffer_head && !prepping) prep_segment();
+      #define NEXT_BLOCK_QUEUED (segment_buffer_tail != segment_buffer_head)
+    #else
+      #define NEXT_BLOCK_QUEUED planner.blocks_queued()
+    #endif
+
+    #if ENABLED(INPUT_SHAPING)
+      // Homing moves skip the shaper, so the endstops stop the motors where
+      // the block steps say. Switch over once the shaped steps are all out,
+      // before the next block is taken from the planner.
+      if (NEXT_BLOCK_QUEUED) LOOP_L_N(i, 2) {
+        shaper_t &s = shaper[i];
+        const bool on = s.impulses && !ENDSTOPS_ENABLED;
+        if (on != s.active) {
+          if (shaping_busy(s)) {
+            _NEXT_ISR(200); // Check again soon - 10 KHz
+            _ENABLE_ISRs(); // re-enable ISRs
+            return;
+          }
+          s.active = on;
+          s.backward = motor_direction((AxisEnum)i);
+          s.position = count_position[i];
+          set_directions();
+        }
+      }
+    #endif
+
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+      current_block = NEXT_BLOCK_QUEUED ? segment_buffer[segment_buffer_tail].block : NULL;
+    #else
+      current_block = planner.get_current_block();
+    #endif
+    #undef NEXT_BLOCK_QUEUED
+
     if (current_block) {
       trapezoid_generator_reset();
 
+      #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+        // The first block of a new command: note where it starts
+        const bool from_sd = TEST(current_block->flag, BLOCK_BIT_FROM_SD);
+        if (from_sd != command_start_from_sd || (from_sd && current_block->sdpos != command_start_sdpos)) {
+          command_start_from_sd = from_sd;
+          command_start_sdpos = current_block->sdpos;
+          command_start_feedrate = current_block->feedrate;
+          command_start_relative_e = TEST(current_block->flag, BLOCK_BIT_RELATIVE_E);
+          LOOP_NA(i) command_start_position[i] = count_position[i];
+          command_start_changed = true;
+        }
+      #endif
+
       // Initialize Bresenham counters to 1/2 the ceiling
-      counter_X = counter_Y = counter_Z = counter_E = -(current_block->step_event_count >> 1);
+      counter_X = counter_Y = counter_Z = counter_E = -(long)(current_block->step_event_count >> 1);
 
       #if ENABLED(MIXING_EXTRUDER)
         MIXING_STEPPERS_LOOP(i)
@@ -434,6 +637,10 @@ void Stepper::isr() {
 
       step_events_completed = 0;
 
+      #if ENABLED(UNIFORM_STEP_PULSES)
+        uniform_steps = 0;
+      #endif
+
       #if ENABLED(ENDSTOP_INTERRUPTS_FEATURE)
         e_hit = 2; // Needed for the case an endstop is already triggered before the new move begins.
                    // No 'change' can be detected.
@@ -455,6 +662,28 @@ void Stepper::isr() {
     }
   }
 
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+    // Start on the next segment
+    if (!segment_isrs
+      #if ENABLED(UNIFORM_STEP_PULSES)
+        && !uniform_steps // The last ISR period of a segment may not be over yet
+      #endif
+    ) {
+      // If prep_segments() fell behind, cut the next segment here, as the ISR
+      // would work out the rate without segments. While it's cutting one, wait.
+      if (segment_buffer_tail == segment_buffer_head && (prepping || !prep_segment())) {
+        _NEXT_ISR(200); // Check again soon - 10 KHz
+        _ENABLE_ISRs(); // re-enable ISRs
+        return;
+      }
+      const step_segment_t &segment = segment_buffer[segment_buffer_tail];
+      segment_interval = segment.interval;
+      segment_isrs = segment.isrs;
+      segment_loops = segment.loops;
+      segment_buffer_tail = SEGMENT_MOD(segment_buffer_tail + 1);
+    }
+  #endif
+
   // Update endstops state, if enabled
   #if ENABLED(ENDSTOP_INTERRUPTS_FEATURE)
     if (e_hit && ENDSTOPS_ENABLED) {
@@ -467,7 +696,26 @@ void Stepper::isr() {
 
   // Take multiple steps per interrupt (For high speed moves)
   bool all_steps_done = false;
-  for (uint8_t i = step_loops; i--;) {
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+    #define ISR_STEP_LOOPS segment_loops
+  #else
+    #define ISR_STEP_LOOPS step_loops
+  #endif
+  #if ENABLED(INPUT_SHAPING)
+    // Hold the steps back until the shapers have room to log them
+    if ((SHAPED_X && current_block->steps[X_AXIS] && shaping_room(shaper[X_AXIS]) < ISR_STEP_LOOPS)
+     || (SHAPED_Y && current_block->steps[Y_AXIS] && shaping_room(shaper[Y_AXIS]) < ISR_STEP_LOOPS)) {
+      _NEXT_ISR(200); // Check again soon - 10 KHz
+      _ENABLE_ISRs(); // re-enable ISRs
+      return;
+    }
+  #endif
+  #if ENABLED(UNIFORM_STEP_PULSES)
+    #define ISR_STEPS (ISR_STEP_LOOPS > 1 ? ISR_STEP_LOOPS >> 1 : 1) // The other half of the period gets an ISR of its own
+  #else
+    #define ISR_STEPS ISR_STEP_LOOPS
+  #endif
+  for (uint8_t i = ISR_STEPS; i--;) {
     #if ENABLED(LIN_ADVANCE)
 
       counter_E += current_block->steps[E_AXIS];
@@ -501,14 +749,16 @@ void Stepper::isr() {
     // Advance the Bresenham counter; start a pulse if the axis needs a step
     #define PULSE_START(AXIS) \
       _COUNTER(AXIS) += current_block->steps[_AXIS(AXIS)]; \
-      if (_COUNTER(AXIS) > 0) { _APPLY_STEP(AXIS)(!_INVERT_STEP_PIN(AXIS),0); }
+      if (_COUNTER(AXIS) > 0 && !SHAPED_## AXIS) { _APPLY_STEP(AXIS)(!_INVERT_STEP_PIN(AXIS),0); }
 
-    // Stop an active pulse, reset the Bresenham counter, update the position
+    // Stop an active pulse, reset the Bresenham counter, update the position.
+    // A shaped axis logs the step for shaping_isr() instead.
     #define PULSE_STOP(AXIS) \
       if (_COUNTER(AXIS) > 0) { \
         _COUNTER(AXIS) -= current_block->step_event_count; \
         count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
-        _APPLY_STEP(AXIS)(_INVERT_STEP_PIN(AXIS),0); \
+        if (SHAPED_## AXIS) SHAPE_## AXIS ##_STEP(); \
+        else _APPLY_STEP(AXIS)(_INVERT_STEP_PIN(AXIS),0); \
       }
 
     /**
@@ -674,14 +924,29 @@ void Stepper::isr() {
 
   #endif // LIN_ADVANCE
 
-  // Calculate new timer value
-  if (step_events_completed <= (uint32_t)current_block->accelerate_until) {
+  #if ENABLED(UNIFORM_STEP_PULSES)
+    // The second half of the period. The step rate stays as it is.
+    if (uniform_steps && !all_steps_done) {
+      --uniform_steps;
+      _NEXT_ISR(step_spacing);
+    }
+    else {
+      uniform_steps = 0;
+  #endif
 
-    MultiU24X32toH16(acc_step_rate, acceleration_time, current_block->acceleration_rate);
-    acc_step_rate += current_block->initial_rate;
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+
+    // The timer value comes with the segment
+    SPLIT(segment_interval);  // split step into multiple ISRs if larger than  ENDSTOP_NOMINAL_OCR_VAL
+    _NEXT_ISR(ocr_val);
+    --segment_isrs;
+
+  #else // !STEP_SEGMENT_BUFFER
+
+  // Calculate new timer value
+  if (step_events_completed <= (uint32_t)current_trapezoid->accelerate_until) {
 
-    // upper limit
-    NOMORE(acc_step_rate, current_block->nominal_rate);
+    acc_step_rate = ramp_up_rate(current_block, current_trapezoid);
 
     // step_rate to timer interval
     const uint16_t timer = calc_timer(acc_step_rate);
@@ -705,16 +970,8 @@ void Stepper::isr() {
 
     #endif // LIN_ADVANCE
   }
-  else if (step_events_completed > (uint32_t)current_block->decelerate_after) {
-    uint16_t step_rate;
-    MultiU24X32toH16(step_rate, deceleration_time, current_block->acceleration_rate);
-
-    if (step_rate < acc_step_rate) { // Still decelerating?
-      step_rate = acc_step_rate - step_rate;
-      NOLESS(step_rate, current_block->final_rate);
-    }
-    else
-      step_rate = current_block->final_rate;
+  else if (step_events_completed > (uint32_t)current_trapezoid->decelerate_after) {
+    const uint16_t step_rate = ramp_down_rate(current_block, current_trapezoid);
 
     // step_rate to timer interval
     const uint16_t timer = calc_timer(step_rate);
@@ -756,7 +1013,21 @@ void Stepper::isr() {
     step_loops = step_loops_nominal;
   }
 
-  #if DISABLED(LIN_ADVANCE)
+  #endif // !STEP_SEGMENT_BUFFER
+
+  #if ENABLED(UNIFORM_STEP_PULSES)
+      // Split the period in two, with half the steps at the start of each
+      // half, so the ISR runs at most twice per period. The first half takes
+      // the odd tick.
+      if (ISR_STEP_LOOPS > 1 && !all_steps_done) {
+        uniform_steps = 1;
+        step_spacing = ocr_val >> 1;
+        _NEXT_ISR(ocr_val - step_spacing);
+      }
+    }
+  #endif
+
+  #if DISABLED(LIN_ADVANCE) && DISABLED(INPUT_SHAPING)
     NOLESS(OCR1A, TCNT1 + 16);
   #endif
 
@@ -764,12 +1035,119 @@ void Stepper::isr() {
   if (all_steps_done) {
     current_block = NULL;
     planner.discard_current_block();
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+      segment_isrs = 0; // An endstop may have ended the block mid-segment
+    #endif
   }
-  #if DISABLED(LIN_ADVANCE)
+  #if DISABLED(LIN_ADVANCE) && DISABLED(INPUT_SHAPING)
     _ENABLE_ISRs(); // re-enable ISRs
   #endif
 }
 
+#if ENABLED(STEP_SEGMENT_BUFFER)
+
+  // Stepper ISRs to fill a segment, without running far past 'events'
+  static FORCE_INLINE uint16_t segment_isr_count(const uint16_t timer, const uint32_t events, const uint8_t loops) {
+    const uint16_t isrs = (STEP_SEGMENT_TICKS) / timer;
+    const uint32_t most = (events + loops - 1) / loops;
+    return isrs ? (isrs < most ? isrs : most) : 1;
+  }
+
+  /**
+   * Cut the queued blocks into segments of constant step rate until the
+   * segment buffer is full. This does the trapezoid math the stepper ISR
+   * would otherwise do for every step, once per segment. Each ramp segment
+   * runs at the rate from halfway through it.
+   */
+  void Stepper::prep_segments() {
+    // Let quick_stop() finish clearing out the buffers
+    CRITICAL_SECTION_START;
+      const bool cleaning = cleaning_buffer_counter;
+    CRITICAL_SECTION_END;
+    if (cleaning) return;
+
+    prepping = true;
+    while (prep_segment()) { /* nada */ }
+    prepping = false;
+  }
+
+  /**
+   * Cut one segment, from the main loop or, when the main loop is held up
+   * (SD card, long G-code, EEPROM write), from the stepper ISR. Returns
+   * false if the buffer is full or there's nothing left to cut.
+   */
+  bool Stepper::prep_segment() {
+    const uint8_t next_head = SEGMENT_MOD(segment_buffer_head + 1);
+    if (next_head == segment_buffer_tail) return false; // The buffer is full
+
+    // An endstop may have ended the block already
+    if (prep_block && !planner.prep_block_queued()) prep_block = NULL;
+
+    if (!prep_block) {
+      prep_block = planner.get_prep_block();
+      if (!prep_block) return false;
+      // Keep to the trapezoid published when the block was taken
+      prep_trapezoid = &prep_block->trapezoid[prep_block->trapezoid_index];
+      prep_events = 0;
+      acceleration_time = deceleration_time = 0;
+      acc_step_rate = prep_trapezoid->initial_rate;
+      OCR1A_nominal = calc_timer(prep_block->nominal_rate);
+      step_loops_nominal = step_loops;
+      // Size the first segment by the time the ramp takes for one step.
+      // Starting from rest, the initial rate would size it much too long.
+      prep_interval = calc_timer(min(0.5f * (acc_step_rate + SQRT(sq(float(acc_step_rate)) + 2.0f * prep_block->acceleration_steps_per_s2)), float(prep_block->nominal_rate)));
+    }
+
+    const uint32_t events_left = prep_block->step_event_count - prep_events;
+    uint16_t timer, isrs;
+
+    // Ramp segments are sized at the rate of the segment before
+    if (prep_events <= (uint32_t)prep_trapezoid->accelerate_until) {
+      const uint32_t start = acceleration_time, ramp_left = prep_trapezoid->accelerate_until + 1 - prep_events;
+      isrs = segment_isr_count(prep_interval, ramp_left, step_loops);
+      acceleration_time = start + ((uint32_t)prep_interval * isrs >> 1);
+      timer = calc_timer(ramp_up_rate(prep_block, prep_trapezoid));
+      acceleration_time = start + (uint32_t)timer * isrs;
+      if ((uint32_t)isrs * step_loops >= ramp_left)
+        acc_step_rate = ramp_up_rate(prep_block, prep_trapezoid); // Braking starts from the end of the ramp
+    }
+    else if (prep_events > (uint32_t)prep_trapezoid->decelerate_after) {
+      const uint32_t start = deceleration_time;
+      isrs = segment_isr_count(prep_interval, events_left, step_loops);
+      deceleration_time = start + ((uint32_t)prep_interval * isrs >> 1);
+      timer = calc_timer(ramp_down_rate(prep_block, prep_trapezoid));
+      deceleration_time = start + (uint32_t)timer * isrs;
+    }
+    else {
+      timer = OCR1A_nominal;
+      step_loops = step_loops_nominal;
+      isrs = segment_isr_count(timer, prep_trapezoid->decelerate_after + 1 - prep_events, step_loops);
+    }
+
+    prep_interval = timer;
+
+    step_segment_t &segment = segment_buffer[segment_buffer_head];
+    segment.block = prep_block;
+    segment.interval = timer;
+    segment.loops = step_loops;
+    segment.first = !prep_events;
+
+    const uint32_t events = (uint32_t)isrs * step_loops;
+    if (events < events_left)
+      prep_events += events;
+    else {
+      isrs = (events_left + step_loops - 1) / step_loops;
+      prep_block = NULL; // All of the block is in segments
+    }
+    segment.isrs = isrs;
+
+    __asm__ __volatile__ ("" ::: "memory"); // All of the above before the ISR can see it
+    segment_buffer_head = next_head;
+    return true;
+  }
+
+#endif // STEP_SEGMENT_BUFFER
+
 #if ENABLED(LIN_ADVANCE)
 
   #define CYCLES_EATEN_E (E_STEPPERS * 5)
@@ -906,6 +1284,186 @@ void Stepper::isr() {
 
 #endif // LIN_ADVANCE
 
+#if ENABLED(INPUT_SHAPING)
+
+  /**
+   * Add the impulses of logged steps that have come due to what the motor
+   * owes, and lower 'next' to the timer ticks until the next one is due.
+   * Return the direction of a step the motor owes (1 = backward), or -1.
+   */
+  FORCE_INLINE int8_t Stepper::shaper_update(shaper_t &s, const uint16_t now, uint32_t &next) {
+    for (uint8_t k = 1; k < s.impulses; k++) {
+      uint8_t &t = s.tail[k - 1];
+      while (t != s.head) {
+        const uint16_t h = s.history[t],
+                       elapsed = (uint16_t)(now - (h & ~1)) >> 1;
+        if (elapsed < s.delay[k]) {
+          NOMORE(next, (uint32_t)(s.delay[k] - elapsed) << 3);
+          break;
+        }
+        s.owed += TEST(h, 0) ? -s.amplitude[k] : s.amplitude[k];
+        t = SHAPING_MOD(t + 1);
+      }
+    }
+    // Round to the nearest step. Half a step goes forward, so a step either way stays put.
+    if (s.owed >= SHAPING_UNIT / 2) { s.owed -= SHAPING_UNIT; return 0; }
+    if (s.owed < -(SHAPING_UNIT / 2)) { s.owed += SHAPING_UNIT; return 1; }
+    return -1;
+  }
+
+  /**
+   * Step the shaped axes as their impulses come due, one step per axis at
+   * a time, and work out when to run again
+   */
+  void Stepper::shaping_isr() {
+    const uint16_t now = (uint16_t)(shaping_ticks >> 2) & ~1;
+    uint32_t next = 0xFFFF;
+
+    const int8_t x_dir = SHAPED_X ? shaper_update(shaper[X_AXIS], now, next) : -1,
+                 y_dir = SHAPED_Y ? shaper_update(shaper[Y_AXIS], now, next) : -1;
+
+    // Set the DIR pins ahead of the pulses
+    #define SHAPING_DIR(AXIS, D) \
+      if (D >= 0 && D != shaper[_AXIS(AXIS)].backward) { \
+        shaper[_AXIS(AXIS)].backward = D; \
+        AXIS ##_APPLY_DIR(D ? INVERT_## AXIS ##_DIR : !INVERT_## AXIS ##_DIR, false); \
+      }
+    SHAPING_DIR(X, x_dir);
+    SHAPING_DIR(Y, y_dir);
+
+    #if EXTRA_CYCLES_XYZE > 20
+      const uint32_t pulse_start = TCNT0;
+    #endif
+
+    if (x_dir >= 0) X_APPLY_STEP(!INVERT_X_STEP_PIN, 0);
+    if (y_dir >= 0) Y_APPLY_STEP(!INVERT_Y_STEP_PIN, 0);
+
+    // For minimum pulse time wait before stopping pulses
+    #if EXTRA_CYCLES_XYZE > 20
+      while (EXTRA_CYCLES_XYZE > (uint32_t)(TCNT0 - pulse_start) * (INT0_PRESCALER)) { /* nada */ }
+    #elif EXTRA_CYCLES_XYZE > 0
+      DELAY_NOPS(EXTRA_CYCLES_XYZE);
+    #endif
+
+    if (x_dir >= 0) {
+      X_APPLY_STEP(INVERT_X_STEP_PIN, 0);
+      shaper[X_AXIS].position += x_dir ? -1 : 1;
+    }
+    if (y_dir >= 0) {
+      Y_APPLY_STEP(INVERT_Y_STEP_PIN, 0);
+      shaper[Y_AXIS].position += y_dir ? -1 : 1;
+    }
+
+    // Owed steps that didn't fit go out at the highest step rate
+    #define SHAPING_OWES(AXIS) (SHAPED_## AXIS && !WITHIN(shaper[_AXIS(AXIS)].owed, -(SHAPING_UNIT / 2), SHAPING_UNIT / 2 - 1))
+    if (SHAPING_OWES(X) || SHAPING_OWES(Y)) NOMORE(next, (F_CPU) / 8 / (MAX_STEP_FREQUENCY));
+
+    nextShapingISR = next;
+  }
+
+  /**
+   * Run the stepper ISR and the shaping ISR each when due, and set
+   * the timer for whichever comes next
+   */
+  void Stepper::shaping_isr_scheduler() {
+    // Disable Timer0 ISRs and enable global ISR again to capture UART events (incoming chars)
+    CBI(TIMSK0, OCIE0B); // Temperature ISR
+    DISABLE_STEPPER_DRIVER_INTERRUPT();
+    sei();
+
+    if (!nextMainISR) isr();
+    if (!nextShapingISR) shaping_isr();
+
+    if (nextShapingISR <= nextMainISR) {
+      OCR1A = nextShapingISR;
+      nextMainISR -= nextShapingISR;
+      nextShapingISR = 0;
+    }
+    else {
+      OCR1A = nextMainISR;
+      nextShapingISR -= nextMainISR;
+      nextMainISR = 0;
+    }
+
+    // Don't run the ISR faster than possible
+    NOLESS(OCR1A, TCNT1 + 16);
+
+    // Timer 1 restarts on the match, so this is the time to the next ISR
+    shaping_ticks += OCR1A;
+
+    // Restore original ISR settings
+    _ENABLE_ISRs();
+  }
+
+  /**
+   * Work out the impulses of each shaper from its settings. Logged steps
+   * need the impulses they started with, so first let the motors catch up.
+   * The X and Y max feedrates come down to what the shapers can keep up
+   * with, so the planner never asks for steps the ISR would hold back.
+   */
+  void Stepper::update_shaping() {
+    synchronize();
+    LOOP_L_N(i, 2) {
+      const float zeta = shaping_zeta[i];
+      float a[3], t[3] = { 0 }, // Impulse sizes, and times in ringing periods
+            period = 0;         // The ringing period, in 8-tick units
+      uint8_t n = 0;
+      if (shaping_frequency[i] > 0) {
+        const float df = SQRT(1 - sq(zeta));
+        period = (F_CPU) / 64 / (shaping_frequency[i] * df);
+        switch (shaping_type[i]) {
+          default: { // ZV
+            const float K = exp(-zeta * M_PI / df);
+            n = 2;
+            a[0] = 1; a[1] = K;
+            t[1] = 0.5;
+          } break;
+          case 1: { // ZVD
+            const float K = exp(-zeta * M_PI / df);
+            n = 3;
+            a[0] = 1; a[1] = 2 * K; a[2] = sq(K);
+            t[1] = 0.5; t[2] = 1;
+          } break;
+          case 2: { // MZV
+            const float K = exp(-0.75 * zeta * M_PI / df), a1 = 1 - M_SQRT1_2;
+            n = 3;
+            a[0] = a1; a[1] = (M_SQRT2 - 1) * K; a[2] = a1 * sq(K);
+            t[1] = 0.375; t[2] = 0.75;
+          } break;
+        }
+      }
+
+      shaper_t &s = shaper[i];
+      uint8_t amplitude[3], rest = SHAPING_UNIT;
+      uint16_t delay[3] = { 0 };
+      if (n) {
+        const float sum = a[0] + a[1] + (n > 2 ? a[2] : 0);
+        for (uint8_t k = n; --k;) {
+          amplitude[k] = LROUND(a[k] / sum * SHAPING_UNIT);
+          rest -= amplitude[k];
+          delay[k] = LROUND(t[k] * period);
+        }
+      }
+      amplitude[0] = rest;
+
+      CRITICAL_SECTION_START;
+        s.impulses = n;
+        COPY(s.amplitude, amplitude);
+        COPY(s.delay, delay);
+        s.tail[0] = s.tail[1] = s.head;
+      CRITICAL_SECTION_END;
+
+      NOMORE(planner.max_feedrate_mm_s[i], shaping_max_rate((AxisEnum)i) * planner.steps_to_mm[i]);
+    }
+  }
+
+  float Stepper::shaping_max_rate(const AxisEnum axis) {
+    const shaper_t &s = shaper[axis];
+    return s.impulses ? (SHAPING_BUFFER_SIZE - 4) * ((F_CPU) / 64.0) / s.delay[s.impulses - 1] : MAX_STEP_FREQUENCY;
+  }
+
+#endif // INPUT_SHAPING
+
 void Stepper::init() {
 
   // Init Digipot Motor Current
@@ -1102,7 +1660,19 @@ void Stepper::init() {
 /**
  * Block until all buffered steps are executed
  */
-void Stepper::synchronize() { while (planner.blocks_queued()) idle(); }
+void Stepper::synchronize() {
+  #if ENABLED(SEGMENT_MERGE)
+    planner.flush_merged_segment();
+  #endif
+  while (planner.blocks_queued()) idle();
+  #if ENABLED(INPUT_SHAPING)
+    // The motors are still moving until the shaped steps are out
+    while (shaping_busy(shaper[X_AXIS]) || shaping_busy(shaper[Y_AXIS])) idle();
+  #endif
+  #if ENABLED(SEGMENT_TIME_BUDGET)
+    planner.end_block_stream();
+  #endif
+}
 
 /**
  * Set the stepper positions directly in steps
@@ -1143,11 +1713,20 @@ void Stepper::set_position(const long &a, const long &b, const long &c, const lo
   #endif
 
   count_position[E_AXIS] = e;
+
+  #if ENABLED(INPUT_SHAPING)
+    // The shaped motors have caught up
+    LOOP_L_N(i, 2) shaper[i].position = count_position[i];
+  #endif
+
   CRITICAL_SECTION_END;
 }
 
 void Stepper::set_position(const AxisEnum &axis, const long &v) {
   CRITICAL_SECTION_START;
+  #if ENABLED(INPUT_SHAPING)
+    if (axis < 2) shaper[axis].position += v - count_position[axis];
+  #endif
   count_position[axis] = v;
   CRITICAL_SECTION_END;
 }
@@ -1200,6 +1779,9 @@ void Stepper::finish_and_disable() {
 }
 
 void Stepper::quick_stop() {
+  #if ENABLED(SEGMENT_MERGE)
+    planner.discard_merged_segment();
+  #endif
   #if ENABLED(AUTO_BED_LEVELING_UBL) && ENABLED(ULTIPANEL)
     if (!ubl_lcd_map_control)
       cleaning_buffer_counter = 5000;
@@ -1209,10 +1791,18 @@ void Stepper::quick_stop() {
   DISABLE_STEPPER_DRIVER_INTERRUPT();
   while (planner.blocks_queued()) planner.discard_current_block();
   current_block = NULL;
+  #if ENABLED(STEP_SEGMENT_BUFFER)
+    segment_buffer_tail = segment_buffer_head;
+    segment_isrs = 0;
+    prep_block = NULL;
+  #endif
   ENABLE_STEPPER_DRIVER_INTERRUPT();
-  #if ENABLED(ULTRA_LCD)
+  #if HAS_BLOCK_BUFFER_RUNTIME
     planner.clear_block_buffer_runtime();
   #endif
+  #if ENABLED(SEGMENT_TIME_BUDGET)
+    planner.end_block_stream();
+  #endif
 }
 
 void Stepper::endstop_triggered(AxisEnum axis) {
@@ -52,36 +52,101 @@
 class Stepper;
 extern Stepper stepper;
 
-// intRes = intIn1 * intIn2 >> 16
-// uses:
-// r26 to store 0
-// r27 to store the byte 1 of the 24 bit result
-#define MultiU16X8toH16(intRes, charIn1, intIn2) \
-  asm volatile ( \
-                 "clr r26 \n\t" \
-                 "mul %A1, %B2 \n\t" \
-                 "movw %A0, r0 \n\t" \
-                 "mul %A1, %A2 \n\t" \
-                 "add %A0, r1 \n\t" \
-                 "adc %B0, r26 \n\t" \
-                 "lsr r0 \n\t" \
-                 "adc %A0, r26 \n\t" \
-                 "adc %B0, r26 \n\t" \
-                 "clr r1 \n\t" \
-                 : \
-                 "=&r" (intRes) \
-                 : \
-                 "d" (charIn1), \
-                 "d" (intIn2) \
-                 : \
-                 "r26" \
-               )
+#ifdef __MARLIN_NATIVE__
+
+  // Host build: the same byte arithmetic as the AVR code below, in C,
+  // so the native simulator computes bit-identical step timings.
+  FORCE_INLINE uint16_t MultiU16X8toH16_C(const uint8_t charIn1, const uint16_t intIn2) {
+    const uint16_t lo = charIn1 * (uint8_t)intIn2;
+    return charIn1 * (uint8_t)(intIn2 >> 8) + (lo >> 8) + (lo & 1);
+  }
+  #define MultiU16X8toH16(intRes, charIn1, intIn2) intRes = MultiU16X8toH16_C(charIn1, intIn2)
+
+#else
+
+  // intRes = intIn1 * intIn2 >> 16
+  // uses:
+  // r26 to store 0
+  // r27 to store the byte 1 of the 24 bit result
+  #define MultiU16X8toH16(intRes, charIn1, intIn2) \
+    asm volatile ( \
+                   "clr r26 \n\t" \
+                   "mul %A1, %B2 \n\t" \
+                   "movw %A0, r0 \n\t" \
+                   "mul %A1, %A2 \n\t" \
+                   "add %A0, r1 \n\t" \
+                   "adc %B0, r26 \n\t" \
+                   "lsr r0 \n\t" \
+                   "adc %A0, r26 \n\t" \
+                   "adc %B0, r26 \n\t" \
+                   "clr r1 \n\t" \
+                   : \
+                   "=&r" (intRes) \
+                   : \
+                   "d" (charIn1), \
+                   "d" (intIn2) \
+                   : \
+                   "r26" \
+                 )
+
+#endif
+
+#if ENABLED(STEP_SEGMENT_BUFFER)
+
+  /**
+   * A run of step events at one step rate, cut from a block in the
+   * main loop by Stepper::prep_segments() for the stepper ISR to play.
+   */
+  typedef struct {
+    block_t* block;     // The block the step events belong to
+    uint16_t interval,  // Timer ticks from one stepper ISR to the next
+             isrs;      // The number of stepper ISRs
+    uint8_t loops;      // Step events per stepper ISR
+    bool first;         // The first segment of the block
+  } step_segment_t;
+
+  #define SEGMENT_MOD(n) ((n)&(STEP_SEGMENT_BUFFER_SIZE-1))
+
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+
+  #define SHAPING_UNIT 128 // The impulses of one step add up to this
+  #define SHAPING_MOD(n) ((n)&(SHAPING_BUFFER_SIZE-1))
+
+  /**
+   * The input shaper of one axis. The stepper ISR logs each step the block
+   * asks for, and adds the first impulse to 'owed'. The later impulses are
+   * added as they come due, and the motor steps whenever half a step is owed.
+   *
+   * Times are in units of 8 timer ticks (4µs), shifted up one bit with the
+   * step direction in bit 0, and wrap after 131ms.
+   */
+  typedef struct {
+    bool active;                          // Block steps go through the shaper
+    uint8_t impulses;                     // 2 or 3, or 0 for no shaping
+    uint8_t amplitude[3];                 // Out of SHAPING_UNIT
+    uint16_t delay[3];                    // After the step, in 8-tick units
+    uint16_t history[SHAPING_BUFFER_SIZE];// Logged steps: time << 1 | backward
+    uint8_t head,                         // Next step to log
+            tail[2];                      // Next step for impulses 1 and 2
+    int16_t owed;                         // Due but not stepped, in SHAPING_UNITs
+    bool backward;                        // The direction the DIR pin is set to
+    long position;                        // Where the motor is, while active
+  } shaper_t;
+
+#endif
 
 class Stepper {
 
   public:
 
     static block_t* current_block;  // A pointer to the block currently being traced
+    static const trapezoid_t* current_trapezoid; // Its speed profile
+
+    #if ENABLED(STEPPER_ISR_LATENCY)
+      static volatile uint16_t isr_latency_max; // Longest delay before the stepper ISR ran, in timer ticks
+    #endif
 
     #if ENABLED(ABORT_ON_ENDSTOP_HIT_FEATURE_ENABLED)
       static bool abort_on_endstop_hit;
@@ -91,6 +156,16 @@ class Stepper {
       static bool performing_homing;
     #endif
 
+    #if ENABLED(ANYCUBIC_OUTAGE_JOURNAL)
+      // Start of the SD command now moving, for the outage journal
+      static volatile bool command_start_changed;
+      static bool command_start_from_sd;
+      static uint32_t command_start_sdpos;
+      static uint16_t command_start_feedrate;   // mm/min
+      static bool command_start_relative_e;
+      static long command_start_position[NUM_AXIS];
+    #endif
+
     #if HAS_MOTOR_CURRENT_PWM
       #ifndef PWM_MOTOR_CURRENT
         #define PWM_MOTOR_CURRENT DEFAULT_PWM_MOTOR_CURRENT
@@ -98,6 +173,13 @@ class Stepper {
       static uint32_t motor_current_setting[3];
     #endif
 
+    #if ENABLED(INPUT_SHAPING)
+      // Shaper settings for X and Y. Apply them with update_shaping()
+      static float shaping_frequency[2], // (Hz) 0 for no shaping
+                   shaping_zeta[2];      // Damping ratio
+      static uint8_t shaping_type[2];    // 0 = ZV, 1 = ZVD, 2 = MZV
+    #endif
+
   private:
 
     static uint8_t last_direction_bits;        // The next stepping-bits to be output
@@ -121,6 +203,13 @@ class Stepper {
       static int current_adv_steps[E_STEPPERS];  // The amount of current added esteps due to advance.
                                                  // i.e., the current amount of pressure applied
                                                  // to the spring (=filament).
+    #elif ENABLED(INPUT_SHAPING)
+
+      static uint16_t nextMainISR, nextShapingISR;
+      #define _NEXT_ISR(T) nextMainISR = T
+      static uint32_t shaping_ticks;             // Timer ticks to this ISR, for timing the impulses
+      static shaper_t shaper[2];                 // X and Y
+
     #else // !LIN_ADVANCE
 
       #define _NEXT_ISR(T) OCR1A = T
@@ -131,11 +220,29 @@ class Stepper {
     //unsigned long accelerate_until, decelerate_after, acceleration_rate, initial_rate, final_rate, nominal_rate;
     static unsigned short acc_step_rate; // needed for deceleration start point
     static uint8_t step_loops, step_loops_nominal;
+    #if ENABLED(UNIFORM_STEP_PULSES)
+      static uint16_t step_spacing; // Timer ticks in the second half of the ISR period
+      static uint8_t uniform_steps; // 1 until the second half of the period has its steps
+    #endif
     static unsigned short OCR1A_nominal;
 
     static volatile long endstops_trigsteps[XYZ];
     static volatile long endstops_stepsTotal, endstops_stepsDone;
 
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+      static step_segment_t segment_buffer[STEP_SEGMENT_BUFFER_SIZE];
+      static volatile uint8_t segment_buffer_head,  // Index of the next segment to be filled
+                              segment_buffer_tail;  // Index of the next segment to play
+      static uint16_t segment_interval, segment_isrs; // The segment playing now, and ISRs left in it
+      static uint8_t segment_loops;
+      static block_t* prep_block;                   // The block being cut into segments
+      static const trapezoid_t* prep_trapezoid;     // Its speed profile
+      static uint32_t prep_events;                  // Its step events already in segments
+      static uint16_t prep_interval;                // The timer interval of the last segment
+      static volatile bool prepping;                // prep_segments() is at work. The ISR leaves the cutting to it.
+      static bool prep_segment();
+    #endif
+
     //
     // Positions of stepper motors, in step units
     //
@@ -177,6 +284,36 @@ class Stepper {
     #if ENABLED(LIN_ADVANCE)
       static void advance_isr();
       static void advance_isr_scheduler();
+    #elif ENABLED(INPUT_SHAPING)
+      static void shaping_isr();
+      static void shaping_isr_scheduler();
+    #endif
+
+    #if ENABLED(INPUT_SHAPING)
+      //
+      // Work out the impulses from the shaper settings, once the shaped steps are done
+      //
+      static void update_shaping();
+
+      //
+      // The position of the X or Y motor in steps, which lags position() while shaping
+      //
+      static FORCE_INLINE long motor_position(const AxisEnum axis) {
+        return shaper[axis].active ? shaper[axis].position : count_position[axis];
+      }
+
+      //
+      // The highest step rate, in steps/s, the shaper of an axis can keep up with
+      //
+      static float shaping_max_rate(const AxisEnum axis);
+    #endif
+
+    #if ENABLED(STEP_SEGMENT_BUFFER)
+      //
+      // Fill the segment buffer from the planner. Called from idle(). If the
+      // buffer runs dry, the stepper ISR cuts segments itself until it's back.
+      //
+      static void prep_segments();
     #endif
 
     //
@@ -282,16 +419,56 @@ class Stepper {
 
   private:
 
+    #if ENABLED(S_CURVE_ACCELERATION)
+
+      /**
+       * Rate change after 'elapsed' of a ramp lasting 2^32/inverse timer ticks.
+       * The ramp follows the quintic Bezier s(t) = 10t^3 - 15t^4 + 6t^5, which
+       * starts and ends with zero acceleration and zero jerk, and covers the same
+       * distance in the same time as a linear ramp. Uses 16-bit fixed-point t.
+       * Callers keep elapsed below 2^32/inverse, so every product fits 32 bits.
+       */
+      static FORCE_INLINE uint16_t s_curve_rate(const uint32_t elapsed, const uint32_t inverse, const uint16_t delta) {
+        const uint32_t t = (elapsed * inverse) >> 16,                       // 0..65535
+                       t2 = (t * t) >> 16,
+                       t3 = (t2 * t) >> 16,
+                       p = (655360UL - 15UL * t + 6UL * t2) >> 4,           // 10 - 15t + 6t^2, scaled by 4096
+                       s = (t3 * p) >> 12;                                  // 0..65535
+        return (uint32_t(delta) * s) >> 16;
+      }
+
+    #endif
+
+    #if ENABLED(INPUT_SHAPING)
+      // Log a block step of a shaped axis
+      static void shape_step(shaper_t &s, const bool backward);
+      // Add up the impulses now due. Return the direction of an owed step, or -1 if none.
+      static int8_t shaper_update(shaper_t &s, const uint16_t now, uint32_t &next);
+      // Free places in the step log
+      static FORCE_INLINE uint8_t shaping_room(const shaper_t &s) {
+        return SHAPING_MOD(s.tail[s.impulses - 2] - s.head - 1);
+      }
+      // Impulses still to come from logged steps
+      static FORCE_INLINE bool shaping_busy(const shaper_t &s) {
+        return s.impulses && s.tail[s.impulses - 2] != s.head;
+      }
+    #endif
+
+    // The step rate at acceleration_time into the acceleration ramp
+    static uint16_t ramp_up_rate(const block_t* const block, const trapezoid_t* const trap);
+    // The step rate at deceleration_time into the deceleration ramp, braking from acc_step_rate
+    static uint16_t ramp_down_rate(const block_t* const block, const trapezoid_t* const trap);
+
     static FORCE_INLINE unsigned short calc_timer(unsigned short step_rate) {
       unsigned short timer;
 
       NOMORE(step_rate, MAX_STEP_FREQUENCY);
 
-      if (step_rate > 20000) { // If steprate > 20kHz >> step 4 times
+      if (step_rate > 2 * (DOUBLE_STEP_FREQUENCY)) { // If steprate > 20kHz >> step 4 times
         step_rate >>= 2;
         step_loops = 4;
       }
-      else if (step_rate > 10000) { // If steprate > 10kHz >> step 2 times
+      else if (step_rate > DOUBLE_STEP_FREQUENCY) { // If steprate > 10kHz >> step 2 times
         step_rate >>= 1;
         step_loops = 2;
       }
@@ -302,17 +479,16 @@ class Stepper {
       NOLESS(step_rate, F_CPU / 500000);
       step_rate -= F_CPU / 500000; // Correct for minimal speed
       if (step_rate >= (8 * 256)) { // higher step rate
-        unsigned short table_address = (unsigned short)&speed_lookuptable_fast[(unsigned char)(step_rate >> 8)][0];
+        const uint16_t *table_address = speed_lookuptable_fast[(unsigned char)(step_rate >> 8)];
         unsigned char tmp_step_rate = (step_rate & 0x00FF);
-        unsigned short gain = (unsigned short)pgm_read_word_near(table_address + 2);
+        unsigned short gain = (unsigned short)pgm_read_word_near(table_address + 1);
         MultiU16X8toH16(timer, tmp_step_rate, gain);
         timer = (unsigned short)pgm_read_word_near(table_address) - timer;
       }
       else { // lower step rates
-        unsigned short table_address = (unsigned short)&speed_lookuptable_slow[0][0];
-        table_address += ((step_rate) >> 1) & 0xFFFC;
+        const uint16_t *table_address = speed_lookuptable_slow[(unsigned char)(step_rate >> 3)];
         timer = (unsigned short)pgm_read_word_near(table_address);
-        timer -= (((unsigned short)pgm_read_word_near(table_address + 2) * (unsigned char)(step_rate & 0x0007)) >> 3);
+        timer -= (((unsigned short)pgm_read_word_near(table_address + 1) * (unsigned char)(step_rate & 0x0007)) >> 3);
       }
       if (timer < 100) { // (20kHz - this should never happen)
         timer = 100;
@@ -334,12 +510,18 @@ class Stepper {
         set_directions();
       }
 
+      // With STEP_SEGMENT_BUFFER the step rates come with the segments
+      #if DISABLED(STEP_SEGMENT_BUFFER)
+
+      // Keep to the trapezoid published when the block was taken
+      current_trapezoid = &current_block->trapezoid[current_block->trapezoid_index];
+
       deceleration_time = 0;
       // step_rate to timer interval
       OCR1A_nominal = calc_timer(current_block->nominal_rate);
       // make a note of the number of step loops required at nominal speed
       step_loops_nominal = step_loops;
-      acc_step_rate = current_block->initial_rate;
+      acc_step_rate = current_trapezoid->initial_rate;
       acceleration_time = calc_timer(acc_step_rate);
       _NEXT_ISR(acceleration_time);
 
@@ -359,6 +541,8 @@ class Stepper {
       // SERIAL_ECHO(current_block->initial_advance/256.0);
       // SERIAL_ECHOPGM("final advance :");
       // SERIAL_ECHOLN(current_block->final_advance/256.0);
+
+      #endif // !STEP_SEGMENT_BUFFER
     }
 
     #if HAS_DIGIPOTSS || HAS_MOTOR_CURRENT_PWM
@@ -49,14 +49,18 @@
 
 #ifdef K1 // Defined in Configuration.h in the PID settings
   #define K2 (1.0-K1)
+  #if ENABLED(PID_FIXED_POINT)
+    #define PID_K1 int32_t((K1) * 4096 + 0.5) // 12-bit fraction
+    #define PID_DTERM_MAX (0x7FFFFFFFL / 4096)  // Largest dTerm the K1 product can take
+  #endif
 #endif
 
 #if ENABLED(TEMP_SENSOR_1_AS_REDUNDANT)
   static void* heater_ttbl_map[2] = { (void*)HEATER_0_TEMPTABLE, (void*)HEATER_1_TEMPTABLE };
-  static uint8_t heater_ttbllen_map[2] = { HEATER_0_TEMPTABLE_LEN, HEATER_1_TEMPTABLE_LEN };
+  static uint16_t heater_ttbllen_map[2] = { HEATER_0_TEMPTABLE_LEN, HEATER_1_TEMPTABLE_LEN };
 #else
   static void* heater_ttbl_map[HOTENDS] = ARRAY_BY_HOTENDS((void*)HEATER_0_TEMPTABLE, (void*)HEATER_1_TEMPTABLE, (void*)HEATER_2_TEMPTABLE, (void*)HEATER_3_TEMPTABLE, (void*)HEATER_4_TEMPTABLE);
-  static uint8_t heater_ttbllen_map[HOTENDS] = ARRAY_BY_HOTENDS(HEATER_0_TEMPTABLE_LEN, HEATER_1_TEMPTABLE_LEN, HEATER_2_TEMPTABLE_LEN, HEATER_3_TEMPTABLE_LEN, HEATER_4_TEMPTABLE_LEN);
+  static uint16_t heater_ttbllen_map[HOTENDS] = ARRAY_BY_HOTENDS(HEATER_0_TEMPTABLE_LEN, HEATER_1_TEMPTABLE_LEN, HEATER_2_TEMPTABLE_LEN, HEATER_3_TEMPTABLE_LEN, HEATER_4_TEMPTABLE_LEN);
 #endif
 
 Temperature thermalManager;
@@ -80,11 +84,20 @@ int16_t Temperature::current_temperature_raw[HOTENDS] = { 0 },
     #if ENABLED(PID_EXTRUSION_SCALING)
       float Temperature::Kc[HOTENDS];
     #endif
+    #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+      float Temperature::Kf[HOTENDS];
+    #endif
   #else
     float Temperature::Kp, Temperature::Ki, Temperature::Kd;
     #if ENABLED(PID_EXTRUSION_SCALING)
       float Temperature::Kc;
     #endif
+    #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+      float Temperature::Kf;
+    #endif
+  #endif
+  #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+    uint16_t Temperature::feedforward_lag;
   #endif
 #endif
 
@@ -122,11 +135,23 @@ int16_t Temperature::current_temperature_raw[HOTENDS] = { 0 },
 volatile bool Temperature::temp_meas_ready = false;
 
 #if ENABLED(PIDTEMP)
-  float Temperature::temp_iState[HOTENDS] = { 0 },
-        Temperature::temp_dState[HOTENDS] = { 0 },
-        Temperature::pTerm[HOTENDS],
-        Temperature::iTerm[HOTENDS],
-        Temperature::dTerm[HOTENDS];
+  #if ENABLED(PID_FIXED_POINT)
+    int32_t Temperature::temp_iState[HOTENDS] = { 0 },
+            Temperature::pTerm[HOTENDS],
+            Temperature::iTerm[HOTENDS] = { 0 },
+            Temperature::dTerm[HOTENDS],
+            Temperature::fixed_Kp[HOTENDS],
+            Temperature::fixed_Ki[HOTENDS],
+            Temperature::fixed_Kd[HOTENDS];
+    int16_t Temperature::temp_dState[HOTENDS] = { 0 },
+            Temperature::pid_temperature[HOTENDS];
+  #else
+    float Temperature::temp_iState[HOTENDS] = { 0 },
+          Temperature::temp_dState[HOTENDS] = { 0 },
+          Temperature::pTerm[HOTENDS],
+          Temperature::iTerm[HOTENDS],
+          Temperature::dTerm[HOTENDS];
+  #endif
 
   #if ENABLED(PID_EXTRUSION_SCALING)
     float Temperature::cTerm[HOTENDS];
@@ -135,17 +160,38 @@ volatile bool Temperature::temp_meas_ready = false;
     int Temperature::lpq_ptr = 0;
   #endif
 
-  float Temperature::pid_error[HOTENDS];
+  #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+    float Temperature::fTerm[HOTENDS];
+  #endif
+
+  #if ENABLED(PID_FIXED_POINT)
+    int16_t Temperature::pid_error[HOTENDS];
+  #else
+    float Temperature::pid_error[HOTENDS];
+  #endif
   bool Temperature::pid_reset[HOTENDS];
 #endif
 
 #if ENABLED(PIDTEMPBED)
-  float Temperature::temp_iState_bed = { 0 },
-        Temperature::temp_dState_bed = { 0 },
-        Temperature::pTerm_bed,
-        Temperature::iTerm_bed,
-        Temperature::dTerm_bed,
-        Temperature::pid_error_bed;
+  #if ENABLED(PID_FIXED_POINT)
+    int32_t Temperature::temp_iState_bed = 0,
+            Temperature::pTerm_bed,
+            Temperature::iTerm_bed = 0,
+            Temperature::dTerm_bed,
+            Temperature::fixed_bedKp,
+            Temperature::fixed_bedKi,
+            Temperature::fixed_bedKd;
+    int16_t Temperature::temp_dState_bed = 0,
+            Temperature::pid_error_bed,
+            Temperature::pid_temperature_bed;
+  #else
+    float Temperature::temp_iState_bed = { 0 },
+          Temperature::temp_dState_bed = { 0 },
+          Temperature::pTerm_bed,
+          Temperature::iTerm_bed,
+          Temperature::dTerm_bed,
+          Temperature::pid_error_bed;
+  #endif
 #else
   millis_t Temperature::next_bed_check_ms;
 #endif
@@ -186,9 +232,20 @@ int16_t Temperature::minttemp_raw[HOTENDS] = ARRAY_BY_HOTENDS(HEATER_0_RAW_LO_TE
 uint8_t Temperature::soft_pwm_amount[HOTENDS],
         Temperature::soft_pwm_amount_bed;
 
+#if ENABLED(SOFT_PWM_SIGMA_DELTA)
+  uint16_t Temperature::soft_pwm_fine[HOTENDS],
+           Temperature::soft_pwm_fine_bed;
+  // Scale a 0-255 PID output, fraction and all, to a 16-bit duty split into amount and fine parts
+  #define SET_SOFT_PWM(A, F, OUT) do{ const uint16_t duty = LROUND((OUT) * 257); A = duty >> 9; F = duty & 0x1FF; }while(0)
+#else
+  #define SET_SOFT_PWM(A, F, OUT) A = (int)(OUT) >> 1
+#endif
+
 #if ENABLED(FAN_SOFT_PWM)
-  uint8_t Temperature::soft_pwm_amount_fan[FAN_COUNT],
-          Temperature::soft_pwm_count_fan[FAN_COUNT];
+  uint8_t Temperature::soft_pwm_amount_fan[FAN_COUNT];
+  #if DISABLED(SOFT_PWM_SIGMA_DELTA)
+    uint8_t Temperature::soft_pwm_count_fan[FAN_COUNT];
+  #endif
 #endif
 
 #if ENABLED(FILAMENT_WIDTH_SENSOR)
@@ -463,6 +520,21 @@ void Temperature::updatePID() {
     #if ENABLED(PID_EXTRUSION_SCALING)
       last_e_position = 0;
     #endif
+    #if ENABLED(PID_FIXED_POINT)
+      // Scale the gains to the fixed-point terms. Carry the integral over as the float PID would.
+      HOTEND_LOOP() {
+        fixed_Kp[e] = LROUND(PID_PARAM(Kp, e) * 256);
+        fixed_Ki[e] = LROUND(PID_PARAM(Ki, e) * 65536);
+        fixed_Kd[e] = LROUND(K2 * PID_PARAM(Kd, e) * 16);
+        iTerm[e] = LROUND(PID_PARAM(Ki, e) * temp_iState[e] * 16);
+      }
+    #endif
+  #endif
+  #if ENABLED(PIDTEMPBED) && ENABLED(PID_FIXED_POINT)
+    fixed_bedKp = LROUND(bedKp * 256);
+    fixed_bedKi = LROUND(bedKi * 65536);
+    fixed_bedKd = LROUND(K2 * bedKd * 16);
+    iTerm_bed = LROUND(bedKi * temp_iState_bed * 16);
   #endif
 }
 
@@ -555,7 +627,83 @@ float Temperature::get_pid_output(const int8_t e) {
   #endif
   float pid_output;
   #if ENABLED(PIDTEMP)
-    #if DISABLED(PID_OPENLOOP)
+    #if DISABLED(PID_OPENLOOP) && ENABLED(PID_FIXED_POINT)
+      const int16_t temp = pid_temperature[HOTEND_INDEX];
+      pid_error[HOTEND_INDEX] = (target_temperature[HOTEND_INDEX] << 4) - temp;
+      dTerm[HOTEND_INDEX] = fixed_Kd[HOTEND_INDEX] * (temp - temp_dState[HOTEND_INDEX])
+                          + ((constrain(dTerm[HOTEND_INDEX], -PID_DTERM_MAX, PID_DTERM_MAX) * PID_K1) >> 12);
+      temp_dState[HOTEND_INDEX] = temp;
+      #if HEATER_IDLE_HANDLER
+        if (heater_idle_timeout_exceeded[HOTEND_INDEX]) {
+          pid_output = 0;
+          pid_reset[HOTEND_INDEX] = true;
+        }
+        else
+      #endif
+      if (pid_error[HOTEND_INDEX] > (PID_FUNCTIONAL_RANGE) * 16) {
+        pid_output = BANG_MAX;
+        pid_reset[HOTEND_INDEX] = true;
+      }
+      else if (pid_error[HOTEND_INDEX] < -(PID_FUNCTIONAL_RANGE) * 16 || target_temperature[HOTEND_INDEX] == 0
+        #if HEATER_IDLE_HANDLER
+          || heater_idle_timeout_exceeded[HOTEND_INDEX]
+        #endif
+        ) {
+        pid_output = 0;
+        pid_reset[HOTEND_INDEX] = true;
+      }
+      else {
+        if (pid_reset[HOTEND_INDEX]) {
+          temp_iState[HOTEND_INDEX] = iTerm[HOTEND_INDEX] = 0;
+          pid_reset[HOTEND_INDEX] = false;
+        }
+        pTerm[HOTEND_INDEX] = (fixed_Kp[HOTEND_INDEX] * pid_error[HOTEND_INDEX]) >> 4;
+        temp_iState[HOTEND_INDEX] += pid_error[HOTEND_INDEX];
+        const int32_t iStep = (fixed_Ki[HOTEND_INDEX] * pid_error[HOTEND_INDEX] + 2048) >> 12;
+        iTerm[HOTEND_INDEX] += iStep;
+
+        int32_t output = pTerm[HOTEND_INDEX] + iTerm[HOTEND_INDEX] - dTerm[HOTEND_INDEX];
+
+        #if ENABLED(PID_EXTRUSION_SCALING)
+          cTerm[HOTEND_INDEX] = 0;
+          if (_HOTEND_TEST) {
+            long e_position = stepper.position(E_AXIS);
+            if (e_position > last_e_position) {
+              lpq[lpq_ptr] = e_position - last_e_position;
+              last_e_position = e_position;
+            }
+            else {
+              lpq[lpq_ptr] = 0;
+            }
+            if (++lpq_ptr >= lpq_len) lpq_ptr = 0;
+            cTerm[HOTEND_INDEX] = (lpq[lpq_ptr] * planner.steps_to_mm[E_AXIS]) * PID_PARAM(Kc, HOTEND_INDEX);
+            output += LROUND(cTerm[HOTEND_INDEX] * 256);
+          }
+        #endif // PID_EXTRUSION_SCALING
+
+        #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+          fTerm[HOTEND_INDEX] = PID_PARAM(Kf, HOTEND_INDEX) * planner.flow_ahead(HOTEND_INDEX, feedforward_lag);
+          output += LROUND(fTerm[HOTEND_INDEX] * 256);
+        #endif
+
+        if (output > int32_t(PID_MAX) << 8) {
+          if (pid_error[HOTEND_INDEX] > 0) { // conditional un-integration
+            temp_iState[HOTEND_INDEX] -= pid_error[HOTEND_INDEX];
+            iTerm[HOTEND_INDEX] -= iStep;
+          }
+          pid_output = PID_MAX;
+        }
+        else if (output < 0) {
+          if (pid_error[HOTEND_INDEX] < 0) { // conditional un-integration
+            temp_iState[HOTEND_INDEX] -= pid_error[HOTEND_INDEX];
+            iTerm[HOTEND_INDEX] -= iStep;
+          }
+          pid_output = 0;
+        }
+        else
+          pid_output = output * (1.0f / 256);
+      }
+    #elif DISABLED(PID_OPENLOOP)
       pid_error[HOTEND_INDEX] = target_temperature[HOTEND_INDEX] - current_temperature[HOTEND_INDEX];
       dTerm[HOTEND_INDEX] = K2 * PID_PARAM(Kd, HOTEND_INDEX) * (current_temperature[HOTEND_INDEX] - temp_dState[HOTEND_INDEX]) + K1 * dTerm[HOTEND_INDEX];
       temp_dState[HOTEND_INDEX] = current_temperature[HOTEND_INDEX];
@@ -606,6 +754,11 @@ float Temperature::get_pid_output(const int8_t e) {
           }
         #endif // PID_EXTRUSION_SCALING
 
+        #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+          fTerm[HOTEND_INDEX] = PID_PARAM(Kf, HOTEND_INDEX) * planner.flow_ahead(HOTEND_INDEX, feedforward_lag);
+          pid_output += fTerm[HOTEND_INDEX];
+        #endif
+
         if (pid_output > PID_MAX) {
           if (pid_error[HOTEND_INDEX] > 0) temp_iState[HOTEND_INDEX] -= pid_error[HOTEND_INDEX]; // conditional un-integration
           pid_output = PID_MAX;
@@ -624,12 +777,15 @@ float Temperature::get_pid_output(const int8_t e) {
       SERIAL_ECHOPAIR(MSG_PID_DEBUG, HOTEND_INDEX);
       SERIAL_ECHOPAIR(MSG_PID_DEBUG_INPUT, current_temperature[HOTEND_INDEX]);
       SERIAL_ECHOPAIR(MSG_PID_DEBUG_OUTPUT, pid_output);
-      SERIAL_ECHOPAIR(MSG_PID_DEBUG_PTERM, pTerm[HOTEND_INDEX]);
-      SERIAL_ECHOPAIR(MSG_PID_DEBUG_ITERM, iTerm[HOTEND_INDEX]);
-      SERIAL_ECHOPAIR(MSG_PID_DEBUG_DTERM, dTerm[HOTEND_INDEX]);
+      SERIAL_ECHOPAIR(MSG_PID_DEBUG_PTERM, PID_TERM(pTerm[HOTEND_INDEX]));
+      SERIAL_ECHOPAIR(MSG_PID_DEBUG_ITERM, PID_TERM(iTerm[HOTEND_INDEX]));
+      SERIAL_ECHOPAIR(MSG_PID_DEBUG_DTERM, PID_TERM(dTerm[HOTEND_INDEX]));
       #if ENABLED(PID_EXTRUSION_SCALING)
         SERIAL_ECHOPAIR(MSG_PID_DEBUG_CTERM, cTerm[HOTEND_INDEX]);
       #endif
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        SERIAL_ECHOPAIR(MSG_PID_DEBUG_FTERM, fTerm[HOTEND_INDEX]);
+      #endif
       SERIAL_EOL();
     #endif // PID_DEBUG
 
@@ -648,7 +804,35 @@ float Temperature::get_pid_output(const int8_t e) {
 #if ENABLED(PIDTEMPBED)
   float Temperature::get_pid_output_bed() {
     float pid_output;
-    #if DISABLED(PID_OPENLOOP)
+    #if DISABLED(PID_OPENLOOP) && ENABLED(PID_FIXED_POINT)
+      const int16_t temp = pid_temperature_bed;
+      pid_error_bed = (target_temperature_bed << 4) - temp;
+      pTerm_bed = (fixed_bedKp * pid_error_bed) >> 4;
+      temp_iState_bed += pid_error_bed;
+      const int32_t iStep = (fixed_bedKi * pid_error_bed + 2048) >> 12;
+      iTerm_bed += iStep;
+
+      dTerm_bed = fixed_bedKd * (temp - temp_dState_bed) + ((constrain(dTerm_bed, -PID_DTERM_MAX, PID_DTERM_MAX) * PID_K1) >> 12);
+      temp_dState_bed = temp;
+
+      const int32_t output = pTerm_bed + iTerm_bed - dTerm_bed;
+      if (output > int32_t(MAX_BED_POWER) << 8) {
+        if (pid_error_bed > 0) { // conditional un-integration
+          temp_iState_bed -= pid_error_bed;
+          iTerm_bed -= iStep;
+        }
+        pid_output = MAX_BED_POWER;
+      }
+      else if (output < 0) {
+        if (pid_error_bed < 0) { // conditional un-integration
+          temp_iState_bed -= pid_error_bed;
+          iTerm_bed -= iStep;
+        }
+        pid_output = 0;
+      }
+      else
+        pid_output = output * (1.0f / 256);
+    #elif DISABLED(PID_OPENLOOP)
       pid_error_bed = target_temperature_bed - current_temperature_bed;
       pTerm_bed = bedKp * pid_error_bed;
       temp_iState_bed += pid_error_bed;
@@ -678,11 +862,11 @@ float Temperature::get_pid_output(const int8_t e) {
       SERIAL_ECHOPGM(" Output ");
       SERIAL_ECHO(pid_output);
       SERIAL_ECHOPGM(" pTerm ");
-      SERIAL_ECHO(pTerm_bed);
+      SERIAL_ECHO(PID_TERM(pTerm_bed));
       SERIAL_ECHOPGM(" iTerm ");
-      SERIAL_ECHO(iTerm_bed);
+      SERIAL_ECHO(PID_TERM(iTerm_bed));
       SERIAL_ECHOPGM(" dTerm ");
-      SERIAL_ECHOLN(dTerm_bed);
+      SERIAL_ECHOLN(PID_TERM(dTerm_bed));
     #endif // PID_BED_DEBUG
 
     return pid_output;
@@ -736,7 +920,8 @@ void Temperature::manage_heater() {
       thermal_runaway_protection(&thermal_runaway_state_machine[e], &thermal_runaway_timer[e], current_temperature[e], target_temperature[e], e, THERMAL_PROTECTION_PERIOD, THERMAL_PROTECTION_HYSTERESIS);
     #endif
 
-    soft_pwm_amount[e] = (current_temperature[e] > minttemp[e] || is_preheating(e)) && current_temperature[e] < maxttemp[e] ? (int)get_pid_output(e) >> 1 : 0;
+    SET_SOFT_PWM(soft_pwm_amount[e], soft_pwm_fine[e],
+      (current_temperature[e] > minttemp[e] || is_preheating(e)) && current_temperature[e] < maxttemp[e] ? get_pid_output(e) : 0);
 
     #if WATCH_HOTENDS
       // Make sure temperature is increasing
@@ -807,6 +992,9 @@ void Temperature::manage_heater() {
       if (bed_idle_timeout_exceeded)
       {
         soft_pwm_amount_bed = 0;
+        #if ENABLED(SOFT_PWM_SIGMA_DELTA)
+          soft_pwm_fine_bed = 0;
+        #endif
 
         #if DISABLED(PIDTEMPBED)
           WRITE_HEATER_BED(LOW);
@@ -816,7 +1004,7 @@ void Temperature::manage_heater() {
     #endif
     {
       #if ENABLED(PIDTEMPBED)
-        soft_pwm_amount_bed = WITHIN(current_temperature_bed, BED_MINTEMP, BED_MAXTEMP) ? (int)get_pid_output_bed() >> 1 : 0;
+        SET_SOFT_PWM(soft_pwm_amount_bed, soft_pwm_fine_bed, WITHIN(current_temperature_bed, BED_MINTEMP, BED_MAXTEMP) ? get_pid_output_bed() : 0);
 
       #elif ENABLED(BED_LIMIT_SWITCHING)
         // Check if temperature is within the correct band
@@ -846,6 +1034,63 @@ void Temperature::manage_heater() {
 
 #define PGM_RD_W(x)   (short)pgm_read_word(&x)
 
+#if ENABLED(THERMISTOR_INDEX_TABLES)
+
+  /**
+   * Get the temperature of a raw reading from an index table (see thermistortables_index.h).
+   * The entry for the ADC count, plus the step to the next entry in proportion to the rest.
+   */
+  float Temperature::indextable2temp(const short * const tt, const uint16_t len, const int raw) {
+    const uint16_t i = (uint16_t)raw / OVERSAMPLENR;
+    if (i >= len - 1) return PGM_RD_W(tt[len - 1]) * (1.0 / (INDEXTABLE_SCALE));
+    const short t = PGM_RD_W(tt[i]);
+    return ((long)t * (OVERSAMPLENR) + (long)(PGM_RD_W(tt[i + 1]) - t) * ((uint16_t)raw % (OVERSAMPLENR)))
+           * (1.0 / ((INDEXTABLE_SCALE) * (OVERSAMPLENR)));
+  }
+
+  #if ENABLED(PID_FIXED_POINT)
+
+    // The same in 1/INDEXTABLE_SCALE °C, rounded, which is what the fixed-point PID takes
+    static_assert(INDEXTABLE_SCALE == 16 && OVERSAMPLENR == 16, "indextable2pid() expects 1/16 °C entries and 16 samples per reading.");
+    static int16_t indextable2pid(const short * const tt, const uint16_t len, const int raw) {
+      const uint16_t i = (uint16_t)raw / OVERSAMPLENR;
+      if (i >= len - 1) return PGM_RD_W(tt[len - 1]);
+      const short t = PGM_RD_W(tt[i]);
+      return t + (int16_t)(((long)(PGM_RD_W(tt[i + 1]) - t) * ((uint16_t)raw % (OVERSAMPLENR)) + (OVERSAMPLENR) / 2) >> 4);
+    }
+
+  #endif
+
+#endif
+
+#if DISABLED(THERMISTOR_INDEX_TABLES) || defined(__MARLIN_NATIVE__)
+
+  /**
+   * Get the temperature of a raw reading by searching a thermistor table for the
+   * first point past it and interpolating from the one before.
+   */
+  float Temperature::temptable2temp(const short (*tt)[2], const uint8_t len, const int raw) {
+    float celsius = 0;
+    uint8_t i;
+
+    for (i = 1; i < len; i++) {
+      if (PGM_RD_W(tt[i][0]) > raw) {
+        celsius = PGM_RD_W(tt[i - 1][1]) +
+                  (raw - PGM_RD_W(tt[i - 1][0])) *
+                  (float)(PGM_RD_W(tt[i][1]) - PGM_RD_W(tt[i - 1][1])) /
+                  (float)(PGM_RD_W(tt[i][0]) - PGM_RD_W(tt[i - 1][0]));
+        break;
+      }
+    }
+
+    // Overflow: Set to last value in the table
+    if (i == len) celsius = PGM_RD_W(tt[i - 1][1]);
+
+    return celsius;
+  }
+
+#endif
+
 // Derived from RepRap FiveD extruder::getTemperature()
 // For hot end temperature measurement.
 float Temperature::analog2temp(int raw, uint8_t e) {
@@ -867,24 +1112,15 @@ float Temperature::analog2temp(int raw, uint8_t e) {
   #endif
 
   if (heater_ttbl_map[e] != NULL) {
-    float celsius = 0;
-    uint8_t i;
-    short(*tt)[][2] = (short(*)[][2])(heater_ttbl_map[e]);
-
-    for (i = 1; i < heater_ttbllen_map[e]; i++) {
-      if (PGM_RD_W((*tt)[i][0]) > raw) {
-        celsius = PGM_RD_W((*tt)[i - 1][1]) +
-                  (raw - PGM_RD_W((*tt)[i - 1][0])) *
-                  (float)(PGM_RD_W((*tt)[i][1]) - PGM_RD_W((*tt)[i - 1][1])) /
-                  (float)(PGM_RD_W((*tt)[i][0]) - PGM_RD_W((*tt)[i - 1][0]));
-        break;
-      }
-    }
+    #if ENABLED(THERMISTOR_INDEX_TABLES)
 
-    // Overflow: Set to last value in the table
-    if (i == heater_ttbllen_map[e]) celsius = PGM_RD_W((*tt)[i - 1][1]);
+      return indextable2temp((const short*)heater_ttbl_map[e], heater_ttbllen_map[e], raw);
 
-    return celsius;
+    #else
+
+      return temptable2temp((const short(*)[2])heater_ttbl_map[e], heater_ttbllen_map[e], raw);
+
+    #endif
   }
   return ((raw * ((5.0 * 100.0) / 1024.0) / OVERSAMPLENR) * (TEMP_SENSOR_AD595_GAIN)) + TEMP_SENSOR_AD595_OFFSET;
 }
@@ -892,24 +1128,13 @@ float Temperature::analog2temp(int raw, uint8_t e) {
 // Derived from RepRap FiveD extruder::getTemperature()
 // For bed temperature measurement.
 float Temperature::analog2tempBed(const int raw) {
-  #if ENABLED(BED_USES_THERMISTOR)
-    float celsius = 0;
-    byte i;
-
-    for (i = 1; i < BEDTEMPTABLE_LEN; i++) {
-      if (PGM_RD_W(BEDTEMPTABLE[i][0]) > raw) {
-        celsius  = PGM_RD_W(BEDTEMPTABLE[i - 1][1]) +
-                   (raw - PGM_RD_W(BEDTEMPTABLE[i - 1][0])) *
-                   (float)(PGM_RD_W(BEDTEMPTABLE[i][1]) - PGM_RD_W(BEDTEMPTABLE[i - 1][1])) /
-                   (float)(PGM_RD_W(BEDTEMPTABLE[i][0]) - PGM_RD_W(BEDTEMPTABLE[i - 1][0]));
-        break;
-      }
-    }
+  #if ENABLED(BED_USES_THERMISTOR) && ENABLED(THERMISTOR_INDEX_TABLES)
 
-    // Overflow: Set to last value in the table
-    if (i == BEDTEMPTABLE_LEN) celsius = PGM_RD_W(BEDTEMPTABLE[i - 1][1]);
+    return indextable2temp(BEDTEMPTABLE, BEDTEMPTABLE_LEN, raw);
 
-    return celsius;
+  #elif ENABLED(BED_USES_THERMISTOR)
+
+    return temptable2temp(BEDTEMPTABLE, BEDTEMPTABLE_LEN, raw);
 
   #elif defined(BED_USES_AD595)
 
@@ -923,6 +1148,37 @@ float Temperature::analog2tempBed(const int raw) {
   #endif
 }
 
+#if ENABLED(PID_FIXED_POINT)
+
+  /**
+   * The fixed-point PID's temperature of a raw reading, in 1/16 °C.
+   * Index tables have it as an integer. Other sensors go through analog2temp().
+   */
+  #if ENABLED(PIDTEMP)
+    int16_t Temperature::analog2pid(const int raw, const uint8_t e) {
+      #if ENABLED(THERMISTOR_INDEX_TABLES)
+        #if ENABLED(HEATER_0_USES_MAX6675)
+          if (e != 0)
+        #endif
+        if (heater_ttbl_map[e] != NULL)
+          return indextable2pid((const short*)heater_ttbl_map[e], heater_ttbllen_map[e], raw);
+      #endif
+      return PID_TEMP(analog2temp(raw, e));
+    }
+  #endif
+
+  #if ENABLED(PIDTEMPBED)
+    int16_t Temperature::analog2pidBed(const int raw) {
+      #if ENABLED(BED_USES_THERMISTOR) && ENABLED(THERMISTOR_INDEX_TABLES)
+        return indextable2pid(BEDTEMPTABLE, BEDTEMPTABLE_LEN, raw);
+      #else
+        return PID_TEMP(analog2tempBed(raw));
+      #endif
+    }
+  #endif
+
+#endif // PID_FIXED_POINT
+
 /**
  * Get the raw values into the actual temperatures.
  * The raw values are created in interrupt context,
@@ -936,6 +1192,12 @@ void Temperature::updateTemperaturesFromRawValues() {
   HOTEND_LOOP()
     current_temperature[e] = Temperature::analog2temp(current_temperature_raw[e], e);
   current_temperature_bed = Temperature::analog2tempBed(current_temperature_bed_raw);
+  #if ENABLED(PIDTEMP) && ENABLED(PID_FIXED_POINT)
+    HOTEND_LOOP() pid_temperature[e] = analog2pid(current_temperature_raw[e], e);
+  #endif
+  #if ENABLED(PIDTEMPBED) && ENABLED(PID_FIXED_POINT)
+    pid_temperature_bed = analog2pidBed(current_temperature_bed_raw);
+  #endif
   #if ENABLED(TEMP_SENSOR_1_AS_REDUNDANT)
     redundant_temperature = Temperature::analog2temp(redundant_temperature_raw, 1);
   #endif
@@ -1354,6 +1616,11 @@ void Temperature::disable_all_heaters() {
   // If all heaters go down then for sure our print job has stopped
   print_job_timer.stop();
 
+  #if ENABLED(SOFT_PWM_SIGMA_DELTA)
+    ZERO(soft_pwm_fine);
+    soft_pwm_fine_bed = 0;
+  #endif
+
   #define DISABLE_HEATER(NR) { \
     setTargetHotend(0, NR); \
     soft_pwm_amount[NR] = 0; \
@@ -1623,9 +1890,11 @@ void Temperature::isr() {
 
   static int8_t temp_count = -1;
   static ADCSensorState adc_sensor_state = StartupDelay;
-  static uint8_t pwm_count = _BV(SOFT_PWM_SCALE);
-  // avoid multiple loads of pwm_count
-  uint8_t pwm_count_tmp = pwm_count;
+  #if DISABLED(SOFT_PWM_SIGMA_DELTA)
+    static uint8_t pwm_count = _BV(SOFT_PWM_SCALE);
+    // avoid multiple loads of pwm_count
+    uint8_t pwm_count_tmp = pwm_count;
+  #endif
   #if ENABLED(ADC_KEYPAD)
     static unsigned int raw_ADCKey_value = 0;
   #endif
@@ -1642,28 +1911,82 @@ void Temperature::isr() {
   #endif
 
   // Statics per heater
-  ISR_STATICS(0);
-  #if HOTENDS > 1
-    ISR_STATICS(1);
-    #if HOTENDS > 2
-      ISR_STATICS(2);
-      #if HOTENDS > 3
-        ISR_STATICS(3);
-        #if HOTENDS > 4
-          ISR_STATICS(4);
-        #endif // HOTENDS > 4
-      #endif // HOTENDS > 3
-    #endif // HOTENDS > 2
-  #endif // HOTENDS > 1
-  #if HAS_HEATER_BED
-    ISR_STATICS(BED);
+  #if ENABLED(SOFT_PWM_SIGMA_DELTA)
+    // One accumulator per output: the hotends, then the bed and the fans
+    enum SoftPWMChannel : uint8_t { PWM_BED = HOTENDS, PWM_FAN0, PWM_FAN1, PWM_FAN2, PWM_CHANNELS };
+    static uint16_t soft_pwm_accum[PWM_CHANNELS];
+  #else
+    ISR_STATICS(0);
+    #if HOTENDS > 1
+      ISR_STATICS(1);
+      #if HOTENDS > 2
+        ISR_STATICS(2);
+        #if HOTENDS > 3
+          ISR_STATICS(3);
+          #if HOTENDS > 4
+            ISR_STATICS(4);
+          #endif // HOTENDS > 4
+        #endif // HOTENDS > 3
+      #endif // HOTENDS > 2
+    #endif // HOTENDS > 1
+    #if HAS_HEATER_BED
+      ISR_STATICS(BED);
+    #endif
   #endif
 
   #if ENABLED(FILAMENT_WIDTH_SENSOR)
     static unsigned long raw_filwidth_value = 0;
   #endif
 
-  #if DISABLED(SLOW_PWM_HEATERS)
+  #if ENABLED(SOFT_PWM_SIGMA_DELTA)
+
+    /**
+     * Sigma-delta modulation
+     *
+     * Each output adds its duty to its accumulator and is on for the ticks
+     * that carry out of it. A heater's duty is its 7-bit amount over the 9
+     * fine bits the PID loop leaves below it. An 8-bit fan speed fills the
+     * whole 16 bits by repeating itself.
+     */
+    #define SIGMA_DELTA(N, DUTY, WRITE) do{ \
+      const uint16_t a = soft_pwm_accum[N] + (DUTY); \
+      WRITE(a < soft_pwm_accum[N] ? HIGH : LOW); \
+      soft_pwm_accum[N] = a; \
+    }while(0)
+    #define HEATER_DUTY(N) ((uint16_t)soft_pwm_amount[N] << 9 | soft_pwm_fine[N])
+    #define FAN_DUTY(N) ((uint16_t)soft_pwm_amount_fan[N] << 8 | soft_pwm_amount_fan[N])
+
+    SIGMA_DELTA(0, HEATER_DUTY(0), WRITE_HEATER_0);
+    #if HOTENDS > 1
+      SIGMA_DELTA(1, HEATER_DUTY(1), WRITE_HEATER_1);
+      #if HOTENDS > 2
+        SIGMA_DELTA(2, HEATER_DUTY(2), WRITE_HEATER_2);
+        #if HOTENDS > 3
+          SIGMA_DELTA(3, HEATER_DUTY(3), WRITE_HEATER_3);
+          #if HOTENDS > 4
+            SIGMA_DELTA(4, HEATER_DUTY(4), WRITE_HEATER_4);
+          #endif // HOTENDS > 4
+        #endif // HOTENDS > 3
+      #endif // HOTENDS > 2
+    #endif // HOTENDS > 1
+
+    #if HAS_HEATER_BED
+      SIGMA_DELTA(PWM_BED, (uint16_t)soft_pwm_amount_bed << 9 | soft_pwm_fine_bed, WRITE_HEATER_BED);
+    #endif
+
+    #if ENABLED(FAN_SOFT_PWM)
+      #if HAS_FAN0
+        SIGMA_DELTA(PWM_FAN0, FAN_DUTY(0), WRITE_FAN);
+      #endif
+      #if HAS_FAN1
+        SIGMA_DELTA(PWM_FAN1, FAN_DUTY(1), WRITE_FAN1);
+      #endif
+      #if HAS_FAN2
+        SIGMA_DELTA(PWM_FAN2, FAN_DUTY(2), WRITE_FAN2);
+      #endif
+    #endif
+
+  #elif DISABLED(SLOW_PWM_HEATERS)
     constexpr uint8_t pwm_mask =
       #if ENABLED(SOFT_PWM_DITHER)
         _BV(SOFT_PWM_SCALE) - 1
@@ -119,13 +119,28 @@ class Temperature {
     static uint8_t soft_pwm_amount[HOTENDS],
                    soft_pwm_amount_bed;
 
+    #if ENABLED(SOFT_PWM_SIGMA_DELTA)
+      // The 9 bits of the 16-bit duty below soft_pwm_amount
+      static uint16_t soft_pwm_fine[HOTENDS],
+                      soft_pwm_fine_bed;
+    #endif
+
     #if ENABLED(FAN_SOFT_PWM)
-      static uint8_t soft_pwm_amount_fan[FAN_COUNT],
-                     soft_pwm_count_fan[FAN_COUNT];
+      static uint8_t soft_pwm_amount_fan[FAN_COUNT];
+      #if DISABLED(SOFT_PWM_SIGMA_DELTA)
+        static uint8_t soft_pwm_count_fan[FAN_COUNT];
+      #endif
     #endif
 
     #if ENABLED(PIDTEMP) || ENABLED(PIDTEMPBED)
       #define PID_dT ((OVERSAMPLENR * float(ACTUAL_ADC_SAMPLES)) / (F_CPU / 64.0 / 256.0))
+      #if ENABLED(PID_FIXED_POINT)
+        // Temperatures in 1/16 °C, PID terms in 1/256 of a PWM step
+        #define PID_TEMP(T) int16_t((T) * 16.0 + 0.5)
+        #define PID_TERM(T) ((T) * (1.0 / 256.0))
+      #else
+        #define PID_TERM(T) (T)
+      #endif
     #endif
 
     #if ENABLED(PIDTEMP)
@@ -136,6 +151,9 @@ class Temperature {
         #if ENABLED(PID_EXTRUSION_SCALING)
           static float Kc[HOTENDS];
         #endif
+        #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+          static float Kf[HOTENDS];
+        #endif
         #define PID_PARAM(param, h) Temperature::param[h]
 
       #else
@@ -144,10 +162,17 @@ class Temperature {
         #if ENABLED(PID_EXTRUSION_SCALING)
           static float Kc;
         #endif
+        #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+          static float Kf;
+        #endif
         #define PID_PARAM(param, h) Temperature::param
 
       #endif // PID_PARAMS_PER_HOTEND
 
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        static uint16_t feedforward_lag; // (ms) How far ahead to read the planner
+      #endif
+
       // Apply the scale factors to the PID values
       #define scalePID_i(i)   ( (i) * PID_dT )
       #define unscalePID_i(i) ( (i) / PID_dT )
@@ -197,11 +222,22 @@ class Temperature {
     static volatile bool temp_meas_ready;
 
     #if ENABLED(PIDTEMP)
-      static float temp_iState[HOTENDS],
-                   temp_dState[HOTENDS],
-                   pTerm[HOTENDS],
-                   iTerm[HOTENDS],
-                   dTerm[HOTENDS];
+      #if ENABLED(PID_FIXED_POINT)
+        static int32_t temp_iState[HOTENDS],
+                       pTerm[HOTENDS],
+                       iTerm[HOTENDS],
+                       dTerm[HOTENDS],
+                       fixed_Kp[HOTENDS], fixed_Ki[HOTENDS], fixed_Kd[HOTENDS];
+        static int16_t temp_dState[HOTENDS],
+                       pid_temperature[HOTENDS]; // 1/16 °C, read with current_temperature
+        static int16_t analog2pid(const int raw, const uint8_t e);
+      #else
+        static float temp_iState[HOTENDS],
+                     temp_dState[HOTENDS],
+                     pTerm[HOTENDS],
+                     iTerm[HOTENDS],
+                     dTerm[HOTENDS];
+      #endif
 
       #if ENABLED(PID_EXTRUSION_SCALING)
         static float cTerm[HOTENDS];
@@ -210,17 +246,37 @@ class Temperature {
         static int lpq_ptr;
       #endif
 
-      static float pid_error[HOTENDS];
+      #if ENABLED(PID_EXTRUSION_FEEDFORWARD)
+        static float fTerm[HOTENDS];
+      #endif
+
+      #if ENABLED(PID_FIXED_POINT)
+        static int16_t pid_error[HOTENDS];
+      #else
+        static float pid_error[HOTENDS];
+      #endif
       static bool pid_reset[HOTENDS];
     #endif
 
     #if ENABLED(PIDTEMPBED)
-      static float temp_iState_bed,
-                   temp_dState_bed,
-                   pTerm_bed,
-                   iTerm_bed,
-                   dTerm_bed,
-                   pid_error_bed;
+      #if ENABLED(PID_FIXED_POINT)
+        static int32_t temp_iState_bed,
+                       pTerm_bed,
+                       iTerm_bed,
+                       dTerm_bed,
+                       fixed_bedKp, fixed_bedKi, fixed_bedKd;
+        static int16_t temp_dState_bed,
+                       pid_error_bed,
+                       pid_temperature_bed;
+        static int16_t analog2pidBed(const int raw);
+      #else
+        static float temp_iState_bed,
+                     temp_dState_bed,
+                     pTerm_bed,
+                     iTerm_bed,
+                     dTerm_bed,
+                     pid_error_bed;
+      #endif
     #else
       static millis_t next_bed_check_ms;
     #endif
@@ -294,6 +350,12 @@ class Temperature {
      */
     static float analog2temp(int raw, uint8_t e);
     static float analog2tempBed(int raw);
+    #if ENABLED(THERMISTOR_INDEX_TABLES)
+      static float indextable2temp(const short * const tt, const uint16_t len, const int raw);
+    #endif
+    #if DISABLED(THERMISTOR_INDEX_TABLES) || defined(__MARLIN_NATIVE__)
+      static float temptable2temp(const short (*tt)[2], const uint8_t len, const int raw); // The native build checks one against the other
+    #endif
 
     /**
      * Called from the Temperature ISR
@@ -28,7 +28,10 @@
 
 #define OVERSAMPLENR 16
 
-#define ANY_THERMISTOR_IS(n) (THERMISTORHEATER_0 == n || THERMISTORHEATER_1 == n || THERMISTORHEATER_2 == n || THERMISTORHEATER_3 == n || THERMISTORHEATER_4 == n || THERMISTORBED == n)
+// The native build's --check-thermistors defines it as 1, for every table
+#ifndef ANY_THERMISTOR_IS
+  #define ANY_THERMISTOR_IS(n) (THERMISTORHEATER_0 == n || THERMISTORHEATER_1 == n || THERMISTORHEATER_2 == n || THERMISTORHEATER_3 == n || THERMISTORHEATER_4 == n || THERMISTORBED == n)
+#endif
 
 // Pt1000 and Pt100 handling
 //
@@ -125,7 +128,13 @@
   #include "thermistortable_999.h"
 #endif
 
-#define _TT_NAME(_N) temptable_ ## _N
+#if ENABLED(THERMISTOR_INDEX_TABLES)
+  // Tables with one entry per ADC count, generated from the tables above
+  #include "thermistortables_index.h"
+  #define _TT_NAME(_N) indextable_ ## _N
+#else
+  #define _TT_NAME(_N) temptable_ ## _N
+#endif
 #define TT_NAME(_N) _TT_NAME(_N)
 
 #ifdef THERMISTORHEATER_0
@@ -0,0 +1,2188 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * Based on Sprinter and grbl.
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Thermistor tables indexed by ADC count, for THERMISTOR_INDEX_TABLES
+ *
+ * Entry n is the temperature, in 1/INDEXTABLE_SCALE degC, of a raw reading
+ * of n * OVERSAMPLENR. Readings in between are interpolated, and readings
+ * past the end of a table read its last entry.
+ *
+ * Generated from the thermistortable_*.h tables. Don't edit this file,
+ * change the table and run
+ *
+ *   buildroot/share/scripts/createTemperatureLookupMarlin.py --index Marlin/thermistortable_*.h > Marlin/thermistortables_index.h
+ */
+
+#ifndef THERMISTORTABLES_INDEX_H_
+#define THERMISTORTABLES_INDEX_H_
+
+#define INDEXTABLE_SCALE 16
+
+#if ANY_THERMISTOR_IS(1)
+  // At most 0.03 degC from temptable_1
+  const short indextable_1[] PROGMEM = {
+    5720, 5680, 5640, 5600, 5560, 5520, 5480, 5440, 5400, 5360, 5320, 5280,
+    5240, 5200, 5160, 5120, 5080, 5040, 5000, 4960, 4920, 4880, 4840, 4800,
+    4760, 4720, 4680, 4640, 4560, 4533, 4507, 4480, 4440, 4400, 4360, 4320,
+    4293, 4267, 4240, 4213, 4187, 4160, 4133, 4107, 4080, 4060, 4040, 4020,
+    4000, 3980, 3960, 3940, 3920, 3900, 3880, 3860, 3840, 3824, 3808, 3792,
+    3776, 3760, 3744, 3728, 3712, 3696, 3680, 3664, 3648, 3632, 3616, 3600,
+    3589, 3577, 3566, 3554, 3543, 3531, 3520, 3507, 3493, 3480, 3467, 3453,
+    3440, 3430, 3420, 3410, 3400, 3390, 3380, 3370, 3360, 3350, 3340, 3330,
+    3320, 3310, 3300, 3290, 3280, 3271, 3262, 3253, 3244, 3236, 3227, 3218,
+    3209, 3200, 3193, 3185, 3178, 3171, 3164, 3156, 3149, 3142, 3135, 3127,
+    3120, 3113, 3105, 3098, 3091, 3084, 3076, 3069, 3062, 3055, 3047, 3040,
+    3033, 3027, 3020, 3013, 3007, 3000, 2993, 2987, 2980, 2973, 2967, 2960,
+    2954, 2948, 2942, 2935, 2929, 2923, 2917, 2911, 2905, 2898, 2892, 2886,
+    2880, 2875, 2869, 2864, 2859, 2853, 2848, 2843, 2837, 2832, 2827, 2821,
+    2816, 2811, 2805, 2800, 2795, 2790, 2785, 2780, 2775, 2770, 2765, 2760,
+    2755, 2750, 2745, 2740, 2735, 2730, 2725, 2720, 2716, 2711, 2707, 2702,
+    2698, 2693, 2689, 2684, 2680, 2676, 2671, 2667, 2662, 2658, 2653, 2649,
+    2644, 2640, 2636, 2632, 2627, 2623, 2619, 2615, 2611, 2606, 2602, 2598,
+    2594, 2589, 2585, 2581, 2577, 2573, 2568, 2564, 2560, 2556, 2552, 2549,
+    2545, 2541, 2537, 2533, 2530, 2526, 2522, 2518, 2514, 2510, 2507, 2503,
+    2499, 2495, 2491, 2488, 2484, 2480, 2477, 2473, 2470, 2466, 2463, 2459,
+    2456, 2452, 2449, 2445, 2442, 2438, 2435, 2431, 2428, 2424, 2421, 2417,
+    2414, 2410, 2407, 2403, 2400, 2397, 2394, 2390, 2387, 2384, 2381, 2378,
+    2374, 2371, 2368, 2365, 2362, 2358, 2355, 2352, 2349, 2346, 2342, 2339,
+    2336, 2333, 2330, 2326, 2323, 2320, 2317, 2314, 2311, 2308, 2305, 2302,
+    2299, 2296, 2293, 2290, 2287, 2284, 2281, 2279, 2276, 2273, 2270, 2267,
+    2264, 2261, 2258, 2255, 2252, 2249, 2246, 2243, 2240, 2237, 2234, 2231,
+    2229, 2226, 2223, 2220, 2217, 2214, 2211, 2209, 2206, 2203, 2200, 2197,
+    2194, 2191, 2189, 2186, 2183, 2180, 2177, 2174, 2171, 2169, 2166, 2163,
+    2160, 2157, 2155, 2152, 2150, 2147, 2145, 2142, 2139, 2137, 2134, 2132,
+    2129, 2126, 2124, 2121, 2119, 2116, 2114, 2111, 2108, 2106, 2103, 2101,
+    2098, 2095, 2093, 2090, 2088, 2085, 2083, 2080, 2078, 2075, 2072, 2070,
+    2068, 2065, 2062, 2060, 2058, 2055, 2052, 2050, 2048, 2045, 2042, 2040,
+    2038, 2035, 2032, 2030, 2028, 2025, 2022, 2020, 2018, 2015, 2012, 2010,
+    2008, 2005, 2002, 2000, 1998, 1995, 1993, 1991, 1988, 1986, 1984, 1981,
+    1979, 1976, 1974, 1972, 1969, 1967, 1965, 1962, 1960, 1958, 1955, 1953,
+    1951, 1948, 1946, 1944, 1941, 1939, 1936, 1934, 1932, 1929, 1927, 1925,
+    1922, 1920, 1918, 1915, 1913, 1911, 1909, 1906, 1904, 1902, 1899, 1897,
+    1895, 1893, 1890, 1888, 1886, 1883, 1881, 1879, 1877, 1874, 1872, 1870,
+    1867, 1865, 1863, 1861, 1858, 1856, 1854, 1851, 1849, 1847, 1845, 1842,
+    1840, 1838, 1836, 1833, 1831, 1829, 1827, 1824, 1822, 1820, 1818, 1816,
+    1813, 1811, 1809, 1807, 1804, 1802, 1800, 1798, 1796, 1793, 1791, 1789,
+    1787, 1784, 1782, 1780, 1778, 1776, 1773, 1771, 1769, 1767, 1764, 1762,
+    1760, 1758, 1756, 1754, 1751, 1749, 1747, 1745, 1743, 1741, 1738, 1736,
+    1734, 1732, 1730, 1728, 1725, 1723, 1721, 1719, 1717, 1715, 1712, 1710,
+    1708, 1706, 1704, 1702, 1699, 1697, 1695, 1693, 1691, 1689, 1686, 1684,
+    1682, 1680, 1678, 1676, 1674, 1672, 1669, 1667, 1665, 1663, 1661, 1659,
+    1657, 1655, 1653, 1651, 1648, 1646, 1644, 1642, 1640, 1638, 1636, 1634,
+    1632, 1629, 1627, 1625, 1623, 1621, 1619, 1617, 1615, 1613, 1611, 1608,
+    1606, 1604, 1602, 1600, 1598, 1596, 1594, 1591, 1589, 1587, 1585, 1583,
+    1581, 1578, 1576, 1574, 1572, 1570, 1568, 1565, 1563, 1561, 1559, 1557,
+    1555, 1552, 1550, 1548, 1546, 1544, 1542, 1539, 1537, 1535, 1533, 1531,
+    1529, 1526, 1524, 1522, 1520, 1518, 1516, 1514, 1511, 1509, 1507, 1505,
+    1503, 1501, 1498, 1496, 1494, 1492, 1490, 1488, 1485, 1483, 1481, 1479,
+    1477, 1475, 1472, 1470, 1468, 1466, 1464, 1462, 1459, 1457, 1455, 1453,
+    1451, 1449, 1446, 1444, 1442, 1440, 1438, 1436, 1434, 1431, 1429, 1427,
+    1425, 1423, 1421, 1418, 1416, 1414, 1412, 1410, 1408, 1405, 1403, 1401,
+    1399, 1397, 1395, 1392, 1390, 1388, 1386, 1384, 1382, 1379, 1377, 1375,
+    1373, 1371, 1369, 1366, 1364, 1362, 1360, 1358, 1355, 1353, 1351, 1349,
+    1346, 1344, 1342, 1339, 1337, 1335, 1333, 1330, 1328, 1326, 1323, 1321,
+    1319, 1317, 1314, 1312, 1310, 1307, 1305, 1303, 1301, 1298, 1296, 1294,
+    1291, 1289, 1287, 1285, 1282, 1280, 1278, 1275, 1273, 1270, 1268, 1265,
+    1263, 1261, 1258, 1256, 1253, 1251, 1248, 1246, 1244, 1241, 1239, 1236,
+    1234, 1232, 1229, 1227, 1224, 1222, 1219, 1217, 1215, 1212, 1210, 1207,
+    1205, 1202, 1200, 1197, 1195, 1192, 1190, 1187, 1185, 1182, 1179, 1177,
+    1174, 1172, 1169, 1166, 1164, 1161, 1159, 1156, 1154, 1151, 1148, 1146,
+    1143, 1141, 1138, 1135, 1133, 1130, 1128, 1125, 1123, 1120, 1117, 1114,
+    1112, 1109, 1106, 1103, 1101, 1098, 1095, 1092, 1090, 1087, 1084, 1081,
+    1079, 1076, 1073, 1070, 1068, 1065, 1062, 1059, 1057, 1054, 1051, 1048,
+    1046, 1043, 1040, 1037, 1034, 1031, 1028, 1025, 1022, 1019, 1016, 1013,
+    1010, 1007, 1004, 1001, 999, 996, 993, 990, 987, 984, 981, 978,
+    975, 972, 969, 966, 963, 960, 957, 953, 950, 947, 943, 940,
+    937, 933, 930, 927, 923, 920, 917, 913, 910, 907, 903, 900,
+    897, 893, 890, 887, 883, 880, 876, 873, 869, 865, 862, 858,
+    855, 851, 847, 844, 840, 836, 833, 829, 825, 822, 818, 815,
+    811, 807, 804, 800, 796, 792, 787, 783, 779, 775, 771, 766,
+    762, 758, 754, 749, 745, 741, 737, 733, 728, 724, 720, 715,
+    711, 706, 701, 696, 692, 687, 682, 678, 673, 668, 664, 659,
+    654, 649, 645, 640, 635, 629, 624, 619, 613, 608, 603, 597,
+    592, 587, 581, 576, 571, 565, 560, 553, 547, 540, 533, 527,
+    520, 513, 507, 500, 493, 487, 480, 473, 465, 458, 451, 444,
+    436, 429, 422, 415, 407, 400, 390, 380, 370, 360, 350, 340,
+    330, 320, 310, 300, 290, 280, 270, 260, 250, 240, 227, 213,
+    200, 187, 173, 160, 144, 128, 112, 96, 80, 60, 40, 20,
+    0, -20, -40, -60, -80, -100, -120, -140, -160, -180, -200, -220,
+    -240
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(2)
+  // At most 0.03 degC from temptable_2
+  const short indextable_2[] PROGMEM = {
+    13870, 13568, 13266, 12963, 12661, 12359, 12056, 11754, 11452, 11149, 10847, 10545,
+    10242, 9940, 9638, 9335, 9033, 8730, 8428, 8126, 7823, 7521, 7219, 6916,
+    6614, 6312, 6009, 5707, 5405, 5102, 4800, 4760, 4720, 4680, 4640, 4608,
+    4576, 4544, 4512, 4480, 4457, 4434, 4411, 4389, 4366, 4343, 4320, 4297,
+    4274, 4251, 4229, 4206, 4183, 4160, 4144, 4128, 4112, 4096, 4080, 4064,
+    4048, 4032, 4016, 4000, 3985, 3971, 3956, 3942, 3927, 3913, 3898, 3884,
+    3869, 3855, 3840, 3828, 3815, 3803, 3791, 3778, 3766, 3754, 3742, 3729,
+    3717, 3705, 3692, 3680, 3671, 3661, 3652, 3642, 3633, 3624, 3614, 3605,
+    3595, 3586, 3576, 3567, 3558, 3548, 3539, 3529, 3520, 3512, 3504, 3496,
+    3488, 3480, 3472, 3464, 3456, 3448, 3440, 3432, 3424, 3416, 3408, 3400,
+    3392, 3384, 3376, 3368, 3360, 3353, 3347, 3340, 3333, 3327, 3320, 3313,
+    3307, 3300, 3293, 3287, 3280, 3273, 3267, 3260, 3253, 3247, 3240, 3233,
+    3227, 3220, 3213, 3207, 3200, 3194, 3189, 3183, 3177, 3171, 3166, 3160,
+    3154, 3149, 3143, 3137, 3131, 3126, 3120, 3114, 3109, 3103, 3097, 3091,
+    3086, 3080, 3074, 3069, 3063, 3057, 3051, 3046, 3040, 3035, 3031, 3026,
+    3022, 3017, 3013, 3008, 3003, 2999, 2994, 2990, 2985, 2981, 2976, 2971,
+    2967, 2962, 2958, 2953, 2949, 2944, 2939, 2935, 2930, 2926, 2921, 2917,
+    2912, 2907, 2903, 2898, 2894, 2889, 2885, 2880, 2876, 2872, 2868, 2864,
+    2860, 2857, 2853, 2849, 2845, 2841, 2837, 2833, 2829, 2825, 2821, 2818,
+    2814, 2810, 2806, 2802, 2798, 2794, 2790, 2786, 2782, 2779, 2775, 2771,
+    2767, 2763, 2759, 2755, 2751, 2747, 2743, 2740, 2736, 2732, 2728, 2724,
+    2720, 2717, 2713, 2710, 2707, 2704, 2700, 2697, 2694, 2691, 2687, 2684,
+    2681, 2678, 2674, 2671, 2668, 2664, 2661, 2658, 2655, 2651, 2648, 2645,
+    2642, 2638, 2635, 2632, 2629, 2625, 2622, 2619, 2616, 2612, 2609, 2606,
+    2602, 2599, 2596, 2593, 2589, 2586, 2583, 2580, 2576, 2573, 2570, 2567,
+    2563, 2560, 2557, 2554, 2551, 2549, 2546, 2543, 2540, 2537, 2534, 2531,
+    2529, 2526, 2523, 2520, 2517, 2514, 2511, 2509, 2506, 2503, 2500, 2497,
+    2494, 2491, 2489, 2486, 2483, 2480, 2477, 2474, 2471, 2469, 2466, 2463,
+    2460, 2457, 2454, 2451, 2449, 2446, 2443, 2440, 2437, 2434, 2431, 2429,
+    2426, 2423, 2420, 2417, 2414, 2411, 2409, 2406, 2403, 2400, 2397, 2395,
+    2392, 2390, 2387, 2385, 2382, 2380, 2377, 2375, 2372, 2370, 2367, 2364,
+    2362, 2359, 2357, 2354, 2352, 2349, 2347, 2344, 2342, 2339, 2337, 2334,
+    2331, 2329, 2326, 2324, 2321, 2319, 2316, 2314, 2311, 2309, 2306, 2303,
+    2301, 2298, 2296, 2293, 2291, 2288, 2286, 2283, 2281, 2278, 2276, 2273,
+    2270, 2268, 2265, 2263, 2260, 2258, 2255, 2253, 2250, 2248, 2245, 2243,
+    2240, 2238, 2235, 2233, 2231, 2228, 2226, 2224, 2221, 2219, 2217, 2214,
+    2212, 2210, 2208, 2205, 2203, 2201, 2198, 2196, 2194, 2191, 2189, 2187,
+    2184, 2182, 2180, 2177, 2175, 2173, 2170, 2168, 2166, 2163, 2161, 2159,
+    2157, 2154, 2152, 2150, 2147, 2145, 2143, 2140, 2138, 2136, 2133, 2131,
+    2129, 2126, 2124, 2122, 2119, 2117, 2115, 2112, 2110, 2108, 2106, 2103,
+    2101, 2099, 2096, 2094, 2092, 2089, 2087, 2085, 2082, 2080, 2078, 2076,
+    2073, 2071, 2069, 2067, 2065, 2062, 2060, 2058, 2056, 2054, 2052, 2049,
+    2047, 2045, 2043, 2041, 2038, 2036, 2034, 2032, 2030, 2027, 2025, 2023,
+    2021, 2019, 2016, 2014, 2012, 2010, 2008, 2005, 2003, 2001, 1999, 1997,
+    1995, 1992, 1990, 1988, 1986, 1984, 1981, 1979, 1977, 1975, 1973, 1970,
+    1968, 1966, 1964, 1962, 1959, 1957, 1955, 1953, 1951, 1948, 1946, 1944,
+    1942, 1940, 1938, 1935, 1933, 1931, 1929, 1927, 1924, 1922, 1920, 1918,
+    1916, 1914, 1911, 1909, 1907, 1905, 1903, 1901, 1898, 1896, 1894, 1892,
+    1890, 1888, 1885, 1883, 1881, 1879, 1877, 1875, 1872, 1870, 1868, 1866,
+    1864, 1862, 1859, 1857, 1855, 1853, 1851, 1849, 1846, 1844, 1842, 1840,
+    1838, 1836, 1834, 1831, 1829, 1827, 1825, 1823, 1821, 1818, 1816, 1814,
+    1812, 1810, 1808, 1805, 1803, 1801, 1799, 1797, 1795, 1792, 1790, 1788,
+    1786, 1784, 1782, 1779, 1777, 1775, 1773, 1771, 1769, 1766, 1764, 1762,
+    1760, 1758, 1756, 1753, 1751, 1749, 1747, 1744, 1742, 1740, 1738, 1736,
+    1733, 1731, 1729, 1727, 1724, 1722, 1720, 1718, 1716, 1713, 1711, 1709,
+    1707, 1704, 1702, 1700, 1698, 1696, 1693, 1691, 1689, 1687, 1684, 1682,
+    1680, 1678, 1676, 1673, 1671, 1669, 1667, 1664, 1662, 1660, 1658, 1656,
+    1653, 1651, 1649, 1647, 1644, 1642, 1640, 1638, 1636, 1633, 1631, 1629,
+    1627, 1624, 1622, 1620, 1618, 1616, 1613, 1611, 1609, 1607, 1604, 1602,
+    1600, 1598, 1595, 1593, 1590, 1588, 1586, 1583, 1581, 1579, 1576, 1574,
+    1571, 1569, 1567, 1564, 1562, 1559, 1557, 1555, 1552, 1550, 1547, 1545,
+    1543, 1540, 1538, 1536, 1533, 1531, 1528, 1526, 1524, 1521, 1519, 1516,
+    1514, 1512, 1509, 1507, 1504, 1502, 1500, 1497, 1495, 1493, 1490, 1488,
+    1485, 1483, 1481, 1478, 1476, 1473, 1471, 1469, 1466, 1464, 1461, 1459,
+    1457, 1454, 1452, 1450, 1447, 1445, 1442, 1440, 1437, 1435, 1432, 1429,
+    1427, 1424, 1421, 1419, 1416, 1413, 1411, 1408, 1405, 1403, 1400, 1397,
+    1395, 1392, 1389, 1387, 1384, 1381, 1379, 1376, 1373, 1371, 1368, 1365,
+    1363, 1360, 1357, 1355, 1352, 1349, 1347, 1344, 1341, 1339, 1336, 1333,
+    1331, 1328, 1325, 1323, 1320, 1317, 1315, 1312, 1309, 1307, 1304, 1301,
+    1299, 1296, 1293, 1291, 1288, 1285, 1283, 1280, 1277, 1273, 1270, 1267,
+    1264, 1260, 1257, 1254, 1251, 1247, 1244, 1241, 1238, 1234, 1231, 1228,
+    1224, 1221, 1218, 1215, 1211, 1208, 1205, 1202, 1198, 1195, 1192, 1189,
+    1185, 1182, 1179, 1176, 1172, 1169, 1166, 1162, 1159, 1156, 1153, 1149,
+    1146, 1143, 1140, 1136, 1133, 1130, 1127, 1123, 1120, 1116, 1112, 1108,
+    1104, 1100, 1096, 1092, 1088, 1084, 1080, 1076, 1072, 1068, 1064, 1060,
+    1056, 1052, 1048, 1044, 1040, 1036, 1032, 1028, 1024, 1020, 1016, 1012,
+    1008, 1004, 1000, 996, 992, 988, 984, 980, 976, 972, 968, 964,
+    960, 955, 950, 945, 939, 934, 929, 924, 919, 914, 908, 903,
+    898, 893, 888, 883, 877, 872, 867, 862, 857, 852, 846, 841,
+    836, 831, 826, 821, 815, 810, 805, 800, 793, 785, 778, 771,
+    764, 756, 749, 742, 735, 727, 720, 713, 705, 698, 691, 684,
+    676, 669, 662, 655, 647, 640, 630, 620, 610, 600, 590, 580,
+    570, 560, 550, 540, 530, 520, 510, 500, 490, 480, 465, 451,
+    436, 422, 407, 393, 378, 364, 349, 335, 320, 300, 280, 260,
+    240, 220, 200, 180, 160, 120, 80, 40, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(3)
+  // At most 0.03 degC from temptable_3
+  const short indextable_3[] PROGMEM = {
+    14275, 13824, 13373, 12922, 12470, 12019, 11568, 11117, 10666, 10214, 9763, 9312,
+    8861, 8410, 7958, 7507, 7056, 6605, 6154, 5702, 5251, 4800, 4760, 4720,
+    4680, 4640, 4600, 4560, 4520, 4480, 4440, 4400, 4360, 4320, 4293, 4267,
+    4240, 4213, 4187, 4160, 4137, 4114, 4091, 4069, 4046, 4023, 4000, 3980,
+    3960, 3940, 3920, 3900, 3880, 3860, 3840, 3824, 3808, 3792, 3776, 3760,
+    3744, 3728, 3712, 3696, 3680, 3665, 3651, 3636, 3622, 3607, 3593, 3578,
+    3564, 3549, 3535, 3520, 3509, 3499, 3488, 3477, 3467, 3456, 3445, 3435,
+    3424, 3413, 3403, 3392, 3381, 3371, 3360, 3351, 3341, 3332, 3322, 3313,
+    3304, 3294, 3285, 3275, 3266, 3256, 3247, 3238, 3228, 3219, 3209, 3200,
+    3192, 3185, 3177, 3170, 3162, 3154, 3147, 3139, 3131, 3124, 3116, 3109,
+    3101, 3093, 3086, 3078, 3070, 3063, 3055, 3048, 3040, 3034, 3028, 3022,
+    3015, 3009, 3003, 2997, 2991, 2985, 2978, 2972, 2966, 2960, 2954, 2948,
+    2942, 2935, 2929, 2923, 2917, 2911, 2905, 2898, 2892, 2886, 2880, 2875,
+    2869, 2864, 2859, 2853, 2848, 2843, 2837, 2832, 2827, 2821, 2816, 2811,
+    2805, 2800, 2795, 2789, 2784, 2779, 2773, 2768, 2763, 2757, 2752, 2747,
+    2741, 2736, 2731, 2725, 2720, 2716, 2711, 2707, 2703, 2698, 2694, 2690,
+    2685, 2681, 2677, 2672, 2668, 2664, 2659, 2655, 2651, 2646, 2642, 2638,
+    2634, 2629, 2625, 2621, 2616, 2612, 2608, 2603, 2599, 2595, 2590, 2586,
+    2582, 2577, 2573, 2569, 2564, 2560, 2556, 2553, 2549, 2545, 2542, 2538,
+    2535, 2531, 2527, 2524, 2520, 2516, 2513, 2509, 2505, 2502, 2498, 2495,
+    2491, 2487, 2484, 2480, 2476, 2473, 2469, 2465, 2462, 2458, 2455, 2451,
+    2447, 2444, 2440, 2436, 2433, 2429, 2425, 2422, 2418, 2415, 2411, 2407,
+    2404, 2400, 2397, 2394, 2391, 2387, 2384, 2381, 2378, 2375, 2372, 2369,
+    2365, 2362, 2359, 2356, 2353, 2350, 2347, 2344, 2340, 2337, 2334, 2331,
+    2328, 2325, 2322, 2318, 2315, 2312, 2309, 2306, 2303, 2300, 2296, 2293,
+    2290, 2287, 2284, 2281, 2278, 2275, 2271, 2268, 2265, 2262, 2259, 2256,
+    2253, 2249, 2246, 2243, 2240, 2237, 2235, 2232, 2229, 2226, 2224, 2221,
+    2218, 2216, 2213, 2210, 2207, 2205, 2202, 2199, 2197, 2194, 2191, 2188,
+    2186, 2183, 2180, 2178, 2175, 2172, 2169, 2167, 2164, 2161, 2159, 2156,
+    2153, 2151, 2148, 2145, 2142, 2140, 2137, 2134, 2132, 2129, 2126, 2123,
+    2121, 2118, 2115, 2113, 2110, 2107, 2104, 2102, 2099, 2096, 2094, 2091,
+    2088, 2085, 2083, 2080, 2078, 2075, 2073, 2070, 2068, 2065, 2063, 2061,
+    2058, 2056, 2053, 2051, 2048, 2046, 2044, 2041, 2039, 2036, 2034, 2032,
+    2029, 2027, 2024, 2022, 2019, 2017, 2015, 2012, 2010, 2007, 2005, 2002,
+    2000, 1998, 1995, 1993, 1990, 1988, 1985, 1983, 1981, 1978, 1976, 1973,
+    1971, 1968, 1966, 1964, 1961, 1959, 1956, 1954, 1952, 1949, 1947, 1944,
+    1942, 1939, 1937, 1935, 1932, 1930, 1927, 1925, 1922, 1920, 1918, 1916,
+    1913, 1911, 1909, 1907, 1904, 1902, 1900, 1898, 1896, 1893, 1891, 1889,
+    1887, 1884, 1882, 1880, 1878, 1876, 1873, 1871, 1869, 1867, 1864, 1862,
+    1860, 1858, 1856, 1853, 1851, 1849, 1847, 1844, 1842, 1840, 1838, 1836,
+    1833, 1831, 1829, 1827, 1824, 1822, 1820, 1818, 1816, 1813, 1811, 1809,
+    1807, 1804, 1802, 1800, 1798, 1796, 1793, 1791, 1789, 1787, 1784, 1782,
+    1780, 1778, 1776, 1773, 1771, 1769, 1767, 1764, 1762, 1760, 1758, 1756,
+    1754, 1751, 1749, 1747, 1745, 1743, 1741, 1739, 1737, 1734, 1732, 1730,
+    1728, 1726, 1724, 1722, 1719, 1717, 1715, 1713, 1711, 1709, 1707, 1705,
+    1702, 1700, 1698, 1696, 1694, 1692, 1690, 1687, 1685, 1683, 1681, 1679,
+    1677, 1675, 1673, 1670, 1668, 1666, 1664, 1662, 1660, 1658, 1655, 1653,
+    1651, 1649, 1647, 1645, 1643, 1641, 1638, 1636, 1634, 1632, 1630, 1628,
+    1626, 1623, 1621, 1619, 1617, 1615, 1613, 1611, 1609, 1606, 1604, 1602,
+    1600, 1598, 1596, 1593, 1591, 1589, 1587, 1585, 1582, 1580, 1578, 1576,
+    1574, 1572, 1569, 1567, 1565, 1563, 1561, 1558, 1556, 1554, 1552, 1550,
+    1547, 1545, 1543, 1541, 1539, 1536, 1534, 1532, 1530, 1528, 1525, 1523,
+    1521, 1519, 1517, 1515, 1512, 1510, 1508, 1506, 1504, 1501, 1499, 1497,
+    1495, 1493, 1490, 1488, 1486, 1484, 1482, 1479, 1477, 1475, 1473, 1471,
+    1468, 1466, 1464, 1462, 1460, 1458, 1455, 1453, 1451, 1449, 1447, 1444,
+    1442, 1440, 1438, 1436, 1433, 1431, 1429, 1427, 1425, 1422, 1420, 1418,
+    1416, 1414, 1412, 1409, 1407, 1405, 1403, 1401, 1398, 1396, 1394, 1392,
+    1390, 1387, 1385, 1383, 1381, 1379, 1376, 1374, 1372, 1370, 1368, 1365,
+    1363, 1361, 1359, 1357, 1355, 1352, 1350, 1348, 1346, 1344, 1341, 1339,
+    1337, 1335, 1333, 1330, 1328, 1326, 1324, 1322, 1319, 1317, 1315, 1313,
+    1311, 1308, 1306, 1304, 1302, 1300, 1298, 1295, 1293, 1291, 1289, 1287,
+    1284, 1282, 1280, 1277, 1275, 1272, 1270, 1267, 1264, 1262, 1259, 1256,
+    1254, 1251, 1249, 1246, 1243, 1241, 1238, 1235, 1233, 1230, 1228, 1225,
+    1222, 1220, 1217, 1214, 1212, 1209, 1207, 1204, 1201, 1199, 1196, 1193,
+    1191, 1188, 1186, 1183, 1180, 1178, 1175, 1172, 1170, 1167, 1165, 1162,
+    1159, 1157, 1154, 1151, 1149, 1146, 1144, 1141, 1138, 1136, 1133, 1130,
+    1128, 1125, 1123, 1120, 1117, 1115, 1112, 1110, 1107, 1104, 1102, 1099,
+    1096, 1094, 1091, 1089, 1086, 1083, 1081, 1078, 1075, 1073, 1070, 1068,
+    1065, 1062, 1060, 1057, 1054, 1052, 1049, 1047, 1044, 1041, 1039, 1036,
+    1033, 1031, 1028, 1026, 1023, 1020, 1018, 1015, 1012, 1010, 1007, 1005,
+    1002, 999, 997, 994, 991, 989, 986, 984, 981, 978, 976, 973,
+    970, 968, 965, 963, 960, 956, 952, 948, 944, 940, 937, 933,
+    929, 925, 921, 917, 913, 909, 905, 901, 898, 894, 890, 886,
+    882, 878, 874, 870, 866, 862, 859, 855, 851, 847, 843, 839,
+    835, 831, 827, 823, 820, 816, 812, 808, 804, 800, 796, 792,
+    788, 784, 780, 777, 773, 769, 765, 761, 757, 753, 749, 745,
+    741, 738, 734, 730, 726, 722, 718, 714, 710, 706, 702, 699,
+    695, 691, 687, 683, 679, 675, 671, 667, 663, 660, 656, 652,
+    648, 644, 640, 633, 627, 620, 613, 607, 600, 593, 587, 580,
+    573, 567, 560, 553, 547, 540, 533, 527, 520, 513, 507, 500,
+    493, 487, 480, 473, 467, 460, 453, 447, 440, 433, 427, 420,
+    413, 407, 400, 393, 387, 380, 373, 367, 360, 353, 347, 340,
+    333, 327, 320, 305, 291, 276, 262, 247, 233, 218, 204, 189,
+    175, 160, 145, 131, 116, 102, 87, 73, 58, 44, 29, 15,
+    0, -32, -64, -96, -128, -160, -192, -224, -256, -288, -320
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(4)
+  // At most 0.03 degC from temptable_4
+  const short indextable_4[] PROGMEM = {
+    6968, 6880, 6792, 6703, 6615, 6526, 6438, 6349, 6261, 6172, 6084, 5995,
+    5907, 5819, 5730, 5642, 5553, 5465, 5376, 5288, 5199, 5111, 5022, 4934,
+    4846, 4757, 4669, 4580, 4492, 4403, 4315, 4226, 4138, 4050, 3961, 3873,
+    3784, 3696, 3607, 3519, 3430, 3342, 3253, 3165, 3077, 2988, 2900, 2811,
+    2723, 2634, 2546, 2457, 2369, 2280, 2192, 2183, 2174, 2165, 2156, 2147,
+    2138, 2129, 2120, 2110, 2101, 2092, 2083, 2074, 2065, 2056, 2047, 2038,
+    2029, 2020, 2011, 2002, 1993, 1984, 1975, 1966, 1957, 1947, 1938, 1929,
+    1920, 1911, 1902, 1893, 1884, 1875, 1866, 1857, 1848, 1839, 1830, 1821,
+    1812, 1803, 1794, 1784, 1775, 1766, 1757, 1748, 1739, 1730, 1721, 1712,
+    1707, 1702, 1698, 1693, 1688, 1683, 1678, 1673, 1669, 1664, 1659, 1654,
+    1649, 1644, 1640, 1635, 1630, 1625, 1620, 1615, 1611, 1606, 1601, 1596,
+    1591, 1586, 1582, 1577, 1572, 1567, 1562, 1557, 1553, 1548, 1543, 1538,
+    1533, 1528, 1524, 1519, 1514, 1509, 1504, 1499, 1495, 1490, 1485, 1480,
+    1475, 1470, 1466, 1461, 1456, 1453, 1449, 1446, 1443, 1439, 1436, 1433,
+    1429, 1426, 1423, 1419, 1416, 1413, 1410, 1406, 1403, 1400, 1396, 1393,
+    1390, 1386, 1383, 1380, 1376, 1373, 1370, 1366, 1363, 1360, 1356, 1353,
+    1350, 1346, 1343, 1340, 1336, 1333, 1330, 1326, 1323, 1320, 1317, 1313,
+    1310, 1307, 1303, 1300, 1297, 1293, 1290, 1287, 1283, 1280, 1277, 1275,
+    1272, 1269, 1266, 1264, 1261, 1258, 1256, 1253, 1250, 1247, 1245, 1242,
+    1239, 1237, 1234, 1231, 1228, 1226, 1223, 1220, 1218, 1215, 1212, 1209,
+    1207, 1204, 1201, 1198, 1196, 1193, 1190, 1188, 1185, 1182, 1179, 1177,
+    1174, 1171, 1169, 1166, 1163, 1160, 1158, 1155, 1152, 1150, 1147, 1144,
+    1141, 1139, 1136, 1134, 1132, 1130, 1128, 1125, 1123, 1121, 1119, 1117,
+    1115, 1113, 1111, 1109, 1106, 1104, 1102, 1100, 1098, 1096, 1094, 1092,
+    1090, 1087, 1085, 1083, 1081, 1079, 1077, 1075, 1073, 1070, 1068, 1066,
+    1064, 1062, 1060, 1058, 1056, 1054, 1051, 1049, 1047, 1045, 1043, 1041,
+    1039, 1037, 1035, 1032, 1030, 1028, 1026, 1024, 1022, 1020, 1018, 1016,
+    1013, 1011, 1009, 1007, 1005, 1003, 1001, 999, 997, 994, 992, 990,
+    988, 986, 984, 982, 980, 978, 975, 973, 971, 969, 967, 965,
+    963, 961, 958, 956, 954, 952, 950, 948, 946, 944, 942, 939,
+    937, 935, 933, 931, 929, 927, 925, 923, 920, 918, 916, 914,
+    912, 910, 908, 907, 905, 903, 901, 899, 898, 896, 894, 892,
+    890, 888, 887, 885, 883, 881, 879, 878, 876, 874, 872, 870,
+    869, 867, 865, 863, 861, 859, 858, 856, 854, 852, 850, 849,
+    847, 845, 843, 841, 840, 838, 836, 834, 832, 830, 829, 827,
+    825, 823, 821, 820, 818, 816, 814, 813, 811, 810, 808, 807,
+    805, 804, 802, 801, 799, 798, 796, 795, 793, 792, 790, 789,
+    787, 786, 784, 783, 781, 780, 778, 777, 775, 774, 772, 771,
+    769, 768, 766, 765, 763, 762, 760, 759, 757, 756, 754, 753,
+    751, 750, 748, 747, 745, 744, 742, 741, 739, 738, 736, 734,
+    733, 731, 730, 728, 727, 725, 724, 722, 721, 719, 718, 716,
+    715, 713, 712, 710, 709, 707, 706, 704, 703, 701, 700, 698,
+    697, 695, 694, 692, 691, 689, 688, 686, 685, 683, 682, 680,
+    679, 677, 676, 674, 673, 671, 670, 668, 667, 665, 664, 662,
+    661, 659, 658, 656, 654, 652, 651, 649, 647, 645, 643, 642,
+    640, 638, 636, 634, 632, 631, 629, 627, 625, 623, 622, 620,
+    618, 616, 614, 613, 611, 609, 607, 605, 603, 602, 600, 598,
+    596, 594, 593, 591, 589, 587, 585, 584, 582, 580, 578, 576,
+    574, 573, 571, 569, 567, 565, 564, 562, 560, 558, 557, 555,
+    554, 552, 551, 549, 548, 546, 545, 543, 542, 540, 539, 537,
+    536, 534, 533, 531, 530, 528, 527, 525, 524, 522, 521, 519,
+    518, 516, 515, 513, 512, 510, 509, 507, 506, 504, 503, 501,
+    500, 498, 497, 495, 494, 492, 491, 489, 488, 486, 485, 483,
+    482, 480, 478, 477, 475, 474, 472, 471, 469, 468, 466, 465,
+    463, 462, 460, 459, 457, 456, 454, 453, 451, 450, 448, 447,
+    445, 444, 442, 441, 439, 438, 436, 435, 433, 432, 430, 429,
+    427, 426, 424, 423, 421, 420, 418, 417, 415, 414, 412, 411,
+    409, 408, 406, 405, 403, 402, 400, 398, 397, 395, 394, 392,
+    391, 389, 388, 386, 385, 383, 382, 380, 379, 377, 376, 374,
+    373, 371, 370, 368, 367, 365, 364, 362, 361, 359, 358, 356,
+    355, 353, 352, 350, 349, 347, 346, 344, 343, 341, 340, 338,
+    337, 335, 334, 332, 331, 329, 328, 326, 325, 323, 322, 320,
+    318, 316, 315, 313, 311, 309, 307, 306, 304, 302, 300, 298,
+    296, 295, 293, 291, 289, 287, 286, 284, 282, 280, 278, 277,
+    275, 273, 271, 269, 267, 266, 264, 262, 260, 258, 257, 255,
+    253, 251, 249, 248, 246, 244, 242, 240, 238, 237, 235, 233,
+    231, 229, 228, 226, 224, 222, 220, 218, 216, 213, 211, 209,
+    207, 205, 203, 201, 199, 197, 194, 192, 190, 188, 186, 184,
+    182, 180, 178, 175, 173, 171, 169, 167, 165, 163, 161, 158,
+    156, 154, 152, 150, 148, 146, 144, 142, 139, 137, 135, 133,
+    131, 129, 127, 125, 123, 120, 118, 116, 114, 112, 110, 108,
+    106, 104, 101, 99, 97, 95, 93, 91, 89, 87, 85, 82,
+    80, 78, 76, 74, 72, 70, 68, 66, 63, 61, 59, 57,
+    55, 53, 51, 49, 46, 44, 42, 40, 38, 36, 34, 32,
+    30, 27, 25, 23, 21, 19, 17, 15, 13, 11, 8, 6,
+    4, 2, 0, -3, -7, -10, -13, -17, -20, -23, -27, -30,
+    -33, -37, -40, -43, -46, -50, -53, -56, -60, -63, -66, -70,
+    -73, -76, -80, -83, -86, -90, -93, -96, -100, -103, -106, -110,
+    -113, -116, -120, -123, -126, -130, -133, -136, -139, -143, -146, -149,
+    -153, -156, -159, -163, -166, -169, -173, -176, -183, -190, -198, -205,
+    -212, -219, -227, -234, -241, -248, -256, -263, -270, -277, -285, -292,
+    -299, -306, -314, -321, -328, -335, -343, -350, -357, -364, -372, -379,
+    -386, -393, -401, -408, -415, -422, -430, -437, -444, -451, -459, -466,
+    -473, -480, -488, -495, -502, -509, -517, -524, -531, -538, -546, -553,
+    -560
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(5)
+  // At most 0.03 degC from temptable_5
+  const short indextable_5[] PROGMEM = {
+    11821, 11408, 10995, 10582, 10169, 9756, 9343, 8930, 8517, 8104, 7691, 7278,
+    6865, 6452, 6039, 5626, 5213, 4800, 4747, 4693, 4640, 4587, 4533, 4480,
+    4440, 4400, 4360, 4320, 4280, 4240, 4200, 4160, 4133, 4107, 4080, 4053,
+    4027, 4000, 3973, 3947, 3920, 3893, 3867, 3840, 3820, 3800, 3780, 3760,
+    3740, 3720, 3700, 3680, 3664, 3648, 3632, 3616, 3600, 3584, 3568, 3552,
+    3536, 3520, 3507, 3493, 3480, 3467, 3453, 3440, 3427, 3413, 3400, 3387,
+    3373, 3360, 3349, 3337, 3326, 3314, 3303, 3291, 3280, 3269, 3257, 3246,
+    3234, 3223, 3211, 3200, 3192, 3183, 3175, 3166, 3158, 3149, 3141, 3133,
+    3124, 3116, 3107, 3099, 3091, 3082, 3074, 3065, 3057, 3048, 3040, 3033,
+    3025, 3018, 3011, 3004, 2996, 2989, 2982, 2975, 2967, 2960, 2953, 2945,
+    2938, 2931, 2924, 2916, 2909, 2902, 2895, 2887, 2880, 2874, 2868, 2862,
+    2856, 2850, 2844, 2839, 2833, 2827, 2821, 2815, 2809, 2803, 2797, 2791,
+    2785, 2779, 2773, 2767, 2761, 2756, 2750, 2744, 2738, 2732, 2726, 2720,
+    2715, 2711, 2706, 2701, 2696, 2692, 2687, 2682, 2678, 2673, 2668, 2664,
+    2659, 2654, 2649, 2645, 2640, 2635, 2631, 2626, 2621, 2616, 2612, 2607,
+    2602, 2598, 2593, 2588, 2584, 2579, 2574, 2569, 2565, 2560, 2556, 2552,
+    2548, 2544, 2540, 2537, 2533, 2529, 2525, 2521, 2517, 2513, 2509, 2505,
+    2501, 2498, 2494, 2490, 2486, 2482, 2478, 2474, 2470, 2466, 2462, 2459,
+    2455, 2451, 2447, 2443, 2439, 2435, 2431, 2427, 2423, 2420, 2416, 2412,
+    2408, 2404, 2400, 2397, 2393, 2390, 2387, 2383, 2380, 2377, 2373, 2370,
+    2367, 2363, 2360, 2357, 2353, 2350, 2347, 2343, 2340, 2337, 2333, 2330,
+    2327, 2323, 2320, 2317, 2313, 2310, 2307, 2303, 2300, 2297, 2293, 2290,
+    2287, 2283, 2280, 2277, 2273, 2270, 2267, 2263, 2260, 2257, 2253, 2250,
+    2247, 2243, 2240, 2237, 2234, 2232, 2229, 2226, 2223, 2221, 2218, 2215,
+    2212, 2210, 2207, 2204, 2201, 2199, 2196, 2193, 2190, 2188, 2185, 2182,
+    2179, 2177, 2174, 2171, 2168, 2166, 2163, 2160, 2157, 2154, 2152, 2149,
+    2146, 2143, 2141, 2138, 2135, 2132, 2130, 2127, 2124, 2121, 2119, 2116,
+    2113, 2110, 2108, 2105, 2102, 2099, 2097, 2094, 2091, 2088, 2086, 2083,
+    2080, 2078, 2075, 2073, 2070, 2068, 2065, 2063, 2061, 2058, 2056, 2053,
+    2051, 2048, 2046, 2044, 2041, 2039, 2036, 2034, 2032, 2029, 2027, 2024,
+    2022, 2019, 2017, 2015, 2012, 2010, 2007, 2005, 2002, 2000, 1998, 1995,
+    1993, 1990, 1988, 1985, 1983, 1981, 1978, 1976, 1973, 1971, 1968, 1966,
+    1964, 1961, 1959, 1956, 1954, 1952, 1949, 1947, 1944, 1942, 1939, 1937,
+    1935, 1932, 1930, 1927, 1925, 1922, 1920, 1918, 1916, 1914, 1911, 1909,
+    1907, 1905, 1903, 1901, 1898, 1896, 1894, 1892, 1890, 1888, 1885, 1883,
+    1881, 1879, 1877, 1875, 1872, 1870, 1868, 1866, 1864, 1862, 1859, 1857,
+    1855, 1853, 1851, 1849, 1846, 1844, 1842, 1840, 1838, 1836, 1834, 1831,
+    1829, 1827, 1825, 1823, 1821, 1818, 1816, 1814, 1812, 1810, 1808, 1805,
+    1803, 1801, 1799, 1797, 1795, 1792, 1790, 1788, 1786, 1784, 1782, 1779,
+    1777, 1775, 1773, 1771, 1769, 1766, 1764, 1762, 1760, 1758, 1756, 1754,
+    1752, 1750, 1748, 1746, 1744, 1742, 1739, 1737, 1735, 1733, 1731, 1729,
+    1727, 1725, 1723, 1721, 1719, 1717, 1715, 1713, 1711, 1709, 1707, 1705,
+    1703, 1701, 1698, 1696, 1694, 1692, 1690, 1688, 1686, 1684, 1682, 1680,
+    1678, 1676, 1674, 1672, 1670, 1668, 1666, 1664, 1662, 1659, 1657, 1655,
+    1653, 1651, 1649, 1647, 1645, 1643, 1641, 1639, 1637, 1635, 1633, 1631,
+    1629, 1627, 1625, 1623, 1621, 1618, 1616, 1614, 1612, 1610, 1608, 1606,
+    1604, 1602, 1600, 1598, 1596, 1594, 1592, 1590, 1588, 1586, 1584, 1582,
+    1580, 1578, 1576, 1574, 1572, 1570, 1568, 1566, 1564, 1562, 1560, 1559,
+    1557, 1555, 1553, 1551, 1549, 1547, 1545, 1543, 1541, 1539, 1537, 1535,
+    1533, 1531, 1529, 1527, 1525, 1523, 1521, 1519, 1517, 1515, 1513, 1511,
+    1509, 1507, 1505, 1503, 1501, 1499, 1497, 1495, 1493, 1491, 1489, 1487,
+    1485, 1483, 1481, 1480, 1478, 1476, 1474, 1472, 1470, 1468, 1466, 1464,
+    1462, 1460, 1458, 1456, 1454, 1452, 1450, 1448, 1446, 1444, 1442, 1440,
+    1438, 1436, 1434, 1432, 1430, 1428, 1426, 1424, 1422, 1419, 1417, 1415,
+    1413, 1411, 1409, 1407, 1405, 1403, 1401, 1399, 1397, 1395, 1393, 1391,
+    1389, 1387, 1385, 1383, 1381, 1378, 1376, 1374, 1372, 1370, 1368, 1366,
+    1364, 1362, 1360, 1358, 1356, 1354, 1352, 1350, 1348, 1346, 1344, 1342,
+    1339, 1337, 1335, 1333, 1331, 1329, 1327, 1325, 1323, 1321, 1319, 1317,
+    1315, 1313, 1311, 1309, 1307, 1305, 1303, 1301, 1298, 1296, 1294, 1292,
+    1290, 1288, 1286, 1284, 1282, 1280, 1278, 1275, 1273, 1271, 1269, 1266,
+    1264, 1262, 1260, 1257, 1255, 1253, 1251, 1248, 1246, 1244, 1242, 1239,
+    1237, 1235, 1233, 1230, 1228, 1226, 1224, 1221, 1219, 1217, 1215, 1212,
+    1210, 1208, 1206, 1203, 1201, 1199, 1197, 1194, 1192, 1190, 1188, 1185,
+    1183, 1181, 1179, 1176, 1174, 1172, 1170, 1167, 1165, 1163, 1161, 1158,
+    1156, 1154, 1152, 1149, 1147, 1145, 1143, 1140, 1138, 1136, 1134, 1131,
+    1129, 1127, 1125, 1122, 1120, 1117, 1115, 1112, 1110, 1107, 1105, 1102,
+    1099, 1097, 1094, 1092, 1089, 1086, 1084, 1081, 1079, 1076, 1074, 1071,
+    1068, 1066, 1063, 1061, 1058, 1055, 1053, 1050, 1048, 1045, 1043, 1040,
+    1037, 1035, 1032, 1030, 1027, 1025, 1022, 1019, 1017, 1014, 1012, 1009,
+    1006, 1004, 1001, 999, 996, 994, 991, 988, 986, 983, 981, 978,
+    975, 973, 970, 968, 965, 963, 960, 957, 954, 951, 947, 944,
+    941, 938, 935, 932, 929, 925, 922, 919, 916, 913, 910, 907,
+    904, 900, 897, 894, 891, 888, 885, 882, 878, 875, 872, 869,
+    866, 863, 860, 856, 853, 850, 847, 844, 841, 838, 835, 831,
+    828, 825, 822, 819, 816, 813, 809, 806, 803, 800, 796, 792,
+    788, 784, 780, 776, 772, 768, 764, 760, 756, 752, 748, 744,
+    740, 736, 732, 728, 724, 720, 716, 712, 708, 704, 700, 696,
+    692, 688, 684, 680, 676, 672, 668, 664, 660, 656, 652, 648,
+    644, 640, 634, 629, 623, 618, 612, 607, 601, 596, 590, 585,
+    579, 574, 568, 563, 557, 552, 546, 541, 535, 530, 524, 519,
+    513, 508, 502, 497, 491, 486, 480, 472, 464, 456, 448, 440,
+    432, 424, 416, 408, 400, 392, 384, 376, 368, 360, 352, 344,
+    336, 328, 320, 309, 297, 286, 274, 263, 251, 240, 229, 217,
+    206, 194, 183, 171, 160, 144, 128, 112, 96, 80, 64, 48,
+    32, 16, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(6)
+  // At most 4.69 degC from temptable_6
+  const short indextable_6[] PROGMEM = {
+    5659, 5600, 5541, 5481, 5422, 5363, 5304, 5244, 5185, 5126, 5067, 5007,
+    4948, 4889, 4830, 4770, 4711, 4652, 4593, 4533, 4474, 4415, 4356, 4296,
+    4237, 4178, 4119, 4059, 4000, 3973, 3947, 3920, 3900, 3880, 3860, 3840,
+    3820, 3800, 3780, 3760, 3733, 3707, 3680, 3640, 3600, 3584, 3568, 3552,
+    3536, 3520, 3500, 3480, 3460, 3440, 3431, 3422, 3413, 3404, 3396, 3387,
+    3378, 3369, 3360, 3351, 3342, 3333, 3324, 3316, 3307, 3298, 3289, 3280,
+    3269, 3257, 3246, 3234, 3223, 3211, 3200, 3190, 3180, 3170, 3160, 3150,
+    3140, 3130, 3120, 3110, 3100, 3090, 3080, 3070, 3060, 3050, 3040, 3030,
+    3020, 3010, 3000, 2990, 2980, 2970, 2960, 2943, 2926, 2909, 2891, 2874,
+    2857, 2840, 2823, 2806, 2789, 2771, 2754, 2737, 2720, 2714, 2708, 2702,
+    2696, 2690, 2684, 2679, 2673, 2667, 2661, 2655, 2649, 2643, 2637, 2631,
+    2625, 2619, 2613, 2607, 2601, 2596, 2590, 2584, 2578, 2572, 2566, 2560,
+    2556, 2552, 2548, 2544, 2540, 2536, 2532, 2528, 2524, 2520, 2516, 2512,
+    2508, 2504, 2500, 2496, 2492, 2488, 2484, 2480, 2476, 2472, 2468, 2464,
+    2460, 2456, 2452, 2448, 2444, 2440, 2436, 2432, 2428, 2424, 2420, 2416,
+    2412, 2408, 2404, 2400, 2396, 2392, 2388, 2384, 2380, 2376, 2372, 2368,
+    2364, 2360, 2356, 2352, 2348, 2344, 2340, 2336, 2332, 2328, 2324, 2320,
+    2316, 2312, 2308, 2304, 2300, 2296, 2292, 2288, 2284, 2280, 2276, 2272,
+    2268, 2264, 2260, 2256, 2252, 2248, 2244, 2240, 2237, 2233, 2230, 2226,
+    2223, 2220, 2216, 2213, 2209, 2206, 2203, 2199, 2196, 2192, 2189, 2186,
+    2182, 2179, 2175, 2172, 2169, 2165, 2162, 2158, 2155, 2151, 2148, 2145,
+    2141, 2138, 2134, 2131, 2128, 2124, 2121, 2117, 2114, 2111, 2107, 2104,
+    2100, 2097, 2094, 2090, 2087, 2083, 2080, 2077, 2073, 2070, 2067, 2063,
+    2060, 2057, 2053, 2050, 2047, 2043, 2040, 2037, 2033, 2030, 2027, 2023,
+    2020, 2017, 2013, 2010, 2007, 2003, 2000, 1997, 1993, 1990, 1987, 1983,
+    1980, 1977, 1973, 1970, 1967, 1963, 1960, 1957, 1953, 1950, 1947, 1943,
+    1940, 1937, 1933, 1930, 1927, 1923, 1920, 1918, 1915, 1913, 1910, 1908,
+    1905, 1903, 1900, 1898, 1895, 1893, 1890, 1888, 1886, 1883, 1881, 1878,
+    1876, 1873, 1871, 1868, 1866, 1863, 1861, 1858, 1856, 1854, 1851, 1849,
+    1846, 1844, 1841, 1839, 1836, 1834, 1831, 1829, 1826, 1824, 1822, 1819,
+    1817, 1814, 1812, 1809, 1807, 1804, 1802, 1799, 1797, 1794, 1792, 1790,
+    1787, 1785, 1782, 1780, 1777, 1775, 1772, 1770, 1767, 1765, 1762, 1760,
+    1757, 1755, 1752, 1749, 1747, 1744, 1741, 1739, 1736, 1733, 1731, 1728,
+    1725, 1723, 1720, 1717, 1715, 1712, 1709, 1707, 1704, 1701, 1699, 1696,
+    1693, 1691, 1688, 1685, 1683, 1680, 1677, 1674, 1671, 1668, 1665, 1662,
+    1658, 1655, 1652, 1649, 1646, 1643, 1640, 1637, 1634, 1631, 1628, 1625,
+    1622, 1618, 1615, 1612, 1609, 1606, 1603, 1600, 1598, 1596, 1595, 1593,
+    1591, 1589, 1588, 1586, 1584, 1582, 1580, 1579, 1577, 1575, 1573, 1572,
+    1570, 1568, 1566, 1564, 1563, 1561, 1559, 1557, 1556, 1554, 1552, 1550,
+    1548, 1547, 1545, 1543, 1541, 1540, 1538, 1536, 1534, 1532, 1531, 1529,
+    1527, 1525, 1524, 1522, 1520, 1517, 1514, 1512, 1509, 1506, 1503, 1501,
+    1498, 1495, 1492, 1490, 1487, 1484, 1481, 1479, 1476, 1473, 1470, 1468,
+    1465, 1462, 1459, 1457, 1454, 1451, 1448, 1446, 1443, 1440, 1438, 1437,
+    1435, 1433, 1431, 1430, 1428, 1426, 1425, 1423, 1421, 1420, 1418, 1416,
+    1414, 1413, 1411, 1409, 1408, 1406, 1404, 1403, 1401, 1399, 1397, 1396,
+    1394, 1392, 1391, 1389, 1387, 1386, 1384, 1382, 1380, 1379, 1377, 1375,
+    1374, 1372, 1370, 1369, 1367, 1365, 1363, 1362, 1360, 1358, 1357, 1355,
+    1353, 1351, 1350, 1348, 1346, 1345, 1343, 1341, 1340, 1338, 1336, 1334,
+    1333, 1331, 1329, 1328, 1326, 1324, 1323, 1321, 1319, 1317, 1316, 1314,
+    1312, 1311, 1309, 1307, 1306, 1304, 1302, 1300, 1299, 1297, 1295, 1294,
+    1292, 1290, 1289, 1287, 1285, 1283, 1282, 1280, 1277, 1274, 1272, 1269,
+    1266, 1263, 1260, 1258, 1255, 1252, 1249, 1246, 1244, 1241, 1238, 1235,
+    1232, 1229, 1227, 1224, 1221, 1218, 1215, 1213, 1210, 1207, 1204, 1201,
+    1199, 1196, 1193, 1190, 1187, 1185, 1182, 1179, 1176, 1173, 1171, 1168,
+    1165, 1162, 1159, 1156, 1154, 1151, 1148, 1145, 1142, 1140, 1137, 1134,
+    1131, 1128, 1126, 1123, 1120, 1119, 1117, 1116, 1115, 1113, 1112, 1110,
+    1109, 1108, 1106, 1105, 1104, 1102, 1101, 1099, 1098, 1097, 1095, 1094,
+    1093, 1091, 1090, 1089, 1087, 1086, 1084, 1083, 1082, 1080, 1079, 1078,
+    1076, 1075, 1074, 1072, 1071, 1069, 1068, 1067, 1065, 1064, 1063, 1061,
+    1060, 1058, 1057, 1056, 1054, 1053, 1052, 1050, 1049, 1048, 1046, 1045,
+    1043, 1042, 1041, 1039, 1038, 1037, 1035, 1034, 1032, 1031, 1030, 1028,
+    1027, 1026, 1024, 1023, 1022, 1020, 1019, 1017, 1016, 1015, 1013, 1012,
+    1011, 1009, 1008, 1006, 1005, 1004, 1002, 1001, 1000, 998, 997, 996,
+    994, 993, 991, 990, 989, 987, 986, 985, 983, 982, 981, 979,
+    978, 976, 975, 974, 972, 971, 970, 968, 967, 965, 964, 963,
+    961, 960, 957, 954, 952, 949, 946, 943, 941, 938, 935, 932,
+    930, 927, 924, 921, 919, 916, 913, 910, 908, 905, 902, 899,
+    897, 894, 891, 888, 886, 883, 880, 878, 876, 874, 872, 870,
+    868, 866, 864, 862, 859, 857, 855, 853, 851, 849, 847, 845,
+    843, 841, 839, 837, 835, 833, 831, 829, 827, 825, 823, 821,
+    818, 816, 814, 812, 810, 808, 806, 804, 802, 800, 799, 798,
+    796, 795, 794, 793, 791, 790, 789, 788, 786, 785, 784, 783,
+    782, 780, 779, 778, 777, 775, 774, 773, 772, 770, 769, 768,
+    767, 766, 764, 763, 762, 761, 759, 758, 757, 756, 754, 753,
+    752, 751, 750, 748, 747, 746, 745, 743, 742, 741, 740, 738,
+    737, 736, 735, 734, 732, 731, 730, 729, 727, 726, 725, 724,
+    722, 721, 640, 636, 632, 629, 625, 621, 617, 613, 610, 606,
+    602, 598, 594, 590, 587, 583, 579, 575, 571, 568, 564, 560,
+    556, 552, 547, 543, 539, 535, 531, 526, 522, 518, 514, 509,
+    505, 501, 497, 493, 488, 484, 480, 475, 470, 465, 460, 455,
+    450, 445, 440, 435, 430, 425, 420, 415, 410, 405, 400, 394,
+    388, 382, 376, 370, 364, 358, 352, 342, 332, 322, 311, 301,
+    291, 281, 271, 261, 251, 241, 230, 220, 210, 200, 190, 180,
+    170, 159, 149, 139, 129, 119, 109, 99, 89, 78, 68, 58,
+    48, 45, 42, 38, 35, 32, 29, 26, 22, 19, 16, 13,
+    10, 6, 3, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(7)
+  // At most 0.03 degC from temptable_7
+  const short indextable_7[] PROGMEM = {
+    15571, 15056, 14541, 14027, 13512, 12997, 12483, 11968, 11453, 10939, 10424, 9909,
+    9395, 8880, 8365, 7851, 7336, 6821, 6307, 5792, 5736, 5680, 5624, 5568,
+    5512, 5456, 5400, 5344, 5288, 5232, 5176, 5120, 5064, 5008, 4952, 4896,
+    4840, 4784, 4755, 4725, 4696, 4667, 4637, 4608, 4579, 4549, 4520, 4491,
+    4461, 4432, 4403, 4373, 4344, 4315, 4285, 4256, 4237, 4219, 4200, 4181,
+    4163, 4144, 4125, 4107, 4088, 4069, 4051, 4032, 4013, 3995, 3976, 3957,
+    3939, 3920, 3906, 3892, 3877, 3863, 3849, 3835, 3820, 3806, 3792, 3778,
+    3764, 3749, 3735, 3721, 3707, 3692, 3678, 3664, 3652, 3641, 3629, 3618,
+    3606, 3595, 3583, 3572, 3560, 3548, 3537, 3525, 3514, 3502, 3491, 3479,
+    3468, 3456, 3447, 3438, 3429, 3420, 3412, 3403, 3394, 3385, 3376, 3367,
+    3358, 3349, 3340, 3332, 3323, 3314, 3305, 3296, 3288, 3280, 3272, 3264,
+    3256, 3248, 3240, 3232, 3224, 3216, 3208, 3200, 3192, 3184, 3176, 3168,
+    3160, 3152, 3146, 3140, 3133, 3127, 3121, 3115, 3108, 3102, 3096, 3090,
+    3084, 3077, 3071, 3065, 3059, 3052, 3046, 3040, 3034, 3028, 3021, 3015,
+    3009, 3003, 2996, 2990, 2984, 2978, 2972, 2965, 2959, 2953, 2947, 2940,
+    2934, 2928, 2923, 2917, 2912, 2907, 2901, 2896, 2891, 2885, 2880, 2875,
+    2869, 2864, 2859, 2853, 2848, 2843, 2837, 2832, 2827, 2821, 2816, 2811,
+    2805, 2800, 2795, 2789, 2784, 2779, 2773, 2768, 2763, 2757, 2752, 2747,
+    2741, 2736, 2732, 2727, 2723, 2718, 2714, 2709, 2705, 2700, 2696, 2692,
+    2687, 2683, 2678, 2674, 2669, 2665, 2660, 2656, 2652, 2649, 2645, 2642,
+    2638, 2635, 2631, 2628, 2624, 2620, 2617, 2613, 2610, 2606, 2603, 2599,
+    2596, 2592, 2588, 2583, 2579, 2574, 2570, 2565, 2561, 2556, 2552, 2548,
+    2543, 2539, 2534, 2530, 2525, 2521, 2516, 2512, 2508, 2505, 2501, 2498,
+    2494, 2491, 2487, 2484, 2480, 2476, 2473, 2469, 2466, 2462, 2459, 2455,
+    2452, 2448, 2444, 2441, 2437, 2434, 2430, 2427, 2423, 2420, 2416, 2412,
+    2409, 2405, 2402, 2398, 2395, 2391, 2388, 2384, 2381, 2379, 2376, 2373,
+    2371, 2368, 2365, 2363, 2360, 2357, 2355, 2352, 2349, 2347, 2344, 2341,
+    2339, 2336, 2332, 2329, 2325, 2322, 2318, 2315, 2311, 2308, 2304, 2300,
+    2297, 2293, 2290, 2286, 2283, 2279, 2276, 2272, 2269, 2267, 2264, 2261,
+    2259, 2256, 2253, 2251, 2248, 2245, 2243, 2240, 2237, 2235, 2232, 2229,
+    2227, 2224, 2220, 2217, 2213, 2210, 2206, 2203, 2199, 2196, 2192, 2188,
+    2185, 2181, 2178, 2174, 2171, 2167, 2164, 2160, 2157, 2155, 2152, 2149,
+    2147, 2144, 2141, 2139, 2136, 2133, 2131, 2128, 2125, 2123, 2120, 2117,
+    2115, 2112, 2109, 2107, 2104, 2101, 2099, 2096, 2093, 2091, 2088, 2085,
+    2083, 2080, 2077, 2075, 2072, 2069, 2067, 2064, 2061, 2059, 2056, 2053,
+    2051, 2048, 2045, 2043, 2040, 2037, 2035, 2032, 2029, 2027, 2024, 2021,
+    2019, 2016, 2013, 2011, 2008, 2005, 2003, 2000, 1997, 1995, 1992, 1989,
+    1987, 1984, 1981, 1979, 1976, 1973, 1971, 1968, 1966, 1964, 1963, 1961,
+    1959, 1957, 1956, 1954, 1952, 1950, 1948, 1947, 1945, 1943, 1941, 1940,
+    1938, 1936, 1933, 1931, 1928, 1925, 1923, 1920, 1917, 1915, 1912, 1909,
+    1907, 1904, 1901, 1899, 1896, 1893, 1891, 1888, 1885, 1883, 1880, 1877,
+    1875, 1872, 1869, 1867, 1864, 1861, 1859, 1856, 1853, 1851, 1848, 1845,
+    1843, 1840, 1837, 1835, 1832, 1829, 1827, 1824, 1821, 1819, 1816, 1813,
+    1811, 1808, 1805, 1803, 1800, 1797, 1795, 1792, 1790, 1788, 1787, 1785,
+    1783, 1781, 1780, 1778, 1776, 1774, 1772, 1771, 1769, 1767, 1765, 1764,
+    1762, 1760, 1757, 1755, 1752, 1749, 1747, 1744, 1741, 1739, 1736, 1733,
+    1731, 1728, 1725, 1723, 1720, 1717, 1715, 1712, 1710, 1708, 1707, 1705,
+    1703, 1701, 1700, 1698, 1696, 1694, 1692, 1691, 1689, 1687, 1685, 1684,
+    1682, 1680, 1677, 1675, 1672, 1669, 1667, 1664, 1661, 1659, 1656, 1653,
+    1651, 1648, 1645, 1643, 1640, 1637, 1635, 1632, 1629, 1627, 1624, 1621,
+    1619, 1616, 1613, 1611, 1608, 1605, 1603, 1600, 1597, 1595, 1592, 1589,
+    1587, 1584, 1582, 1580, 1579, 1577, 1575, 1573, 1572, 1570, 1568, 1566,
+    1564, 1563, 1561, 1559, 1557, 1556, 1554, 1552, 1549, 1547, 1544, 1541,
+    1539, 1536, 1533, 1531, 1528, 1525, 1523, 1520, 1517, 1515, 1512, 1509,
+    1507, 1504, 1502, 1500, 1499, 1497, 1495, 1493, 1492, 1490, 1488, 1486,
+    1484, 1483, 1481, 1479, 1477, 1476, 1474, 1472, 1469, 1467, 1464, 1461,
+    1459, 1456, 1453, 1451, 1448, 1445, 1443, 1440, 1437, 1435, 1432, 1429,
+    1427, 1424, 1421, 1419, 1416, 1413, 1411, 1408, 1405, 1403, 1400, 1397,
+    1395, 1392, 1389, 1387, 1384, 1381, 1379, 1376, 1374, 1372, 1371, 1369,
+    1367, 1365, 1364, 1362, 1360, 1358, 1356, 1355, 1353, 1351, 1349, 1348,
+    1346, 1344, 1341, 1339, 1336, 1333, 1331, 1328, 1325, 1323, 1320, 1317,
+    1315, 1312, 1309, 1307, 1304, 1301, 1299, 1296, 1293, 1291, 1288, 1285,
+    1283, 1280, 1277, 1275, 1272, 1269, 1267, 1264, 1261, 1259, 1256, 1253,
+    1251, 1248, 1245, 1243, 1240, 1237, 1235, 1232, 1229, 1227, 1224, 1221,
+    1219, 1216, 1213, 1211, 1208, 1205, 1203, 1200, 1197, 1195, 1192, 1189,
+    1187, 1184, 1181, 1179, 1176, 1173, 1171, 1168, 1165, 1163, 1160, 1157,
+    1155, 1152, 1149, 1147, 1144, 1141, 1139, 1136, 1133, 1131, 1128, 1125,
+    1123, 1120, 1117, 1115, 1112, 1109, 1107, 1104, 1101, 1099, 1096, 1093,
+    1091, 1088, 1085, 1083, 1080, 1077, 1075, 1072, 1069, 1067, 1064, 1061,
+    1059, 1056, 1052, 1049, 1045, 1042, 1038, 1035, 1031, 1028, 1024, 1020,
+    1017, 1013, 1010, 1006, 1003, 999, 996, 992, 989, 987, 984, 981,
+    979, 976, 973, 971, 968, 965, 963, 960, 957, 955, 952, 949,
+    947, 944, 940, 937, 933, 930, 926, 923, 919, 916, 912, 908,
+    905, 901, 898, 894, 891, 887, 884, 880, 876, 873, 869, 866,
+    862, 859, 855, 852, 848, 844, 841, 837, 834, 830, 827, 823,
+    820, 816, 812, 807, 803, 798, 794, 789, 785, 780, 776, 772,
+    767, 763, 758, 754, 749, 745, 740, 736, 732, 727, 723, 718,
+    714, 709, 705, 700, 696, 692, 687, 683, 678, 674, 669, 665,
+    660, 656, 651, 645, 640, 635, 629, 624, 619, 613, 608, 603,
+    597, 592, 587, 581, 576, 571, 565, 560, 553, 546, 539, 532,
+    524, 517, 510, 503, 496, 489, 482, 475, 468, 460, 453, 446,
+    439, 432, 423, 414, 405, 396, 388, 379, 370, 361, 352, 343,
+    334, 325, 316, 308, 299, 290, 281, 272, 258, 244, 229, 215,
+    201, 187, 172, 158, 144, 130, 116, 101, 87, 73, 59, 44,
+    30, 16, 15, 14, 13, 11, 10, 9, 8, 7, 6, 5,
+    3, 2, 1, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(8)
+  // At most 0.03 degC from temptable_8
+  const short indextable_8[] PROGMEM = {
+    11411, 11264, 11117, 10969, 10822, 10675, 10527, 10380, 10233, 10085, 9938, 9791,
+    9643, 9496, 9349, 9202, 9054, 8907, 8760, 8612, 8465, 8318, 8170, 8023,
+    7876, 7728, 7581, 7434, 7286, 7139, 6992, 6844, 6697, 6550, 6402, 6255,
+    6108, 5960, 5813, 5666, 5518, 5371, 5224, 5077, 4929, 4782, 4635, 4487,
+    4340, 4193, 4045, 3898, 3751, 3603, 3456, 3444, 3431, 3419, 3406, 3394,
+    3382, 3369, 3357, 3345, 3332, 3320, 3307, 3295, 3283, 3270, 3258, 3246,
+    3233, 3221, 3208, 3196, 3184, 3171, 3159, 3147, 3134, 3122, 3109, 3097,
+    3085, 3072, 3060, 3048, 3035, 3023, 3010, 2998, 2986, 2973, 2961, 2949,
+    2936, 2924, 2911, 2899, 2887, 2874, 2862, 2850, 2837, 2825, 2812, 2800,
+    2793, 2786, 2779, 2772, 2765, 2758, 2751, 2744, 2738, 2731, 2724, 2717,
+    2710, 2703, 2696, 2689, 2682, 2675, 2668, 2661, 2654, 2647, 2640, 2633,
+    2626, 2619, 2613, 2606, 2599, 2592, 2585, 2578, 2571, 2564, 2557, 2550,
+    2543, 2536, 2529, 2522, 2515, 2508, 2501, 2494, 2488, 2481, 2474, 2467,
+    2460, 2453, 2446, 2439, 2432, 2427, 2423, 2418, 2414, 2409, 2405, 2400,
+    2396, 2391, 2387, 2382, 2378, 2373, 2369, 2364, 2360, 2355, 2350, 2346,
+    2341, 2337, 2332, 2328, 2323, 2319, 2314, 2310, 2305, 2301, 2296, 2292,
+    2287, 2283, 2278, 2274, 2269, 2264, 2260, 2255, 2251, 2246, 2242, 2237,
+    2233, 2228, 2224, 2219, 2215, 2210, 2206, 2201, 2197, 2192, 2188, 2185,
+    2181, 2178, 2174, 2170, 2167, 2163, 2159, 2156, 2152, 2149, 2145, 2141,
+    2138, 2134, 2130, 2127, 2123, 2120, 2116, 2112, 2109, 2105, 2101, 2098,
+    2094, 2091, 2087, 2083, 2080, 2076, 2072, 2069, 2065, 2062, 2058, 2054,
+    2051, 2047, 2043, 2040, 2036, 2033, 2029, 2025, 2022, 2018, 2014, 2011,
+    2007, 2004, 2000, 1997, 1994, 1991, 1988, 1985, 1982, 1979, 1976, 1973,
+    1970, 1967, 1964, 1961, 1958, 1955, 1952, 1949, 1946, 1943, 1940, 1937,
+    1934, 1931, 1928, 1925, 1922, 1918, 1915, 1912, 1909, 1906, 1903, 1900,
+    1897, 1894, 1891, 1888, 1885, 1882, 1879, 1876, 1873, 1870, 1867, 1864,
+    1861, 1858, 1855, 1852, 1849, 1846, 1843, 1840, 1837, 1835, 1832, 1829,
+    1826, 1824, 1821, 1818, 1816, 1813, 1810, 1807, 1805, 1802, 1799, 1797,
+    1794, 1791, 1788, 1786, 1783, 1780, 1778, 1775, 1772, 1769, 1767, 1764,
+    1761, 1758, 1756, 1753, 1750, 1748, 1745, 1742, 1739, 1737, 1734, 1731,
+    1729, 1726, 1723, 1720, 1718, 1715, 1712, 1710, 1707, 1704, 1701, 1699,
+    1696, 1694, 1692, 1690, 1688, 1685, 1683, 1681, 1679, 1677, 1675, 1673,
+    1671, 1669, 1666, 1664, 1662, 1660, 1658, 1656, 1654, 1652, 1650, 1647,
+    1645, 1643, 1641, 1639, 1637, 1635, 1633, 1630, 1628, 1626, 1624, 1622,
+    1620, 1618, 1616, 1614, 1611, 1609, 1607, 1605, 1603, 1601, 1599, 1597,
+    1595, 1592, 1590, 1588, 1586, 1584, 1582, 1579, 1577, 1574, 1572, 1570,
+    1567, 1565, 1562, 1560, 1557, 1555, 1553, 1550, 1548, 1545, 1543, 1541,
+    1538, 1536, 1533, 1531, 1528, 1526, 1524, 1521, 1519, 1516, 1514, 1512,
+    1509, 1507, 1504, 1502, 1499, 1497, 1495, 1492, 1490, 1487, 1485, 1483,
+    1480, 1478, 1475, 1473, 1470, 1468, 1466, 1463, 1461, 1458, 1456, 1454,
+    1452, 1451, 1449, 1447, 1445, 1443, 1442, 1440, 1438, 1436, 1434, 1432,
+    1431, 1429, 1427, 1425, 1423, 1422, 1420, 1418, 1416, 1414, 1413, 1411,
+    1409, 1407, 1405, 1403, 1402, 1400, 1398, 1396, 1394, 1393, 1391, 1389,
+    1387, 1385, 1384, 1382, 1380, 1378, 1376, 1374, 1373, 1371, 1369, 1367,
+    1365, 1364, 1362, 1360, 1358, 1356, 1354, 1352, 1349, 1347, 1345, 1343,
+    1341, 1339, 1337, 1335, 1333, 1330, 1328, 1326, 1324, 1322, 1320, 1318,
+    1316, 1314, 1311, 1309, 1307, 1305, 1303, 1301, 1299, 1297, 1294, 1292,
+    1290, 1288, 1286, 1284, 1282, 1280, 1278, 1275, 1273, 1271, 1269, 1267,
+    1265, 1263, 1261, 1259, 1256, 1254, 1252, 1250, 1248, 1246, 1244, 1242,
+    1240, 1237, 1235, 1233, 1231, 1229, 1227, 1225, 1223, 1221, 1218, 1216,
+    1214, 1212, 1210, 1208, 1206, 1204, 1202, 1199, 1197, 1195, 1193, 1191,
+    1189, 1187, 1185, 1182, 1180, 1178, 1176, 1174, 1172, 1170, 1168, 1166,
+    1163, 1161, 1159, 1157, 1155, 1153, 1151, 1149, 1147, 1144, 1142, 1140,
+    1138, 1136, 1134, 1132, 1131, 1129, 1127, 1125, 1123, 1122, 1120, 1118,
+    1116, 1114, 1112, 1111, 1109, 1107, 1105, 1103, 1102, 1100, 1098, 1096,
+    1094, 1093, 1091, 1089, 1087, 1085, 1083, 1082, 1080, 1078, 1076, 1074,
+    1073, 1071, 1069, 1067, 1065, 1064, 1062, 1060, 1058, 1056, 1054, 1053,
+    1051, 1049, 1047, 1045, 1044, 1042, 1040, 1038, 1036, 1034, 1032, 1029,
+    1027, 1025, 1023, 1021, 1019, 1017, 1015, 1013, 1010, 1008, 1006, 1004,
+    1002, 1000, 998, 996, 994, 991, 989, 987, 985, 983, 981, 979,
+    977, 974, 972, 970, 968, 966, 964, 962, 960, 958, 955, 953,
+    951, 949, 947, 945, 943, 941, 939, 936, 934, 932, 930, 928,
+    926, 923, 921, 918, 916, 914, 911, 909, 906, 904, 901, 899,
+    897, 894, 892, 889, 887, 885, 882, 880, 877, 875, 872, 870,
+    868, 865, 863, 860, 858, 856, 853, 851, 848, 846, 843, 841,
+    839, 836, 834, 831, 829, 827, 824, 822, 819, 817, 814, 812,
+    810, 807, 805, 802, 800, 798, 795, 793, 790, 788, 786, 783,
+    781, 778, 776, 773, 771, 769, 766, 764, 761, 759, 757, 754,
+    752, 749, 747, 744, 742, 740, 737, 735, 732, 730, 728, 725,
+    723, 720, 718, 715, 713, 711, 708, 706, 703, 701, 699, 696,
+    694, 691, 689, 686, 684, 682, 679, 677, 674, 672, 669, 665,
+    662, 659, 655, 652, 649, 645, 642, 639, 635, 632, 629, 626,
+    622, 619, 616, 612, 609, 606, 602, 599, 596, 592, 589, 586,
+    582, 579, 576, 572, 569, 566, 562, 559, 556, 552, 549, 546,
+    542, 539, 536, 533, 529, 526, 523, 519, 516, 513, 509, 506,
+    503, 499, 496, 492, 488, 483, 479, 475, 471, 466, 462, 458,
+    454, 450, 445, 441, 437, 433, 428, 424, 420, 416, 411, 407,
+    403, 399, 395, 390, 386, 382, 378, 373, 369, 365, 361, 357,
+    352, 348, 344, 340, 335, 331, 327, 323, 318, 314, 310, 306,
+    302, 297, 293, 289, 285, 280, 276, 272, 267, 262, 257, 251,
+    246, 241, 236, 231, 226, 221, 216, 210, 205, 200, 195, 190,
+    185, 180, 174, 169, 164, 159, 154, 149, 144, 139, 133, 128,
+    123, 118, 113, 108, 103, 98, 92, 87, 82, 77, 72, 67,
+    62, 56, 51, 46, 41, 36, 31, 26, 21, 15, 10, 5,
+    0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(9)
+  // At most 0.03 degC from temptable_9
+  const short indextable_9[] PROGMEM = {
+    15267, 14976, 14685, 14395, 14104, 13813, 13522, 13232, 12941, 12650, 12359, 12069,
+    11778, 11487, 11196, 10906, 10615, 10324, 10033, 9743, 9452, 9161, 8870, 8580,
+    8289, 7998, 7707, 7417, 7126, 6835, 6544, 6254, 5963, 5672, 5381, 5091,
+    4800, 4775, 4751, 4726, 4701, 4677, 4652, 4627, 4603, 4578, 4553, 4528,
+    4504, 4479, 4454, 4430, 4405, 4380, 4356, 4331, 4306, 4282, 4257, 4232,
+    4208, 4183, 4158, 4133, 4109, 4084, 4059, 4035, 4010, 3985, 3961, 3936,
+    3923, 3910, 3898, 3885, 3872, 3859, 3846, 3834, 3821, 3808, 3795, 3782,
+    3770, 3757, 3744, 3731, 3718, 3706, 3693, 3680, 3667, 3654, 3642, 3629,
+    3616, 3603, 3590, 3578, 3565, 3552, 3539, 3526, 3514, 3501, 3488, 3479,
+    3471, 3462, 3453, 3445, 3436, 3427, 3419, 3410, 3401, 3392, 3384, 3375,
+    3366, 3358, 3349, 3340, 3332, 3323, 3314, 3306, 3297, 3288, 3280, 3271,
+    3262, 3253, 3245, 3236, 3227, 3219, 3210, 3201, 3193, 3184, 3178, 3171,
+    3165, 3158, 3152, 3146, 3139, 3133, 3126, 3120, 3114, 3107, 3101, 3094,
+    3088, 3082, 3075, 3069, 3062, 3056, 3050, 3043, 3037, 3030, 3024, 3018,
+    3011, 3005, 2998, 2992, 2986, 2979, 2973, 2966, 2960, 2955, 2949, 2944,
+    2938, 2933, 2927, 2922, 2916, 2911, 2905, 2900, 2894, 2889, 2883, 2878,
+    2872, 2867, 2861, 2856, 2850, 2845, 2839, 2834, 2828, 2823, 2817, 2812,
+    2806, 2801, 2795, 2790, 2784, 2779, 2773, 2768, 2763, 2759, 2754, 2750,
+    2745, 2741, 2736, 2731, 2727, 2722, 2718, 2713, 2709, 2704, 2699, 2695,
+    2690, 2686, 2681, 2677, 2672, 2667, 2663, 2658, 2654, 2649, 2645, 2640,
+    2635, 2631, 2626, 2622, 2617, 2613, 2608, 2604, 2601, 2597, 2593, 2590,
+    2586, 2582, 2579, 2575, 2571, 2568, 2564, 2560, 2557, 2553, 2549, 2546,
+    2542, 2539, 2535, 2531, 2528, 2524, 2520, 2517, 2513, 2509, 2506, 2502,
+    2498, 2495, 2491, 2487, 2484, 2480, 2476, 2473, 2469, 2465, 2462, 2458,
+    2454, 2451, 2447, 2443, 2440, 2436, 2432, 2429, 2425, 2421, 2418, 2414,
+    2411, 2407, 2403, 2400, 2396, 2392, 2389, 2385, 2381, 2378, 2374, 2370,
+    2367, 2363, 2359, 2356, 2352, 2349, 2346, 2342, 2339, 2336, 2333, 2330,
+    2326, 2323, 2320, 2317, 2314, 2310, 2307, 2304, 2301, 2298, 2294, 2291,
+    2288, 2285, 2282, 2278, 2275, 2272, 2269, 2266, 2262, 2259, 2256, 2253,
+    2250, 2246, 2243, 2240, 2237, 2235, 2232, 2229, 2226, 2224, 2221, 2218,
+    2215, 2213, 2210, 2207, 2204, 2202, 2199, 2196, 2193, 2191, 2188, 2185,
+    2182, 2180, 2177, 2174, 2171, 2169, 2166, 2163, 2160, 2158, 2155, 2152,
+    2149, 2147, 2144, 2141, 2139, 2136, 2133, 2130, 2128, 2125, 2122, 2119,
+    2117, 2114, 2111, 2108, 2106, 2103, 2100, 2097, 2095, 2092, 2089, 2086,
+    2084, 2081, 2078, 2075, 2073, 2070, 2067, 2064, 2062, 2059, 2056, 2053,
+    2051, 2048, 2045, 2043, 2040, 2037, 2034, 2032, 2029, 2026, 2023, 2021,
+    2018, 2015, 2012, 2010, 2007, 2004, 2001, 1999, 1996, 1993, 1990, 1988,
+    1985, 1982, 1979, 1977, 1974, 1971, 1968, 1966, 1963, 1960, 1957, 1955,
+    1952, 1950, 1947, 1945, 1943, 1941, 1938, 1936, 1934, 1931, 1929, 1927,
+    1925, 1922, 1920, 1918, 1915, 1913, 1911, 1909, 1906, 1904, 1902, 1899,
+    1897, 1895, 1893, 1890, 1888, 1886, 1883, 1881, 1879, 1877, 1874, 1872,
+    1870, 1867, 1865, 1863, 1861, 1858, 1856, 1854, 1851, 1849, 1847, 1845,
+    1842, 1840, 1838, 1835, 1833, 1831, 1829, 1826, 1824, 1822, 1819, 1817,
+    1815, 1813, 1810, 1808, 1806, 1803, 1801, 1799, 1797, 1794, 1792, 1790,
+    1787, 1785, 1783, 1781, 1778, 1776, 1774, 1771, 1769, 1767, 1765, 1762,
+    1760, 1758, 1755, 1753, 1751, 1749, 1746, 1744, 1742, 1739, 1737, 1735,
+    1733, 1730, 1728, 1726, 1723, 1721, 1719, 1717, 1714, 1712, 1710, 1707,
+    1705, 1703, 1701, 1698, 1696, 1694, 1691, 1689, 1687, 1685, 1682, 1680,
+    1678, 1675, 1673, 1671, 1669, 1666, 1664, 1662, 1659, 1657, 1655, 1653,
+    1650, 1648, 1646, 1643, 1641, 1639, 1637, 1634, 1632, 1630, 1627, 1625,
+    1623, 1621, 1618, 1616, 1614, 1611, 1609, 1607, 1605, 1602, 1600, 1598,
+    1595, 1593, 1591, 1589, 1586, 1584, 1582, 1579, 1577, 1575, 1573, 1570,
+    1568, 1566, 1563, 1561, 1559, 1557, 1554, 1552, 1550, 1547, 1545, 1543,
+    1541, 1538, 1536, 1534, 1531, 1529, 1527, 1525, 1522, 1520, 1518, 1515,
+    1513, 1511, 1509, 1506, 1504, 1502, 1499, 1497, 1495, 1493, 1490, 1488,
+    1486, 1483, 1481, 1479, 1477, 1474, 1472, 1470, 1467, 1465, 1463, 1461,
+    1458, 1456, 1454, 1451, 1449, 1447, 1445, 1442, 1440, 1438, 1435, 1433,
+    1431, 1429, 1426, 1424, 1422, 1419, 1417, 1415, 1413, 1410, 1408, 1406,
+    1403, 1401, 1399, 1397, 1394, 1392, 1389, 1387, 1384, 1381, 1378, 1376,
+    1373, 1370, 1367, 1365, 1362, 1359, 1356, 1354, 1351, 1348, 1345, 1343,
+    1340, 1337, 1334, 1332, 1329, 1326, 1323, 1321, 1318, 1315, 1312, 1310,
+    1307, 1304, 1301, 1299, 1296, 1294, 1291, 1289, 1287, 1285, 1282, 1280,
+    1278, 1275, 1273, 1271, 1269, 1266, 1264, 1262, 1259, 1257, 1255, 1253,
+    1250, 1248, 1246, 1243, 1241, 1239, 1237, 1234, 1232, 1230, 1227, 1225,
+    1223, 1221, 1218, 1216, 1213, 1211, 1208, 1205, 1202, 1200, 1197, 1194,
+    1191, 1189, 1186, 1183, 1180, 1178, 1175, 1172, 1169, 1167, 1164, 1161,
+    1158, 1156, 1153, 1150, 1147, 1145, 1142, 1139, 1136, 1134, 1131, 1128,
+    1125, 1123, 1120, 1117, 1114, 1110, 1107, 1104, 1101, 1098, 1094, 1091,
+    1088, 1085, 1082, 1078, 1075, 1072, 1069, 1066, 1062, 1059, 1056, 1053,
+    1050, 1046, 1043, 1040, 1037, 1034, 1030, 1027, 1024, 1021, 1018, 1014,
+    1011, 1008, 1005, 1002, 998, 995, 992, 989, 986, 982, 979, 976,
+    973, 970, 966, 963, 960, 957, 954, 950, 947, 944, 941, 938,
+    934, 931, 928, 925, 922, 918, 915, 912, 909, 906, 902, 899,
+    896, 892, 889, 885, 881, 878, 874, 870, 867, 863, 859, 856,
+    852, 848, 845, 841, 837, 834, 830, 827, 823, 819, 816, 812,
+    808, 805, 801, 797, 794, 790, 786, 783, 779, 775, 772, 768,
+    763, 759, 754, 750, 745, 741, 736, 731, 727, 722, 718, 713,
+    709, 704, 699, 695, 690, 686, 681, 677, 672, 667, 663, 658,
+    654, 649, 645, 640, 635, 631, 626, 622, 617, 613, 608, 601,
+    594, 587, 581, 574, 567, 560, 553, 546, 539, 533, 526, 519,
+    512, 505, 498, 491, 485, 478, 471, 464, 457, 450, 443, 437,
+    430, 423, 416, 409, 402, 395, 389, 382, 375, 368, 356, 344,
+    332, 320, 308, 296, 284, 272, 260, 248, 236, 224, 212, 200,
+    188, 176, 164, 152, 140, 128, 116, 104, 92, 80, 73, 65,
+    58, 51, 44, 36, 29, 22, 15, 7, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(10)
+  // At most 0.03 degC from temptable_10
+  const short indextable_10[] PROGMEM = {
+    15152, 14864, 14576, 14288, 14000, 13712, 13424, 13136, 12848, 12560, 12272, 11984,
+    11696, 11408, 11120, 10832, 10544, 10256, 9968, 9680, 9392, 9104, 8816, 8528,
+    8240, 7952, 7664, 7376, 7088, 6800, 6512, 6224, 5936, 5648, 5360, 5072,
+    4784, 4760, 4736, 4711, 4687, 4663, 4639, 4614, 4590, 4566, 4542, 4517,
+    4493, 4469, 4445, 4421, 4396, 4372, 4348, 4324, 4299, 4275, 4251, 4227,
+    4203, 4178, 4154, 4130, 4106, 4081, 4057, 4033, 4009, 3984, 3960, 3936,
+    3923, 3909, 3896, 3883, 3870, 3856, 3843, 3830, 3817, 3803, 3790, 3777,
+    3764, 3750, 3737, 3724, 3711, 3697, 3684, 3671, 3658, 3644, 3631, 3618,
+    3605, 3591, 3578, 3565, 3552, 3538, 3525, 3512, 3499, 3485, 3472, 3463,
+    3455, 3446, 3437, 3429, 3420, 3411, 3403, 3394, 3385, 3376, 3368, 3359,
+    3350, 3342, 3333, 3324, 3316, 3307, 3298, 3290, 3281, 3272, 3264, 3255,
+    3246, 3237, 3229, 3220, 3211, 3203, 3194, 3185, 3177, 3168, 3162, 3155,
+    3149, 3142, 3136, 3130, 3123, 3117, 3110, 3104, 3098, 3091, 3085, 3078,
+    3072, 3066, 3059, 3053, 3046, 3040, 3034, 3027, 3021, 3014, 3008, 3002,
+    2995, 2989, 2982, 2976, 2970, 2963, 2957, 2950, 2944, 2939, 2934, 2929,
+    2924, 2919, 2914, 2909, 2904, 2899, 2894, 2889, 2884, 2879, 2874, 2869,
+    2864, 2859, 2853, 2848, 2843, 2838, 2833, 2828, 2823, 2818, 2813, 2808,
+    2803, 2798, 2793, 2788, 2783, 2778, 2773, 2768, 2763, 2759, 2754, 2750,
+    2745, 2741, 2736, 2731, 2727, 2722, 2718, 2713, 2709, 2704, 2699, 2695,
+    2690, 2686, 2681, 2677, 2672, 2667, 2663, 2658, 2654, 2649, 2645, 2640,
+    2635, 2631, 2626, 2622, 2617, 2613, 2608, 2604, 2600, 2596, 2592, 2587,
+    2583, 2579, 2575, 2571, 2567, 2563, 2559, 2555, 2550, 2546, 2542, 2538,
+    2534, 2530, 2526, 2522, 2517, 2513, 2509, 2505, 2501, 2497, 2493, 2489,
+    2485, 2480, 2476, 2472, 2468, 2464, 2461, 2458, 2454, 2451, 2448, 2445,
+    2442, 2438, 2435, 2432, 2429, 2426, 2422, 2419, 2416, 2413, 2410, 2406,
+    2403, 2400, 2397, 2394, 2390, 2387, 2384, 2381, 2378, 2374, 2371, 2368,
+    2365, 2362, 2358, 2355, 2352, 2349, 2346, 2342, 2339, 2336, 2333, 2330,
+    2326, 2323, 2320, 2317, 2314, 2310, 2307, 2304, 2301, 2298, 2294, 2291,
+    2288, 2285, 2282, 2278, 2275, 2272, 2269, 2266, 2262, 2259, 2256, 2253,
+    2250, 2246, 2243, 2240, 2237, 2235, 2232, 2229, 2226, 2224, 2221, 2218,
+    2215, 2213, 2210, 2207, 2204, 2202, 2199, 2196, 2193, 2191, 2188, 2185,
+    2182, 2180, 2177, 2174, 2171, 2169, 2166, 2163, 2160, 2158, 2155, 2152,
+    2149, 2147, 2144, 2141, 2139, 2136, 2133, 2130, 2128, 2125, 2122, 2119,
+    2117, 2114, 2111, 2108, 2106, 2103, 2100, 2097, 2095, 2092, 2089, 2086,
+    2084, 2081, 2078, 2075, 2073, 2070, 2067, 2064, 2062, 2059, 2056, 2053,
+    2051, 2048, 2045, 2043, 2040, 2037, 2034, 2032, 2029, 2026, 2023, 2021,
+    2018, 2015, 2012, 2010, 2007, 2004, 2001, 1999, 1996, 1993, 1990, 1988,
+    1985, 1982, 1979, 1977, 1974, 1971, 1968, 1966, 1963, 1960, 1957, 1955,
+    1952, 1950, 1947, 1945, 1943, 1941, 1938, 1936, 1934, 1931, 1929, 1927,
+    1925, 1922, 1920, 1918, 1915, 1913, 1911, 1909, 1906, 1904, 1902, 1899,
+    1897, 1895, 1893, 1890, 1888, 1886, 1883, 1881, 1879, 1877, 1874, 1872,
+    1870, 1867, 1865, 1863, 1861, 1858, 1856, 1854, 1851, 1849, 1847, 1845,
+    1842, 1840, 1838, 1835, 1833, 1831, 1829, 1826, 1824, 1822, 1819, 1817,
+    1815, 1813, 1810, 1808, 1806, 1803, 1801, 1799, 1797, 1794, 1792, 1790,
+    1787, 1785, 1783, 1781, 1778, 1776, 1774, 1771, 1769, 1767, 1765, 1762,
+    1760, 1758, 1755, 1753, 1751, 1749, 1746, 1744, 1742, 1739, 1737, 1735,
+    1733, 1730, 1728, 1726, 1723, 1721, 1719, 1717, 1714, 1712, 1710, 1707,
+    1705, 1703, 1701, 1698, 1696, 1694, 1691, 1689, 1687, 1685, 1682, 1680,
+    1678, 1675, 1673, 1671, 1669, 1666, 1664, 1662, 1659, 1657, 1655, 1653,
+    1650, 1648, 1646, 1643, 1641, 1639, 1637, 1634, 1632, 1630, 1627, 1625,
+    1623, 1621, 1618, 1616, 1614, 1611, 1609, 1607, 1605, 1602, 1600, 1598,
+    1595, 1593, 1591, 1589, 1586, 1584, 1582, 1579, 1577, 1575, 1573, 1570,
+    1568, 1566, 1563, 1561, 1559, 1557, 1554, 1552, 1549, 1547, 1544, 1541,
+    1538, 1536, 1533, 1530, 1527, 1525, 1522, 1519, 1516, 1514, 1511, 1508,
+    1505, 1503, 1500, 1497, 1494, 1492, 1489, 1486, 1483, 1481, 1478, 1475,
+    1472, 1470, 1467, 1464, 1461, 1459, 1456, 1454, 1451, 1449, 1447, 1445,
+    1442, 1440, 1438, 1435, 1433, 1431, 1429, 1426, 1424, 1422, 1419, 1417,
+    1415, 1413, 1410, 1408, 1406, 1403, 1401, 1399, 1397, 1394, 1392, 1390,
+    1387, 1385, 1383, 1381, 1378, 1376, 1374, 1371, 1369, 1367, 1365, 1362,
+    1360, 1358, 1355, 1353, 1351, 1349, 1346, 1344, 1342, 1339, 1337, 1335,
+    1333, 1330, 1328, 1326, 1323, 1321, 1319, 1317, 1314, 1312, 1310, 1307,
+    1305, 1303, 1301, 1298, 1296, 1294, 1291, 1289, 1287, 1285, 1282, 1280,
+    1278, 1275, 1273, 1271, 1269, 1266, 1264, 1262, 1259, 1257, 1255, 1253,
+    1250, 1248, 1246, 1243, 1241, 1239, 1237, 1234, 1232, 1230, 1227, 1225,
+    1223, 1221, 1218, 1216, 1213, 1211, 1208, 1205, 1202, 1200, 1197, 1194,
+    1191, 1189, 1186, 1183, 1180, 1178, 1175, 1172, 1169, 1167, 1164, 1161,
+    1158, 1156, 1153, 1150, 1147, 1145, 1142, 1139, 1136, 1134, 1131, 1128,
+    1125, 1123, 1120, 1117, 1114, 1110, 1107, 1104, 1101, 1098, 1094, 1091,
+    1088, 1085, 1082, 1078, 1075, 1072, 1069, 1066, 1062, 1059, 1056, 1053,
+    1050, 1046, 1043, 1040, 1037, 1034, 1030, 1027, 1024, 1021, 1018, 1014,
+    1011, 1008, 1005, 1002, 998, 995, 992, 989, 986, 982, 979, 976,
+    973, 970, 966, 963, 960, 957, 954, 950, 947, 944, 941, 938,
+    934, 931, 928, 925, 922, 918, 915, 912, 909, 906, 902, 899,
+    896, 892, 889, 885, 881, 878, 874, 870, 867, 863, 859, 856,
+    852, 848, 845, 841, 837, 834, 830, 827, 823, 819, 816, 812,
+    808, 805, 801, 797, 794, 790, 786, 783, 779, 775, 772, 768,
+    763, 759, 754, 750, 745, 741, 736, 731, 727, 722, 718, 713,
+    709, 704, 699, 695, 690, 686, 681, 677, 672, 667, 663, 658,
+    654, 649, 645, 640, 635, 631, 626, 622, 617, 613, 608, 601,
+    594, 587, 581, 574, 567, 560, 553, 546, 539, 533, 526, 519,
+    512, 505, 498, 491, 485, 478, 471, 464, 457, 450, 443, 437,
+    430, 423, 416, 409, 402, 395, 389, 382, 375, 368, 356, 344,
+    332, 320, 308, 296, 284, 272, 260, 248, 236, 224, 212, 200,
+    188, 176, 164, 152, 140, 128, 116, 104, 92, 80, 73, 65,
+    58, 51, 44, 36, 29, 22, 15, 7, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(11)
+  // At most 0.03 degC from temptable_11
+  const short indextable_11[] PROGMEM = {
+    15341, 15008, 14675, 14342, 14010, 13677, 13344, 13011, 12678, 12346, 12013, 11680,
+    11347, 11014, 10682, 10349, 10016, 9683, 9350, 9018, 8685, 8352, 8019, 7686,
+    7354, 7021, 6688, 6355, 6022, 5690, 5357, 5024, 4986, 4947, 4909, 4870,
+    4832, 4794, 4755, 4717, 4678, 4640, 4611, 4582, 4554, 4525, 4496, 4467,
+    4438, 4410, 4381, 4352, 4330, 4307, 4285, 4262, 4240, 4218, 4195, 4173,
+    4150, 4128, 4110, 4093, 4075, 4058, 4040, 4022, 4005, 3987, 3970, 3952,
+    3936, 3920, 3904, 3888, 3872, 3856, 3840, 3824, 3808, 3792, 3779, 3766,
+    3754, 3741, 3728, 3715, 3702, 3690, 3677, 3664, 3651, 3638, 3626, 3613,
+    3600, 3587, 3574, 3562, 3549, 3536, 3526, 3517, 3507, 3498, 3488, 3478,
+    3469, 3459, 3450, 3440, 3430, 3421, 3411, 3402, 3392, 3382, 3373, 3363,
+    3354, 3344, 3336, 3328, 3320, 3312, 3304, 3296, 3288, 3280, 3272, 3264,
+    3256, 3248, 3240, 3232, 3224, 3216, 3208, 3200, 3192, 3184, 3178, 3171,
+    3165, 3158, 3152, 3146, 3139, 3133, 3126, 3120, 3112, 3104, 3096, 3088,
+    3080, 3072, 3064, 3056, 3048, 3040, 3035, 3030, 3026, 3021, 3016, 3011,
+    3006, 3002, 2997, 2992, 2986, 2979, 2973, 2966, 2960, 2954, 2947, 2941,
+    2934, 2928, 2922, 2915, 2909, 2902, 2896, 2890, 2883, 2877, 2870, 2864,
+    2859, 2854, 2850, 2845, 2840, 2835, 2830, 2826, 2821, 2816, 2811, 2806,
+    2802, 2797, 2792, 2787, 2782, 2778, 2773, 2768, 2763, 2758, 2754, 2749,
+    2744, 2739, 2734, 2730, 2725, 2720, 2716, 2712, 2708, 2704, 2700, 2696,
+    2692, 2688, 2684, 2680, 2676, 2672, 2668, 2664, 2660, 2656, 2652, 2648,
+    2644, 2640, 2636, 2632, 2628, 2624, 2620, 2616, 2612, 2608, 2604, 2600,
+    2596, 2592, 2588, 2584, 2580, 2576, 2572, 2568, 2564, 2560, 2556, 2552,
+    2548, 2544, 2540, 2536, 2532, 2528, 2524, 2520, 2516, 2512, 2508, 2504,
+    2500, 2496, 2492, 2488, 2484, 2480, 2476, 2472, 2468, 2464, 2460, 2456,
+    2452, 2448, 2444, 2440, 2436, 2432, 2428, 2424, 2420, 2416, 2412, 2408,
+    2404, 2400, 2397, 2394, 2390, 2387, 2384, 2381, 2378, 2374, 2371, 2368,
+    2365, 2362, 2358, 2355, 2352, 2349, 2346, 2342, 2339, 2336, 2333, 2330,
+    2326, 2323, 2320, 2317, 2314, 2310, 2307, 2304, 2301, 2299, 2296, 2293,
+    2291, 2288, 2285, 2283, 2280, 2277, 2275, 2272, 2269, 2267, 2264, 2261,
+    2259, 2256, 2253, 2251, 2248, 2245, 2243, 2240, 2237, 2235, 2232, 2229,
+    2227, 2224, 2221, 2218, 2214, 2211, 2208, 2205, 2202, 2198, 2195, 2192,
+    2189, 2186, 2182, 2179, 2176, 2173, 2170, 2166, 2163, 2160, 2157, 2154,
+    2150, 2147, 2144, 2141, 2138, 2134, 2131, 2128, 2125, 2123, 2120, 2117,
+    2115, 2112, 2109, 2107, 2104, 2101, 2099, 2096, 2093, 2091, 2088, 2085,
+    2083, 2080, 2077, 2075, 2072, 2069, 2067, 2064, 2061, 2059, 2056, 2053,
+    2051, 2048, 2045, 2043, 2040, 2037, 2035, 2032, 2029, 2027, 2024, 2021,
+    2019, 2016, 2013, 2011, 2008, 2005, 2003, 2000, 1997, 1995, 1992, 1989,
+    1987, 1984, 1981, 1979, 1976, 1973, 1971, 1968, 1966, 1963, 1961, 1958,
+    1956, 1954, 1951, 1949, 1946, 1944, 1942, 1939, 1937, 1934, 1932, 1930,
+    1927, 1925, 1922, 1920, 1918, 1915, 1913, 1910, 1908, 1906, 1903, 1901,
+    1898, 1896, 1894, 1891, 1889, 1886, 1884, 1882, 1879, 1877, 1874, 1872,
+    1870, 1867, 1865, 1862, 1860, 1858, 1855, 1853, 1850, 1848, 1846, 1843,
+    1841, 1838, 1836, 1834, 1831, 1829, 1826, 1824, 1822, 1819, 1817, 1814,
+    1812, 1810, 1807, 1805, 1802, 1800, 1798, 1795, 1793, 1790, 1788, 1786,
+    1783, 1781, 1778, 1776, 1774, 1771, 1769, 1766, 1764, 1762, 1759, 1757,
+    1754, 1752, 1750, 1747, 1745, 1742, 1740, 1738, 1735, 1733, 1730, 1728,
+    1726, 1723, 1721, 1718, 1716, 1714, 1711, 1709, 1706, 1704, 1702, 1699,
+    1697, 1694, 1692, 1690, 1687, 1685, 1682, 1680, 1678, 1676, 1674, 1672,
+    1670, 1668, 1666, 1664, 1662, 1660, 1658, 1656, 1654, 1652, 1650, 1648,
+    1646, 1644, 1642, 1640, 1638, 1636, 1634, 1632, 1630, 1628, 1626, 1624,
+    1622, 1620, 1618, 1616, 1614, 1612, 1610, 1608, 1606, 1604, 1602, 1600,
+    1597, 1595, 1592, 1589, 1587, 1584, 1581, 1579, 1576, 1573, 1571, 1568,
+    1565, 1563, 1560, 1557, 1555, 1552, 1549, 1547, 1544, 1541, 1539, 1536,
+    1533, 1531, 1528, 1525, 1523, 1520, 1518, 1516, 1514, 1512, 1510, 1508,
+    1506, 1504, 1502, 1500, 1498, 1496, 1494, 1492, 1490, 1488, 1486, 1484,
+    1482, 1480, 1478, 1476, 1474, 1472, 1470, 1468, 1466, 1464, 1462, 1460,
+    1458, 1456, 1454, 1452, 1450, 1448, 1446, 1444, 1442, 1440, 1437, 1435,
+    1432, 1429, 1427, 1424, 1421, 1419, 1416, 1413, 1411, 1408, 1405, 1403,
+    1400, 1397, 1395, 1392, 1389, 1387, 1384, 1381, 1379, 1376, 1373, 1371,
+    1368, 1365, 1363, 1360, 1358, 1355, 1353, 1350, 1348, 1346, 1343, 1341,
+    1338, 1336, 1334, 1331, 1329, 1326, 1324, 1322, 1319, 1317, 1314, 1312,
+    1310, 1307, 1305, 1302, 1300, 1298, 1295, 1293, 1290, 1288, 1286, 1283,
+    1281, 1278, 1276, 1274, 1271, 1269, 1266, 1264, 1261, 1258, 1256, 1253,
+    1250, 1247, 1244, 1242, 1239, 1236, 1233, 1230, 1228, 1225, 1222, 1219,
+    1216, 1214, 1211, 1208, 1205, 1202, 1200, 1197, 1194, 1191, 1188, 1186,
+    1183, 1180, 1177, 1174, 1172, 1169, 1166, 1163, 1160, 1158, 1155, 1152,
+    1150, 1147, 1145, 1142, 1140, 1138, 1135, 1133, 1130, 1128, 1126, 1123,
+    1121, 1118, 1116, 1114, 1111, 1109, 1106, 1104, 1101, 1098, 1094, 1091,
+    1088, 1085, 1082, 1078, 1075, 1072, 1069, 1066, 1062, 1059, 1056, 1053,
+    1050, 1046, 1043, 1040, 1037, 1034, 1030, 1027, 1024, 1021, 1018, 1014,
+    1011, 1008, 1005, 1002, 998, 995, 992, 989, 986, 982, 979, 976,
+    973, 970, 966, 963, 960, 957, 954, 950, 947, 944, 941, 938,
+    934, 931, 928, 925, 922, 918, 915, 912, 909, 906, 902, 899,
+    896, 893, 890, 886, 883, 880, 877, 874, 870, 867, 864, 861,
+    858, 854, 851, 848, 845, 842, 838, 835, 832, 829, 826, 822,
+    819, 816, 811, 806, 802, 797, 792, 787, 782, 778, 773, 768,
+    763, 758, 754, 749, 744, 739, 734, 730, 725, 720, 715, 710,
+    706, 701, 696, 691, 686, 682, 677, 672, 667, 662, 658, 653,
+    648, 643, 638, 634, 629, 624, 618, 612, 606, 601, 595, 589,
+    583, 577, 571, 565, 559, 554, 548, 542, 536, 530, 524, 518,
+    513, 507, 501, 495, 489, 483, 477, 471, 466, 460, 454, 448,
+    440, 432, 424, 416, 408, 400, 392, 384, 376, 368, 358, 349,
+    339, 330, 320, 310, 301, 291, 282, 272, 259, 246, 234, 221,
+    208, 195, 182, 170, 157, 144, 115, 86, 58, 29, 0, -29,
+    -58, -86, -115, -144, -173, -202, -230, -259, -288, -317, -346, -374,
+    -403, -432
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(12)
+  // At most 0.03 degC from temptable_12
+  const short indextable_12[] PROGMEM = {
+    3007, 3004, 3000, 2996, 2993, 2989, 2985, 2982, 2978, 2975, 2971, 2967,
+    2964, 2960, 2956, 2953, 2949, 2945, 2942, 2938, 2935, 2931, 2927, 2924,
+    2920, 2916, 2913, 2909, 2905, 2902, 2898, 2895, 2891, 2887, 2884, 2880,
+    2876, 2873, 2869, 2865, 2862, 2858, 2855, 2851, 2847, 2844, 2840, 2836,
+    2833, 2829, 2825, 2822, 2818, 2815, 2811, 2807, 2804, 2800, 2796, 2793,
+    2789, 2785, 2782, 2778, 2775, 2771, 2767, 2764, 2760, 2756, 2753, 2749,
+    2745, 2742, 2738, 2735, 2731, 2727, 2724, 2720, 2716, 2713, 2709, 2705,
+    2702, 2698, 2695, 2691, 2687, 2684, 2680, 2676, 2673, 2669, 2665, 2662,
+    2658, 2655, 2651, 2647, 2644, 2640, 2636, 2633, 2629, 2625, 2622, 2618,
+    2615, 2611, 2607, 2604, 2600, 2596, 2593, 2589, 2585, 2582, 2578, 2575,
+    2571, 2567, 2564, 2560, 2556, 2553, 2549, 2545, 2542, 2538, 2535, 2531,
+    2527, 2524, 2520, 2516, 2513, 2509, 2505, 2502, 2498, 2495, 2491, 2487,
+    2484, 2480, 2476, 2473, 2469, 2465, 2462, 2458, 2455, 2451, 2447, 2444,
+    2440, 2436, 2433, 2429, 2425, 2422, 2418, 2415, 2411, 2407, 2404, 2400,
+    2396, 2393, 2389, 2385, 2382, 2378, 2375, 2371, 2367, 2364, 2360, 2356,
+    2353, 2349, 2345, 2342, 2338, 2335, 2331, 2327, 2324, 2320, 2316, 2313,
+    2309, 2305, 2302, 2298, 2295, 2291, 2287, 2284, 2280, 2276, 2273, 2269,
+    2265, 2262, 2258, 2255, 2251, 2247, 2244, 2240, 2236, 2233, 2229, 2225,
+    2222, 2218, 2215, 2211, 2207, 2204, 2200, 2196, 2193, 2189, 2185, 2182,
+    2178, 2175, 2171, 2167, 2164, 2160, 2157, 2154, 2151, 2149, 2146, 2143,
+    2140, 2137, 2134, 2131, 2129, 2126, 2123, 2120, 2117, 2114, 2111, 2109,
+    2106, 2103, 2100, 2097, 2094, 2091, 2089, 2086, 2083, 2080, 2077, 2074,
+    2072, 2069, 2066, 2063, 2061, 2058, 2055, 2052, 2050, 2047, 2044, 2041,
+    2039, 2036, 2033, 2030, 2028, 2025, 2022, 2019, 2017, 2014, 2011, 2008,
+    2006, 2003, 2000, 1998, 1996, 1994, 1992, 1989, 1987, 1985, 1983, 1981,
+    1979, 1977, 1975, 1973, 1971, 1968, 1966, 1964, 1962, 1960, 1958, 1956,
+    1954, 1952, 1949, 1947, 1945, 1943, 1941, 1939, 1937, 1935, 1933, 1931,
+    1928, 1926, 1924, 1922, 1920, 1918, 1915, 1913, 1911, 1908, 1906, 1904,
+    1901, 1899, 1896, 1894, 1892, 1889, 1887, 1885, 1882, 1880, 1878, 1875,
+    1873, 1871, 1868, 1866, 1864, 1861, 1859, 1856, 1854, 1852, 1849, 1847,
+    1845, 1842, 1840, 1838, 1836, 1835, 1833, 1831, 1829, 1827, 1825, 1824,
+    1822, 1820, 1818, 1816, 1815, 1813, 1811, 1809, 1807, 1805, 1804, 1802,
+    1800, 1798, 1796, 1795, 1793, 1791, 1789, 1787, 1785, 1784, 1782, 1780,
+    1778, 1776, 1775, 1773, 1771, 1769, 1767, 1765, 1764, 1762, 1760, 1758,
+    1756, 1754, 1752, 1750, 1748, 1746, 1744, 1742, 1740, 1738, 1736, 1734,
+    1732, 1730, 1728, 1726, 1724, 1722, 1720, 1718, 1716, 1714, 1712, 1710,
+    1708, 1706, 1704, 1702, 1700, 1698, 1696, 1694, 1692, 1690, 1688, 1686,
+    1684, 1682, 1680, 1678, 1677, 1675, 1674, 1672, 1670, 1669, 1667, 1666,
+    1664, 1662, 1661, 1659, 1658, 1656, 1654, 1653, 1651, 1650, 1648, 1646,
+    1645, 1643, 1642, 1640, 1638, 1637, 1635, 1634, 1632, 1630, 1629, 1627,
+    1626, 1624, 1622, 1621, 1619, 1618, 1616, 1614, 1613, 1611, 1610, 1608,
+    1606, 1605, 1603, 1602, 1600, 1598, 1596, 1594, 1593, 1591, 1589, 1587,
+    1585, 1583, 1581, 1580, 1578, 1576, 1574, 1572, 1570, 1568, 1567, 1565,
+    1563, 1561, 1559, 1557, 1555, 1553, 1552, 1550, 1548, 1546, 1544, 1542,
+    1540, 1539, 1537, 1535, 1533, 1531, 1529, 1527, 1526, 1524, 1522, 1520,
+    1518, 1517, 1515, 1513, 1511, 1510, 1508, 1506, 1504, 1503, 1501, 1499,
+    1497, 1496, 1494, 1492, 1490, 1489, 1487, 1485, 1483, 1482, 1480, 1478,
+    1477, 1475, 1473, 1471, 1470, 1468, 1466, 1464, 1463, 1461, 1459, 1457,
+    1456, 1454, 1452, 1450, 1449, 1447, 1445, 1443, 1442, 1440, 1438, 1436,
+    1435, 1433, 1431, 1429, 1427, 1425, 1424, 1422, 1420, 1418, 1416, 1415,
+    1413, 1411, 1409, 1407, 1405, 1404, 1402, 1400, 1398, 1396, 1395, 1393,
+    1391, 1389, 1387, 1385, 1384, 1382, 1380, 1378, 1376, 1375, 1373, 1371,
+    1369, 1367, 1365, 1364, 1362, 1360, 1358, 1357, 1355, 1353, 1351, 1350,
+    1348, 1346, 1344, 1343, 1341, 1339, 1337, 1336, 1334, 1332, 1330, 1329,
+    1327, 1325, 1323, 1322, 1320, 1318, 1317, 1315, 1313, 1311, 1310, 1308,
+    1306, 1304, 1303, 1301, 1299, 1297, 1296, 1294, 1292, 1290, 1289, 1287,
+    1285, 1283, 1282, 1280, 1278, 1276, 1274, 1273, 1271, 1269, 1267, 1265,
+    1263, 1261, 1260, 1258, 1256, 1254, 1252, 1250, 1248, 1247, 1245, 1243,
+    1241, 1239, 1237, 1235, 1233, 1232, 1230, 1228, 1226, 1224, 1222, 1220,
+    1219, 1217, 1215, 1213, 1211, 1209, 1207, 1206, 1204, 1202, 1200, 1198,
+    1196, 1194, 1192, 1190, 1188, 1186, 1184, 1182, 1180, 1178, 1176, 1174,
+    1172, 1170, 1168, 1166, 1164, 1162, 1160, 1158, 1156, 1154, 1152, 1150,
+    1148, 1146, 1144, 1142, 1140, 1138, 1136, 1134, 1132, 1130, 1128, 1126,
+    1124, 1122, 1120, 1118, 1115, 1113, 1111, 1109, 1106, 1104, 1102, 1099,
+    1097, 1095, 1093, 1090, 1088, 1086, 1083, 1081, 1079, 1077, 1074, 1072,
+    1070, 1067, 1065, 1063, 1061, 1058, 1056, 1054, 1051, 1049, 1047, 1045,
+    1042, 1040, 1037, 1034, 1032, 1029, 1026, 1023, 1021, 1018, 1015, 1012,
+    1010, 1007, 1004, 1001, 999, 996, 993, 990, 988, 985, 982, 979,
+    977, 974, 971, 968, 966, 963, 960, 956, 952, 947, 943, 939,
+    935, 931, 926, 922, 918, 914, 909, 905, 901, 897, 893, 888,
+    884, 880, 878, 875, 873, 871, 868, 866, 864, 861, 859, 856,
+    854, 852, 849, 847, 845, 842, 840, 838, 835, 833, 831, 828,
+    826, 824, 821, 819, 816, 814, 812, 809, 807, 805, 802, 800,
+    797, 793, 790, 787, 783, 780, 777, 773, 770, 767, 763, 760,
+    757, 753, 750, 747, 743, 740, 737, 733, 730, 727, 723, 720,
+    717, 714, 711, 708, 705, 702, 699, 696, 693, 690, 687, 684,
+    681, 679, 676, 673, 670, 667, 664, 661, 658, 655, 652, 649,
+    646, 643, 640, 636, 632, 628, 624, 620, 616, 612, 608, 604,
+    600, 596, 592, 588, 584, 580, 576, 572, 568, 564, 560, 555,
+    550, 545, 540, 535, 530, 525, 520, 515, 510, 505, 500, 495,
+    490, 485, 480, 475, 469, 464, 459, 453, 448, 443, 437, 432,
+    427, 421, 416, 411, 405, 400, 392, 384, 376, 368, 360, 352,
+    344, 336, 328, 320, 310, 300, 290, 280, 270, 260, 250, 240,
+    227, 213, 200, 187, 173, 160, 142, 124, 107, 89, 71, 53,
+    36, 18, 0, -49, -98, -148, -197, -246, -295, -345, -394, -443,
+    -492, -542, -591, -640
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(13)
+  // At most 0.20 degC from temptable_13
+  const short indextable_13[] PROGMEM = {
+    5804, 5754, 5704, 5653, 5603, 5553, 5503, 5453, 5402, 5352, 5302, 5252,
+    5202, 5151, 5101, 5051, 5001, 4951, 4900, 4850, 4800, 4750, 4700, 4649,
+    4603, 4557, 4511, 4469, 4433, 4398, 4362, 4327, 4296, 4265, 4235, 4205,
+    4175, 4147, 4122, 4096, 4070, 4045, 4019, 3995, 3975, 3954, 3934, 3914,
+    3893, 3873, 3853, 3834, 3817, 3800, 3784, 3767, 3750, 3733, 3717, 3700,
+    3683, 3669, 3655, 3642, 3628, 3615, 3601, 3588, 3574, 3561, 3547, 3534,
+    3520, 3509, 3498, 3488, 3477, 3466, 3455, 3444, 3434, 3423, 3412, 3401,
+    3390, 3380, 3369, 3358, 3348, 3338, 3328, 3318, 3308, 3298, 3288, 3278,
+    3268, 3258, 3248, 3238, 3228, 3218, 3208, 3198, 3191, 3183, 3176, 3169,
+    3161, 3154, 3147, 3139, 3132, 3124, 3117, 3110, 3102, 3095, 3087, 3080,
+    3073, 3065, 3058, 3051, 3043, 3037, 3031, 3025, 3019, 3013, 3006, 3000,
+    2994, 2988, 2982, 2976, 2970, 2964, 2958, 2952, 2946, 2940, 2934, 2928,
+    2922, 2916, 2910, 2904, 2898, 2892, 2886, 2880, 2875, 2870, 2865, 2860,
+    2855, 2850, 2845, 2840, 2835, 2830, 2825, 2820, 2815, 2810, 2805, 2800,
+    2794, 2789, 2784, 2779, 2774, 2769, 2764, 2759, 2754, 2749, 2744, 2739,
+    2734, 2729, 2724, 2719, 2715, 2711, 2707, 2702, 2698, 2694, 2690, 2685,
+    2681, 2677, 2673, 2669, 2664, 2660, 2656, 2652, 2647, 2643, 2639, 2635,
+    2630, 2626, 2622, 2618, 2614, 2609, 2605, 2601, 2597, 2592, 2588, 2584,
+    2580, 2576, 2571, 2567, 2563, 2559, 2556, 2552, 2549, 2546, 2542, 2539,
+    2536, 2532, 2529, 2526, 2522, 2519, 2516, 2512, 2509, 2506, 2502, 2499,
+    2496, 2492, 2489, 2486, 2482, 2479, 2476, 2473, 2469, 2466, 2463, 2459,
+    2456, 2453, 2449, 2446, 2443, 2439, 2436, 2433, 2429, 2426, 2423, 2419,
+    2416, 2413, 2409, 2406, 2403, 2399, 2396, 2393, 2389, 2386, 2383, 2379,
+    2376, 2373, 2369, 2366, 2363, 2359, 2356, 2353, 2350, 2346, 2343, 2340,
+    2336, 2333, 2330, 2326, 2323, 2320, 2316, 2313, 2310, 2306, 2303, 2300,
+    2296, 2293, 2290, 2286, 2283, 2280, 2276, 2273, 2270, 2266, 2263, 2260,
+    2256, 2253, 2250, 2246, 2243, 2240, 2237, 2235, 2232, 2230, 2228, 2225,
+    2223, 2220, 2218, 2215, 2213, 2210, 2208, 2205, 2203, 2201, 2198, 2196,
+    2193, 2191, 2188, 2186, 2183, 2181, 2178, 2176, 2173, 2171, 2169, 2166,
+    2164, 2161, 2159, 2156, 2154, 2151, 2149, 2146, 2144, 2142, 2139, 2137,
+    2134, 2132, 2129, 2127, 2124, 2122, 2119, 2117, 2114, 2112, 2110, 2107,
+    2105, 2102, 2100, 2097, 2095, 2092, 2090, 2087, 2085, 2083, 2080, 2078,
+    2075, 2073, 2070, 2068, 2065, 2063, 2060, 2058, 2055, 2053, 2051, 2048,
+    2046, 2043, 2041, 2038, 2036, 2033, 2031, 2028, 2026, 2024, 2021, 2019,
+    2016, 2014, 2011, 2009, 2006, 2004, 2001, 1999, 1997, 1994, 1992, 1989,
+    1987, 1984, 1982, 1979, 1977, 1974, 1972, 1969, 1967, 1965, 1962, 1960,
+    1957, 1955, 1952, 1950, 1947, 1945, 1942, 1940, 1938, 1935, 1933, 1930,
+    1928, 1925, 1923, 1920, 1918, 1916, 1914, 1911, 1909, 1907, 1905, 1902,
+    1900, 1898, 1896, 1894, 1891, 1889, 1887, 1885, 1882, 1880, 1878, 1876,
+    1873, 1871, 1869, 1867, 1865, 1862, 1860, 1858, 1856, 1853, 1851, 1849,
+    1847, 1844, 1842, 1840, 1838, 1836, 1833, 1831, 1829, 1827, 1824, 1822,
+    1820, 1818, 1815, 1813, 1811, 1809, 1807, 1804, 1802, 1800, 1798, 1795,
+    1793, 1791, 1789, 1786, 1784, 1782, 1780, 1777, 1775, 1773, 1771, 1769,
+    1766, 1764, 1762, 1760, 1757, 1755, 1753, 1751, 1748, 1746, 1744, 1742,
+    1740, 1737, 1735, 1733, 1731, 1728, 1726, 1724, 1722, 1719, 1717, 1715,
+    1713, 1711, 1708, 1706, 1704, 1702, 1699, 1697, 1695, 1693, 1690, 1688,
+    1686, 1684, 1682, 1679, 1677, 1675, 1673, 1670, 1668, 1666, 1664, 1661,
+    1659, 1657, 1655, 1653, 1650, 1648, 1646, 1644, 1641, 1639, 1637, 1635,
+    1632, 1630, 1628, 1626, 1624, 1621, 1619, 1617, 1615, 1612, 1610, 1608,
+    1606, 1603, 1601, 1599, 1597, 1595, 1593, 1590, 1588, 1586, 1584, 1582,
+    1579, 1577, 1575, 1573, 1571, 1569, 1566, 1564, 1562, 1560, 1558, 1555,
+    1553, 1551, 1549, 1547, 1545, 1542, 1540, 1538, 1536, 1534, 1531, 1529,
+    1527, 1525, 1523, 1521, 1518, 1516, 1514, 1512, 1510, 1507, 1505, 1503,
+    1501, 1499, 1497, 1494, 1492, 1490, 1488, 1486, 1483, 1481, 1479, 1477,
+    1475, 1473, 1470, 1468, 1466, 1464, 1462, 1459, 1457, 1455, 1453, 1451,
+    1449, 1446, 1444, 1442, 1440, 1438, 1435, 1433, 1431, 1429, 1427, 1425,
+    1422, 1420, 1418, 1416, 1414, 1411, 1409, 1407, 1405, 1403, 1401, 1398,
+    1396, 1394, 1392, 1390, 1387, 1385, 1383, 1381, 1379, 1377, 1374, 1372,
+    1370, 1368, 1366, 1363, 1361, 1359, 1357, 1355, 1353, 1350, 1348, 1346,
+    1344, 1342, 1339, 1337, 1335, 1333, 1331, 1329, 1326, 1324, 1322, 1320,
+    1318, 1315, 1313, 1311, 1309, 1307, 1305, 1302, 1300, 1298, 1296, 1294,
+    1291, 1289, 1287, 1285, 1283, 1281, 1278, 1275, 1273, 1270, 1267, 1265,
+    1262, 1259, 1257, 1254, 1251, 1249, 1246, 1243, 1241, 1238, 1236, 1233,
+    1230, 1228, 1225, 1222, 1220, 1217, 1214, 1212, 1209, 1206, 1204, 1201,
+    1198, 1196, 1193, 1190, 1188, 1185, 1182, 1180, 1177, 1174, 1172, 1169,
+    1166, 1164, 1161, 1159, 1156, 1153, 1151, 1148, 1145, 1143, 1140, 1137,
+    1135, 1132, 1129, 1127, 1124, 1121, 1119, 1116, 1113, 1111, 1108, 1105,
+    1103, 1100, 1097, 1095, 1092, 1089, 1087, 1084, 1081, 1079, 1076, 1074,
+    1071, 1068, 1066, 1063, 1060, 1058, 1055, 1052, 1050, 1047, 1044, 1042,
+    1039, 1036, 1034, 1031, 1028, 1026, 1023, 1020, 1018, 1015, 1012, 1010,
+    1007, 1004, 1002, 999, 997, 994, 991, 989, 986, 983, 981, 978,
+    975, 973, 970, 967, 965, 962, 959, 955, 951, 947, 943, 939,
+    936, 932, 928, 924, 920, 916, 912, 908, 904, 900, 896, 892,
+    889, 885, 881, 877, 873, 869, 865, 861, 857, 853, 849, 846,
+    842, 838, 834, 830, 826, 822, 818, 814, 810, 806, 802, 799,
+    795, 791, 787, 783, 779, 775, 771, 767, 763, 759, 755, 752,
+    748, 744, 740, 736, 732, 728, 724, 720, 716, 712, 709, 705,
+    701, 697, 693, 689, 685, 681, 677, 673, 669, 665, 662, 658,
+    654, 650, 646, 642, 637, 630, 623, 616, 609, 602, 595, 588,
+    582, 575, 568, 561, 554, 547, 540, 533, 526, 520, 513, 506,
+    499, 492, 485, 478, 471, 465, 458, 451, 444, 437, 430, 423,
+    416, 409, 403, 396, 389, 382, 375, 368, 361, 354, 348, 341,
+    334, 327, 320, 306, 292, 278, 264, 249, 235, 221, 207, 193,
+    179, 165, 151, 137, 123, 108, 94, 80, 66, 52, 38, 24,
+    10, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(20)
+  // At most 0.03 degC from temptable_20
+  const short indextable_20[] PROGMEM = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+    9, 9, 9, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+    10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13,
+    13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+    14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 16, 16, 16, 16, 16, 16, 16, 16,
+    32, 48, 64, 80, 96, 112, 128, 144, 160, 178, 196, 213,
+    231, 249, 267, 284, 302, 320, 340, 360, 380, 400, 420, 440,
+    460, 480, 498, 516, 533, 551, 569, 587, 604, 622, 640, 660,
+    680, 700, 720, 740, 760, 780, 800, 818, 836, 853, 871, 889,
+    907, 924, 942, 960, 980, 1000, 1020, 1040, 1060, 1080, 1100, 1120,
+    1140, 1160, 1180, 1200, 1220, 1240, 1260, 1280, 1298, 1316, 1333, 1351,
+    1369, 1387, 1404, 1422, 1440, 1460, 1480, 1500, 1520, 1540, 1560, 1580,
+    1600, 1620, 1640, 1660, 1680, 1700, 1720, 1740, 1760, 1778, 1796, 1813,
+    1831, 1849, 1867, 1884, 1902, 1920, 1940, 1960, 1980, 2000, 2020, 2040,
+    2060, 2080, 2100, 2120, 2140, 2160, 2180, 2200, 2220, 2240, 2260, 2280,
+    2300, 2320, 2340, 2360, 2380, 2400, 2420, 2440, 2460, 2480, 2500, 2520,
+    2540, 2560, 2580, 2600, 2620, 2640, 2660, 2680, 2700, 2720, 2740, 2760,
+    2780, 2800, 2820, 2840, 2860, 2880, 2900, 2920, 2940, 2960, 2980, 3000,
+    3020, 3040, 3060, 3080, 3100, 3120, 3140, 3160, 3180, 3200, 3220, 3240,
+    3260, 3280, 3300, 3320, 3340, 3360, 3380, 3400, 3420, 3440, 3460, 3480,
+    3500, 3520, 3540, 3560, 3580, 3600, 3620, 3640, 3660, 3680, 3703, 3726,
+    3749, 3771, 3794, 3817, 3840, 3860, 3880, 3900, 3920, 3940, 3960, 3980,
+    4000, 4020, 4040, 4060, 4080, 4100, 4120, 4140, 4160, 4183, 4206, 4229,
+    4251, 4274, 4297, 4320, 4340, 4360, 4380, 4400, 4420, 4440, 4460, 4480,
+    4500, 4520, 4540, 4560, 4580, 4600, 4620, 4640, 4663, 4686, 4709, 4731,
+    4754, 4777, 4800, 4820, 4840, 4860, 4880, 4900, 4920, 4940, 4960, 4983,
+    5006, 5029, 5051, 5074, 5097, 5120, 5140, 5160, 5180, 5200, 5220, 5240,
+    5260, 5280, 5303, 5326, 5349, 5371, 5394, 5417, 5440, 5463, 5486, 5509,
+    5531, 5554, 5577, 5600, 5620, 5640, 5660, 5680, 5700, 5720, 5740, 5760,
+    5783, 5806, 5829, 5851, 5874, 5897, 5920, 5943, 5966, 5989, 6011, 6034,
+    6057, 6080, 6100, 6120, 6140, 6160, 6180, 6200, 6220, 6240, 6263, 6286,
+    6309, 6331, 6354, 6377, 6400, 6423, 6446, 6469, 6491, 6514, 6537, 6560,
+    6583, 6606, 6629, 6651, 6674, 6697, 6720, 6743, 6766, 6789, 6811, 6834,
+    6857, 6880, 6903, 6926, 6949, 6971, 6994, 7017, 7040, 7063, 7086, 7109,
+    7131, 7154, 7177, 7200, 7223, 7246, 7269, 7291, 7314, 7337, 7360, 7383,
+    7406, 7429, 7451, 7474, 7497, 7520, 7543, 7566, 7589, 7611, 7634, 7657,
+    7680, 7703, 7726, 7749, 7771, 7794, 7817, 7840, 7863, 7886, 7909, 7931,
+    7954, 7977, 8000, 8024, 8048, 8072, 8096, 8119, 8143, 8167, 8191, 8215,
+    8239, 8263, 8287, 8310, 8334, 8358, 8382, 8406, 8430, 8454, 8478, 8501,
+    8525, 8549, 8573, 8597, 8621, 8645, 8669, 8693, 8716, 8740, 8764, 8788,
+    8812, 8836, 8860, 8884, 8907, 8931, 8955, 8979, 9003, 9027, 9051, 9075,
+    9099, 9122, 9146, 9170, 9194, 9218, 9242, 9266, 9290, 9313, 9337, 9361,
+    9385, 9409, 9433, 9457, 9481, 9504, 9528, 9552, 9576, 9600, 9625, 9651,
+    9676, 9702, 9727, 9752, 9778, 9803, 9829, 9854, 9879, 9905, 9930, 9956,
+    9981, 10006, 10032, 10057, 10083, 10108, 10133, 10159, 10184, 10210, 10235, 10260,
+    10286, 10311, 10337, 10362, 10387, 10413, 10438, 10463, 10489, 10514, 10540, 10565,
+    10590, 10616, 10641, 10667, 10692, 10717, 10743, 10768, 10794, 10819, 10844, 10870,
+    10895, 10921, 10946, 10971, 10997, 11022, 11048, 11073, 11098, 11124, 11149, 11175,
+    11200, 11226, 11252, 11279, 11305, 11331, 11357, 11384, 11410, 11436, 11462, 11489,
+    11515, 11541, 11567, 11593, 11620, 11646, 11672, 11698, 11725, 11751, 11777, 11803,
+    11830, 11856, 11882, 11908, 11934, 11961, 11987, 12013, 12039, 12066, 12092, 12118,
+    12144, 12170, 12197, 12223, 12249, 12275, 12302, 12328, 12354, 12380, 12407, 12433,
+    12459, 12485, 12511, 12538, 12564, 12590, 12616, 12643, 12669, 12695, 12721, 12748,
+    12774, 12800, 12828, 12856, 12884, 12912, 12940, 12968, 12996, 13025, 13053, 13081,
+    13109, 13137, 13165, 13193, 13221, 13249, 13277, 13305, 13333, 13361, 13389, 13418,
+    13446, 13474, 13502, 13530, 13558, 13586, 13614, 13642, 13670, 13698, 13726, 13754,
+    13782, 13811, 13839, 13867, 13895, 13923, 13951, 13979, 14007, 14035, 14063, 14091,
+    14119, 14147, 14175, 14204, 14232, 14260, 14288, 14316, 14344, 14372, 14400, 14429,
+    14458, 14487, 14516, 14545, 14575, 14604, 14633, 14662, 14691, 14720, 14749, 14778,
+    14807, 14836, 14865, 14895, 14924, 14953, 14982, 15011, 15040, 15069, 15098, 15127,
+    15156, 15185, 15215, 15244, 15273, 15302, 15331, 15360, 15389, 15418, 15447, 15476,
+    15505, 15535, 15564, 15593, 15622, 15651, 15680, 15709, 15738, 15767, 15796, 15825,
+    15855, 15884, 15913, 15942, 15971, 16000, 16031, 16063, 16094, 16125, 16157, 16188,
+    16220, 16251, 16282, 16314, 16345, 16376, 16408, 16439, 16471, 16502, 16533, 16565,
+    16596, 16627, 16659, 16690, 16722, 16753, 16784, 16816, 16847, 16878, 16910, 16941,
+    16973, 17004, 17035, 17067, 17098, 17129, 17161, 17192, 17224, 17255, 17286, 17318,
+    17349, 17380, 17412, 17443, 17475, 17506, 17537, 17569, 17600
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(51)
+  // At most 0.03 degC from temptable_51
+  const short indextable_51[] PROGMEM = {
+    5608, 5600, 5592, 5583, 5575, 5566, 5558, 5549, 5541, 5532, 5524, 5515,
+    5507, 5498, 5490, 5481, 5473, 5465, 5456, 5448, 5439, 5431, 5422, 5414,
+    5405, 5397, 5388, 5380, 5371, 5363, 5354, 5346, 5338, 5329, 5321, 5312,
+    5304, 5295, 5287, 5278, 5270, 5261, 5253, 5244, 5236, 5228, 5219, 5211,
+    5202, 5194, 5185, 5177, 5168, 5160, 5151, 5143, 5134, 5126, 5117, 5109,
+    5101, 5092, 5084, 5075, 5067, 5058, 5050, 5041, 5033, 5024, 5016, 5007,
+    4999, 4990, 4982, 4974, 4965, 4957, 4948, 4940, 4931, 4923, 4914, 4906,
+    4897, 4889, 4880, 4872, 4863, 4855, 4847, 4838, 4830, 4821, 4813, 4804,
+    4796, 4787, 4779, 4770, 4762, 4753, 4745, 4737, 4728, 4720, 4711, 4703,
+    4694, 4686, 4677, 4669, 4660, 4652, 4643, 4635, 4626, 4618, 4610, 4601,
+    4593, 4584, 4576, 4567, 4559, 4550, 4542, 4533, 4525, 4516, 4508, 4499,
+    4491, 4483, 4474, 4466, 4457, 4449, 4440, 4432, 4423, 4415, 4406, 4398,
+    4389, 4381, 4372, 4364, 4356, 4347, 4339, 4330, 4322, 4313, 4305, 4296,
+    4288, 4279, 4271, 4262, 4254, 4246, 4237, 4229, 4220, 4212, 4203, 4195,
+    4186, 4178, 4169, 4161, 4152, 4144, 4135, 4127, 4119, 4110, 4102, 4093,
+    4085, 4076, 4068, 4059, 4051, 4042, 4034, 4025, 4017, 4008, 4000, 3994,
+    3988, 3982, 3975, 3969, 3963, 3957, 3951, 3945, 3938, 3932, 3926, 3920,
+    3914, 3909, 3903, 3897, 3891, 3886, 3880, 3874, 3869, 3863, 3857, 3851,
+    3846, 3840, 3835, 3829, 3824, 3819, 3813, 3808, 3803, 3797, 3792, 3787,
+    3781, 3776, 3771, 3765, 3760, 3755, 3750, 3745, 3740, 3735, 3730, 3725,
+    3720, 3715, 3710, 3705, 3700, 3695, 3690, 3685, 3680, 3675, 3671, 3666,
+    3661, 3656, 3652, 3647, 3642, 3638, 3633, 3628, 3624, 3619, 3614, 3609,
+    3605, 3600, 3596, 3591, 3587, 3582, 3578, 3573, 3569, 3564, 3560, 3556,
+    3551, 3547, 3542, 3538, 3533, 3529, 3524, 3520, 3516, 3512, 3507, 3503,
+    3499, 3495, 3491, 3486, 3482, 3478, 3474, 3469, 3465, 3461, 3457, 3453,
+    3448, 3444, 3440, 3436, 3432, 3428, 3424, 3420, 3416, 3412, 3408, 3404,
+    3400, 3396, 3392, 3388, 3384, 3380, 3376, 3372, 3368, 3364, 3360, 3356,
+    3353, 3349, 3345, 3342, 3338, 3335, 3331, 3327, 3324, 3320, 3316, 3313,
+    3309, 3305, 3302, 3298, 3295, 3291, 3287, 3284, 3280, 3276, 3273, 3269,
+    3265, 3262, 3258, 3255, 3251, 3247, 3244, 3240, 3236, 3233, 3229, 3225,
+    3222, 3218, 3215, 3211, 3207, 3204, 3200, 3197, 3193, 3190, 3187, 3183,
+    3180, 3177, 3173, 3170, 3167, 3163, 3160, 3157, 3153, 3150, 3147, 3143,
+    3140, 3137, 3133, 3130, 3127, 3123, 3120, 3117, 3114, 3110, 3107, 3104,
+    3101, 3098, 3094, 3091, 3088, 3085, 3082, 3078, 3075, 3072, 3069, 3066,
+    3062, 3059, 3056, 3053, 3050, 3046, 3043, 3040, 3037, 3034, 3030, 3027,
+    3024, 3021, 3018, 3014, 3011, 3008, 3005, 3002, 2998, 2995, 2992, 2989,
+    2986, 2982, 2979, 2976, 2973, 2970, 2966, 2963, 2960, 2957, 2954, 2951,
+    2948, 2945, 2942, 2939, 2936, 2933, 2930, 2927, 2924, 2921, 2919, 2916,
+    2913, 2910, 2907, 2904, 2901, 2898, 2895, 2892, 2889, 2886, 2883, 2880,
+    2877, 2874, 2871, 2868, 2865, 2862, 2859, 2856, 2853, 2850, 2847, 2844,
+    2841, 2839, 2836, 2833, 2830, 2827, 2824, 2821, 2818, 2815, 2812, 2809,
+    2806, 2803, 2800, 2797, 2794, 2791, 2789, 2786, 2783, 2780, 2777, 2774,
+    2771, 2769, 2766, 2763, 2760, 2757, 2754, 2751, 2749, 2746, 2743, 2740,
+    2737, 2734, 2731, 2729, 2726, 2723, 2720, 2717, 2714, 2712, 2709, 2706,
+    2703, 2701, 2698, 2695, 2692, 2690, 2687, 2684, 2681, 2679, 2676, 2673,
+    2670, 2668, 2665, 2662, 2659, 2657, 2654, 2651, 2648, 2646, 2643, 2640,
+    2637, 2634, 2632, 2629, 2626, 2623, 2621, 2618, 2615, 2612, 2610, 2607,
+    2604, 2601, 2599, 2596, 2593, 2590, 2588, 2585, 2582, 2579, 2577, 2574,
+    2571, 2568, 2566, 2563, 2560, 2557, 2554, 2552, 2549, 2546, 2543, 2541,
+    2538, 2535, 2532, 2530, 2527, 2524, 2521, 2519, 2516, 2513, 2510, 2508,
+    2505, 2502, 2499, 2497, 2494, 2491, 2488, 2486, 2483, 2480, 2477, 2474,
+    2472, 2469, 2466, 2463, 2461, 2458, 2455, 2452, 2450, 2447, 2444, 2441,
+    2439, 2436, 2433, 2430, 2428, 2425, 2422, 2419, 2417, 2414, 2411, 2408,
+    2406, 2403, 2400, 2397, 2394, 2391, 2389, 2386, 2383, 2380, 2377, 2374,
+    2371, 2369, 2366, 2363, 2360, 2357, 2354, 2351, 2349, 2346, 2343, 2340,
+    2337, 2334, 2331, 2329, 2326, 2323, 2320, 2317, 2314, 2312, 2309, 2306,
+    2303, 2301, 2298, 2295, 2292, 2290, 2287, 2284, 2281, 2279, 2276, 2273,
+    2270, 2268, 2265, 2262, 2259, 2257, 2254, 2251, 2248, 2246, 2243, 2240,
+    2237, 2234, 2231, 2228, 2225, 2222, 2219, 2216, 2213, 2210, 2207, 2204,
+    2201, 2199, 2196, 2193, 2190, 2187, 2184, 2181, 2178, 2175, 2172, 2169,
+    2166, 2163, 2160, 2157, 2154, 2151, 2148, 2145, 2142, 2139, 2136, 2133,
+    2130, 2127, 2124, 2121, 2119, 2116, 2113, 2110, 2107, 2104, 2101, 2098,
+    2095, 2092, 2089, 2086, 2083, 2080, 2077, 2074, 2071, 2068, 2065, 2062,
+    2058, 2055, 2052, 2049, 2046, 2043, 2040, 2037, 2034, 2031, 2028, 2025,
+    2022, 2018, 2015, 2012, 2009, 2006, 2003, 2000, 1997, 1994, 1990, 1987,
+    1984, 1981, 1978, 1974, 1971, 1968, 1965, 1962, 1958, 1955, 1952, 1949,
+    1946, 1942, 1939, 1936, 1933, 1930, 1926, 1923, 1920, 1917, 1913, 1910,
+    1906, 1903, 1899, 1896, 1892, 1889, 1885, 1882, 1878, 1875, 1871, 1868,
+    1864, 1861, 1857, 1854, 1850, 1847, 1843, 1840, 1836, 1833, 1829, 1825,
+    1822, 1818, 1815, 1811, 1807, 1804, 1800, 1796, 1793, 1789, 1785, 1782,
+    1778, 1775, 1771, 1767, 1764, 1760, 1756, 1752, 1748, 1744, 1740, 1736,
+    1732, 1728, 1724, 1720, 1716, 1712, 1708, 1704, 1700, 1696, 1692, 1688,
+    1684, 1680, 1676, 1672, 1667, 1663, 1659, 1655, 1651, 1646, 1642, 1638,
+    1634, 1629, 1625, 1621, 1617, 1613, 1608, 1604, 1600, 1595, 1591, 1586,
+    1581, 1576, 1572, 1567, 1562, 1558, 1553, 1548, 1544, 1539, 1534, 1529,
+    1525, 1520, 1515, 1510, 1505, 1500, 1495, 1490, 1485, 1480, 1475, 1470,
+    1465, 1460, 1455, 1450, 1445, 1440, 1435, 1429, 1424, 1419, 1413, 1408,
+    1403, 1397, 1392, 1387, 1381, 1376, 1371, 1365, 1360, 1353, 1347, 1340,
+    1333, 1327, 1320, 1313, 1307, 1300, 1293, 1287, 1280, 1273, 1267, 1260,
+    1253, 1247, 1240, 1233, 1227, 1220, 1213, 1207, 1200, 1192, 1184, 1176,
+    1168, 1160, 1152, 1144, 1136, 1128, 1120, 1111, 1102, 1093, 1084, 1076,
+    1067, 1058, 1049, 1040, 1029, 1017, 1006, 994, 983, 971, 960, 949,
+    937, 926, 914, 903, 891, 880, 867, 853, 840, 827, 813, 800,
+    784, 768, 752, 736, 720, 700, 680, 660, 640, 613, 587, 560,
+    533, 507, 480, 453, 427, 400, 360, 320, 280, 240, 160, 80,
+    0, -80
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(52)
+  // At most 0.03 degC from temptable_52
+  const short indextable_52[] PROGMEM = {
+    8026, 8000, 7974, 7948, 7923, 7897, 7871, 7845, 7819, 7794, 7768, 7742,
+    7716, 7690, 7665, 7639, 7613, 7587, 7561, 7535, 7510, 7484, 7458, 7432,
+    7406, 7381, 7355, 7329, 7303, 7277, 7252, 7226, 7200, 7174, 7148, 7123,
+    7097, 7071, 7045, 7019, 6994, 6968, 6942, 6916, 6890, 6865, 6839, 6813,
+    6787, 6761, 6735, 6710, 6684, 6658, 6632, 6606, 6581, 6555, 6529, 6503,
+    6477, 6452, 6426, 6400, 6374, 6348, 6323, 6297, 6271, 6245, 6219, 6194,
+    6168, 6142, 6116, 6090, 6065, 6039, 6013, 5987, 5961, 5935, 5910, 5884,
+    5858, 5832, 5806, 5781, 5755, 5729, 5703, 5677, 5652, 5626, 5600, 5574,
+    5548, 5523, 5497, 5471, 5445, 5419, 5394, 5368, 5342, 5316, 5290, 5265,
+    5239, 5213, 5187, 5161, 5135, 5110, 5084, 5058, 5032, 5006, 4981, 4955,
+    4929, 4903, 4877, 4852, 4826, 4800, 4791, 4781, 4772, 4762, 4753, 4744,
+    4734, 4725, 4715, 4706, 4696, 4687, 4678, 4668, 4659, 4649, 4640, 4632,
+    4624, 4616, 4608, 4600, 4592, 4584, 4576, 4568, 4560, 4552, 4544, 4536,
+    4528, 4520, 4512, 4504, 4496, 4488, 4480, 4473, 4466, 4459, 4452, 4445,
+    4438, 4431, 4424, 4417, 4410, 4403, 4397, 4390, 4383, 4376, 4369, 4362,
+    4355, 4348, 4341, 4334, 4327, 4320, 4314, 4308, 4302, 4295, 4289, 4283,
+    4277, 4271, 4265, 4258, 4252, 4246, 4240, 4234, 4228, 4222, 4215, 4209,
+    4203, 4197, 4191, 4185, 4178, 4172, 4166, 4160, 4154, 4149, 4143, 4138,
+    4132, 4127, 4121, 4116, 4110, 4105, 4099, 4094, 4088, 4083, 4077, 4072,
+    4066, 4061, 4055, 4050, 4044, 4039, 4033, 4028, 4022, 4017, 4011, 4006,
+    4000, 3995, 3991, 3986, 3981, 3976, 3972, 3967, 3962, 3958, 3953, 3948,
+    3944, 3939, 3934, 3929, 3925, 3920, 3915, 3911, 3906, 3901, 3896, 3892,
+    3887, 3882, 3878, 3873, 3868, 3864, 3859, 3854, 3849, 3845, 3840, 3836,
+    3832, 3827, 3823, 3819, 3815, 3811, 3806, 3802, 3798, 3794, 3789, 3785,
+    3781, 3777, 3773, 3768, 3764, 3760, 3756, 3752, 3747, 3743, 3739, 3735,
+    3731, 3726, 3722, 3718, 3714, 3709, 3705, 3701, 3697, 3693, 3688, 3684,
+    3680, 3676, 3673, 3669, 3665, 3661, 3658, 3654, 3650, 3647, 3643, 3639,
+    3635, 3632, 3628, 3624, 3620, 3617, 3613, 3609, 3606, 3602, 3598, 3594,
+    3591, 3587, 3583, 3580, 3576, 3572, 3568, 3565, 3561, 3557, 3553, 3550,
+    3546, 3542, 3539, 3535, 3531, 3527, 3524, 3520, 3517, 3513, 3510, 3506,
+    3503, 3499, 3496, 3492, 3489, 3485, 3482, 3478, 3475, 3471, 3468, 3464,
+    3461, 3457, 3454, 3450, 3447, 3443, 3440, 3437, 3433, 3430, 3426, 3423,
+    3419, 3416, 3412, 3409, 3405, 3402, 3398, 3395, 3391, 3388, 3384, 3381,
+    3377, 3374, 3370, 3367, 3363, 3360, 3357, 3354, 3351, 3347, 3344, 3341,
+    3338, 3335, 3332, 3329, 3325, 3322, 3319, 3316, 3313, 3310, 3307, 3304,
+    3300, 3297, 3294, 3291, 3288, 3285, 3282, 3278, 3275, 3272, 3269, 3266,
+    3263, 3260, 3256, 3253, 3250, 3247, 3244, 3241, 3238, 3235, 3231, 3228,
+    3225, 3222, 3219, 3216, 3213, 3209, 3206, 3203, 3200, 3197, 3194, 3191,
+    3188, 3185, 3182, 3179, 3176, 3173, 3170, 3167, 3164, 3161, 3159, 3156,
+    3153, 3150, 3147, 3144, 3141, 3138, 3135, 3132, 3129, 3126, 3123, 3120,
+    3117, 3114, 3111, 3108, 3105, 3102, 3099, 3096, 3093, 3090, 3087, 3084,
+    3081, 3079, 3076, 3073, 3070, 3067, 3064, 3061, 3058, 3055, 3052, 3049,
+    3046, 3043, 3040, 3037, 3034, 3032, 3029, 3026, 3023, 3020, 3018, 3015,
+    3012, 3009, 3006, 3004, 3001, 2998, 2995, 2992, 2989, 2987, 2984, 2981,
+    2978, 2975, 2973, 2970, 2967, 2964, 2961, 2959, 2956, 2953, 2950, 2947,
+    2945, 2942, 2939, 2936, 2933, 2931, 2928, 2925, 2922, 2919, 2916, 2914,
+    2911, 2908, 2905, 2902, 2900, 2897, 2894, 2891, 2888, 2886, 2883, 2880,
+    2877, 2874, 2872, 2869, 2866, 2863, 2860, 2858, 2855, 2852, 2849, 2846,
+    2844, 2841, 2838, 2835, 2832, 2829, 2827, 2824, 2821, 2818, 2815, 2813,
+    2810, 2807, 2804, 2801, 2799, 2796, 2793, 2790, 2787, 2785, 2782, 2779,
+    2776, 2773, 2771, 2768, 2765, 2762, 2759, 2756, 2754, 2751, 2748, 2745,
+    2742, 2740, 2737, 2734, 2731, 2728, 2726, 2723, 2720, 2717, 2714, 2712,
+    2709, 2706, 2703, 2700, 2698, 2695, 2692, 2689, 2686, 2684, 2681, 2678,
+    2675, 2672, 2669, 2667, 2664, 2661, 2658, 2655, 2653, 2650, 2647, 2644,
+    2641, 2639, 2636, 2633, 2630, 2627, 2625, 2622, 2619, 2616, 2613, 2611,
+    2608, 2605, 2602, 2599, 2596, 2594, 2591, 2588, 2585, 2582, 2580, 2577,
+    2574, 2571, 2568, 2566, 2563, 2560, 2557, 2554, 2551, 2548, 2545, 2543,
+    2540, 2537, 2534, 2531, 2528, 2525, 2522, 2519, 2516, 2513, 2511, 2508,
+    2505, 2502, 2499, 2496, 2493, 2490, 2487, 2484, 2481, 2479, 2476, 2473,
+    2470, 2467, 2464, 2461, 2458, 2455, 2452, 2449, 2447, 2444, 2441, 2438,
+    2435, 2432, 2429, 2426, 2423, 2420, 2417, 2415, 2412, 2409, 2406, 2403,
+    2400, 2397, 2394, 2391, 2387, 2384, 2381, 2378, 2375, 2372, 2369, 2365,
+    2362, 2359, 2356, 2353, 2350, 2347, 2344, 2340, 2337, 2334, 2331, 2328,
+    2325, 2322, 2318, 2315, 2312, 2309, 2306, 2303, 2300, 2296, 2293, 2290,
+    2287, 2284, 2281, 2278, 2275, 2271, 2268, 2265, 2262, 2259, 2256, 2253,
+    2249, 2246, 2243, 2240, 2237, 2233, 2230, 2226, 2223, 2220, 2216, 2213,
+    2209, 2206, 2203, 2199, 2196, 2192, 2189, 2186, 2182, 2179, 2175, 2172,
+    2169, 2165, 2162, 2158, 2155, 2151, 2148, 2145, 2141, 2138, 2134, 2131,
+    2128, 2124, 2121, 2117, 2114, 2111, 2107, 2104, 2100, 2097, 2094, 2090,
+    2087, 2083, 2080, 2076, 2072, 2068, 2064, 2060, 2057, 2053, 2049, 2045,
+    2041, 2037, 2033, 2029, 2025, 2021, 2018, 2014, 2010, 2006, 2002, 1998,
+    1994, 1990, 1986, 1982, 1979, 1975, 1971, 1967, 1963, 1959, 1955, 1951,
+    1947, 1943, 1940, 1936, 1932, 1928, 1924, 1920, 1915, 1911, 1906, 1902,
+    1897, 1893, 1888, 1883, 1879, 1874, 1870, 1865, 1861, 1856, 1851, 1847,
+    1842, 1838, 1833, 1829, 1824, 1819, 1815, 1810, 1806, 1801, 1797, 1792,
+    1787, 1783, 1778, 1774, 1769, 1765, 1760, 1754, 1749, 1743, 1738, 1732,
+    1727, 1721, 1716, 1710, 1705, 1699, 1694, 1688, 1683, 1677, 1672, 1666,
+    1661, 1655, 1650, 1644, 1639, 1633, 1628, 1622, 1617, 1611, 1606, 1600,
+    1593, 1586, 1579, 1572, 1565, 1558, 1551, 1544, 1537, 1530, 1523, 1517,
+    1510, 1503, 1496, 1489, 1482, 1475, 1468, 1461, 1454, 1447, 1440, 1431,
+    1422, 1413, 1404, 1396, 1387, 1378, 1369, 1360, 1351, 1342, 1333, 1324,
+    1316, 1307, 1298, 1289, 1280, 1269, 1257, 1246, 1234, 1223, 1211, 1200,
+    1189, 1177, 1166, 1154, 1143, 1131, 1120, 1104, 1088, 1072, 1056, 1040,
+    1024, 1008, 992, 976, 960, 940, 920, 900, 880, 860, 840, 820,
+    800, 768, 736, 704, 672, 640, 600, 560, 520, 480, 400, 320,
+    240, 160, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(55)
+  // At most 0.03 degC from temptable_55
+  const short indextable_55[] PROGMEM = {
+    8043, 8000, 7957, 7915, 7872, 7829, 7787, 7744, 7701, 7659, 7616, 7573,
+    7531, 7488, 7445, 7403, 7360, 7317, 7275, 7232, 7189, 7147, 7104, 7061,
+    7019, 6976, 6933, 6891, 6848, 6805, 6763, 6720, 6677, 6635, 6592, 6549,
+    6507, 6464, 6421, 6379, 6336, 6293, 6251, 6208, 6165, 6123, 6080, 6037,
+    5995, 5952, 5909, 5867, 5824, 5781, 5739, 5696, 5653, 5611, 5568, 5525,
+    5483, 5440, 5397, 5355, 5312, 5269, 5227, 5184, 5141, 5099, 5056, 5013,
+    4971, 4928, 4885, 4843, 4800, 4785, 4771, 4756, 4742, 4727, 4713, 4698,
+    4684, 4669, 4655, 4640, 4628, 4615, 4603, 4591, 4578, 4566, 4554, 4542,
+    4529, 4517, 4505, 4492, 4480, 4469, 4457, 4446, 4434, 4423, 4411, 4400,
+    4389, 4377, 4366, 4354, 4343, 4331, 4320, 4311, 4301, 4292, 4282, 4273,
+    4264, 4254, 4245, 4235, 4226, 4216, 4207, 4198, 4188, 4179, 4169, 4160,
+    4152, 4145, 4137, 4130, 4122, 4114, 4107, 4099, 4091, 4084, 4076, 4069,
+    4061, 4053, 4046, 4038, 4030, 4023, 4015, 4008, 4000, 3993, 3986, 3979,
+    3972, 3965, 3958, 3951, 3944, 3937, 3930, 3923, 3917, 3910, 3903, 3896,
+    3889, 3882, 3875, 3868, 3861, 3854, 3847, 3840, 3834, 3828, 3822, 3816,
+    3810, 3804, 3799, 3793, 3787, 3781, 3775, 3769, 3763, 3757, 3751, 3745,
+    3739, 3733, 3727, 3721, 3716, 3710, 3704, 3698, 3692, 3686, 3680, 3675,
+    3670, 3665, 3660, 3655, 3650, 3645, 3640, 3635, 3630, 3625, 3620, 3615,
+    3610, 3605, 3600, 3595, 3590, 3585, 3580, 3575, 3570, 3565, 3560, 3555,
+    3550, 3545, 3540, 3535, 3530, 3525, 3520, 3516, 3511, 3507, 3503, 3498,
+    3494, 3490, 3485, 3481, 3477, 3472, 3468, 3464, 3459, 3455, 3451, 3446,
+    3442, 3438, 3434, 3429, 3425, 3421, 3416, 3412, 3408, 3403, 3399, 3395,
+    3390, 3386, 3382, 3377, 3373, 3369, 3364, 3360, 3356, 3352, 3348, 3344,
+    3340, 3337, 3333, 3329, 3325, 3321, 3317, 3313, 3309, 3305, 3301, 3298,
+    3294, 3290, 3286, 3282, 3278, 3274, 3270, 3266, 3262, 3259, 3255, 3251,
+    3247, 3243, 3239, 3235, 3231, 3227, 3223, 3220, 3216, 3212, 3208, 3204,
+    3200, 3197, 3193, 3190, 3186, 3183, 3180, 3176, 3173, 3169, 3166, 3163,
+    3159, 3156, 3152, 3149, 3146, 3142, 3139, 3135, 3132, 3129, 3125, 3122,
+    3118, 3115, 3111, 3108, 3105, 3101, 3098, 3094, 3091, 3088, 3084, 3081,
+    3077, 3074, 3071, 3067, 3064, 3060, 3057, 3054, 3050, 3047, 3043, 3040,
+    3037, 3034, 3031, 3028, 3025, 3022, 3018, 3015, 3012, 3009, 3006, 3003,
+    3000, 2997, 2994, 2991, 2988, 2985, 2982, 2978, 2975, 2972, 2969, 2966,
+    2963, 2960, 2957, 2954, 2951, 2948, 2945, 2942, 2938, 2935, 2932, 2929,
+    2926, 2923, 2920, 2917, 2914, 2911, 2908, 2905, 2902, 2898, 2895, 2892,
+    2889, 2886, 2883, 2880, 2877, 2874, 2871, 2869, 2866, 2863, 2860, 2857,
+    2854, 2851, 2849, 2846, 2843, 2840, 2837, 2834, 2831, 2829, 2826, 2823,
+    2820, 2817, 2814, 2811, 2809, 2806, 2803, 2800, 2797, 2794, 2791, 2789,
+    2786, 2783, 2780, 2777, 2774, 2771, 2769, 2766, 2763, 2760, 2757, 2754,
+    2751, 2749, 2746, 2743, 2740, 2737, 2734, 2731, 2729, 2726, 2723, 2720,
+    2717, 2715, 2712, 2709, 2707, 2704, 2701, 2699, 2696, 2693, 2691, 2688,
+    2685, 2683, 2680, 2677, 2675, 2672, 2669, 2667, 2664, 2661, 2659, 2656,
+    2653, 2651, 2648, 2645, 2643, 2640, 2637, 2635, 2632, 2629, 2627, 2624,
+    2621, 2619, 2616, 2613, 2611, 2608, 2605, 2603, 2600, 2597, 2595, 2592,
+    2589, 2587, 2584, 2581, 2579, 2576, 2573, 2571, 2568, 2565, 2563, 2560,
+    2557, 2555, 2552, 2550, 2547, 2545, 2542, 2540, 2537, 2535, 2532, 2530,
+    2527, 2524, 2522, 2519, 2517, 2514, 2512, 2509, 2507, 2504, 2502, 2499,
+    2497, 2494, 2491, 2489, 2486, 2484, 2481, 2479, 2476, 2474, 2471, 2469,
+    2466, 2463, 2461, 2458, 2456, 2453, 2451, 2448, 2446, 2443, 2441, 2438,
+    2436, 2433, 2430, 2428, 2425, 2423, 2420, 2418, 2415, 2413, 2410, 2408,
+    2405, 2403, 2400, 2397, 2395, 2392, 2390, 2387, 2385, 2382, 2379, 2377,
+    2374, 2372, 2369, 2366, 2364, 2361, 2359, 2356, 2354, 2351, 2348, 2346,
+    2343, 2341, 2338, 2335, 2333, 2330, 2328, 2325, 2323, 2320, 2317, 2315,
+    2312, 2310, 2307, 2305, 2302, 2299, 2297, 2294, 2292, 2289, 2286, 2284,
+    2281, 2279, 2276, 2274, 2271, 2268, 2266, 2263, 2261, 2258, 2255, 2253,
+    2250, 2248, 2245, 2243, 2240, 2237, 2235, 2232, 2230, 2227, 2224, 2222,
+    2219, 2216, 2214, 2211, 2209, 2206, 2203, 2201, 2198, 2195, 2193, 2190,
+    2188, 2185, 2182, 2180, 2177, 2174, 2172, 2169, 2167, 2164, 2161, 2159,
+    2156, 2153, 2151, 2148, 2146, 2143, 2140, 2138, 2135, 2132, 2130, 2127,
+    2125, 2122, 2119, 2117, 2114, 2111, 2109, 2106, 2104, 2101, 2098, 2096,
+    2093, 2090, 2088, 2085, 2083, 2080, 2077, 2074, 2072, 2069, 2066, 2063,
+    2060, 2058, 2055, 2052, 2049, 2046, 2044, 2041, 2038, 2035, 2032, 2029,
+    2027, 2024, 2021, 2018, 2015, 2013, 2010, 2007, 2004, 2001, 1999, 1996,
+    1993, 1990, 1987, 1985, 1982, 1979, 1976, 1973, 1971, 1968, 1965, 1962,
+    1959, 1956, 1954, 1951, 1948, 1945, 1942, 1940, 1937, 1934, 1931, 1928,
+    1926, 1923, 1920, 1917, 1914, 1911, 1908, 1905, 1902, 1898, 1895, 1892,
+    1889, 1886, 1883, 1880, 1877, 1874, 1871, 1868, 1865, 1862, 1858, 1855,
+    1852, 1849, 1846, 1843, 1840, 1837, 1834, 1831, 1828, 1825, 1822, 1818,
+    1815, 1812, 1809, 1806, 1803, 1800, 1797, 1794, 1791, 1788, 1785, 1782,
+    1778, 1775, 1772, 1769, 1766, 1763, 1760, 1756, 1753, 1749, 1746, 1742,
+    1739, 1735, 1732, 1728, 1724, 1721, 1717, 1714, 1710, 1707, 1703, 1700,
+    1696, 1692, 1689, 1685, 1682, 1678, 1675, 1671, 1668, 1664, 1660, 1657,
+    1653, 1650, 1646, 1643, 1639, 1636, 1632, 1628, 1625, 1621, 1618, 1614,
+    1611, 1607, 1604, 1600, 1596, 1592, 1587, 1583, 1579, 1575, 1571, 1566,
+    1562, 1558, 1554, 1549, 1545, 1541, 1537, 1533, 1528, 1524, 1520, 1516,
+    1512, 1507, 1503, 1499, 1495, 1491, 1486, 1482, 1478, 1474, 1469, 1465,
+    1461, 1457, 1453, 1448, 1444, 1440, 1435, 1430, 1425, 1419, 1414, 1409,
+    1404, 1399, 1394, 1388, 1383, 1378, 1373, 1368, 1363, 1357, 1352, 1347,
+    1342, 1337, 1332, 1326, 1321, 1316, 1311, 1306, 1301, 1295, 1290, 1285,
+    1280, 1274, 1267, 1261, 1254, 1248, 1242, 1235, 1229, 1222, 1216, 1210,
+    1203, 1197, 1190, 1184, 1178, 1171, 1165, 1158, 1152, 1146, 1139, 1133,
+    1126, 1120, 1111, 1102, 1093, 1084, 1076, 1067, 1058, 1049, 1040, 1031,
+    1022, 1013, 1004, 996, 987, 978, 969, 960, 949, 937, 926, 914,
+    903, 891, 880, 869, 857, 846, 834, 823, 811, 800, 784, 768,
+    752, 736, 720, 704, 688, 672, 656, 640, 617, 594, 571, 549,
+    526, 503, 480, 448, 416, 384, 352, 320, 267, 213, 160, 80,
+    0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(60)
+  // At most 0.03 degC from temptable_60
+  const short indextable_60[] PROGMEM = {
+    5494, 5472, 5450, 5427, 5405, 5382, 5360, 5338, 5315, 5293, 5270, 5248,
+    5226, 5203, 5181, 5158, 5136, 5114, 5091, 5069, 5046, 5024, 5002, 4979,
+    4957, 4934, 4912, 4890, 4867, 4845, 4822, 4800, 4778, 4755, 4733, 4710,
+    4688, 4666, 4643, 4621, 4598, 4576, 4554, 4531, 4509, 4486, 4464, 4442,
+    4419, 4397, 4374, 4352, 4330, 4307, 4285, 4262, 4240, 4218, 4195, 4173,
+    4150, 4128, 4110, 4093, 4075, 4058, 4040, 4022, 4005, 3987, 3970, 3952,
+    3936, 3920, 3904, 3888, 3872, 3856, 3840, 3824, 3808, 3792, 3779, 3766,
+    3754, 3741, 3728, 3715, 3702, 3690, 3677, 3664, 3651, 3638, 3626, 3613,
+    3600, 3587, 3574, 3562, 3549, 3536, 3527, 3518, 3509, 3500, 3491, 3482,
+    3473, 3463, 3454, 3445, 3436, 3427, 3418, 3409, 3400, 3391, 3382, 3373,
+    3364, 3355, 3346, 3337, 3327, 3318, 3309, 3300, 3291, 3282, 3273, 3264,
+    3257, 3249, 3242, 3234, 3227, 3219, 3212, 3204, 3197, 3189, 3182, 3174,
+    3167, 3159, 3152, 3145, 3137, 3130, 3122, 3115, 3107, 3100, 3092, 3085,
+    3077, 3070, 3062, 3055, 3047, 3040, 3034, 3028, 3022, 3017, 3011, 3005,
+    2999, 2993, 2987, 2981, 2975, 2970, 2964, 2958, 2952, 2946, 2940, 2934,
+    2929, 2923, 2917, 2911, 2905, 2899, 2893, 2887, 2882, 2876, 2870, 2864,
+    2859, 2854, 2850, 2845, 2840, 2835, 2830, 2826, 2821, 2816, 2811, 2806,
+    2802, 2797, 2792, 2787, 2782, 2778, 2773, 2768, 2763, 2758, 2754, 2749,
+    2744, 2739, 2734, 2730, 2725, 2720, 2715, 2710, 2706, 2701, 2696, 2691,
+    2686, 2682, 2677, 2672, 2668, 2664, 2660, 2656, 2652, 2648, 2644, 2640,
+    2636, 2632, 2628, 2624, 2620, 2616, 2612, 2608, 2604, 2600, 2596, 2592,
+    2588, 2584, 2580, 2576, 2572, 2568, 2564, 2560, 2556, 2552, 2548, 2544,
+    2540, 2536, 2532, 2528, 2524, 2520, 2516, 2512, 2508, 2505, 2501, 2498,
+    2494, 2490, 2487, 2483, 2480, 2476, 2472, 2469, 2465, 2462, 2458, 2454,
+    2451, 2447, 2444, 2440, 2436, 2433, 2429, 2426, 2422, 2418, 2415, 2411,
+    2408, 2404, 2400, 2397, 2393, 2390, 2386, 2382, 2379, 2375, 2372, 2368,
+    2365, 2362, 2358, 2355, 2352, 2349, 2346, 2342, 2339, 2336, 2333, 2330,
+    2326, 2323, 2320, 2317, 2314, 2310, 2307, 2304, 2301, 2298, 2294, 2291,
+    2288, 2285, 2282, 2278, 2275, 2272, 2269, 2266, 2262, 2259, 2256, 2253,
+    2250, 2246, 2243, 2240, 2237, 2235, 2232, 2229, 2227, 2224, 2221, 2219,
+    2216, 2213, 2211, 2208, 2205, 2203, 2200, 2197, 2195, 2192, 2189, 2187,
+    2184, 2181, 2179, 2176, 2173, 2171, 2168, 2165, 2163, 2160, 2157, 2155,
+    2152, 2149, 2147, 2144, 2141, 2139, 2136, 2133, 2131, 2128, 2125, 2123,
+    2120, 2117, 2115, 2112, 2109, 2107, 2104, 2101, 2099, 2096, 2093, 2091,
+    2088, 2085, 2083, 2080, 2077, 2075, 2072, 2069, 2067, 2064, 2061, 2059,
+    2056, 2053, 2051, 2048, 2045, 2043, 2040, 2037, 2035, 2032, 2029, 2027,
+    2024, 2021, 2019, 2016, 2013, 2011, 2008, 2005, 2003, 2000, 1997, 1994,
+    1990, 1987, 1984, 1981, 1978, 1974, 1971, 1968, 1966, 1965, 1963, 1962,
+    1960, 1958, 1957, 1955, 1954, 1952, 1949, 1946, 1942, 1939, 1936, 1933,
+    1930, 1926, 1923, 1920, 1918, 1917, 1915, 1914, 1912, 1910, 1909, 1907,
+    1906, 1904, 1901, 1898, 1894, 1891, 1888, 1885, 1882, 1878, 1875, 1872,
+    1870, 1869, 1867, 1866, 1864, 1862, 1861, 1859, 1858, 1856, 1853, 1850,
+    1846, 1843, 1840, 1837, 1834, 1830, 1827, 1824, 1822, 1821, 1819, 1818,
+    1816, 1814, 1813, 1811, 1810, 1808, 1805, 1802, 1798, 1795, 1792, 1789,
+    1786, 1782, 1779, 1776, 1774, 1773, 1771, 1770, 1768, 1766, 1765, 1763,
+    1762, 1760, 1757, 1754, 1750, 1747, 1744, 1741, 1738, 1734, 1731, 1728,
+    1726, 1725, 1723, 1722, 1720, 1718, 1717, 1715, 1714, 1712, 1709, 1706,
+    1702, 1699, 1696, 1693, 1690, 1686, 1683, 1680, 1678, 1677, 1675, 1674,
+    1672, 1670, 1669, 1667, 1666, 1664, 1661, 1658, 1654, 1651, 1648, 1645,
+    1642, 1638, 1635, 1632, 1630, 1629, 1627, 1626, 1624, 1622, 1621, 1619,
+    1618, 1616, 1614, 1613, 1611, 1610, 1608, 1606, 1605, 1603, 1602, 1600,
+    1597, 1594, 1590, 1587, 1584, 1581, 1578, 1574, 1571, 1568, 1566, 1565,
+    1563, 1562, 1560, 1558, 1557, 1555, 1554, 1552, 1549, 1546, 1542, 1539,
+    1536, 1533, 1530, 1526, 1523, 1520, 1518, 1517, 1515, 1514, 1512, 1510,
+    1509, 1507, 1506, 1504, 1501, 1498, 1494, 1491, 1488, 1485, 1482, 1478,
+    1475, 1472, 1470, 1469, 1467, 1466, 1464, 1462, 1461, 1459, 1458, 1456,
+    1454, 1453, 1451, 1450, 1448, 1446, 1445, 1443, 1442, 1440, 1437, 1434,
+    1430, 1427, 1424, 1421, 1418, 1414, 1411, 1408, 1406, 1405, 1403, 1402,
+    1400, 1398, 1397, 1395, 1394, 1392, 1389, 1386, 1382, 1379, 1376, 1373,
+    1370, 1366, 1363, 1360, 1358, 1357, 1355, 1354, 1352, 1350, 1349, 1347,
+    1346, 1344, 1341, 1338, 1334, 1331, 1328, 1325, 1322, 1318, 1315, 1312,
+    1310, 1309, 1307, 1306, 1304, 1302, 1301, 1299, 1298, 1296, 1293, 1290,
+    1286, 1283, 1280, 1277, 1274, 1270, 1267, 1264, 1261, 1258, 1254, 1251,
+    1248, 1245, 1242, 1238, 1235, 1232, 1230, 1229, 1227, 1226, 1224, 1222,
+    1221, 1219, 1218, 1216, 1213, 1210, 1206, 1203, 1200, 1197, 1194, 1190,
+    1187, 1184, 1181, 1178, 1174, 1171, 1168, 1165, 1162, 1158, 1155, 1152,
+    1150, 1149, 1147, 1146, 1144, 1142, 1141, 1139, 1138, 1136, 1133, 1130,
+    1126, 1123, 1120, 1117, 1114, 1110, 1107, 1104, 1101, 1098, 1094, 1091,
+    1088, 1085, 1082, 1078, 1075, 1072, 1069, 1066, 1062, 1059, 1056, 1053,
+    1050, 1046, 1043, 1040, 1037, 1034, 1030, 1027, 1024, 1021, 1018, 1014,
+    1011, 1008, 1006, 1005, 1003, 1002, 1000, 998, 997, 995, 994, 992,
+    989, 986, 982, 979, 976, 973, 970, 966, 963, 960, 955, 950,
+    946, 941, 936, 931, 926, 922, 917, 912, 909, 906, 902, 899,
+    896, 893, 890, 886, 883, 880, 877, 874, 870, 867, 864, 861,
+    858, 854, 851, 848, 845, 842, 838, 835, 832, 829, 826, 822,
+    819, 816, 811, 806, 802, 797, 792, 787, 782, 778, 773, 768,
+    763, 758, 754, 749, 744, 739, 734, 730, 725, 720, 715, 710,
+    706, 701, 696, 691, 686, 682, 677, 672, 667, 662, 658, 653,
+    648, 643, 638, 634, 629, 624, 619, 614, 610, 605, 600, 595,
+    590, 586, 581, 576, 570, 563, 557, 550, 544, 538, 531, 525,
+    518, 512, 505, 498, 490, 483, 476, 469, 462, 454, 447, 440,
+    433, 426, 418, 411, 404, 397, 390, 382, 375, 368, 358, 349,
+    339, 330, 320, 310, 301, 291, 282, 272, 259, 246, 234, 221,
+    208, 195, 182, 170, 157, 144, 123, 103, 82, 62, 41, 21,
+    0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(66)
+  // At most 101.54 degC from temptable_66
+  const short indextable_66[] PROGMEM = {
+    32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767,
+    32767, 32767, 32767, 32767, 32767, 21067, 7990, 7906, 7822, 7738, 7659, 7594,
+    7528, 7463, 7397, 7338, 7289, 7240, 7191, 7142, 7092, 7043, 7002, 6962,
+    6922, 6881, 6841, 6801, 6760, 6720, 6692, 6663, 6635, 6606, 6578, 6549,
+    6521, 6492, 6464, 6436, 6407, 6384, 6364, 6343, 6322, 6302, 6281, 6260,
+    6239, 6219, 6198, 6177, 6156, 6136, 6115, 6094, 6075, 6058, 6041, 6024,
+    6007, 5990, 5973, 5956, 5939, 5922, 5905, 5888, 5871, 5854, 5837, 5820,
+    5803, 5786, 5769, 5754, 5741, 5729, 5716, 5704, 5691, 5678, 5666, 5653,
+    5641, 5628, 5616, 5603, 5591, 5578, 5565, 5553, 5540, 5528, 5515, 5503,
+    5490, 5478, 5465, 5453, 5440, 5431, 5422, 5413, 5404, 5395, 5385, 5376,
+    5367, 5358, 5349, 5340, 5331, 5322, 5313, 5304, 5294, 5285, 5276, 5267,
+    5258, 5249, 5240, 5231, 5222, 5213, 5204, 5194, 5185, 5176, 5167, 5158,
+    5149, 5140, 5131, 5122, 5114, 5108, 5101, 5094, 5087, 5080, 5073, 5067,
+    5060, 5053, 5046, 5039, 5032, 5026, 5019, 5012, 5005, 4998, 4991, 4985,
+    4978, 4971, 4964, 4957, 4950, 4944, 4937, 4930, 4923, 4916, 4909, 4903,
+    4896, 4889, 4882, 4875, 4868, 4862, 4855, 4848, 4841, 4834, 4827, 4821,
+    4814, 4807, 4800, 4795, 4789, 4784, 4779, 4773, 4768, 4763, 4758, 4752,
+    4747, 4742, 4736, 4731, 4726, 4720, 4715, 4710, 4704, 4699, 4694, 4688,
+    4683, 4678, 4673, 4667, 4662, 4657, 4651, 4646, 4641, 4635, 4630, 4625,
+    4619, 4614, 4609, 4603, 4598, 4593, 4588, 4582, 4577, 4572, 4566, 4561,
+    4556, 4550, 4545, 4540, 4534, 4529, 4524, 4519, 4513, 4508, 4503, 4497,
+    4492, 4487, 4481, 4477, 4473, 4468, 4464, 4460, 4456, 4452, 4447, 4443,
+    4439, 4435, 4430, 4426, 4422, 4418, 4414, 4409, 4405, 4401, 4397, 4393,
+    4388, 4384, 4380, 4376, 4371, 4367, 4363, 4359, 4355, 4350, 4346, 4342,
+    4338, 4334, 4329, 4325, 4321, 4317, 4312, 4308, 4304, 4300, 4296, 4291,
+    4287, 4283, 4279, 4275, 4270, 4266, 4262, 4258, 4253, 4249, 4245, 4241,
+    4237, 4232, 4228, 4224, 4220, 4216, 4211, 4207, 4203, 4199, 4195, 4190,
+    4186, 4182, 4178, 4173, 4169, 4165, 4161, 4157, 4154, 4151, 4148, 4144,
+    4141, 4138, 4134, 4131, 4128, 4125, 4121, 4118, 4115, 4111, 4108, 4105,
+    4102, 4098, 4095, 4092, 4089, 4085, 4082, 4079, 4075, 4072, 4069, 4066,
+    4062, 4059, 4056, 4053, 4049, 4046, 4043, 4039, 4036, 4033, 4030, 4026,
+    4023, 4020, 4016, 4013, 4010, 4007, 4003, 4000, 3997, 3994, 3990, 3987,
+    3984, 3980, 3977, 3974, 3971, 3967, 3964, 3961, 3958, 3954, 3951, 3948,
+    3944, 3941, 3938, 3935, 3931, 3928, 3925, 3921, 3918, 3915, 3912, 3908,
+    3905, 3902, 3899, 3895, 3892, 3889, 3885, 3882, 3879, 3876, 3872, 3869,
+    3866, 3863, 3859, 3856, 3853, 3849, 3846, 3843, 3840, 3837, 3834, 3831,
+    3827, 3824, 3821, 3818, 3815, 3812, 3809, 3806, 3803, 3800, 3797, 3794,
+    3791, 3788, 3785, 3782, 3779, 3776, 3773, 3770, 3767, 3764, 3761, 3758,
+    3755, 3752, 3749, 3746, 3743, 3740, 3736, 3733, 3730, 3727, 3724, 3721,
+    3718, 3715, 3712, 3709, 3706, 3703, 3700, 3697, 3694, 3691, 3688, 3685,
+    3682, 3679, 3676, 3673, 3670, 3667, 3664, 3661, 3658, 3655, 3652, 3649,
+    3645, 3642, 3639, 3636, 3633, 3630, 3627, 3624, 3621, 3618, 3615, 3612,
+    3609, 3606, 3603, 3600, 3597, 3594, 3591, 3588, 3585, 3582, 3579, 3576,
+    3573, 3570, 3567, 3564, 3561, 3558, 3555, 3551, 3548, 3545, 3542, 3539,
+    3536, 3533, 3530, 3527, 3524, 3521, 3518, 3515, 3513, 3510, 3507, 3504,
+    3501, 3498, 3496, 3493, 3490, 3487, 3484, 3481, 3479, 3476, 3473, 3470,
+    3467, 3464, 3462, 3459, 3456, 3453, 3450, 3448, 3445, 3442, 3439, 3436,
+    3433, 3431, 3428, 3425, 3422, 3419, 3416, 3414, 3411, 3408, 3405, 3402,
+    3399, 3397, 3394, 3391, 3388, 3385, 3382, 3380, 3377, 3374, 3371, 3368,
+    3365, 3363, 3360, 3357, 3354, 3351, 3349, 3346, 3343, 3340, 3337, 3334,
+    3332, 3329, 3326, 3323, 3320, 3317, 3315, 3312, 3309, 3306, 3303, 3300,
+    3298, 3295, 3292, 3289, 3286, 3283, 3281, 3278, 3275, 3272, 3269, 3266,
+    3264, 3261, 3258, 3255, 3252, 3250, 3247, 3244, 3241, 3238, 3235, 3233,
+    3230, 3227, 3224, 3221, 3218, 3216, 3213, 3210, 3207, 3204, 3201, 3199,
+    3196, 3193, 3190, 3187, 3184, 3181, 3178, 3175, 3172, 3169, 3166, 3163,
+    3160, 3157, 3154, 3151, 3148, 3145, 3142, 3139, 3136, 3133, 3130, 3127,
+    3124, 3121, 3118, 3115, 3112, 3110, 3107, 3104, 3101, 3098, 3095, 3092,
+    3089, 3086, 3083, 3080, 3077, 3074, 3071, 3068, 3065, 3062, 3059, 3056,
+    3053, 3050, 3047, 3044, 3041, 3038, 3035, 3032, 3029, 3026, 3023, 3021,
+    3018, 3015, 3012, 3009, 3006, 3003, 3000, 2997, 2994, 2991, 2988, 2985,
+    2982, 2979, 2976, 2973, 2970, 2967, 2964, 2961, 2958, 2955, 2952, 2949,
+    2946, 2943, 2940, 2937, 2935, 2932, 2929, 2926, 2923, 2920, 2917, 2914,
+    2911, 2908, 2905, 2902, 2899, 2896, 2893, 2890, 2887, 2884, 2881, 2878,
+    2874, 2871, 2867, 2864, 2860, 2856, 2853, 2849, 2846, 2842, 2839, 2835,
+    2831, 2828, 2824, 2821, 2817, 2814, 2810, 2807, 2803, 2799, 2796, 2792,
+    2789, 2785, 2782, 2778, 2775, 2771, 2767, 2764, 2760, 2757, 2753, 2750,
+    2746, 2742, 2739, 2735, 2732, 2728, 2725, 2721, 2718, 2714, 2710, 2707,
+    2703, 2700, 2696, 2693, 2689, 2686, 2682, 2678, 2675, 2671, 2668, 2664,
+    2661, 2657, 2653, 2650, 2646, 2643, 2639, 2636, 2632, 2629, 2625, 2621,
+    2618, 2614, 2611, 2607, 2604, 2600, 2596, 2593, 2589, 2586, 2582, 2579,
+    2575, 2572, 2568, 2564, 2561, 2556, 2552, 2547, 2542, 2537, 2533, 2528,
+    2523, 2518, 2514, 2509, 2504, 2499, 2495, 2490, 2485, 2481, 2476, 2471,
+    2466, 2462, 2457, 2452, 2447, 2443, 2438, 2433, 2428, 2424, 2419, 2414,
+    2409, 2405, 2400, 2395, 2390, 2386, 2381, 2376, 2371, 2367, 2362, 2357,
+    2352, 2348, 2343, 2338, 2333, 2329, 2324, 2319, 2314, 2310, 2305, 2300,
+    2295, 2291, 2286, 2281, 2276, 2272, 2267, 2262, 2257, 2253, 2248, 2243,
+    2238, 2231, 2224, 2217, 2211, 2204, 2197, 2190, 2183, 2176, 2170, 2163,
+    2156, 2149, 2142, 2135, 2129, 2122, 2115, 2108, 2101, 2095, 2088, 2081,
+    2074, 2067, 2060, 2054, 2047, 2040, 2033, 2026, 2019, 2013, 2006, 1999,
+    1992, 1985, 1978, 1972, 1965, 1958, 1951, 1944, 1937, 1931, 1924, 1915,
+    1905, 1894, 1884, 1873, 1862, 1852, 1841, 1831, 1820, 1809, 1799, 1788,
+    1778, 1767, 1756, 1746, 1735, 1725, 1714, 1703, 1693, 1682, 1672, 1661,
+    1650, 1640, 1629, 1619, 1608, 1596, 1578, 1560, 1542, 1524, 1506, 1488,
+    1470, 1452, 1434, 1416, 1398, 1380, 1362, 1344, 1326, 1308, 1290, 1265,
+    1230, 1195, 1160, 1125, 1091, 1056, 1021, 986, 938, 851, 764, 676,
+    589, 502, 444, 320
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(70)
+  // At most 0.03 degC from temptable_70
+  const short indextable_70[] PROGMEM = {
+    5680, 5640, 5600, 5560, 5520, 5480, 5440, 5400, 5360, 5320, 5280, 5240,
+    5200, 5160, 5120, 5080, 5040, 5000, 4960, 4920, 4880, 4840, 4800, 4760,
+    4720, 4640, 4600, 4560, 4520, 4480, 4453, 4427, 4400, 4360, 4320, 4293,
+    4267, 4240, 4213, 4187, 4160, 4133, 4107, 4080, 4053, 4027, 4000, 3980,
+    3960, 3940, 3920, 3900, 3880, 3860, 3840, 3824, 3808, 3792, 3776, 3760,
+    3744, 3728, 3712, 3696, 3680, 3667, 3653, 3640, 3627, 3613, 3600, 3587,
+    3573, 3560, 3547, 3533, 3520, 3509, 3497, 3486, 3474, 3463, 3451, 3440,
+    3429, 3417, 3406, 3394, 3383, 3371, 3360, 3351, 3342, 3333, 3324, 3316,
+    3307, 3298, 3289, 3280, 3271, 3262, 3253, 3244, 3236, 3227, 3218, 3209,
+    3200, 3192, 3184, 3176, 3168, 3160, 3152, 3144, 3136, 3128, 3120, 3113,
+    3105, 3098, 3091, 3084, 3076, 3069, 3062, 3055, 3047, 3040, 3033, 3027,
+    3020, 3013, 3007, 3000, 2993, 2987, 2980, 2973, 2967, 2960, 2954, 2948,
+    2942, 2935, 2929, 2923, 2917, 2911, 2905, 2898, 2892, 2886, 2880, 2875,
+    2869, 2864, 2859, 2853, 2848, 2843, 2837, 2832, 2827, 2821, 2816, 2811,
+    2805, 2800, 2795, 2790, 2785, 2780, 2775, 2770, 2765, 2760, 2755, 2750,
+    2745, 2740, 2735, 2730, 2725, 2720, 2716, 2711, 2707, 2702, 2698, 2693,
+    2689, 2684, 2680, 2676, 2671, 2667, 2662, 2658, 2653, 2649, 2644, 2640,
+    2636, 2632, 2627, 2623, 2619, 2615, 2611, 2606, 2602, 2598, 2594, 2589,
+    2585, 2581, 2577, 2573, 2568, 2564, 2560, 2556, 2552, 2549, 2545, 2541,
+    2537, 2533, 2530, 2526, 2522, 2518, 2514, 2510, 2507, 2503, 2499, 2495,
+    2491, 2488, 2484, 2480, 2477, 2473, 2470, 2466, 2463, 2459, 2456, 2452,
+    2449, 2445, 2442, 2438, 2435, 2431, 2428, 2424, 2421, 2417, 2414, 2410,
+    2407, 2403, 2400, 2397, 2393, 2390, 2387, 2383, 2380, 2377, 2373, 2370,
+    2367, 2363, 2360, 2357, 2353, 2350, 2347, 2343, 2340, 2337, 2333, 2330,
+    2327, 2323, 2320, 2317, 2314, 2311, 2308, 2305, 2302, 2299, 2296, 2293,
+    2290, 2287, 2284, 2281, 2279, 2276, 2273, 2270, 2267, 2264, 2261, 2258,
+    2255, 2252, 2249, 2246, 2243, 2240, 2237, 2234, 2232, 2229, 2226, 2223,
+    2221, 2218, 2215, 2212, 2210, 2207, 2204, 2201, 2199, 2196, 2193, 2190,
+    2188, 2185, 2182, 2179, 2177, 2174, 2171, 2168, 2166, 2163, 2160, 2157,
+    2155, 2152, 2149, 2147, 2144, 2141, 2139, 2136, 2133, 2131, 2128, 2125,
+    2123, 2120, 2117, 2115, 2112, 2109, 2107, 2104, 2101, 2099, 2096, 2093,
+    2091, 2088, 2085, 2083, 2080, 2078, 2075, 2072, 2070, 2068, 2065, 2062,
+    2060, 2058, 2055, 2052, 2050, 2048, 2045, 2042, 2040, 2038, 2035, 2032,
+    2030, 2028, 2025, 2022, 2020, 2018, 2015, 2012, 2010, 2008, 2005, 2002,
+    2000, 1998, 1995, 1993, 1991, 1988, 1986, 1984, 1981, 1979, 1976, 1974,
+    1972, 1969, 1967, 1965, 1962, 1960, 1958, 1955, 1953, 1951, 1948, 1946,
+    1944, 1941, 1939, 1936, 1934, 1932, 1929, 1927, 1925, 1922, 1920, 1918,
+    1915, 1913, 1911, 1909, 1906, 1904, 1902, 1899, 1897, 1895, 1893, 1890,
+    1888, 1886, 1883, 1881, 1879, 1877, 1874, 1872, 1870, 1867, 1865, 1863,
+    1861, 1858, 1856, 1854, 1851, 1849, 1847, 1845, 1842, 1840, 1838, 1836,
+    1833, 1831, 1829, 1827, 1824, 1822, 1820, 1818, 1816, 1813, 1811, 1809,
+    1807, 1804, 1802, 1800, 1798, 1796, 1793, 1791, 1789, 1787, 1784, 1782,
+    1780, 1778, 1776, 1773, 1771, 1769, 1767, 1764, 1762, 1760, 1758, 1756,
+    1754, 1752, 1749, 1747, 1745, 1743, 1741, 1739, 1737, 1735, 1733, 1731,
+    1728, 1726, 1724, 1722, 1720, 1718, 1716, 1714, 1712, 1709, 1707, 1705,
+    1703, 1701, 1699, 1697, 1695, 1693, 1691, 1688, 1686, 1684, 1682, 1680,
+    1678, 1676, 1674, 1671, 1669, 1667, 1665, 1663, 1661, 1658, 1656, 1654,
+    1652, 1650, 1648, 1645, 1643, 1641, 1639, 1637, 1635, 1632, 1630, 1628,
+    1626, 1624, 1622, 1619, 1617, 1615, 1613, 1611, 1609, 1606, 1604, 1602,
+    1600, 1598, 1596, 1594, 1592, 1589, 1587, 1585, 1583, 1581, 1579, 1577,
+    1575, 1573, 1571, 1568, 1566, 1564, 1562, 1560, 1558, 1556, 1554, 1552,
+    1549, 1547, 1545, 1543, 1541, 1539, 1537, 1535, 1533, 1531, 1528, 1526,
+    1524, 1522, 1520, 1518, 1516, 1514, 1511, 1509, 1507, 1505, 1503, 1501,
+    1498, 1496, 1494, 1492, 1490, 1488, 1485, 1483, 1481, 1479, 1477, 1475,
+    1472, 1470, 1468, 1466, 1464, 1462, 1459, 1457, 1455, 1453, 1451, 1449,
+    1446, 1444, 1442, 1440, 1438, 1436, 1433, 1431, 1429, 1427, 1424, 1422,
+    1420, 1418, 1416, 1413, 1411, 1409, 1407, 1404, 1402, 1400, 1398, 1396,
+    1393, 1391, 1389, 1387, 1384, 1382, 1380, 1378, 1376, 1373, 1371, 1369,
+    1367, 1364, 1362, 1360, 1358, 1356, 1353, 1351, 1349, 1347, 1344, 1342,
+    1340, 1338, 1336, 1333, 1331, 1329, 1327, 1324, 1322, 1320, 1318, 1316,
+    1313, 1311, 1309, 1307, 1304, 1302, 1300, 1298, 1296, 1293, 1291, 1289,
+    1287, 1284, 1282, 1280, 1278, 1275, 1273, 1270, 1268, 1265, 1263, 1261,
+    1258, 1256, 1253, 1251, 1248, 1246, 1244, 1241, 1239, 1236, 1234, 1232,
+    1229, 1227, 1224, 1222, 1219, 1217, 1215, 1212, 1210, 1207, 1205, 1202,
+    1200, 1198, 1195, 1192, 1190, 1188, 1185, 1182, 1180, 1178, 1175, 1172,
+    1170, 1168, 1165, 1162, 1160, 1158, 1155, 1152, 1150, 1148, 1145, 1142,
+    1140, 1138, 1135, 1132, 1130, 1128, 1125, 1122, 1120, 1117, 1114, 1112,
+    1109, 1106, 1103, 1101, 1098, 1095, 1092, 1090, 1087, 1084, 1081, 1079,
+    1076, 1073, 1070, 1068, 1065, 1062, 1059, 1057, 1054, 1051, 1048, 1046,
+    1043, 1040, 1037, 1034, 1031, 1028, 1025, 1022, 1019, 1016, 1013, 1010,
+    1007, 1004, 1001, 999, 996, 993, 990, 987, 984, 981, 978, 975,
+    972, 969, 966, 963, 960, 957, 954, 950, 947, 944, 941, 938,
+    934, 931, 928, 925, 922, 918, 915, 912, 909, 906, 902, 899,
+    896, 893, 890, 886, 883, 880, 876, 873, 869, 865, 862, 858,
+    855, 851, 847, 844, 840, 836, 833, 829, 825, 822, 818, 815,
+    811, 807, 804, 800, 796, 792, 787, 783, 779, 775, 771, 766,
+    762, 758, 754, 749, 745, 741, 737, 733, 728, 724, 720, 715,
+    711, 706, 701, 696, 692, 687, 682, 678, 673, 668, 664, 659,
+    654, 649, 645, 640, 635, 629, 624, 619, 613, 608, 603, 597,
+    592, 587, 581, 576, 571, 565, 560, 553, 547, 540, 533, 527,
+    520, 513, 507, 500, 493, 487, 480, 473, 465, 458, 451, 444,
+    436, 429, 422, 415, 407, 400, 391, 382, 373, 364, 356, 347,
+    338, 329, 320, 310, 300, 290, 280, 270, 260, 250, 240, 227,
+    213, 200, 187, 173, 160, 144, 128, 112, 96, 80, 60, 40,
+    20, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(71)
+  // At most 0.03 degC from temptable_71
+  const short indextable_71[] PROGMEM = {
+    5850, 5820, 5790, 5760, 5730, 5700, 5670, 5640, 5610, 5580, 5550, 5520,
+    5490, 5460, 5430, 5400, 5370, 5340, 5310, 5280, 5250, 5220, 5190, 5160,
+    5130, 5100, 5070, 5040, 5010, 4980, 4950, 4920, 4890, 4860, 4830, 4800,
+    4770, 4740, 4710, 4680, 4650, 4620, 4590, 4560, 4530, 4500, 4470, 4440,
+    4410, 4380, 4350, 4320, 4293, 4267, 4240, 4220, 4200, 4180, 4160, 4128,
+    4112, 4096, 4080, 4064, 4032, 4016, 4000, 3984, 3968, 3952, 3936, 3920,
+    3904, 3888, 3872, 3856, 3840, 3824, 3808, 3792, 3776, 3760, 3744, 3736,
+    3728, 3712, 3696, 3680, 3672, 3664, 3648, 3632, 3616, 3608, 3600, 3584,
+    3576, 3568, 3552, 3536, 3528, 3520, 3504, 3496, 3488, 3480, 3472, 3456,
+    3448, 3440, 3424, 3416, 3408, 3400, 3392, 3376, 3368, 3360, 3352, 3344,
+    3336, 3328, 3320, 3312, 3304, 3296, 3280, 3272, 3264, 3256, 3248, 3240,
+    3232, 3224, 3216, 3208, 3200, 3195, 3189, 3184, 3176, 3168, 3160, 3152,
+    3144, 3136, 3128, 3120, 3115, 3109, 3104, 3096, 3088, 3080, 3072, 3067,
+    3061, 3056, 3048, 3040, 3035, 3029, 3024, 3016, 3008, 3003, 2997, 2992,
+    2987, 2981, 2976, 2968, 2960, 2955, 2949, 2944, 2939, 2933, 2928, 2923,
+    2917, 2912, 2907, 2901, 2896, 2891, 2885, 2880, 2875, 2869, 2864, 2859,
+    2853, 2848, 2843, 2837, 2832, 2827, 2821, 2816, 2811, 2805, 2800, 2795,
+    2789, 2784, 2779, 2773, 2768, 2764, 2760, 2756, 2752, 2747, 2741, 2736,
+    2732, 2728, 2724, 2720, 2716, 2711, 2707, 2702, 2698, 2693, 2689, 2684,
+    2680, 2676, 2671, 2667, 2662, 2658, 2653, 2649, 2644, 2640, 2636, 2632,
+    2627, 2623, 2619, 2615, 2611, 2606, 2602, 2598, 2594, 2589, 2585, 2581,
+    2577, 2573, 2568, 2564, 2560, 2556, 2553, 2549, 2545, 2542, 2538, 2535,
+    2531, 2527, 2524, 2520, 2516, 2513, 2509, 2505, 2502, 2498, 2495, 2491,
+    2487, 2484, 2480, 2476, 2473, 2469, 2465, 2462, 2458, 2455, 2451, 2447,
+    2444, 2440, 2436, 2433, 2429, 2425, 2422, 2418, 2415, 2411, 2407, 2404,
+    2400, 2397, 2394, 2391, 2387, 2384, 2381, 2378, 2375, 2372, 2369, 2365,
+    2362, 2359, 2356, 2353, 2350, 2347, 2344, 2340, 2337, 2334, 2331, 2328,
+    2325, 2322, 2318, 2315, 2312, 2309, 2306, 2303, 2300, 2296, 2293, 2290,
+    2287, 2284, 2281, 2278, 2275, 2271, 2268, 2265, 2262, 2259, 2256, 2253,
+    2249, 2246, 2243, 2240, 2237, 2235, 2232, 2229, 2227, 2224, 2221, 2218,
+    2216, 2213, 2210, 2208, 2205, 2202, 2200, 2197, 2194, 2192, 2189, 2186,
+    2184, 2181, 2178, 2175, 2173, 2170, 2167, 2165, 2162, 2159, 2157, 2154,
+    2151, 2149, 2146, 2143, 2141, 2138, 2135, 2132, 2130, 2127, 2124, 2122,
+    2119, 2116, 2114, 2111, 2108, 2106, 2103, 2100, 2097, 2095, 2092, 2089,
+    2087, 2084, 2081, 2079, 2076, 2073, 2071, 2068, 2065, 2063, 2060, 2057,
+    2054, 2052, 2049, 2046, 2044, 2041, 2038, 2036, 2033, 2030, 2028, 2025,
+    2022, 2019, 2017, 2014, 2011, 2009, 2006, 2003, 2001, 1998, 1995, 1993,
+    1990, 1987, 1985, 1982, 1979, 1976, 1974, 1971, 1968, 1966, 1963, 1960,
+    1958, 1955, 1952, 1950, 1947, 1944, 1942, 1939, 1936, 1933, 1931, 1928,
+    1925, 1923, 1920, 1918, 1915, 1913, 1911, 1908, 1906, 1904, 1901, 1899,
+    1896, 1894, 1892, 1889, 1887, 1885, 1882, 1880, 1878, 1875, 1873, 1871,
+    1868, 1866, 1864, 1861, 1859, 1856, 1854, 1852, 1849, 1847, 1845, 1842,
+    1840, 1838, 1835, 1833, 1831, 1828, 1826, 1824, 1821, 1819, 1816, 1814,
+    1812, 1809, 1807, 1805, 1802, 1800, 1798, 1795, 1793, 1791, 1788, 1786,
+    1784, 1781, 1779, 1776, 1774, 1772, 1769, 1767, 1765, 1762, 1760, 1758,
+    1755, 1753, 1751, 1749, 1746, 1744, 1742, 1739, 1737, 1735, 1733, 1730,
+    1728, 1726, 1723, 1721, 1719, 1717, 1714, 1712, 1710, 1707, 1705, 1703,
+    1701, 1698, 1696, 1694, 1691, 1689, 1687, 1685, 1682, 1680, 1678, 1675,
+    1673, 1671, 1669, 1666, 1664, 1662, 1659, 1657, 1655, 1653, 1650, 1648,
+    1646, 1643, 1641, 1639, 1637, 1634, 1632, 1630, 1627, 1625, 1623, 1621,
+    1618, 1616, 1614, 1611, 1609, 1607, 1605, 1602, 1600, 1598, 1595, 1593,
+    1591, 1589, 1586, 1584, 1582, 1579, 1577, 1575, 1573, 1570, 1568, 1566,
+    1563, 1561, 1559, 1557, 1554, 1552, 1550, 1547, 1545, 1543, 1541, 1538,
+    1536, 1534, 1531, 1529, 1527, 1525, 1522, 1520, 1518, 1515, 1513, 1511,
+    1509, 1506, 1504, 1502, 1499, 1497, 1495, 1493, 1490, 1488, 1486, 1483,
+    1481, 1479, 1477, 1474, 1472, 1470, 1467, 1465, 1463, 1461, 1458, 1456,
+    1454, 1451, 1449, 1447, 1445, 1442, 1440, 1438, 1435, 1433, 1431, 1428,
+    1426, 1424, 1421, 1419, 1416, 1414, 1412, 1409, 1407, 1405, 1402, 1400,
+    1398, 1395, 1393, 1391, 1388, 1386, 1384, 1381, 1379, 1376, 1374, 1372,
+    1369, 1367, 1365, 1362, 1360, 1358, 1355, 1353, 1350, 1348, 1345, 1343,
+    1341, 1338, 1336, 1333, 1331, 1328, 1326, 1324, 1321, 1319, 1316, 1314,
+    1312, 1309, 1307, 1304, 1302, 1299, 1297, 1295, 1292, 1290, 1287, 1285,
+    1282, 1280, 1278, 1275, 1273, 1270, 1268, 1265, 1263, 1260, 1258, 1255,
+    1253, 1250, 1248, 1245, 1243, 1240, 1237, 1235, 1232, 1229, 1227, 1224,
+    1221, 1219, 1216, 1214, 1211, 1209, 1206, 1204, 1201, 1199, 1196, 1194,
+    1191, 1189, 1186, 1184, 1181, 1179, 1176, 1173, 1171, 1168, 1165, 1163,
+    1160, 1157, 1155, 1152, 1149, 1146, 1143, 1140, 1137, 1135, 1132, 1129,
+    1126, 1123, 1120, 1117, 1115, 1112, 1109, 1107, 1104, 1101, 1099, 1096,
+    1093, 1091, 1088, 1085, 1082, 1079, 1076, 1073, 1071, 1068, 1065, 1062,
+    1059, 1056, 1053, 1050, 1047, 1044, 1041, 1039, 1036, 1033, 1030, 1027,
+    1024, 1021, 1018, 1014, 1011, 1008, 1005, 1002, 998, 995, 992, 989,
+    986, 982, 979, 976, 973, 970, 966, 963, 960, 957, 954, 950,
+    947, 944, 941, 938, 934, 931, 928, 924, 921, 917, 914, 910,
+    907, 903, 900, 896, 892, 889, 885, 882, 878, 875, 871, 868,
+    864, 860, 857, 853, 850, 846, 843, 839, 836, 832, 828, 824,
+    820, 816, 812, 808, 804, 800, 796, 792, 787, 783, 779, 775,
+    771, 766, 762, 758, 754, 749, 745, 741, 737, 733, 728, 724,
+    720, 715, 710, 705, 700, 695, 690, 685, 680, 675, 670, 665,
+    660, 655, 650, 645, 640, 635, 629, 624, 619, 613, 608, 603,
+    597, 592, 587, 581, 576, 571, 565, 560, 553, 547, 540, 533,
+    527, 520, 513, 507, 500, 493, 487, 480, 475, 469, 464, 456,
+    448, 440, 432, 424, 416, 408, 400, 392, 384, 376, 368, 360,
+    352, 336, 328, 320, 310, 300, 290, 280, 270, 260, 250, 240,
+    227, 213, 200, 187, 173, 160, 144, 128, 112, 96, 80, 60,
+    40, 20, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(75)
+  // At most 0.07 degC from temptable_75
+  const short indextable_75[] PROGMEM = {
+    3740, 3735, 3730, 3726, 3721, 3716, 3711, 3706, 3701, 3696, 3692, 3687,
+    3682, 3677, 3672, 3667, 3662, 3657, 3653, 3648, 3643, 3638, 3633, 3628,
+    3623, 3619, 3614, 3609, 3604, 3599, 3594, 3589, 3584, 3580, 3575, 3570,
+    3565, 3560, 3555, 3550, 3546, 3541, 3536, 3531, 3526, 3521, 3516, 3511,
+    3507, 3502, 3497, 3492, 3487, 3482, 3477, 3473, 3468, 3463, 3458, 3453,
+    3448, 3443, 3438, 3434, 3429, 3424, 3419, 3414, 3409, 3404, 3400, 3395,
+    3390, 3385, 3380, 3375, 3370, 3365, 3361, 3356, 3351, 3346, 3341, 3336,
+    3331, 3327, 3322, 3317, 3312, 3307, 3302, 3297, 3292, 3288, 3283, 3278,
+    3273, 3268, 3263, 3258, 3254, 3249, 3244, 3239, 3234, 3229, 3224, 3219,
+    3215, 3210, 3205, 3200, 3195, 3190, 3185, 3181, 3176, 3171, 3166, 3161,
+    3156, 3151, 3146, 3142, 3137, 3132, 3127, 3122, 3117, 3112, 3108, 3103,
+    3098, 3093, 3088, 3083, 3078, 3073, 3069, 3064, 3059, 3054, 3049, 3044,
+    3039, 3035, 3030, 3025, 3020, 3015, 3010, 3005, 3000, 2996, 2991, 2986,
+    2981, 2976, 2971, 2966, 2962, 2957, 2952, 2947, 2942, 2937, 2932, 2927,
+    2923, 2918, 2913, 2908, 2903, 2898, 2893, 2889, 2884, 2879, 2874, 2869,
+    2864, 2859, 2854, 2850, 2845, 2840, 2835, 2830, 2825, 2820, 2816, 2811,
+    2806, 2801, 2796, 2791, 2786, 2781, 2777, 2772, 2767, 2762, 2757, 2752,
+    2747, 2743, 2738, 2733, 2728, 2723, 2718, 2713, 2708, 2704, 2699, 2694,
+    2689, 2684, 2679, 2674, 2670, 2665, 2660, 2655, 2650, 2645, 2640, 2635,
+    2631, 2626, 2621, 2616, 2611, 2606, 2601, 2597, 2592, 2587, 2582, 2577,
+    2572, 2567, 2562, 2558, 2553, 2548, 2543, 2538, 2533, 2528, 2523, 2519,
+    2514, 2509, 2504, 2499, 2494, 2489, 2485, 2480, 2475, 2470, 2465, 2460,
+    2455, 2450, 2446, 2441, 2436, 2431, 2426, 2421, 2416, 2412, 2407, 2402,
+    2398, 2395, 2392, 2389, 2386, 2383, 2380, 2377, 2374, 2371, 2368, 2365,
+    2362, 2359, 2356, 2353, 2350, 2347, 2344, 2341, 2338, 2335, 2332, 2329,
+    2326, 2323, 2320, 2317, 2313, 2310, 2307, 2304, 2301, 2298, 2295, 2292,
+    2289, 2286, 2283, 2280, 2277, 2274, 2271, 2268, 2265, 2262, 2259, 2256,
+    2253, 2250, 2247, 2244, 2241, 2238, 2236, 2233, 2230, 2228, 2225, 2222,
+    2220, 2217, 2214, 2212, 2209, 2206, 2204, 2201, 2198, 2196, 2193, 2190,
+    2188, 2185, 2182, 2180, 2177, 2175, 2172, 2169, 2167, 2164, 2161, 2159,
+    2156, 2153, 2151, 2148, 2145, 2143, 2140, 2137, 2135, 2132, 2129, 2127,
+    2124, 2121, 2119, 2116, 2113, 2111, 2108, 2106, 2103, 2100, 2098, 2095,
+    2092, 2090, 2087, 2084, 2082, 2079, 2077, 2074, 2072, 2069, 2067, 2064,
+    2062, 2060, 2057, 2055, 2052, 2050, 2047, 2045, 2042, 2040, 2038, 2035,
+    2033, 2030, 2028, 2025, 2023, 2020, 2018, 2016, 2013, 2011, 2008, 2006,
+    2003, 2001, 1999, 1996, 1994, 1992, 1989, 1987, 1985, 1982, 1980, 1978,
+    1975, 1973, 1971, 1968, 1966, 1964, 1961, 1959, 1956, 1954, 1952, 1949,
+    1947, 1945, 1942, 1940, 1938, 1935, 1933, 1931, 1928, 1926, 1924, 1921,
+    1919, 1917, 1915, 1912, 1910, 1908, 1906, 1903, 1901, 1899, 1897, 1894,
+    1892, 1890, 1888, 1885, 1883, 1881, 1879, 1876, 1874, 1872, 1870, 1867,
+    1865, 1863, 1861, 1858, 1856, 1854, 1852, 1849, 1847, 1845, 1843, 1840,
+    1838, 1836, 1834, 1832, 1829, 1827, 1825, 1823, 1821, 1818, 1816, 1814,
+    1812, 1810, 1807, 1805, 1803, 1801, 1799, 1796, 1794, 1792, 1790, 1788,
+    1785, 1783, 1781, 1779, 1777, 1775, 1772, 1770, 1768, 1766, 1764, 1761,
+    1759, 1757, 1755, 1753, 1751, 1748, 1746, 1744, 1742, 1740, 1738, 1735,
+    1733, 1731, 1729, 1727, 1725, 1723, 1720, 1718, 1716, 1714, 1712, 1710,
+    1707, 1705, 1703, 1701, 1699, 1697, 1695, 1692, 1690, 1688, 1686, 1684,
+    1682, 1679, 1677, 1675, 1673, 1671, 1669, 1667, 1665, 1662, 1660, 1658,
+    1656, 1654, 1652, 1650, 1647, 1645, 1643, 1641, 1639, 1637, 1635, 1632,
+    1630, 1628, 1626, 1624, 1622, 1620, 1617, 1615, 1613, 1611, 1609, 1607,
+    1605, 1603, 1600, 1598, 1596, 1594, 1592, 1590, 1587, 1585, 1583, 1581,
+    1579, 1577, 1574, 1572, 1570, 1568, 1566, 1564, 1561, 1559, 1557, 1555,
+    1553, 1551, 1548, 1546, 1544, 1542, 1540, 1538, 1535, 1533, 1531, 1529,
+    1527, 1525, 1522, 1520, 1518, 1516, 1514, 1512, 1509, 1507, 1505, 1503,
+    1501, 1499, 1496, 1494, 1492, 1490, 1488, 1486, 1483, 1481, 1479, 1477,
+    1475, 1473, 1470, 1468, 1466, 1464, 1462, 1460, 1457, 1455, 1453, 1451,
+    1449, 1447, 1444, 1442, 1440, 1438, 1435, 1433, 1431, 1429, 1426, 1424,
+    1422, 1419, 1417, 1415, 1412, 1410, 1408, 1406, 1403, 1401, 1399, 1396,
+    1394, 1392, 1390, 1387, 1385, 1383, 1380, 1378, 1376, 1374, 1371, 1369,
+    1367, 1364, 1362, 1360, 1357, 1355, 1353, 1351, 1348, 1346, 1344, 1341,
+    1339, 1337, 1335, 1332, 1330, 1328, 1325, 1323, 1321, 1319, 1316, 1314,
+    1312, 1309, 1307, 1305, 1302, 1300, 1298, 1296, 1293, 1291, 1289, 1286,
+    1284, 1282, 1280, 1277, 1275, 1272, 1270, 1267, 1265, 1262, 1260, 1257,
+    1255, 1252, 1250, 1247, 1245, 1243, 1240, 1238, 1235, 1233, 1230, 1228,
+    1225, 1223, 1220, 1218, 1215, 1213, 1210, 1208, 1206, 1203, 1201, 1198,
+    1195, 1193, 1190, 1188, 1185, 1182, 1180, 1177, 1174, 1172, 1169, 1167,
+    1164, 1161, 1159, 1156, 1153, 1151, 1148, 1146, 1143, 1140, 1138, 1135,
+    1132, 1130, 1127, 1125, 1122, 1119, 1116, 1114, 1111, 1108, 1105, 1102,
+    1099, 1097, 1094, 1091, 1088, 1085, 1082, 1080, 1077, 1074, 1071, 1068,
+    1065, 1063, 1060, 1057, 1054, 1051, 1048, 1045, 1043, 1040, 1037, 1034,
+    1030, 1027, 1024, 1021, 1018, 1015, 1012, 1009, 1006, 1003, 999, 996,
+    993, 990, 987, 984, 981, 978, 975, 971, 968, 965, 962, 959,
+    956, 952, 949, 945, 942, 938, 935, 932, 928, 925, 921, 918,
+    914, 911, 908, 904, 901, 897, 894, 890, 887, 884, 880, 876,
+    873, 869, 865, 861, 857, 853, 850, 846, 842, 838, 834, 830,
+    827, 823, 819, 815, 811, 807, 804, 800, 795, 790, 786, 781,
+    777, 772, 767, 763, 758, 754, 749, 744, 740, 735, 731, 726,
+    721, 717, 712, 707, 703, 698, 694, 689, 684, 680, 675, 671,
+    666, 661, 657, 652, 647, 643, 638, 632, 625, 619, 613, 607,
+    601, 595, 589, 583, 576, 570, 564, 558, 552, 546, 540, 534,
+    527, 521, 515, 509, 503, 497, 491, 485, 478, 470, 462, 455,
+    447, 439, 431, 423, 416, 408, 400, 391, 382, 374, 365, 355,
+    346, 337, 327, 317, 306, 294, 283, 272, 261, 250, 239, 226,
+    212, 199, 186, 172, 159, 141, 123, 106, 88, 70, 52, 34,
+    17, 0
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(110)
+  // At most 0.03 degC from temptable_110
+  const short indextable_110[] PROGMEM = {
+    -4650, -4600, -4550, -4500, -4450, -4400, -4350, -4300, -4250, -4200, -4150, -4100,
+    -4050, -4000, -3950, -3900, -3850, -3800, -3750, -3700, -3650, -3600, -3550, -3500,
+    -3450, -3400, -3350, -3300, -3250, -3200, -3150, -3100, -3050, -3000, -2950, -2900,
+    -2850, -2800, -2750, -2700, -2650, -2600, -2550, -2500, -2450, -2400, -2350, -2300,
+    -2250, -2200, -2150, -2100, -2050, -2000, -1950, -1900, -1850, -1800, -1750, -1700,
+    -1650, -1600, -1550, -1500, -1450, -1400, -1350, -1300, -1250, -1200, -1150, -1100,
+    -1050, -1000, -950, -900, -850, -800, -750, -700, -650, -600, -550, -500,
+    -450, -400, -350, -300, -250, -200, -150, -100, -50, 0, 50, 100,
+    150, 200, 250, 300, 350, 400, 450, 500, 550, 600, 650, 700,
+    750, 800, 853, 907, 960, 1013, 1067, 1120, 1173, 1227, 1280, 1333,
+    1387, 1440, 1493, 1547, 1600, 1653, 1707, 1760, 1813, 1867, 1920, 1973,
+    2027, 2080, 2133, 2187, 2240, 2293, 2347, 2400, 2457, 2514, 2571, 2629,
+    2686, 2743, 2800, 2857, 2914, 2971, 3029, 3086, 3143, 3200, 3262, 3323,
+    3385, 3446, 3508, 3569, 3631, 3692, 3754, 3815, 3877, 3938, 4000, 4062,
+    4123, 4185, 4246, 4308, 4369, 4431, 4492, 4554, 4615, 4677, 4738, 4800
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(147)
+  // At most 0.02 degC from temptable_147
+  const short indextable_147[] PROGMEM = {
+    -4200, -4000, -3800, -3600, -3400, -3200, -3000, -2800, -2600, -2400, -2200, -2000,
+    -1800, -1600, -1400, -1200, -1000, -800, -600, -400, -200, 0, 200, 400,
+    600, 800, 1000, 1200, 1400, 1600, 1800, 2000, 2200, 2400, 2667, 2933,
+    3200, 3400, 3600, 3800, 4000, 4200, 4400, 4600, 4800
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(998)
+  const short indextable_998[] PROGMEM = {
+    DUMMY_THERMISTOR_998_VALUE * INDEXTABLE_SCALE
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(999)
+  const short indextable_999[] PROGMEM = {
+    DUMMY_THERMISTOR_999_VALUE * INDEXTABLE_SCALE
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(1010)
+  // At most 0.03 degC from temptable_1010
+  const short indextable_1010[] PROGMEM = {
+    -8904, -8887, -8870, -8852, -8835, -8817, -8800, -8783, -8765, -8748, -8730, -8713,
+    -8696, -8678, -8661, -8643, -8626, -8609, -8591, -8574, -8557, -8539, -8522, -8504,
+    -8487, -8470, -8452, -8435, -8417, -8400, -8383, -8365, -8348, -8330, -8313, -8296,
+    -8278, -8261, -8243, -8226, -8209, -8191, -8174, -8157, -8139, -8122, -8104, -8087,
+    -8070, -8052, -8035, -8017, -8000, -7983, -7965, -7948, -7930, -7913, -7896, -7878,
+    -7861, -7843, -7826, -7809, -7791, -7774, -7757, -7739, -7722, -7704, -7687, -7670,
+    -7652, -7635, -7617, -7600, -7583, -7565, -7548, -7530, -7513, -7496, -7478, -7461,
+    -7443, -7426, -7409, -7391, -7374, -7357, -7339, -7322, -7304, -7287, -7270, -7252,
+    -7235, -7217, -7200, -7183, -7165, -7148, -7130, -7113, -7096, -7078, -7061, -7043,
+    -7026, -7009, -6991, -6974, -6957, -6939, -6922, -6904, -6887, -6870, -6852, -6835,
+    -6817, -6800, -6783, -6765, -6748, -6730, -6713, -6696, -6678, -6661, -6643, -6626,
+    -6609, -6591, -6574, -6557, -6539, -6522, -6504, -6487, -6470, -6452, -6435, -6417,
+    -6400, -6383, -6365, -6348, -6330, -6313, -6296, -6278, -6261, -6243, -6226, -6209,
+    -6191, -6174, -6157, -6139, -6122, -6104, -6087, -6070, -6052, -6035, -6017, -6000,
+    -5983, -5965, -5948, -5930, -5913, -5896, -5878, -5861, -5843, -5826, -5809, -5791,
+    -5774, -5757, -5739, -5722, -5704, -5687, -5670, -5652, -5635, -5617, -5600, -5583,
+    -5565, -5548, -5530, -5513, -5496, -5478, -5461, -5443, -5426, -5409, -5391, -5374,
+    -5357, -5339, -5322, -5304, -5287, -5270, -5252, -5235, -5217, -5200, -5183, -5165,
+    -5148, -5130, -5113, -5096, -5078, -5061, -5043, -5026, -5009, -4991, -4974, -4957,
+    -4939, -4922, -4904, -4887, -4870, -4852, -4835, -4817, -4800, -4783, -4765, -4748,
+    -4730, -4713, -4696, -4678, -4661, -4643, -4626, -4609, -4591, -4574, -4557, -4539,
+    -4522, -4504, -4487, -4470, -4452, -4435, -4417, -4400, -4383, -4365, -4348, -4330,
+    -4313, -4296, -4278, -4261, -4243, -4226, -4209, -4191, -4174, -4157, -4139, -4122,
+    -4104, -4087, -4070, -4052, -4035, -4017, -4000, -3983, -3965, -3948, -3930, -3913,
+    -3896, -3878, -3861, -3843, -3826, -3809, -3791, -3774, -3757, -3739, -3722, -3704,
+    -3687, -3670, -3652, -3635, -3617, -3600, -3583, -3565, -3548, -3530, -3513, -3496,
+    -3478, -3461, -3443, -3426, -3409, -3391, -3374, -3357, -3339, -3322, -3304, -3287,
+    -3270, -3252, -3235, -3217, -3200, -3183, -3165, -3148, -3130, -3113, -3096, -3078,
+    -3061, -3043, -3026, -3009, -2991, -2974, -2957, -2939, -2922, -2904, -2887, -2870,
+    -2852, -2835, -2817, -2800, -2783, -2765, -2748, -2730, -2713, -2696, -2678, -2661,
+    -2643, -2626, -2609, -2591, -2574, -2557, -2539, -2522, -2504, -2487, -2470, -2452,
+    -2435, -2417, -2400, -2383, -2365, -2348, -2330, -2313, -2296, -2278, -2261, -2243,
+    -2226, -2209, -2191, -2174, -2157, -2139, -2122, -2104, -2087, -2070, -2052, -2035,
+    -2017, -2000, -1983, -1965, -1948, -1930, -1913, -1896, -1878, -1861, -1843, -1826,
+    -1809, -1791, -1774, -1757, -1739, -1722, -1704, -1687, -1670, -1652, -1635, -1617,
+    -1600, -1583, -1565, -1548, -1530, -1513, -1496, -1478, -1461, -1443, -1426, -1409,
+    -1391, -1374, -1357, -1339, -1322, -1304, -1287, -1270, -1252, -1235, -1217, -1200,
+    -1183, -1165, -1148, -1130, -1113, -1096, -1078, -1061, -1043, -1026, -1009, -991,
+    -974, -957, -939, -922, -904, -887, -870, -852, -835, -817, -800, -783,
+    -765, -748, -730, -713, -696, -678, -661, -643, -626, -609, -591, -574,
+    -557, -539, -522, -504, -487, -470, -452, -435, -417, -400, -383, -365,
+    -348, -330, -313, -296, -278, -261, -243, -226, -209, -191, -174, -157,
+    -139, -122, -104, -87, -70, -52, -35, -17, 0, 17, 35, 52,
+    70, 87, 104, 122, 139, 157, 174, 191, 209, 226, 243, 261,
+    278, 296, 313, 330, 348, 365, 383, 400, 418, 436, 455, 473,
+    491, 509, 527, 545, 564, 582, 600, 618, 636, 655, 673, 691,
+    709, 727, 745, 764, 782, 800, 821, 842, 863, 884, 905, 926,
+    947, 968, 989, 1011, 1032, 1053, 1074, 1095, 1116, 1137, 1158, 1179,
+    1200, 1222, 1244, 1267, 1289, 1311, 1333, 1356, 1378, 1400, 1422, 1444,
+    1467, 1489, 1511, 1533, 1556, 1578, 1600, 1624, 1647, 1671, 1694, 1718,
+    1741, 1765, 1788, 1812, 1835, 1859, 1882, 1906, 1929, 1953, 1976, 2000,
+    2027, 2053, 2080, 2107, 2133, 2160, 2187, 2213, 2240, 2267, 2293, 2320,
+    2347, 2373, 2400, 2431, 2462, 2492, 2523, 2554, 2585, 2615, 2646, 2677,
+    2708, 2738, 2769, 2800, 2831, 2862, 2892, 2923, 2954, 2985, 3015, 3046,
+    3077, 3108, 3138, 3169, 3200, 3233, 3267, 3300, 3333, 3367, 3400, 3433,
+    3467, 3500, 3533, 3567, 3600, 3636, 3673, 3709, 3745, 3782, 3818, 3855,
+    3891, 3927, 3964, 4000, 4036, 4073, 4109, 4145, 4182, 4218, 4255, 4291,
+    4327, 4364, 4400, 4444, 4489, 4533, 4578, 4622, 4667, 4711, 4756, 4800
+  };
+#endif
+
+#if ANY_THERMISTOR_IS(1047)
+  // At most 0.03 degC from temptable_1047
+  const short indextable_1047[] PROGMEM = {
+    -5114, -5086, -5057, -5029, -5000, -4971, -4943, -4914, -4886, -4857, -4829, -4800,
+    -4771, -4743, -4714, -4686, -4657, -4629, -4600, -4571, -4543, -4514, -4486, -4457,
+    -4429, -4400, -4371, -4343, -4314, -4286, -4257, -4229, -4200, -4171, -4143, -4114,
+    -4086, -4057, -4029, -4000, -3971, -3943, -3914, -3886, -3857, -3829, -3800, -3771,
+    -3743, -3714, -3686, -3657, -3629, -3600, -3571, -3543, -3514, -3486, -3457, -3429,
+    -3400, -3371, -3343, -3314, -3286, -3257, -3229, -3200, -3171, -3143, -3114, -3086,
+    -3057, -3029, -3000, -2971, -2943, -2914, -2886, -2857, -2829, -2800, -2771, -2743,
+    -2714, -2686, -2657, -2629, -2600, -2571, -2543, -2514, -2486, -2457, -2429, -2400,
+    -2371, -2343, -2314, -2286, -2257, -2229, -2200, -2171, -2143, -2114, -2086, -2057,
+    -2029, -2000, -1971, -1943, -1914, -1886, -1857, -1829, -1800, -1771, -1743, -1714,
+    -1686, -1657, -1629, -1600, -1571, -1543, -1514, -1486, -1457, -1429, -1400, -1371,
+    -1343, -1314, -1286, -1257, -1229, -1200, -1171, -1143, -1114, -1086, -1057, -1029,
+    -1000, -971, -943, -914, -886, -857, -829, -800, -771, -743, -714, -686,
+    -657, -629, -600, -571, -543, -514, -486, -457, -429, -400, -371, -343,
+    -314, -286, -257, -229, -200, -171, -143, -114, -86, -57, -29, 0,
+    29, 57, 86, 114, 143, 171, 200, 229, 257, 286, 314, 343,
+    371, 400, 429, 457, 486, 514, 543, 571, 600, 629, 657, 686,
+    714, 743, 771, 800, 831, 862, 892, 923, 954, 985, 1015, 1046,
+    1077, 1108, 1138, 1169, 1200, 1231, 1262, 1292, 1323, 1354, 1385, 1415,
+    1446, 1477, 1508, 1538, 1569, 1600, 1635, 1670, 1704, 1739, 1774, 1809,
+    1843, 1878, 1913, 1948, 1983, 2017, 2052, 2087, 2122, 2157, 2191, 2226,
+    2261, 2296, 2330, 2365, 2400, 2436, 2473, 2509, 2545, 2582, 2618, 2655,
+    2691, 2727, 2764, 2800, 2836, 2873, 2909, 2945, 2982, 3018, 3055, 3091,
+    3127, 3164, 3200, 3238, 3276, 3314, 3352, 3390, 3429, 3467, 3505, 3543,
+    3581, 3619, 3657, 3695, 3733, 3771, 3810, 3848, 3886, 3924, 3962, 4000,
+    4042, 4084, 4126, 4168, 4211, 4253, 4295, 4337, 4379, 4421, 4463, 4505,
+    4547, 4589, 4632, 4674, 4716, 4758, 4800
+  };
+#endif
+
+#endif // THERMISTORTABLES_INDEX_H_
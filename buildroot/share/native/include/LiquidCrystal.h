@@ -0,0 +1,52 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * LiquidCrystal.h for the native (host) build
+ *
+ * A character LCD that accepts everything and shows nothing.
+ */
+
+#ifndef _NATIVE_LIQUIDCRYSTAL_H
+#define _NATIVE_LIQUIDCRYSTAL_H
+
+#include "Print.h"
+
+class LiquidCrystal : public Print {
+  public:
+    LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+    LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+    LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+    LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+    void begin(uint8_t, uint8_t, uint8_t = 0) {}
+    void clear() {}
+    void home() {}
+    void noDisplay() {}
+    void display() {}
+    void noBlink() {}
+    void blink() {}
+    void noCursor() {}
+    void cursor() {}
+    void createChar(uint8_t, uint8_t[]) {}
+    void setCursor(uint8_t, uint8_t) {}
+    virtual size_t write(uint8_t) { return 1; }
+    using Print::write;
+};
+
+#endif // _NATIVE_LIQUIDCRYSTAL_H
@@ -0,0 +1,101 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Print.h for the native (host) build
+ *
+ * Formatting follows the Arduino core so output matches the board.
+ */
+
+#ifndef _NATIVE_PRINT_H
+#define _NATIVE_PRINT_H
+
+#include "Arduino.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+      size_t n = 0;
+      while (size--) n += write(*buffer++);
+      return n;
+    }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+    size_t print(const __FlashStringHelper *s) { return write((const char *)s); }
+    size_t print(const char s[]) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC) {
+      if (base == 0) return write((uint8_t)n);
+      if (base == 10 && n < 0) return print('-') + printNumber(-(unsigned long)n, 10);
+      return printNumber(n, base);
+    }
+    size_t print(unsigned long n, int base = DEC) { return base ? printNumber(n, base) : write((uint8_t)n); }
+    size_t print(double n, int digits = 2) { return printFloat(n, digits); }
+
+    size_t println() { return write("\r\n"); }
+    template<typename T> size_t println(T v) { return print(v) + println(); }
+    template<typename T> size_t println(T v, int f) { return print(v, f) + println(); }
+
+  private:
+    size_t printNumber(unsigned long n, uint8_t base) {
+      char buf[8 * sizeof(long) + 1], *str = &buf[sizeof(buf) - 1];
+      *str = '\0';
+      if (base < 2) base = 10;
+      do {
+        const char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+      } while (n);
+      return write(str);
+    }
+    size_t printFloat(double number, uint8_t digits) {
+      if (isnan(number)) return print("nan");
+      if (isinf(number)) return print("inf");
+      if (number > 4294967040.0 || number < -4294967040.0) return print("ovf");
+      size_t n = 0;
+      if (number < 0.0) { n += print('-'); number = -number; }
+      double rounding = 0.5;
+      for (uint8_t i = 0; i < digits; ++i) rounding /= 10.0;
+      number += rounding;
+      unsigned long int_part = (unsigned long)number;
+      double remainder = number - (double)int_part;
+      n += print(int_part);
+      if (digits > 0) n += print('.');
+      while (digits-- > 0) {
+        remainder *= 10.0;
+        const unsigned int toPrint = (unsigned int)remainder;
+        n += print(toPrint);
+        remainder -= toPrint;
+      }
+      return n;
+    }
+};
+
+#endif // _NATIVE_PRINT_H
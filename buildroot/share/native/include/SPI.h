@@ -0,0 +1,38 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * SPI.h for the native (host) build
+ */
+
+#ifndef _NATIVE_SPI_H
+#define _NATIVE_SPI_H
+
+#include "Arduino.h"
+
+class SPIClass {
+  public:
+    static void begin() {}
+    static void end() {}
+    static uint8_t transfer(uint8_t data) { SPDR = data; return SPDR; }
+};
+
+extern SPIClass SPI;
+
+#endif // _NATIVE_SPI_H
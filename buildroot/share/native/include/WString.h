@@ -0,0 +1,45 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * WString.h for the native (host) build
+ *
+ * Just enough of the Arduino String for the MarlinSerial print overloads.
+ */
+
+#ifndef _NATIVE_WSTRING_H
+#define _NATIVE_WSTRING_H
+
+#include <stdlib.h>
+#include <string.h>
+
+class String {
+  public:
+    String(const char *s = "") : buf(strdup(s ? s : "")) {}
+    String(const String &s) : buf(strdup(s.buf)) {}
+    ~String() { free(buf); }
+    String& operator=(const String &s) { if (this != &s) { free(buf); buf = strdup(s.buf); } return *this; }
+    unsigned int length() const { return strlen(buf); }
+    char operator[](unsigned int i) const { return buf[i]; }
+    const char* c_str() const { return buf; }
+  private:
+    char *buf;
+};
+
+#endif // _NATIVE_WSTRING_H
@@ -0,0 +1,53 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * avr/eeprom.h for the native (host) build
+ *
+ * The 4K EEPROM is an array, loaded from and saved back to the file given
+ * with the --eeprom option of the simulator. Writes complete immediately.
+ */
+
+#ifndef _NATIVE_AVR_EEPROM_H
+#define _NATIVE_AVR_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "io.h"
+
+extern uint8_t native_eeprom[E2END + 1];
+
+#define eeprom_is_ready() true
+#define eeprom_busy_wait() do{}while(0)
+
+inline uint8_t eeprom_read_byte(const uint8_t *p) { return native_eeprom[(size_t)p & E2END]; }
+inline void eeprom_write_byte(uint8_t *p, const uint8_t v) { native_eeprom[(size_t)p & E2END] = v; }
+inline void eeprom_update_byte(uint8_t *p, const uint8_t v) { if (eeprom_read_byte(p) != v) eeprom_write_byte(p, v); }
+
+inline void eeprom_read_block(void *dst, const void *src, size_t n) {
+  for (size_t i = 0; i < n; i++) ((uint8_t*)dst)[i] = eeprom_read_byte((const uint8_t*)src + i);
+}
+inline void eeprom_write_block(const void *src, void *dst, size_t n) {
+  for (size_t i = 0; i < n; i++) eeprom_write_byte((uint8_t*)dst + i, ((const uint8_t*)src)[i]);
+}
+inline void eeprom_update_block(const void *src, void *dst, size_t n) {
+  for (size_t i = 0; i < n; i++) eeprom_update_byte((uint8_t*)dst + i, ((const uint8_t*)src)[i]);
+}
+
+#endif // _NATIVE_AVR_EEPROM_H
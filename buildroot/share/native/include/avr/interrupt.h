@@ -0,0 +1,43 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * avr/interrupt.h for the native (host) build
+ *
+ * ISR() and SIGNAL() define plain functions named after the vector, which
+ * native_dispatch() calls when the matching interrupt is due. cli() and sei()
+ * work on the I bit of the simulated SREG.
+ */
+
+#ifndef _NATIVE_AVR_INTERRUPT_H
+#define _NATIVE_AVR_INTERRUPT_H
+
+#include "io.h"
+
+#define ISR(vector, ...) extern "C" void vector(void); extern "C" void vector(void)
+#define SIGNAL(vector) ISR(vector)
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+
+#define cli() (SREG &= ~_BV(SREG_I))
+#define sei() do{ SREG |= _BV(SREG_I); native_dispatch(); }while(0)
+
+#endif // _NATIVE_AVR_INTERRUPT_H
@@ -0,0 +1,628 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * avr/io.h for the native (host) build
+ *
+ * The ATmega2560 I/O registers the firmware touches, as plain memory.
+ * fastio.h, the timer setup and the ISRs compile unchanged against these.
+ *
+ * The few registers whose value depends on elapsed time or on a peripheral
+ * (TCNT0, TCNT1, ADC, SPDR and the UDRn data registers) are small proxy
+ * objects that call into the simulator in native_sim.h.
+ */
+
+#ifndef _NATIVE_AVR_IO_H
+#define _NATIVE_AVR_IO_H
+
+#include <stdint.h>
+#include "../native_sim.h"
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+
+// Status register
+extern volatile uint8_t SREG;
+#define SREG_I 7
+
+// General purpose I/O ports. PINx is refreshed from PORTx, DDRx and the
+// simulated inputs whenever the virtual clock advances.
+extern volatile uint8_t PORTA, DDRA, PINA;
+extern volatile uint8_t PORTB, DDRB, PINB;
+extern volatile uint8_t PORTC, DDRC, PINC;
+extern volatile uint8_t PORTD, DDRD, PIND;
+extern volatile uint8_t PORTE, DDRE, PINE;
+extern volatile uint8_t PORTF, DDRF, PINF;
+extern volatile uint8_t PORTG, DDRG, PING;
+extern volatile uint8_t PORTH, DDRH, PINH;
+extern volatile uint8_t PORTJ, DDRJ, PINJ;
+extern volatile uint8_t PORTK, DDRK, PINK;
+extern volatile uint8_t PORTL, DDRL, PINL;
+
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PINA0 0
+#define PINA1 1
+#define PINA2 2
+#define PINA3 3
+#define PINA4 4
+#define PINA5 5
+#define PINA6 6
+#define PINA7 7
+#define DDA0 0 #define DDA1 1 #define DDA2 2 #define DDA3 3 #define DDA4 4 #define DDA5 5 #define DDA6 6 #define DDA7 7
+#define PORTA0 0
+#define PORTA1 1
+#define PORTA2 2
+#define PORTA3 3
+#define PORTA4 4
+#define PORTA5 5
+#define PORTA6 6
+#define PORTA7 7
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PINB0 0
+#define PINB1 1
+#define PINB2 2
+#define PINB3 3
+#define PINB4 4
+#define PINB5 5
+#define PINB6 6
+#define PINB7 7
+#define DDB0 0 #define DDB1 1 #define DDB2 2 #define DDB3 3 #define DDB4 4 #define DDB5 5 #define DDB6 6 #define DDB7 7
+#define PORTB0 0
+#define PORTB1 1
+#define PORTB2 2
+#define PORTB3 3
+#define PORTB4 4
+#define PORTB5 5
+#define PORTB6 6
+#define PORTB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PC7 7
+#define PINC0 0
+#define PINC1 1
+#define PINC2 2
+#define PINC3 3
+#define PINC4 4
+#define PINC5 5
+#define PINC6 6
+#define PINC7 7
+#define DDC0 0 #define DDC1 1 #define DDC2 2 #define DDC3 3 #define DDC4 4 #define DDC5 5 #define DDC6 6 #define DDC7 7
+#define PORTC0 0
+#define PORTC1 1
+#define PORTC2 2
+#define PORTC3 3
+#define PORTC4 4
+#define PORTC5 5
+#define PORTC6 6
+#define PORTC7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+#define PIND0 0
+#define PIND1 1
+#define PIND2 2
+#define PIND3 3
+#define PIND4 4
+#define PIND5 5
+#define PIND6 6
+#define PIND7 7
+#define DDD0 0 #define DDD1 1 #define DDD2 2 #define DDD3 3 #define DDD4 4 #define DDD5 5 #define DDD6 6 #define DDD7 7
+#define PORTD0 0
+#define PORTD1 1
+#define PORTD2 2
+#define PORTD3 3
+#define PORTD4 4
+#define PORTD5 5
+#define PORTD6 6
+#define PORTD7 7
+#define PE0 0
+#define PE1 1
+#define PE2 2
+#define PE3 3
+#define PE4 4
+#define PE5 5
+#define PE6 6
+#define PE7 7
+#define PINE0 0
+#define PINE1 1
+#define PINE2 2
+#define PINE3 3
+#define PINE4 4
+#define PINE5 5
+#define PINE6 6
+#define PINE7 7
+#define DDE0 0 #define DDE1 1 #define DDE2 2 #define DDE3 3 #define DDE4 4 #define DDE5 5 #define DDE6 6 #define DDE7 7
+#define PORTE0 0
+#define PORTE1 1
+#define PORTE2 2
+#define PORTE3 3
+#define PORTE4 4
+#define PORTE5 5
+#define PORTE6 6
+#define PORTE7 7
+#define PF0 0
+#define PF1 1
+#define PF2 2
+#define PF3 3
+#define PF4 4
+#define PF5 5
+#define PF6 6
+#define PF7 7
+#define PINF0 0
+#define PINF1 1
+#define PINF2 2
+#define PINF3 3
+#define PINF4 4
+#define PINF5 5
+#define PINF6 6
+#define PINF7 7
+#define DDF0 0 #define DDF1 1 #define DDF2 2 #define DDF3 3 #define DDF4 4 #define DDF5 5 #define DDF6 6 #define DDF7 7
+#define PORTF0 0
+#define PORTF1 1
+#define PORTF2 2
+#define PORTF3 3
+#define PORTF4 4
+#define PORTF5 5
+#define PORTF6 6
+#define PORTF7 7
+#define PG0 0
+#define PG1 1
+#define PG2 2
+#define PG3 3
+#define PG4 4
+#define PG5 5
+#define PG6 6
+#define PG7 7
+#define PING0 0
+#define PING1 1
+#define PING2 2
+#define PING3 3
+#define PING4 4
+#define PING5 5
+#define PING6 6
+#define PING7 7
+#define DDG0 0 #define DDG1 1 #define DDG2 2 #define DDG3 3 #define DDG4 4 #define DDG5 5 #define DDG6 6 #define DDG7 7
+#define PORTG0 0
+#define PORTG1 1
+#define PORTG2 2
+#define PORTG3 3
+#define PORTG4 4
+#define PORTG5 5
+#define PORTG6 6
+#define PORTG7 7
+#define PH0 0
+#define PH1 1
+#define PH2 2
+#define PH3 3
+#define PH4 4
+#define PH5 5
+#define PH6 6
+#define PH7 7
+#define PINH0 0
+#define PINH1 1
+#define PINH2 2
+#define PINH3 3
+#define PINH4 4
+#define PINH5 5
+#define PINH6 6
+#define PINH7 7
+#define DDH0 0 #define DDH1 1 #define DDH2 2 #define DDH3 3 #define DDH4 4 #define DDH5 5 #define DDH6 6 #define DDH7 7
+#define PORTH0 0
+#define PORTH1 1
+#define PORTH2 2
+#define PORTH3 3
+#define PORTH4 4
+#define PORTH5 5
+#define PORTH6 6
+#define PORTH7 7
+#define PJ0 0
+#define PJ1 1
+#define PJ2 2
+#define PJ3 3
+#define PJ4 4
+#define PJ5 5
+#define PJ6 6
+#define PJ7 7
+#define PINJ0 0
+#define PINJ1 1
+#define PINJ2 2
+#define PINJ3 3
+#define PINJ4 4
+#define PINJ5 5
+#define PINJ6 6
+#define PINJ7 7
+#define DDJ0 0 #define DDJ1 1 #define DDJ2 2 #define DDJ3 3 #define DDJ4 4 #define DDJ5 5 #define DDJ6 6 #define DDJ7 7
+#define PORTJ0 0
+#define PORTJ1 1
+#define PORTJ2 2
+#define PORTJ3 3
+#define PORTJ4 4
+#define PORTJ5 5
+#define PORTJ6 6
+#define PORTJ7 7
+#define PK0 0
+#define PK1 1
+#define PK2 2
+#define PK3 3
+#define PK4 4
+#define PK5 5
+#define PK6 6
+#define PK7 7
+#define PINK0 0
+#define PINK1 1
+#define PINK2 2
+#define PINK3 3
+#define PINK4 4
+#define PINK5 5
+#define PINK6 6
+#define PINK7 7
+#define DDK0 0 #define DDK1 1 #define DDK2 2 #define DDK3 3 #define DDK4 4 #define DDK5 5 #define DDK6 6 #define DDK7 7
+#define PORTK0 0
+#define PORTK1 1
+#define PORTK2 2
+#define PORTK3 3
+#define PORTK4 4
+#define PORTK5 5
+#define PORTK6 6
+#define PORTK7 7
+#define PL0 0
+#define PL1 1
+#define PL2 2
+#define PL3 3
+#define PL4 4
+#define PL5 5
+#define PL6 6
+#define PL7 7
+#define PINL0 0
+#define PINL1 1
+#define PINL2 2
+#define PINL3 3
+#define PINL4 4
+#define PINL5 5
+#define PINL6 6
+#define PINL7 7
+#define DDL0 0 #define DDL1 1 #define DDL2 2 #define DDL3 3 #define DDL4 4 #define DDL5 5 #define DDL6 6 #define DDL7 7
+#define PORTL0 0
+#define PORTL1 1
+#define PORTL2 2
+#define PORTL3 3
+#define PORTL4 4
+#define PORTL5 5
+#define PORTL6 6
+#define PORTL7 7
+
+// 8-bit timers 0 and 2. TCNT0 follows the virtual clock at clk/64.
+extern volatile uint8_t TCCR0A, TCCR0B, TIMSK0, TIFR0, OCR0A, OCR0B;
+extern volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TIFR2, OCR2A, OCR2B, TCNT2, ASSR;
+#define TCNT0 native_tcnt0
+
+// 16-bit timers 1, 3, 4 and 5. TCNT1 follows the virtual clock at clk/8.
+extern volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+extern volatile uint16_t OCR1A, OCR1B, OCR1C, ICR1;
+#define TCNT1 native_tcnt1
+extern volatile uint8_t TCCR3A, TCCR3B, TCCR3C, TIMSK3, TIFR3;
+extern volatile uint16_t OCR3A, OCR3B, OCR3C, ICR3, TCNT3;
+extern volatile uint8_t TCCR4A, TCCR4B, TCCR4C, TIMSK4, TIFR4;
+extern volatile uint16_t OCR4A, OCR4B, OCR4C, ICR4, TCNT4;
+extern volatile uint8_t TCCR5A, TCCR5B, TCCR5C, TIMSK5, TIFR5;
+extern volatile uint16_t OCR5A, OCR5B, OCR5C, ICR5, TCNT5;
+
+// Low bytes of the compare registers, for the fastio PWM table
+#define OCR1AL (*(volatile uint8_t*)&OCR1A)
+#define OCR1BL (*(volatile uint8_t*)&OCR1B)
+#define OCR1CL (*(volatile uint8_t*)&OCR1C)
+#define OCR3AL (*(volatile uint8_t*)&OCR3A)
+#define OCR3BL (*(volatile uint8_t*)&OCR3B)
+#define OCR3CL (*(volatile uint8_t*)&OCR3C)
+#define OCR4AL (*(volatile uint8_t*)&OCR4A)
+#define OCR4BL (*(volatile uint8_t*)&OCR4B)
+#define OCR4CL (*(volatile uint8_t*)&OCR4C)
+#define OCR5AL (*(volatile uint8_t*)&OCR5A)
+#define OCR5BL (*(volatile uint8_t*)&OCR5B)
+#define OCR5CL (*(volatile uint8_t*)&OCR5C)
+
+#define TOIE0  0
+#define OCIE0A 1
+#define OCIE0B 2
+#define TOIE1  0
+#define OCIE1A 1
+#define OCIE1B 2
+#define OCIE1C 3
+#define TOIE2  0
+#define OCIE2A 1
+#define OCIE2B 2
+#define WGM00 0
+#define WGM01 1
+#define WGM02 3
+#define WGM10 0
+#define WGM11 1
+#define WGM12 3
+#define WGM13 4
+#define WGM20 0
+#define WGM21 1
+#define WGM22 3
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define COM0A0 6
+#define COM0A1 7
+#define COM0B0 4
+#define COM0B1 5
+#define COM1A0 6
+#define COM1A1 7
+#define COM1B0 4
+#define COM1B1 5
+#define COM1C0 2
+#define COM1C1 3
+#define COM2A0 6
+#define COM2A1 7
+#define COM2B0 4
+#define COM2B1 5
+
+// ADC. Reading ADC returns the simulated conversion of the selected channel.
+extern volatile uint8_t ADCSRA, ADCSRB, ADMUX, DIDR0, DIDR2;
+#define ADC native_adc
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE  3
+#define ADIF  4
+#define ADATE 5
+#define ADSC  6
+#define ADEN  7
+#define MUX5  3
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+
+// SPI. SPDR exchanges a byte with the simulated SD card; SPIF is always set.
+extern volatile uint8_t SPCR, SPSR;
+#define SPDR native_spdr
+#define SPR0  0
+#define SPR1  1
+#define CPHA  2
+#define CPOL  3
+#define MSTR  4
+#define DORD  5
+#define SPE   6
+#define SPIE  7
+#define SPI2X 0
+#define WCOL  6
+#define SPIF  7
+
+// USART 0-3. Writing UDRn sends to the host side of the port, reading it
+// returns the byte the simulator has just delivered.
+#define _NATIVE_USART(N) \
+  extern volatile uint8_t UCSR##N##B, UCSR##N##C, UBRR##N##H, UBRR##N##L; \
+  extern native_ucsra_t UCSR##N##A; \
+  extern native_udr_t UDR##N
+_NATIVE_USART(0);
+_NATIVE_USART(1);
+_NATIVE_USART(2);
+_NATIVE_USART(3);
+#undef _NATIVE_USART
+#define _NATIVE_USART_BITS(N) \
+  enum { MPCM##N = 0, U2X##N = 1, UPE##N = 2, DOR##N = 3, FE##N = 4, UDRE##N = 5, TXC##N = 6, RXC##N = 7, \
+         TXB8##N = 0, RXB8##N = 1, UCSZ##N##2 = 2, TXEN##N = 3, RXEN##N = 4, UDRIE##N = 5, TXCIE##N = 6, RXCIE##N = 7, \
+         UCSZ##N##0 = 1, UCSZ##N##1 = 2 }
+_NATIVE_USART_BITS(0);
+_NATIVE_USART_BITS(1);
+_NATIVE_USART_BITS(2);
+_NATIVE_USART_BITS(3);
+#undef _NATIVE_USART_BITS
+
+// External and pin change interrupts
+extern volatile uint8_t EICRA, EICRB, EIMSK, EIFR, PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+
+// Reset and watchdog
+extern volatile uint8_t MCUSR, MCUCR, WDTCSR;
+#define PORF  0
+#define EXTRF 1
+#define BORF  2
+#define WDRF  3
+#define JTRF  4
+#define JTD   7
+
+// Registers are variables, so make them visible to #ifdef as well
+#define SREG SREG
+#define PORTA PORTA
+#define DDRA DDRA
+#define PINA PINA
+#define PORTB PORTB
+#define DDRB DDRB
+#define PINB PINB
+#define PORTC PORTC
+#define DDRC DDRC
+#define PINC PINC
+#define PORTD PORTD
+#define DDRD DDRD
+#define PIND PIND
+#define PORTE PORTE
+#define DDRE DDRE
+#define PINE PINE
+#define PORTF PORTF
+#define DDRF DDRF
+#define PINF PINF
+#define PORTG PORTG
+#define DDRG DDRG
+#define PING PING
+#define PORTH PORTH
+#define DDRH DDRH
+#define PINH PINH
+#define PORTJ PORTJ
+#define DDRJ DDRJ
+#define PINJ PINJ
+#define PORTK PORTK
+#define DDRK DDRK
+#define PINK PINK
+#define PORTL PORTL
+#define DDRL DDRL
+#define PINL PINL
+#define TCCR0A TCCR0A
+#define TCCR0B TCCR0B
+#define TIMSK0 TIMSK0
+#define TIFR0 TIFR0
+#define OCR0A OCR0A
+#define OCR0B OCR0B
+#define TCCR2A TCCR2A
+#define TCCR2B TCCR2B
+#define TIMSK2 TIMSK2
+#define TIFR2 TIFR2
+#define OCR2A OCR2A
+#define OCR2B OCR2B
+#define TCNT2 TCNT2
+#define ASSR ASSR
+#define TCCR1A TCCR1A
+#define TCCR1B TCCR1B
+#define TCCR1C TCCR1C
+#define TIMSK1 TIMSK1
+#define TIFR1 TIFR1
+#define OCR1A OCR1A
+#define OCR1B OCR1B
+#define OCR1C OCR1C
+#define ICR1 ICR1
+#define TCCR3A TCCR3A
+#define TCCR3B TCCR3B
+#define TCCR3C TCCR3C
+#define TIMSK3 TIMSK3
+#define TIFR3 TIFR3
+#define OCR3A OCR3A
+#define OCR3B OCR3B
+#define OCR3C OCR3C
+#define ICR3 ICR3
+#define TCNT3 TCNT3
+#define TCCR4A TCCR4A
+#define TCCR4B TCCR4B
+#define TCCR4C TCCR4C
+#define TIMSK4 TIMSK4
+#define TIFR4 TIFR4
+#define OCR4A OCR4A
+#define OCR4B OCR4B
+#define OCR4C OCR4C
+#define ICR4 ICR4
+#define TCNT4 TCNT4
+#define TCCR5A TCCR5A
+#define TCCR5B TCCR5B
+#define TCCR5C TCCR5C
+#define TIMSK5 TIMSK5
+#define TIFR5 TIFR5
+#define OCR5A OCR5A
+#define OCR5B OCR5B
+#define OCR5C OCR5C
+#define ICR5 ICR5
+#define TCNT5 TCNT5
+#define ADCSRA ADCSRA
+#define ADCSRB ADCSRB
+#define ADMUX ADMUX
+#define DIDR0 DIDR0
+#define DIDR2 DIDR2
+#define SPCR SPCR
+#define SPSR SPSR
+#define EICRA EICRA
+#define EICRB EICRB
+#define EIMSK EIMSK
+#define EIFR EIFR
+#define PCICR PCICR
+#define PCIFR PCIFR
+#define PCMSK0 PCMSK0
+#define PCMSK1 PCMSK1
+#define PCMSK2 PCMSK2
+#define MCUSR MCUSR
+#define MCUCR MCUCR
+#define WDTCSR WDTCSR
+#define UCSR0A UCSR0A
+#define UCSR0B UCSR0B
+#define UCSR0C UCSR0C
+#define UBRR0H UBRR0H
+#define UBRR0L UBRR0L
+#define UDR0 UDR0
+#define UCSR1A UCSR1A
+#define UCSR1B UCSR1B
+#define UCSR1C UCSR1C
+#define UBRR1H UBRR1H
+#define UBRR1L UBRR1L
+#define UDR1 UDR1
+#define UCSR2A UCSR2A
+#define UCSR2B UCSR2B
+#define UCSR2C UCSR2C
+#define UBRR2H UBRR2H
+#define UBRR2L UBRR2L
+#define UDR2 UDR2
+#define UCSR3A UCSR3A
+#define UCSR3B UCSR3B
+#define UCSR3C UCSR3C
+#define UBRR3H UBRR3H
+#define UBRR3L UBRR3L
+#define UDR3 UDR3
+
+// Interrupt vectors. ISR() turns each into an extern "C" function.
+#define TIMER0_COMPA_vect TIMER0_COMPA_vect
+#define TIMER0_COMPB_vect TIMER0_COMPB_vect
+#define TIMER0_OVF_vect   TIMER0_OVF_vect
+#define TIMER1_COMPA_vect TIMER1_COMPA_vect
+#define TIMER1_COMPB_vect TIMER1_COMPB_vect
+#define TIMER1_OVF_vect   TIMER1_OVF_vect
+#define TIMER3_COMPA_vect TIMER3_COMPA_vect
+#define TIMER4_COMPA_vect TIMER4_COMPA_vect
+#define TIMER5_COMPA_vect TIMER5_COMPA_vect
+#define USART0_RX_vect    USART0_RX_vect
+#define USART0_UDRE_vect  USART0_UDRE_vect
+#define USART1_RX_vect    USART1_RX_vect
+#define USART1_UDRE_vect  USART1_UDRE_vect
+#define USART2_RX_vect    USART2_RX_vect
+#define USART2_UDRE_vect  USART2_UDRE_vect
+#define USART3_RX_vect    USART3_RX_vect
+#define USART3_UDRE_vect  USART3_UDRE_vect
+#define WDT_vect          WDT_vect
+
+#define RAMEND 0x21FF
+#define E2END  0xFFF
+
+#endif // _NATIVE_AVR_IO_H
@@ -0,0 +1,72 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * avr/pgmspace.h for the native (host) build
+ *
+ * Program memory is ordinary memory on the host.
+ */
+
+#ifndef _NATIVE_AVR_PGMSPACE_H
+#define _NATIVE_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+
+typedef char prog_char;
+typedef uint8_t prog_uchar;
+
+// Tables are often read as another type than they were declared with, so
+// anything wider than a byte is copied out rather than dereferenced
+#define _PGM_READ(T, addr) ({ T _v; memcpy(&_v, (const void *)(addr), sizeof(T)); _v; })
+
+#define pgm_read_byte(addr)   (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)   _PGM_READ(uint16_t, addr)
+#define pgm_read_dword(addr)  _PGM_READ(uint32_t, addr)
+#define pgm_read_float(addr)  _PGM_READ(float, addr)
+#define pgm_read_ptr(addr)    _PGM_READ(void *, addr)
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word_near(addr) pgm_read_word(addr)
+#define pgm_read_dword_near(addr) pgm_read_dword(addr)
+#define pgm_read_float_near(addr) pgm_read_float(addr)
+#define pgm_read_byte_far(addr) pgm_read_byte(addr)
+#define pgm_read_word_far(addr) pgm_read_word(addr)
+
+#define strcpy_P(d, s)      strcpy((d), (s))
+#define strncpy_P(d, s, n)  strncpy((d), (s), (n))
+#define strcat_P(d, s)      strcat((d), (s))
+#define strncat_P(d, s, n)  strncat((d), (s), (n))
+#define strlen_P(s)         strlen(s)
+#define strcmp_P(a, b)      strcmp((a), (b))
+#define strncmp_P(a, b, n)  strncmp((a), (b), (n))
+#define strcasecmp_P(a, b)  strcasecmp((a), (b))
+#define strstr_P(a, b)      strstr((a), (b))
+#define strchr_P(s, c)      strchr((s), (c))
+#define memcpy_P(d, s, n)   memcpy((d), (s), (n))
+#define memcmp_P(a, b, n)   memcmp((a), (b), (n))
+#define sprintf_P           sprintf
+#define snprintf_P          snprintf
+#define vsnprintf_P         vsnprintf
+
+#endif // _NATIVE_AVR_PGMSPACE_H
@@ -0,0 +1,52 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * avr/wdt.h for the native (host) build
+ *
+ * The watchdog never bites. Instead, a long run of wdt_reset() calls with
+ * the virtual clock standing still (the loop at the end of kill()) ends
+ * the simulation.
+ */
+
+#ifndef _NATIVE_AVR_WDT_H
+#define _NATIVE_AVR_WDT_H
+
+#include "io.h"
+
+#define WDTO_15MS  0
+#define WDTO_30MS  1
+#define WDTO_60MS  2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S    6
+#define WDTO_2S    7
+#define WDTO_4S    8
+#define WDTO_8S    9
+
+#define WDCE 4
+#define WDE  3
+#define WDIE 6
+
+#define wdt_enable(t) do{}while(0)
+#define wdt_disable() do{}while(0)
+#define wdt_reset()   native_wdt_reset()
+
+#endif // _NATIVE_AVR_WDT_H
@@ -0,0 +1,118 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * native_sim.h - Simulated ATmega2560 for the native (host) build
+ *
+ * Time is a virtual 16MHz cycle counter. It only moves forward when the
+ * firmware asks for the time (millis, micros, the delay functions, TCNT0 and
+ * TCNT1), so a print runs as fast as the host can execute it while every
+ * timer interrupt still fires in the right order relative to the main loop.
+ *
+ * Due interrupts are dispatched from native_advance() whenever the global
+ * interrupt flag is set and no handler is already running. Handlers never
+ * nest, even when they re-enable interrupts with sei().
+ */
+
+#ifndef _NATIVE_SIM_H
+#define _NATIVE_SIM_H
+
+#include <stdint.h>
+
+#define NATIVE_CYCLES_PER_US (F_CPU / 1000000UL)
+
+// Virtual clock, in CPU cycles since reset
+extern uint64_t native_cycles;
+
+// Per-call cost charged to the virtual clock by millis() and micros()
+extern uint32_t native_call_cycles;
+
+void native_advance(const uint32_t cycles);
+void native_dispatch();
+void native_wdt_reset();
+
+// Peripheral hooks behind the proxy registers
+uint8_t native_tcnt0_read();
+uint16_t native_tcnt1_read();
+void native_tcnt1_write(const uint16_t v);
+uint16_t native_adc_read();
+uint8_t native_spi_exchange(const uint8_t out);
+uint8_t native_spi_last();
+void native_uart_write(const uint8_t port, const uint8_t c);
+
+// Analog inputs, in 10-bit ADC counts, indexed by ADC channel (0-15).
+// The thermal model (or anything else) may set these at any time.
+extern uint16_t native_adc_value[16];
+
+// Digital inputs driven from outside, indexed by Arduino pin number.
+// A pin that is not overridden reads back its PORT (pull-up) bit.
+void native_pin_override(const uint8_t pin, const int8_t level);
+
+// Optional hook called every simulated millisecond, for plant models
+extern void (*native_tick_hook)();
+
+// Optional hook called with the text of every command committed to the queue
+extern void (*native_command_hook)(const char * const cmd);
+
+struct native_tcnt0_t {
+  operator uint8_t() const { return native_tcnt0_read(); }
+  native_tcnt0_t& operator=(const uint8_t) { return *this; }
+};
+
+struct native_tcnt1_t {
+  operator uint16_t() const { return native_tcnt1_read(); }
+  native_tcnt1_t& operator=(const uint16_t v) { native_tcnt1_write(v); return *this; }
+};
+
+struct native_adc_t {
+  operator uint16_t() const { return native_adc_read(); }
+};
+
+struct native_spdr_t {
+  operator uint8_t() const { return native_spi_last(); }
+  native_spdr_t& operator=(const uint8_t v) { native_spi_exchange(v); return *this; }
+};
+
+struct native_udr_t {
+  const uint8_t port;
+  volatile uint8_t rx;
+  operator uint8_t() const { return rx; }
+  native_udr_t& operator=(const uint8_t c) { native_uart_write(port, c); return *this; }
+  volatile uint8_t* operator&() { return &rx; } // for drivers that keep a pointer to UDRn
+};
+
+// USART control and status register A. The data register always reads as
+// empty. Bytes on the host port leave the moment they are written, and the
+// TFT port is only written from its UDRE interrupt, which the simulator
+// holds back for a byte time after each write.
+struct native_ucsra_t {
+  volatile uint8_t v;
+  operator uint8_t() const { return v | 0x20; } // UDREn
+  native_ucsra_t& operator=(const uint8_t x) { v = x; return *this; }
+  native_ucsra_t& operator|=(const uint8_t x) { v |= x; return *this; }
+  native_ucsra_t& operator&=(const uint8_t x) { v &= x; return *this; }
+  volatile uint8_t* operator&() { return &v; }
+};
+
+extern native_tcnt0_t native_tcnt0;
+extern native_tcnt1_t native_tcnt1;
+extern native_adc_t native_adc;
+extern native_spdr_t native_spdr;
+
+#endif // _NATIVE_SIM_H
@@ -0,0 +1,45 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * pins_arduino.h for the native (host) build - Arduino Mega 2560 variant
+ */
+
+#ifndef _NATIVE_PINS_ARDUINO_H
+#define _NATIVE_PINS_ARDUINO_H
+
+#include <stdint.h>
+
+#define NUM_DIGITAL_PINS 70
+#define NUM_ANALOG_INPUTS 16
+#define analogInputToDigitalPin(p) ((p < 16) ? (p) + 54 : -1)
+
+enum {
+  NOT_ON_TIMER = 0,
+  TIMER0A, TIMER0B,
+  TIMER1A, TIMER1B, TIMER1C,
+  TIMER2, TIMER2A, TIMER2B,
+  TIMER3A, TIMER3B, TIMER3C,
+  TIMER4A, TIMER4B, TIMER4C, TIMER4D,
+  TIMER5A, TIMER5B, TIMER5C
+};
+
+uint8_t digitalPinToTimer(const uint8_t pin);
+
+#endif // _NATIVE_PINS_ARDUINO_H
@@ -0,0 +1,36 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * util/atomic.h for the native (host) build
+ */
+
+#ifndef _NATIVE_UTIL_ATOMIC_H
+#define _NATIVE_UTIL_ATOMIC_H
+
+#include "../avr/interrupt.h"
+
+static inline uint8_t __native_cli() { const uint8_t s = SREG; cli(); return s; }
+static inline void __native_restore(const uint8_t *s) { SREG = *s; if (*s & _BV(SREG_I)) native_dispatch(); }
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for (uint8_t __s __attribute__((__cleanup__(__native_restore))) = __native_cli(), __t = 1; __t; __t = 0)
+
+#endif // _NATIVE_UTIL_ATOMIC_H
@@ -0,0 +1,34 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * util/delay.h for the native (host) build
+ *
+ * Busy waits advance the virtual clock instead of spinning.
+ */
+
+#ifndef _NATIVE_UTIL_DELAY_H
+#define _NATIVE_UTIL_DELAY_H
+
+#include "../native_sim.h"
+
+#define _delay_us(us) native_advance((uint32_t)((us) * NATIVE_CYCLES_PER_US))
+#define _delay_ms(ms) native_advance((uint32_t)((ms) * 1000UL * NATIVE_CYCLES_PER_US))
+
+#endif // _NATIVE_UTIL_DELAY_H
@@ -0,0 +1,40 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * wiring_private.h for the native (host) build
+ *
+ * On the AVR an interrupt whose enable bit is set while its flag is already
+ * up (UDRIE with an empty data register) runs right after the sbi. Drivers
+ * that wait on such an interrupt get the same treatment here.
+ */
+
+#ifndef _NATIVE_WIRING_PRIVATE_H
+#define _NATIVE_WIRING_PRIVATE_H
+
+#include "Arduino.h"
+
+#ifndef cbi
+  #define cbi(sfr, bit) (sfr &= ~_BV(bit))
+#endif
+#ifndef sbi
+  #define sbi(sfr, bit) do{ sfr |= _BV(bit); native_dispatch(); }while(0)
+#endif
+
+#endif // _NATIVE_WIRING_PRIVATE_H
@@ -0,0 +1,78 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * native_host.h - The world outside the simulated ATmega2560
+ *
+ * native_sim.cpp is the chip. These are the things wired to it: the host
+ * on USART0, the TFT on USART3, the SD card on SPI, the endstops, the
+ * heaters and their thermistors, and the harness that runs the firmware
+ * and decides when a job is finished.
+ */
+
+#ifndef _NATIVE_HOST_H
+#define _NATIVE_HOST_H
+
+#include <stdint.h>
+
+// USART link 0 is the host serial port, link 1 is the TFT port (USART3)
+bool native_host_rx_available(const uint8_t link);
+uint8_t native_host_rx_read(const uint8_t link);
+void native_host_tx(const uint8_t link, const uint8_t c);
+
+// Called once per simulated millisecond
+void native_host_tick();
+
+// Called before the clock moves on, to time what happened until now
+void native_host_clock();
+
+// Run the stepper ISR, keeping the simulated axes and endstops in step
+void native_host_stepper_isr(void (*isr)());
+
+// Run a handler as an interrupt (I flag clear, no nesting)
+void native_run_isr(void (*isr)());
+
+// Recompute every PINx register from the outputs and simulated inputs
+void native_refresh_pins();
+
+// The current level of one Arduino pin, as PINx would read it
+bool native_pin_level(const uint8_t pin);
+
+// SD card on the SPI bus
+bool native_sd_open(const char * const path);
+void native_sd_close();
+uint8_t native_host_spi(const uint8_t out);
+
+// Heaters and thermistors
+bool native_thermal_heater(const bool is_bed, const char * const spec);
+bool native_thermal_fan(const char * const spec);
+bool native_thermal_melt(const char * const spec);
+bool native_thermal_thermistor(const char * const spec);
+bool native_thermal_log(const char * const path);
+void native_thermal_start(const bool with_plant, const float celsius);
+void native_thermal_tick();
+void native_thermal_report();
+
+// --check-thermistors: every table's search against its index table
+bool native_check_thermistors();
+
+// End the simulation with a message
+void native_host_halt(const char * const msg);
+
+#endif // _NATIVE_HOST_H
@@ -0,0 +1,646 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * native_main.cpp - Run Marlin on the host
+ *
+ *   marlin [options] [file.gcode | -]
+ *
+ *   -s, --sd IMAGE      Insert a FAT-formatted SD card image
+ *   -p, --print FILE    Print FILE from the SD card (M23 / M24)
+ *   -e, --eeprom FILE   Load EEPROM contents from FILE and save them on exit
+ *   -t, --temp C        Temperature every thermistor reads (default 25)
+ *   -o, --output FILE   Write the serial output to FILE instead of stdout
+ *   -q, --quiet         Discard the serial output
+ *       --tft FILE      Write what the firmware sends to the TFT to FILE
+ *       --tft-in FILE   Send the lines of FILE to the firmware as the TFT
+ *       --timeout SEC   Give up after SEC seconds of simulated time
+ *       --histogram     Report how far apart the steps of each axis came
+ *       --trace FILE    Record every step and DIR change to FILE (see below)
+ *       --blocks FILE   Record the trapezoid of every block to FILE (see below)
+ *       --parse-floats FILE  Parse the G-code lines of FILE with the firmware's
+ *                       parser and check every value against strtof()
+ *       --check-thermistors  Read every thermistor table with the table search
+ *                       and the index tables and compare them (see
+ *                       native_thermistors.cpp)
+ *       --commands FILE Record every command queued, as text, to FILE
+ *       --sd-read       Only read the -p file into the command queue (see below)
+ *
+ *       --plant         Heat hotend 0 and the bed, with the defaults below
+ *       --hotend W,C,K,L  Hotend heater power (W), heat capacity (J/K), loss
+ *                       to ambient (W/K) and dead time (s). Default 40,12,0.12,1.5
+ *       --bed W,C,K,L   The same for the bed. Default 200,500,1.6,4
+ *       --fan K         Extra hotend loss with the part fan at full (W/K, 0.05)
+ *       --melt J        Heat it takes to melt a mm³ of filament (J, 0.4)
+ *       --thermistor R25,BETA,PULLUP  Give the plant this thermistor instead
+ *                       of the one the firmware is configured for
+ *       --thermal-log FILE  Write temperatures, targets, heater duty and fan
+ *                       duty to FILE every 100ms
+ *
+ * G-code given on the command line is sent over the serial port the way a
+ * simple host does it, one line at a time, waiting for each "ok". The run
+ * ends once the input is used up, the SD print (if any) is done and the
+ * planner is empty. A summary of simulated and host time goes to stderr.
+ *
+ * Lines sent as the TFT go out whole, at the TFT port's baud rate, each one
+ * 100ms after the last began, so several commands in one line separated by
+ * ':' arrive back to back. A line "wait SEC" holds the next one back for SEC
+ * seconds. The run lasts until 100ms after the last line. The longest
+ * pass of loop() from the first line on goes to stderr, in simulated time.
+ *
+ * The axes start 50mm (Z 20mm) from their minimum endstops, which trigger
+ * at zero, so G28 and probing behave as on a machine.
+ *
+ * --parse-floats runs no G-code. After setup() it gives each line of FILE
+ * to the G-code parser and compares the float of every parameter, bit for
+ * bit, with strtof() of its text up to the first character that isn't part
+ * of a plain decimal. With GCODE_PREPARSE the packed form of each G0-G3 is
+ * checked the same way. Mismatches go to stderr and the exit code is 1.
+ *
+ * --sd-read runs no G-code either. After setup() it opens the -p file and
+ * fills the command queue from it over and over, dropping what was queued,
+ * until the print is done. The host time spent reading goes to stderr (not
+ * AVR cycles). buildroot/share/scripts/check_sd_scanner.py compares the
+ * commands and the time of a build with SD_READ_AHEAD, which scans the
+ * read-ahead buffer a run at a time, and one reading a byte at a time.
+ *
+ * Any of the plant options makes the heaters warm their thermistors, from
+ * the --temp temperature as ambient (see native_thermal.cpp). M303, M109,
+ * M190 and thermal runaway protection then run as on a machine, and each
+ * heater's time to target, overshoot and settling time go to stderr. The
+ * first error the firmware reports is repeated there with its time.
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Marlin.h"
+#include "planner.h"
+#include "stepper.h"
+#include "cardreader.h"
+#include "gcode.h"
+#include "native_host.h"
+
+extern uint8_t commands_in_queue;
+void get_available_commands();
+void setup();
+void loop();
+
+static FILE *gcode_in, *serial_out, *tft_in, *tft_out, *parse_in, *commands_out;
+static const char *eeprom_path;
+static const char *print_file;
+static uint64_t timeout_cycles;
+
+//
+// Host serial: one line in flight, sent again only after its "ok"
+//
+static char tx_line[MAX_CMD_SIZE + 2], rx_line[MAX_CMD_SIZE + 2];
+static uint8_t tx_len, rx_pos, rx_len;
+static uint32_t lines_sent, oks;
+static uint8_t prelude;
+static bool host_ready, input_done;
+static char error_line[sizeof(tx_line) + 1];
+static double error_seconds;
+
+static bool next_line() {
+  char buf[256];
+  for (;;) {
+    if (print_file && prelude < 2) {
+      if (prelude++ == 0) snprintf(buf, sizeof(buf), "M23 %s", print_file);
+      else strcpy(buf, "M24");
+    }
+    else if (!gcode_in || !fgets(buf, sizeof(buf), gcode_in)) {
+      input_done = true;
+      return false;
+    }
+    char *c = strchr(buf, ';');
+    if (c) *c = '\0';
+    char *s = buf;
+    while (*s == ' ' || *s == '\t') s++;
+    size_t n = strlen(s);
+    while (n && (s[n - 1] == ' ' || s[n - 1] == '\t' || s[n - 1] == '\r' || s[n - 1] == '\n')) n--;
+    if (!n) continue;
+    NOMORE(n, MAX_CMD_SIZE - 1U);
+    memcpy(rx_line, s, n);
+    rx_line[n++] = '\n';
+    rx_len = n;
+    rx_pos = 0;
+    lines_sent++;
+    return true;
+  }
+}
+
+//
+// TFT serial: one line every TFT_LINE_MS, not waiting for any answer
+//
+#define TFT_LINE_MS 100
+static bool tft_polled;
+static uint64_t longest_loop;
+static char tft_line[256];
+static uint16_t tft_pos, tft_len;
+static uint64_t tft_next; // When the next line may start
+
+static bool tft_next_line() {
+  char buf[sizeof(tft_line) - 2];
+  while (fgets(buf, sizeof(buf), tft_in)) {
+    size_t n = strlen(buf);
+    while (n && (buf[n - 1] == '\r' || buf[n - 1] == '\n')) n--;
+    if (!n) continue;
+    float seconds;
+    if (sscanf(buf, "wait %f", &seconds) == 1) {
+      tft_next = native_cycles + (uint64_t)(seconds * F_CPU);
+      return false;
+    }
+    memcpy(tft_line, buf, n);
+    tft_line[n++] = '\r';
+    tft_line[n++] = '\n';
+    tft_len = n;
+    tft_pos = 0;
+    tft_polled = true;
+    tft_next = native_cycles + (uint64_t)(TFT_LINE_MS) * (F_CPU / 1000);
+    return true;
+  }
+  fclose(tft_in);
+  tft_in = NULL;
+  return false;
+}
+
+bool native_host_rx_available(const uint8_t link) {
+  if (!host_ready) return false;
+  if (link) {
+    if (tft_pos < tft_len) return true;
+    return tft_in && native_cycles >= tft_next && tft_next_line();
+  }
+  if (rx_pos < rx_len) return true;
+  return !input_done && oks >= lines_sent && next_line();
+}
+
+uint8_t native_host_rx_read(const uint8_t link) {
+  if (link) return tft_pos < tft_len ? tft_line[tft_pos++] : 0;
+  return rx_pos >= rx_len ? 0 : rx_line[rx_pos++];
+}
+
+void native_host_tx(const uint8_t link, const uint8_t c) {
+  if (link) {
+    if (tft_out) fputc(c, tft_out);
+    return;
+  }
+  if (serial_out) fputc(c, serial_out);
+  if (c == '\n') {
+    if (tx_len >= 2 && tx_line[0] == 'o' && tx_line[1] == 'k') oks++;
+    if (!error_line[0] && tx_len > 6 && !strncmp(tx_line, "Error:", 6)) {
+      memcpy(error_line, tx_line, tx_len);
+      error_line[tx_len] = '\0';
+      error_seconds = native_cycles / (double)F_CPU;
+    }
+    tx_len = 0;
+  }
+  else if (tx_len < sizeof(tx_line)) tx_line[tx_len++] = c;
+}
+
+//
+// Step timing. Steps are timed by the clock when the firmware next makes
+// it move on, so steps sent in one burst are 0µs apart.
+//
+// The --trace file starts with "MSTP" and F_CPU as a uint32, then holds
+// packed little-endian records of a uint64 cycle count, a type and an arg:
+//
+//   'B'  The stepper took a new block. arg is 0 and twelve int32 follow:
+//        steps X Y Z E, step_event_count, direction_bits, initial_rate,
+//        nominal_rate, final_rate, acceleration_steps_per_s2,
+//        accelerate_until, decelerate_after. With S_CURVE_ACCELERATION
+//        arg is 1 and three more follow: cruise_rate, acceleration_time
+//        and deceleration_time, the last two in Timer1 ticks (F_CPU / 8).
+//   'D'  A DIR pin changed. arg is the axis, plus 0x80 if it is now high
+//   'S'  A step. arg is the axis, plus 0x80 if it went backward
+//   'P'  With INPUT_SHAPING, a step of the X or Y motor, as 'S'. The
+//        'S' records are then the steps the blocks asked for.
+//
+// buildroot/share/scripts/check_step_trace.py checks a trace against its
+// blocks and reports step rates and jitter.
+//
+// The stepper ISR takes no simulated time, so the ISR cost given at the end
+// is host nanoseconds. It compares builds on one host and is no AVR cycle
+// count.
+//
+// The --blocks file has a text line for each block the planner discards,
+// with the trapezoid it ran: step_event_count, nominal_rate, initial_rate,
+// final_rate, accelerate_until and decelerate_after.
+// buildroot/share/scripts/check_planner_fixed.py compares two builds' files.
+//
+static bool step_histogram;
+static FILE *trace_out, *blocks_out;
+static uint8_t blocks_tail;
+static long step_position[NUM_AXIS];
+static uint64_t step_cycle[NUM_AXIS];
+static uint32_t step_bins[NUM_AXIS][13]; // <1µs, 1µs, 2-3µs, 4-7µs ... 1024-2047µs, 2048µs+
+static const block_t *trace_block;
+static bool trace_dir[NUM_AXIS];
+static const uint8_t trace_dir_pin[NUM_AXIS] = { X_DIR_PIN, Y_DIR_PIN, Z_DIR_PIN, E0_DIR_PIN };
+static uint32_t total_steps;
+static uint64_t isr_host_ns;
+
+static void trace_record(const uint8_t type, const uint8_t arg) {
+  uint8_t r[10];
+  memcpy(r, &native_cycles, 8);
+  r[8] = type;
+  r[9] = arg;
+  fwrite(r, sizeof(r), 1, trace_out);
+}
+
+static void trace_block_start(const block_t * const b) {
+  const trapezoid_t &t = b->trapezoid[b->trapezoid_index];
+  const int32_t v[] = {
+    (int32_t)b->steps[X_AXIS], (int32_t)b->steps[Y_AXIS], (int32_t)b->steps[Z_AXIS], (int32_t)b->steps[E_AXIS],
+    (int32_t)b->step_event_count, b->direction_bits,
+    (int32_t)t.initial_rate, (int32_t)b->nominal_rate, (int32_t)t.final_rate,
+    (int32_t)b->acceleration_steps_per_s2, t.accelerate_until, t.decelerate_after
+    #if ENABLED(S_CURVE_ACCELERATION)
+      , (int32_t)t.cruise_rate, (int32_t)t.acceleration_time, (int32_t)t.deceleration_time
+    #endif
+  };
+  #if ENABLED(S_CURVE_ACCELERATION)
+    trace_record('B', 1);
+  #else
+    trace_record('B', 0);
+  #endif
+  fwrite(v, sizeof(v), 1, trace_out);
+}
+
+static void blocks_discarded() {
+  for (; blocks_tail != planner.block_buffer_tail; blocks_tail = BLOCK_MOD(blocks_tail + 1)) {
+    const block_t &b = planner.block_buffer[blocks_tail];
+    const trapezoid_t &t = b.trapezoid[b.trapezoid_index];
+    fprintf(blocks_out, "%lu %lu %lu %lu %ld %ld\n", (unsigned long)b.step_event_count, (unsigned long)b.nominal_rate,
+      (unsigned long)t.initial_rate, (unsigned long)t.final_rate, (long)t.accelerate_until, (long)t.decelerate_after);
+  }
+}
+
+void native_host_clock() {
+  if (blocks_out) blocks_discarded();
+  if (!step_histogram && !trace_out) return;
+  if (trace_out) {
+    const block_t * const b = stepper.current_block;
+    if (b != trace_block) {
+      trace_block = b;
+      if (b) trace_block_start(b);
+    }
+    LOOP_XYZE(i) {
+      const bool d = native_pin_level(trace_dir_pin[i]);
+      if (d != trace_dir[i]) {
+        trace_dir[i] = d;
+        trace_record('D', i | (d ? 0x80 : 0));
+      }
+    }
+  }
+  LOOP_XYZE(i) {
+    const long p = stepper.position((AxisEnum)i);
+    const long n = labs(p - step_position[i]);
+    if (!n) continue;
+    const bool backward = p < step_position[i];
+    step_position[i] = p;
+    if (n > 4) continue; // set_position(), not steps
+    const uint64_t us = (native_cycles - step_cycle[i]) / NATIVE_CYCLES_PER_US;
+    uint8_t b = 0;
+    while (b < 12 && us >> b) b++;
+    step_bins[i][b]++;
+    step_bins[i][0] += n - 1;
+    step_cycle[i] = native_cycles;
+    total_steps += n;
+    if (trace_out) for (long s = n; s--;) trace_record('S', i | (backward ? 0x80 : 0));
+  }
+  #if ENABLED(INPUT_SHAPING)
+    static long motor_position[2];
+    if (trace_out) for (uint8_t i = 0; i < 2; i++) {
+      const long p = stepper.motor_position((AxisEnum)i), n = labs(p - motor_position[i]);
+      if (n && n <= 4) for (long s = n; s--;) trace_record('P', i | (p < motor_position[i] ? 0x80 : 0));
+      motor_position[i] = p;
+    }
+  #endif
+}
+
+static void report_step_histogram() {
+  fprintf(stderr, "native: step intervals (us)");
+  fprintf(stderr, " %7s", "<1");
+  for (uint8_t b = 1; b < 13; b++) fprintf(stderr, " %7u%s", 1U << (b - 1), b == 12 ? "+" : "");
+  fputc('\n', stderr);
+  LOOP_XYZE(i) {
+    fprintf(stderr, "native: %c                  ", "XYZE"[i]);
+    for (uint8_t b = 0; b < 13; b++) fprintf(stderr, " %7u", step_bins[i][b]);
+    fputc('\n', stderr);
+  }
+}
+
+static uint64_t host_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//
+// Axes and endstops. Steps made by the stepper ISR move the carriages;
+// set_position() and homing only change what the firmware believes.
+//
+static int32_t carriage[XYZ];
+static bool carriage_ready;
+static uint32_t stepper_isrs;
+
+static void update_endstops() {
+  #define _ENDSTOP(A,M,HIT) native_pin_override(A##_##M##_PIN, (HIT) != A##_##M##_ENDSTOP_INVERTING)
+  #if HAS_X_MIN
+    _ENDSTOP(X, MIN, carriage[X_AXIS] <= 0);
+  #endif
+  #if HAS_Y_MIN
+    _ENDSTOP(Y, MIN, carriage[Y_AXIS] <= 0);
+  #endif
+  #if HAS_Z_MIN
+    _ENDSTOP(Z, MIN, carriage[Z_AXIS] <= 0);
+  #endif
+  #if HAS_X_MAX
+    _ENDSTOP(X, MAX, carriage[X_AXIS] >= (X_MAX_POS - (X_MIN_POS)) * planner.axis_steps_per_mm[X_AXIS]);
+  #endif
+  #if HAS_Y_MAX
+    _ENDSTOP(Y, MAX, carriage[Y_AXIS] >= (Y_MAX_POS - (Y_MIN_POS)) * planner.axis_steps_per_mm[Y_AXIS]);
+  #endif
+  #if HAS_Z_MAX
+    _ENDSTOP(Z, MAX, carriage[Z_AXIS] >= (Z_MAX_POS - (Z_MIN_POS)) * planner.axis_steps_per_mm[Z_AXIS]);
+  #endif
+  #undef _ENDSTOP
+  #if HAS_Z_MIN_PROBE_PIN
+    native_pin_override(Z_MIN_PROBE_PIN, (carriage[Z_AXIS] <= 0) != Z_MIN_PROBE_ENDSTOP_INVERTING);
+  #endif
+  native_refresh_pins();
+}
+
+void native_host_stepper_isr(void (*isr)()) {
+  if (!carriage_ready) {
+    carriage[X_AXIS] = 50 * planner.axis_steps_per_mm[X_AXIS];
+    carriage[Y_AXIS] = 50 * planner.axis_steps_per_mm[Y_AXIS];
+    carriage[Z_AXIS] = 20 * planner.axis_steps_per_mm[Z_AXIS];
+    carriage_ready = true;
+  }
+  long before[XYZ];
+  LOOP_XYZ(i) before[i] = stepper.position((AxisEnum)i);
+  update_endstops();
+  const uint64_t ns = trace_out ? host_ns() : 0;
+  native_run_isr(isr);
+  if (trace_out) isr_host_ns += host_ns() - ns;
+  LOOP_XYZ(i) carriage[i] += stepper.position((AxisEnum)i) - before[i];
+  native_host_clock();
+  stepper_isrs++;
+}
+
+void native_host_tick() {
+  if (timeout_cycles && native_cycles >= timeout_cycles) native_host_halt("timeout");
+  native_thermal_tick();
+}
+
+//
+// Start and finish
+//
+static struct timespec host_start;
+
+static double host_seconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - host_start.tv_sec) + (now.tv_nsec - host_start.tv_nsec) * 1e-9;
+}
+
+static void finish(const int code) {
+  if (serial_out) fflush(serial_out);
+  if (tft_out) fclose(tft_out);
+  if (eeprom_path) {
+    FILE *f = fopen(eeprom_path, "wb");
+    if (f) { fwrite(native_eeprom, sizeof(native_eeprom), 1, f); fclose(f); }
+  }
+  native_sd_close();
+  const double sim = native_cycles / (double)F_CPU, host = host_seconds();
+  fprintf(stderr, "native: %u lines, %.3f s simulated in %.3f s (%.0fx), %u stepper ISRs\n",
+    lines_sent, sim, host, host > 0 ? sim / host : 0, stepper_isrs);
+  if (step_histogram) report_step_histogram();
+  native_thermal_report();
+  if (error_line[0]) fprintf(stderr, "native: %.3f s: %s\n", error_seconds, error_line);
+  if (tft_polled) fprintf(stderr, "native: longest loop() %.2f ms\n", longest_loop * 1000.0 / F_CPU);
+  if (blocks_out) fclose(blocks_out);
+  if (commands_out) fclose(commands_out);
+  if (trace_out) {
+    fclose(trace_out);
+    fprintf(stderr, "native: %u steps, stepper ISR host time (not AVR cycles) %.0f ns per ISR, %.0f ns per step\n", total_steps,
+      stepper_isrs ? (double)isr_host_ns / stepper_isrs : 0, total_steps ? (double)isr_host_ns / total_steps : 0);
+  }
+  fflush(NULL);
+  _exit(code); // Firmware objects are never destroyed on the MCU; skip their destructors
+}
+
+void native_host_halt(const char * const msg) {
+  fprintf(stderr, "native: %s\n", msg);
+  finish(1);
+}
+
+//
+// --parse-floats: the firmware's G-code parser against strtof()
+//
+static uint32_t parse_values, parse_wrong;
+
+static void parse_compare(const char * const text, const char * const form) {
+  for (const char *p = strchr(text, ' '); p && *p; p++) {
+    if (!WITHIN(*p, 'A', 'Z') || !parser.seenval(*p)) continue;
+    const char *v = p + 1;
+    while (*v == ' ') v++;
+    char num[MAX_CMD_SIZE];
+    const size_t n = strspn(v, "+-.0123456789");
+    memcpy(num, v, n);
+    num[n] = '\0';
+    const float got = parser.value_float(), want = strtof(num, NULL);
+    parse_values++;
+    if (memcmp(&got, &want, sizeof(got)) && parse_wrong++ < 10)
+      fprintf(stderr, "native: %s %c%s gave %.9g, strtof %.9g: %s\n", form, *p, num, got, want, text);
+  }
+}
+
+static void parse_floats() {
+  char line[MAX_CMD_SIZE], text[MAX_CMD_SIZE];
+  while (fgets(line, sizeof(line), parse_in)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (!line[0]) continue;
+    lines_sent++;
+    strcpy(text, line);
+    parser.parse(line);
+    parse_compare(text, "text");
+    #if ENABLED(GCODE_PREPARSE)
+      gcode_packed_t packed;
+      if (parser.pack(text, packed)) {
+        parser.load(packed);
+        parse_compare(text, "packed");
+      }
+    #endif
+  }
+  fclose(parse_in);
+  fprintf(stderr, "native: %u values parsed, %u differ from strtof()\n", parse_values, parse_wrong);
+  finish(parse_wrong ? 1 : 0);
+}
+
+//
+// --commands and --sd-read: the commands the firmware queues
+//
+static uint32_t commands_queued;
+
+static void command_queued(const char * const cmd) {
+  commands_queued++;
+  if (commands_out) fprintf(commands_out, "%s\n", cmd);
+}
+
+static void read_sd_print() {
+  if (!card.cardOK) card.initsd();
+  card.openFile((char*)print_file, true);
+  if (!card.isFileOpen()) native_host_halt("--sd-read can't open the file");
+  card.startFileprint();
+  uint32_t bytes = 0;
+  uint64_t ns = 0;
+  while (card.sdprinting) {
+    const uint64_t start = host_ns();
+    get_available_commands();
+    ns += host_ns() - start;
+    NOLESS(bytes, card.getIndex() + 1);
+    clear_command_queue();
+  }
+  fprintf(stderr, "native: read %u commands, %u bytes in %.3f ms host time (not AVR cycles), %.1f ns per byte\n",
+    commands_queued, bytes, ns * 1e-6, bytes ? (double)ns / bytes : 0);
+  finish(0);
+}
+
+static bool job_done() {
+  return input_done && oks >= lines_sent && !commands_in_queue
+      && !planner.blocks_queued() && !card.sdprinting
+      && !tft_in && native_cycles >= tft_next;
+}
+
+static void usage(const char * const name) {
+  fprintf(stderr, "usage: %s [-s sd.img] [-p file] [-e eeprom.bin] [-t celsius] [-o out | -q] [--tft out] [--tft-in file] [--timeout sec] [--histogram] [--trace out] [--blocks out] [--parse-floats file] [--check-thermistors]\n"
+                  "  [--commands out] [--sd-read] [--plant] [--hotend W,C,K,L] [--bed W,C,K,L] [--fan K] [--melt J] [--thermistor R25,BETA,PULLUP] [--thermal-log out] [gcode | -]\n", name);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  static const struct option opts[] = {
+    { "sd",      required_argument, NULL, 's' },
+    { "print",   required_argument, NULL, 'p' },
+    { "eeprom",  required_argument, NULL, 'e' },
+    { "temp",    required_argument, NULL, 't' },
+    { "output",  required_argument, NULL, 'o' },
+    { "quiet",   no_argument,       NULL, 'q' },
+    { "tft",     required_argument, NULL, 'T' },
+    { "tft-in",  required_argument, NULL, 'I' },
+    { "timeout", required_argument, NULL, 'L' },
+    { "histogram", no_argument,     NULL, 'H' },
+    { "trace",   required_argument, NULL, 'R' },
+    { "blocks",  required_argument, NULL, 'K' },
+    { "parse-floats", required_argument, NULL, 'V' },
+    { "check-thermistors", no_argument, NULL, 'C' },
+    { "commands", required_argument, NULL, 'Q' },
+    { "sd-read", no_argument,       NULL, 'D' },
+    { "plant",   no_argument,       NULL, 'P' },
+    { "hotend",  required_argument, NULL, 'E' },
+    { "bed",     required_argument, NULL, 'B' },
+    { "fan",     required_argument, NULL, 'F' },
+    { "melt",    required_argument, NULL, 'M' },
+    { "thermistor", required_argument, NULL, 'N' },
+    { "thermal-log", required_argument, NULL, 'G' },
+    { NULL, 0, NULL, 0 }
+  };
+  const char *sd_image = NULL;
+  float celsius = 25;
+  bool quiet = false, plant = false, sd_read = false;
+  serial_out = stdout;
+
+  for (int c; (c = getopt_long(argc, argv, "s:p:e:t:o:q", opts, NULL)) != -1;) switch (c) {
+    case 's': sd_image = optarg; break;
+    case 'p': print_file = optarg; break;
+    case 'e': eeprom_path = optarg; break;
+    case 't': celsius = atof(optarg); break;
+    case 'o': if (!(serial_out = fopen(optarg, "w"))) { perror(optarg); return 2; } break;
+    case 'q': quiet = true; break;
+    case 'T': if (!(tft_out = fopen(optarg, "w"))) { perror(optarg); return 2; } break;
+    case 'I': if (!(tft_in = fopen(optarg, "r"))) { perror(optarg); return 2; } break;
+    case 'L': timeout_cycles = (uint64_t)(atof(optarg) * F_CPU); break;
+    case 'H': step_histogram = true; break;
+    case 'R':
+      if (!(trace_out = fopen(optarg, "wb"))) { perror(optarg); return 2; }
+      fwrite("MSTP", 4, 1, trace_out);
+      { const uint32_t f = F_CPU; fwrite(&f, sizeof(f), 1, trace_out); }
+      break;
+    case 'K': if (!(blocks_out = fopen(optarg, "w"))) { perror(optarg); return 2; } break;
+    case 'V': if (!(parse_in = fopen(optarg, "r"))) { perror(optarg); return 2; } break;
+    case 'C': _exit(native_check_thermistors() ? 0 : 1);
+    case 'Q': if (!(commands_out = fopen(optarg, "w"))) { perror(optarg); return 2; } break;
+    case 'D': sd_read = true; break;
+    case 'P': plant = true; break;
+    case 'E': if (!native_thermal_heater(false, optarg)) usage(argv[0]); break;
+    case 'B': if (!native_thermal_heater(true, optarg)) usage(argv[0]); break;
+    case 'F': if (!native_thermal_fan(optarg)) usage(argv[0]); break;
+    case 'M': if (!native_thermal_melt(optarg)) usage(argv[0]); break;
+    case 'N': if (!native_thermal_thermistor(optarg)) usage(argv[0]); break;
+    case 'G': if (!native_thermal_log(optarg)) { perror(optarg); return 2; } break;
+    default: usage(argv[0]);
+  }
+  if (optind < argc) {
+    if (!strcmp(argv[optind], "-")) gcode_in = stdin;
+    else if (!(gcode_in = fopen(argv[optind], "r"))) { perror(argv[optind]); return 2; }
+  }
+  if (sd_read && !(sd_image && print_file)) usage(argv[0]);
+  if (quiet) serial_out = NULL;
+  else setvbuf(serial_out, NULL, _IOFBF, 1 << 16);
+
+  memset(native_eeprom, 0xFF, sizeof(native_eeprom));
+  if (eeprom_path) {
+    FILE *f = fopen(eeprom_path, "rb");
+    if (f) { if (fread(native_eeprom, 1, sizeof(native_eeprom), f)) {} fclose(f); }
+  }
+
+  if (sd_image && !native_sd_open(sd_image)) { perror(sd_image); return 2; }
+  #if PIN_EXISTS(SD_DETECT)
+    #if ENABLED(SD_DETECT_INVERTED)
+      native_pin_override(SD_DETECT_PIN, sd_image != NULL);
+    #else
+      native_pin_override(SD_DETECT_PIN, sd_image == NULL);
+    #endif
+  #endif
+  #if ENABLED(ANYCUBIC_FILAMENT_RUNOUT_SENSOR)
+    native_pin_override(FIL_RUNOUT_PIN, LOW);           // Filament loaded
+  #elif ENABLED(FILAMENT_RUNOUT_SENSOR)
+    native_pin_override(FIL_RUNOUT_PIN, !FIL_RUNOUT_INVERTING);
+  #endif
+
+  native_thermal_start(plant, celsius);
+
+  clock_gettime(CLOCK_MONOTONIC, &host_start);
+  SREG = _BV(SREG_I); // The Arduino core's init() leaves interrupts on
+  setup();
+  if (parse_in) parse_floats();
+  native_command_hook = commands_out || sd_read ? command_queued : NULL;
+  if (sd_read) read_sd_print();
+  host_ready = true;
+  for (;;) {
+    const uint64_t loop_start = native_cycles;
+    loop();
+    if (tft_polled) NOLESS(longest_loop, native_cycles - loop_start);
+    if (job_done()) finish(0);
+  }
+}
@@ -0,0 +1,211 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * native_sdcard.cpp - An SDHC card on the SPI bus, backed by an image file
+ *
+ * Speaks enough of the SPI-mode protocol for Sd2Card: the init sequence
+ * (CMD0, CMD8, ACMD41, CMD58), CSD/CID reads, single and multiple block
+ * reads and writes, and status. Any FAT image made with mkfs.vfat works.
+ */
+
+#include <Arduino.h>
+#include "MarlinConfig.h"
+#include "native_host.h"
+
+static FILE *image;
+static bool read_only;
+static uint32_t image_blocks;
+
+// Bytes waiting to be clocked out to the host
+static uint8_t out[1024];
+static uint16_t out_head, out_tail;
+
+static void out_clear() { out_head = out_tail = 0; }
+static void out_byte(const uint8_t b) { if (out_tail < sizeof(out)) out[out_tail++] = b; }
+
+enum SDState : uint8_t { SD_COMMAND, SD_READ_MULTIPLE, SD_WRITE_TOKEN, SD_WRITE_DATA };
+static SDState state;
+static bool idle = true, app_cmd, write_multiple;
+static uint8_t cmd[6], cmd_len;
+static uint32_t block;
+static uint8_t data[514];
+static uint16_t data_len;
+
+static uint16_t crc_ccitt(const uint8_t *buf, const uint16_t n) {
+  uint16_t crc = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    crc ^= (uint16_t)buf[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// Start token, payload and CRC
+static void out_data(const uint8_t *buf, const uint16_t n) {
+  out_byte(0xFF);
+  out_byte(0xFE);
+  for (uint16_t i = 0; i < n; i++) out_byte(buf[i]);
+  const uint16_t crc = crc_ccitt(buf, n);
+  out_byte(crc >> 8);
+  out_byte(crc & 0xFF);
+}
+
+static bool read_block(const uint32_t b, uint8_t *buf) {
+  if (b >= image_blocks || fseek(image, (long)b * 512, SEEK_SET) || fread(buf, 512, 1, image) != 1) return false;
+  return true;
+}
+
+static bool write_block(const uint32_t b, const uint8_t *buf) {
+  if (read_only || b >= image_blocks || fseek(image, (long)b * 512, SEEK_SET) || fwrite(buf, 512, 1, image) != 1) return false;
+  return true;
+}
+
+static void out_r1(const uint8_t r1) {
+  out_byte(0xFF); // NCR
+  out_byte(r1 | (idle ? 0x01 : 0x00));
+}
+
+static void command() {
+  const uint8_t c = cmd[0] & 0x3F;
+  const uint32_t arg = ((uint32_t)cmd[1] << 24) | ((uint32_t)cmd[2] << 16) | ((uint32_t)cmd[3] << 8) | cmd[4];
+  const bool acmd = app_cmd;
+  app_cmd = false;
+  out_clear();
+  if (acmd) switch (c) {
+    case 41: idle = false; out_r1(0); return;  // ACMD41 SD_SEND_OP_COND
+    case 23: out_r1(0); return;                // ACMD23 SET_WR_BLK_ERASE_COUNT
+  }
+  switch (c) {
+    case 0:  // GO_IDLE_STATE
+      idle = true;
+      state = SD_COMMAND;
+      out_r1(0);
+      break;
+    case 8:  // SEND_IF_COND
+      out_r1(0);
+      out_byte(0x00); out_byte(0x00); out_byte(0x01); out_byte(0xAA);
+      break;
+    case 9: { // SEND_CSD, version 2.0 (SDHC)
+      const uint32_t c_size = (image_blocks >> 10) ? (image_blocks >> 10) - 1 : 0;
+      const uint8_t csd[16] = { 0x40, 0x0E, 0x00, 0x32, 0x5B, 0x59, 0x00,
+                                (uint8_t)((c_size >> 16) & 0x3F), (uint8_t)(c_size >> 8), (uint8_t)c_size,
+                                0x7F, 0x80, 0x0A, 0x40, 0x00, 0x01 };
+      out_r1(0);
+      out_data(csd, sizeof(csd));
+    } break;
+    case 10: { // SEND_CID
+      const uint8_t cid[16] = { 0x02, 'M', 'L', 'N', 'A', 'T', 'I', 'V', 0x10, 0, 0, 0, 1, 0x01, 0x11, 0x01 };
+      out_r1(0);
+      out_data(cid, sizeof(cid));
+    } break;
+    case 12: // STOP_TRANSMISSION
+      state = SD_COMMAND;
+      out_r1(0);
+      break;
+    case 13: // SEND_STATUS
+      out_r1(0);
+      out_byte(0x00);
+      break;
+    case 17: // READ_SINGLE_BLOCK
+      if (!read_block(arg, data)) { out_r1(0x40); break; }
+      out_r1(0);
+      out_data(data, 512);
+      break;
+    case 18: // READ_MULTIPLE_BLOCK
+      if (arg >= image_blocks) { out_r1(0x40); break; }
+      out_r1(0);
+      block = arg;
+      state = SD_READ_MULTIPLE;
+      break;
+    case 24: // WRITE_BLOCK
+    case 25: // WRITE_MULTIPLE_BLOCK
+      out_r1(0);
+      block = arg;
+      write_multiple = (c == 25);
+      state = SD_WRITE_TOKEN;
+      break;
+    case 32: case 33: case 38: // Erase
+      out_r1(0);
+      break;
+    case 55: // APP_CMD
+      app_cmd = true;
+      out_r1(0);
+      break;
+    case 58: // READ_OCR: powered up, high capacity
+      out_r1(0);
+      out_byte(0xC0); out_byte(0xFF); out_byte(0x80); out_byte(0x00);
+      break;
+    default:
+      out_r1(0x04); // Illegal command
+  }
+}
+
+uint8_t native_host_spi(const uint8_t b) {
+  if (!image || native_pin_level(SDSS)) return 0xFF;
+
+  // Stream the next block of a multiple block read once the last one is out
+  if (state == SD_READ_MULTIPLE && out_head == out_tail && b == 0xFF) {
+    out_clear();
+    if (read_block(block, data)) { out_data(data, 512); block++; }
+  }
+
+  const uint8_t r = out_head < out_tail ? out[out_head++] : 0xFF;
+
+  switch (state) {
+    case SD_WRITE_TOKEN:
+      if (b == 0xFE || b == 0xFC) { state = SD_WRITE_DATA; data_len = 0; }
+      else if (b == 0xFD) { state = SD_COMMAND; out_clear(); out_byte(0x00); } // Stop tran, then busy
+      else if ((b & 0xC0) == 0x40) { state = SD_COMMAND; cmd[0] = b; cmd_len = 1; }
+      break;
+    case SD_COMMAND:
+    case SD_READ_MULTIPLE:
+      if (cmd_len || (b & 0xC0) == 0x40) {
+        cmd[cmd_len++] = b;
+        if (cmd_len == 6) { cmd_len = 0; command(); }
+      }
+      break;
+    case SD_WRITE_DATA:
+      data[data_len++] = b;
+      if (data_len == 514) {
+        out_clear();
+        out_byte(write_block(block, data) ? 0x05 : 0x0D); // Data accepted / write error
+        out_byte(0x00);                                   // Busy
+        block++;
+        state = write_multiple ? SD_WRITE_TOKEN : SD_COMMAND;
+      }
+      break;
+  }
+  return r;
+}
+
+bool native_sd_open(const char * const path) {
+  image = fopen(path, "r+b");
+  read_only = !image;
+  if (!image) image = fopen(path, "rb");
+  if (!image) return false;
+  fseek(image, 0, SEEK_END);
+  image_blocks = ftell(image) / 512;
+  return true;
+}
+
+void native_sd_close() {
+  if (image) fclose(image);
+  image = NULL;
+}
@@ -0,0 +1,430 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * native_sim.cpp - Simulated ATmega2560 core for the native (host) build
+ *
+ * Registers, the virtual clock, timer 0/1 compare matches, the USARTs,
+ * interrupt dispatch and the parts of the Arduino core Marlin calls.
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <SPI.h>
+#include "fastio.h"
+#include "native_host.h"
+
+//
+// Registers
+//
+volatile uint8_t SREG;
+
+#define _NATIVE_PORT(P) volatile uint8_t PORT##P, DDR##P, PIN##P
+_NATIVE_PORT(A); _NATIVE_PORT(B); _NATIVE_PORT(C); _NATIVE_PORT(D);
+_NATIVE_PORT(E); _NATIVE_PORT(F); _NATIVE_PORT(G); _NATIVE_PORT(H);
+_NATIVE_PORT(J); _NATIVE_PORT(K); _NATIVE_PORT(L);
+
+volatile uint8_t TCCR0A, TCCR0B, TIMSK0, TIFR0, OCR0A, OCR0B;
+volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TIFR2, OCR2A, OCR2B, TCNT2, ASSR;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+volatile uint16_t OCR1A, OCR1B, OCR1C, ICR1;
+volatile uint8_t TCCR3A, TCCR3B, TCCR3C, TIMSK3, TIFR3;
+volatile uint16_t OCR3A, OCR3B, OCR3C, ICR3, TCNT3;
+volatile uint8_t TCCR4A, TCCR4B, TCCR4C, TIMSK4, TIFR4;
+volatile uint16_t OCR4A, OCR4B, OCR4C, ICR4, TCNT4;
+volatile uint8_t TCCR5A, TCCR5B, TCCR5C, TIMSK5, TIFR5;
+volatile uint16_t OCR5A, OCR5B, OCR5C, ICR5, TCNT5;
+volatile uint8_t ADCSRA, ADCSRB, ADMUX, DIDR0, DIDR2;
+volatile uint8_t SPCR, SPSR = _BV(SPIF);
+volatile uint8_t EICRA, EICRB, EIMSK, EIFR, PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t MCUSR = _BV(PORF), MCUCR, WDTCSR;
+
+#define _NATIVE_USART(N) \
+  volatile uint8_t UCSR##N##B, UCSR##N##C, UBRR##N##H, UBRR##N##L; \
+  native_ucsra_t UCSR##N##A; \
+  native_udr_t UDR##N = { N, 0 }
+_NATIVE_USART(0); _NATIVE_USART(1); _NATIVE_USART(2); _NATIVE_USART(3);
+
+native_tcnt0_t native_tcnt0;
+native_tcnt1_t native_tcnt1;
+native_adc_t native_adc;
+native_spdr_t native_spdr;
+
+uint8_t native_eeprom[E2END + 1];
+uint8_t native_analog_out[86];
+uint16_t native_adc_value[16];
+void (*native_tick_hook)();
+void (*native_command_hook)(const char * const cmd);
+
+// Present for the free memory reports
+char *__brkval, __bss_end;
+
+//
+// Interrupt vectors, as defined by ISR() in the firmware. Any that the
+// configuration leaves out are simply never called.
+//
+extern "C" {
+  void TIMER0_COMPB_vect() __attribute__((weak));
+  void TIMER1_COMPA_vect() __attribute__((weak));
+  void USART0_RX_vect() __attribute__((weak));
+  void USART0_UDRE_vect() __attribute__((weak));
+  void USART3_RX_vect() __attribute__((weak));
+  void USART3_UDRE_vect() __attribute__((weak));
+}
+
+//
+// Virtual clock
+//
+uint64_t native_cycles;
+uint32_t native_call_cycles = NATIVE_CYCLES_PER_US;
+
+static uint64_t t1_base,    // Cycle at which TCNT1 last passed 0
+                next_ms_tick = 16000UL;
+static bool in_isr;
+
+enum NativeIRQ : uint8_t {
+  IRQ_T1_COMPA = _BV(0),
+  IRQ_T0_COMPB = _BV(1),
+  IRQ_RX0      = _BV(2),
+  IRQ_RX3      = _BV(3)
+};
+static uint8_t pending;
+
+// Clock select to prescaler shift, for the 1/8/64/256/1024 timers
+static int8_t prescale_shift(const uint8_t cs) {
+  static const int8_t shift[8] = { -1, 0, 3, 6, 8, 10, -1, -1 };
+  return shift[cs & 0x07];
+}
+
+// Timer 1 runs in CTC mode, so the counter restarts on every OCR1A match.
+// If OCR1A is set below the count the counter runs on past 0xFFFF first.
+static uint64_t timer1_next() {
+  const int8_t sh = prescale_shift(TCCR1B);
+  if (sh < 0) return UINT64_MAX;
+  uint64_t count = (native_cycles - t1_base) >> sh;
+  if (count > 0xFFFF) {
+    t1_base += (count & ~0xFFFFULL) << sh;
+    count &= 0xFFFF;
+  }
+  const uint32_t top = OCR1A ? OCR1A : 0x10000;
+  return t1_base + ((uint64_t)(top > count ? top : top + 0x10000) << sh);
+}
+
+// Reading TCNT1 costs a little time too, for the step spacing waits
+uint16_t native_tcnt1_read() {
+  native_advance(8);
+  const int8_t sh = prescale_shift(TCCR1B);
+  return sh < 0 ? 0 : (uint16_t)((native_cycles - t1_base) >> sh);
+}
+
+void native_tcnt1_write(const uint16_t v) {
+  const int8_t sh = prescale_shift(TCCR1B);
+  t1_base = native_cycles - ((uint64_t)v << (sh < 0 ? 0 : sh));
+}
+
+// Timer 0 is left as the Arduino core sets it up: free running at clk/64,
+// so OCR0B matches once every 256 counts (1.024ms).
+static uint64_t timer0b_next() {
+  const uint64_t now = native_cycles >> 6;
+  uint64_t k = (now & ~0xFFULL) | OCR0B;
+  if (k <= now) k += 0x100;
+  return k << 6;
+}
+
+// Reading TCNT0 costs a little time, so pulse-width busy waits finish
+uint8_t native_tcnt0_read() {
+  native_advance(8);
+  return (uint8_t)(native_cycles >> 6);
+}
+
+//
+// USARTs. Bytes from the host arrive at the configured baud rate, each one
+// only after the previous one has been taken by the RX interrupt. The TFT
+// port sends at its baud rate too, so its UDRE interrupt comes one byte
+// time after each write. The host port sends the moment it is written.
+//
+struct NativeUSART {
+  volatile uint8_t &ucsrb, &ubrrh, &ubrrl;
+  native_ucsra_t &ucsra;
+  native_udr_t &udr;
+  uint8_t irq;
+  uint64_t next_rx, tx_ready;
+};
+
+static NativeUSART usart[2] = {
+  { UCSR0B, UBRR0H, UBRR0L, UCSR0A, UDR0, IRQ_RX0, 0, 0 },
+  { UCSR3B, UBRR3H, UBRR3L, UCSR3A, UDR3, IRQ_RX3, 0, 0 }
+};
+
+static uint32_t byte_cycles(const NativeUSART &u) {
+  const uint16_t ubrr = (u.ubrrh << 8) | u.ubrrl;
+  return 10UL * (TEST(u.ucsra.v, 1) ? 8 : 16) * (ubrr + 1UL); // 10 bits per byte; U2Xn
+}
+
+static uint64_t usart_next(NativeUSART &u) {
+  if (!TEST(u.ucsrb, 4) || (pending & u.irq) || !native_host_rx_available(&u - usart)) return UINT64_MAX; // RXENn
+  if (u.next_rx <= native_cycles) u.next_rx = native_cycles + byte_cycles(u);
+  return u.next_rx;
+}
+
+static void usart_receive(NativeUSART &u) {
+  u.udr.rx = native_host_rx_read(&u - usart);
+  u.next_rx = 0;
+  pending |= u.irq;
+}
+
+// When the data register is free for the next byte
+static uint64_t usart_tx_next(const NativeUSART &u) {
+  return TEST(u.ucsrb, 5) && u.tx_ready > native_cycles ? u.tx_ready : UINT64_MAX; // UDRIEn
+}
+
+void native_uart_write(const uint8_t port, const uint8_t c) {
+  if (port == 3) usart[1].tx_ready = native_cycles + byte_cycles(usart[1]);
+  native_host_tx(port == 3 ? 1 : 0, c);
+}
+
+//
+// Advance the clock, raising every interrupt that comes due on the way
+//
+void native_advance(const uint32_t cycles) {
+  native_host_clock();
+  const uint64_t target = native_cycles + cycles;
+  for (;;) {
+    const uint64_t t1 = timer1_next(), t0 = timer0b_next(),
+                   r0 = usart_next(usart[0]), r3 = usart_next(usart[1]),
+                   x3 = usart_tx_next(usart[1]);
+    uint64_t t = target;
+    NOMORE(t, t1);
+    NOMORE(t, t0);
+    NOMORE(t, r0);
+    NOMORE(t, r3);
+    NOMORE(t, x3);
+    NOMORE(t, next_ms_tick);
+    native_cycles = t;
+
+    if (t == t1) { t1_base = t; pending |= IRQ_T1_COMPA; }
+    if (t == t0) pending |= IRQ_T0_COMPB;
+    if (t == r0) usart_receive(usart[0]);
+    if (t == r3) usart_receive(usart[1]);
+    if (t == next_ms_tick) {
+      next_ms_tick += 1000UL * NATIVE_CYCLES_PER_US;
+      native_refresh_pins();
+      native_host_tick();
+      if (native_tick_hook) native_tick_hook();
+    }
+
+    native_dispatch();
+    if (t == target) break;
+  }
+}
+
+static inline void native_call_isr(void (*isr)()) {
+  in_isr = true;
+  SREG &= ~_BV(SREG_I);
+  isr();
+  SREG |= _BV(SREG_I);
+  in_isr = false;
+}
+
+// Run pending interrupts in AVR vector order. Handlers never nest.
+void native_dispatch() {
+  if (in_isr || !TEST(SREG, SREG_I)) return;
+  for (;;) {
+    if ((pending & IRQ_T1_COMPA) && TEST(TIMSK1, OCIE1A) && TIMER1_COMPA_vect) {
+      pending &= ~IRQ_T1_COMPA;
+      native_host_stepper_isr(TIMER1_COMPA_vect);
+    }
+    else if ((pending & IRQ_T0_COMPB) && TEST(TIMSK0, OCIE0B) && TIMER0_COMPB_vect) {
+      pending &= ~IRQ_T0_COMPB;
+      native_call_isr(TIMER0_COMPB_vect);
+    }
+    else if ((pending & IRQ_RX0) && TEST(UCSR0B, RXCIE0) && USART0_RX_vect) {
+      pending &= ~IRQ_RX0;
+      native_call_isr(USART0_RX_vect);
+    }
+    else if (TEST(UCSR0B, UDRIE0) && USART0_UDRE_vect)
+      native_call_isr(USART0_UDRE_vect);
+    else if ((pending & IRQ_RX3) && TEST(UCSR3B, RXCIE3) && USART3_RX_vect) {
+      pending &= ~IRQ_RX3;
+      native_call_isr(USART3_RX_vect);
+    }
+    else if (TEST(UCSR3B, UDRIE3) && USART3_UDRE_vect && native_cycles >= usart[1].tx_ready)
+      native_call_isr(USART3_UDRE_vect);
+    else
+      break;
+  }
+}
+
+void native_run_isr(void (*isr)()) { native_call_isr(isr); }
+
+// A long run of watchdog resets with the clock standing still means the
+// firmware has stopped for good, as at the end of kill().
+void native_wdt_reset() {
+  static uint64_t last_cycles;
+  static uint32_t still;
+  if (native_cycles != last_cycles) { last_cycles = native_cycles; still = 0; }
+  else if (++still > 10000000UL) native_host_halt("watchdog: firmware halted");
+}
+
+//
+// ADC: the selected channel's value, as set by the host side
+//
+uint16_t native_adc_read() {
+  const uint8_t ch = (ADMUX & 0x07) | (TEST(ADCSRB, MUX5) ? 8 : 0);
+  return native_adc_value[ch] & 0x3FF;
+}
+
+//
+// SPI: exchanged with the simulated SD card while its select is low. Each
+// byte takes its eight SCK periods at the rate set in SPCR / SPSR.
+//
+static uint8_t spi_in = 0xFF;
+
+uint8_t native_spi_exchange(const uint8_t out) {
+  static const uint8_t divider[4] = { 4, 16, 64, 128 };
+  native_advance(8U * divider[SPCR & 0x03] >> (SPSR & _BV(SPI2X) ? 1 : 0));
+  spi_in = native_host_spi(out);
+  SPSR |= _BV(SPIF);
+  return spi_in;
+}
+
+uint8_t native_spi_last() { return spi_in; }
+
+//
+// Arduino core
+//
+unsigned long millis() {
+  native_advance(native_call_cycles);
+  return native_cycles / (1000UL * NATIVE_CYCLES_PER_US);
+}
+
+unsigned long micros() {
+  native_advance(native_call_cycles);
+  return native_cycles / NATIVE_CYCLES_PER_US;
+}
+
+void delay(unsigned long ms) { while (ms--) native_advance(1000UL * NATIVE_CYCLES_PER_US); }
+void delayMicroseconds(unsigned int us) { native_advance(us * NATIVE_CYCLES_PER_US); }
+
+// Arduino Mega pin numbers to port bits, straight from fastio
+struct NativePin { volatile uint8_t *port, *ddr, *pin; uint8_t bit; };
+#define _NP(N) { &DIO##N##_WPORT, &DIO##N##_DDR, &DIO##N##_RPORT, DIO##N##_PIN }
+static const NativePin native_pins[] = {
+  _NP(0),  _NP(1),  _NP(2),  _NP(3),  _NP(4),  _NP(5),  _NP(6),  _NP(7),  _NP(8),  _NP(9),
+  _NP(10), _NP(11), _NP(12), _NP(13), _NP(14), _NP(15), _NP(16), _NP(17), _NP(18), _NP(19),
+  _NP(20), _NP(21), _NP(22), _NP(23), _NP(24), _NP(25), _NP(26), _NP(27), _NP(28), _NP(29),
+  _NP(30), _NP(31), _NP(32), _NP(33), _NP(34), _NP(35), _NP(36), _NP(37), _NP(38), _NP(39),
+  _NP(40), _NP(41), _NP(42), _NP(43), _NP(44), _NP(45), _NP(46), _NP(47), _NP(48), _NP(49),
+  _NP(50), _NP(51), _NP(52), _NP(53), _NP(54), _NP(55), _NP(56), _NP(57), _NP(58), _NP(59),
+  _NP(60), _NP(61), _NP(62), _NP(63), _NP(64), _NP(65), _NP(66), _NP(67), _NP(68), _NP(69),
+  _NP(70), _NP(71), _NP(72), _NP(73), _NP(74), _NP(75), _NP(76), _NP(77), _NP(78), _NP(79),
+  _NP(80), _NP(81), _NP(82), _NP(83), _NP(84), _NP(85)
+};
+#undef _NP
+
+static int8_t pin_override[COUNT(native_pins)];
+
+void native_pin_override(const uint8_t pin, const int8_t level) {
+  if (pin < COUNT(native_pins)) pin_override[pin] = level < 0 ? 0 : level ? 1 : -1;
+}
+
+// Outputs read back as driven, inputs as their pull-up (PORTx) unless the
+// host side drives them
+bool native_pin_level(const uint8_t pin) {
+  const NativePin &np = native_pins[pin];
+  const uint8_t m = _BV(np.bit);
+  return (*np.ddr & m) || !pin_override[pin] ? (*np.port & m) : pin_override[pin] > 0;
+}
+
+void native_refresh_pins() {
+  for (uint8_t p = 0; p < COUNT(native_pins); p++) {
+    const NativePin &np = native_pins[p];
+    if (native_pin_level(p)) *np.pin |= _BV(np.bit); else *np.pin &= ~_BV(np.bit);
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= COUNT(native_pins)) return;
+  const NativePin &np = native_pins[pin];
+  if (mode == OUTPUT) *np.ddr |= _BV(np.bit);
+  else {
+    *np.ddr &= ~_BV(np.bit);
+    if (mode == INPUT_PULLUP) *np.port |= _BV(np.bit); else *np.port &= ~_BV(np.bit);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= COUNT(native_pins)) return;
+  const NativePin &np = native_pins[pin];
+  if (val) *np.port |= _BV(np.bit); else *np.port &= ~_BV(np.bit);
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < COUNT(native_pins) && native_pin_level(pin) ? HIGH : LOW;
+}
+
+void analogWrite(uint8_t pin, int val) {
+  if (pin >= COUNT(native_pins)) return;
+  pinMode(pin, OUTPUT);
+  native_analog_out[pin] = val;
+  digitalWrite(pin, val >= 128);
+}
+
+int analogRead(uint8_t pin) {
+  if (pin >= 54) pin -= 54;
+  return native_adc_value[pin & 0x0F];
+}
+
+uint8_t digitalPinToTimer(const uint8_t) { return NOT_ON_TIMER; }
+
+void tone(uint8_t, unsigned int, unsigned long) {}
+void noTone(uint8_t) {}
+
+long random(long howbig) { return howbig ? rand() % howbig : 0; }
+long random(long howsmall, long howbig) { return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall); }
+void randomSeed(unsigned long seed) { if (seed) srand(seed); }
+
+SPIClass SPI;
+
+//
+// avr-libc string conversions
+//
+char* dtostrf(double val, signed char width, unsigned char prec, char *s) {
+  sprintf(s, "%*.*f", width, prec, val);
+  return s;
+}
+
+char* ultoa(unsigned long val, char *s, int radix) {
+  char buf[8 * sizeof(long) + 1], *p = &buf[sizeof(buf) - 1];
+  *p = '\0';
+  do {
+    const uint8_t d = val % radix;
+    *--p = d < 10 ? '0' + d : 'a' + d - 10;
+    val /= radix;
+  } while (val);
+  return strcpy(s, p);
+}
+
+char* ltoa(long val, char *s, int radix) {
+  if (val < 0 && radix == 10) { *s = '-'; ultoa(-(unsigned long)val, s + 1, radix); return s; }
+  return ultoa((unsigned long)val, s, radix);
+}
+
+char* utoa(unsigned int val, char *s, int radix) { return ultoa(val, s, radix); }
+char* itoa(int val, char *s, int radix) { return ltoa(val, s, radix); }
@@ -0,0 +1,289 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * native_thermal.cpp - Thermistors, and heaters that warm them
+ *
+ * Without a plant every thermistor reads the --temp temperature forever.
+ * With one, hotend 0 and the bed are lumped thermal masses:
+ *
+ *   C dT/dt = P u(t - L) - (k + k_fan f) (T - T_ambient) - m q
+ *
+ * P is the heater power, u the heater pin (sampled every millisecond, so
+ * soft PWM averages out), L the dead time between the heater and the
+ * thermistor, C the heat capacity, k the loss to ambient and f the part
+ * fan duty. That is a first-order plus dead-time plant with gain P/k and
+ * time constant C/k. The hotend also loses m joules for every mm³ of
+ * filament it melts, at the rate q the E stepper pushes it in. Filament
+ * pulled back by a retract is melted again only once.
+ *
+ * The plant's temperature reaches the firmware as an ADC count, through
+ * the firmware's own thermistor table unless another thermistor is given.
+ * The fraction of a count is dithered, as ADC noise does on a real board,
+ * so the oversampled reading resolves less than a count.
+ *
+ * Every change of target starts a new run. When it ends, the run's time to
+ * target, overshoot and settling time go to stderr, with the range and
+ * RMS of the error once it has stayed within 1°C for 10s.
+ */
+
+#include <Arduino.h>
+#include "Marlin.h"
+#include "temperature.h"
+#include "planner.h"
+#include "stepper.h"
+#include "native_host.h"
+
+struct Heater {
+  const char *name;
+  float watts, capacity, loss, dead_time; // W, J/K, W/K, s
+  float T;
+  float *delay;                           // Heater power over the dead time, one entry per ms
+  uint32_t delay_len, delay_pos;
+  uint32_t on_ms;                         // For the log's duty column
+  // The current run
+  int16_t target;
+  float start_T, peak;
+  double start, reached, settled, held;
+  float held_min, held_max, held_sq;      // Error once it has been settled for 10s
+  uint32_t held_ms;
+};
+
+// A heater with its model. The rest starts at zero, with no run in progress.
+#define HEATER(NAME, WATTS, CAPACITY, LOSS, DEAD_TIME) { NAME, WATTS, CAPACITY, LOSS, DEAD_TIME, \
+  0, NULL, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }
+static Heater hotend = HEATER("hotend", 40, 12, 0.12, 1.5),
+              bed    = HEATER("bed",   200, 500, 1.6,  4.0);
+#undef HEATER
+static float fan_loss = 0.05, melt = 0.4, ambient = 25;
+static bool plant;
+
+// A thermistor on a pull-up, by its resistance at 25°C and its beta
+static bool beta_model;
+static float r25 = 100000, beta = 4092, pullup = 4700;
+
+static FILE *log_out;
+static uint32_t ticks;
+
+static double now() { return native_cycles / (double)F_CPU; }
+
+//
+// Thermistors
+//
+static float beta_adc(const float celsius) {
+  const float r = r25 * exp(beta * (1.0 / (celsius + 273.15) - 1.0 / 298.15));
+  return 1023.0 * r / (r + pullup);
+}
+
+static float firmware_temp(const int raw, const bool is_bed) {
+  #if HAS_TEMP_BED
+    if (is_bed) return Temperature::analog2tempBed(raw);
+  #endif
+  UNUSED(is_bed);
+  return Temperature::analog2temp(raw, 0);
+}
+
+// The ADC count, with a fraction, at which the firmware would read celsius
+static float firmware_adc(const float celsius, const bool is_bed) {
+  int lo = 0, hi = 1023 * OVERSAMPLENR;
+  const bool rising = firmware_temp(hi, is_bed) > firmware_temp(lo, is_bed);
+  while (hi - lo > 1) {
+    const int mid = (lo + hi) / 2;
+    if ((firmware_temp(mid, is_bed) < celsius) == rising) lo = mid; else hi = mid;
+  }
+  return lo / float(OVERSAMPLENR);
+}
+
+static uint16_t dither(const float adc) {
+  static uint32_t seed = 1;
+  seed = seed * 1103515245UL + 12345;
+  const float a = adc + ((seed >> 8) & 0xFFFF) / 65536.0;
+  return a <= 0 ? 0 : a >= 1023 ? 1023 : (uint16_t)a;
+}
+
+static void set_thermistor(const uint8_t channel, const float celsius, const bool is_bed) {
+  native_adc_value[channel] = dither(beta_model ? beta_adc(celsius) : firmware_adc(celsius, is_bed));
+}
+
+//
+// Runs: time to target, overshoot beyond it, and settling within 1°C
+//
+static void report_run(const Heater &h) {
+  if (!h.target) return;
+  fprintf(stderr, "native: %s %.1fC -> %dC at %.1fs: ", h.name, h.start_T, h.target, h.start);
+  if (h.reached < 0) { fprintf(stderr, "not reached, got to %.1fC\n", h.peak); return; }
+  fprintf(stderr, "reached in %.1fs, overshoot %.2fC, ", h.reached - h.start, fabs(h.peak - h.target));
+  if (h.settled < 0) fputs("not settled", stderr);
+  else fprintf(stderr, "settled in %.1fs", h.settled - h.start);
+  if (h.held_ms) fprintf(stderr, ", then held %+.2f/%+.2fC (rms %.2fC)", h.held_min, h.held_max, sqrt(h.held_sq / h.held_ms));
+  fputc('\n', stderr);
+}
+
+static void track_run(Heater &h, const int16_t target) {
+  const double t = now();
+  if (target != h.target) {
+    report_run(h);
+    h.target = target;
+    h.start = t;
+    h.start_T = h.peak = h.T;
+    h.reached = h.settled = h.held = -1;
+    h.held_min = h.held_max = h.held_sq = 0;
+    h.held_ms = 0;
+  }
+  if (!target) return;
+  const bool up = target >= h.start_T;
+  if (h.reached < 0 && (up ? h.T >= target : h.T <= target)) h.reached = t;
+  if (up ? h.T > h.peak : h.T < h.peak) h.peak = h.T;
+  const float error = h.T - target;
+  if (fabs(error) > 1) h.settled = -1;
+  else if (h.settled < 0) h.settled = t;
+  if (h.held < 0 && h.settled >= 0 && t - h.settled >= 10) h.held = t; // As long as M109 waits
+  if (h.held >= 0) {
+    NOMORE(h.held_min, error);
+    NOLESS(h.held_max, error);
+    h.held_sq += sq(error);
+    h.held_ms++;
+  }
+}
+
+//
+// The heaters
+//
+
+// Filament (mm³) melted in the last millisecond
+static float melt_volume() {
+  static long last_e, retracted;
+  const long e = stepper.position(E_AXIS);
+  long d = e - last_e;
+  last_e = e;
+  if (labs(d) > 100) return 0; // set_position(), not steps
+  if (d < 0) { retracted -= d; return 0; }
+  const long again = min(d, retracted);
+  retracted -= again;
+  d -= again;
+  return d * planner.steps_to_mm[E_AXIS] * (M_PI * 0.25) * sq(DEFAULT_NOMINAL_FILAMENT_DIA);
+}
+static void heater_step(Heater &h, const bool on, const float fan, const float melt_watts=0) {
+  float power = on ? h.watts : 0;
+  if (h.delay_len) {
+    float &slot = h.delay[h.delay_pos];
+    if (++h.delay_pos >= h.delay_len) h.delay_pos = 0;
+    const float late = slot;
+    slot = power;
+    power = late;
+  }
+  h.T += (power - (h.loss + fan_loss * fan) * (h.T - ambient) - melt_watts) / h.capacity * 0.001;
+  if (on) h.on_ms++;
+}
+
+static void heater_start(Heater &h) {
+  h.T = ambient;
+  h.delay_len = h.dead_time * 1000 + 0.5;
+  if (h.delay_len) h.delay = (float*)calloc(h.delay_len, sizeof(float));
+}
+
+static bool parse(const char * const spec, float * const v, const uint8_t n) {
+  const char *s = spec;
+  for (uint8_t i = 0; i < n && *s; i++) {
+    char *end;
+    if (*s != ',') {
+      v[i] = strtod(s, &end);
+      if (end == s || v[i] < 0) return false;
+      s = end;
+    }
+    if (*s == ',') s++;
+    else if (*s) return false;
+  }
+  return !*s;
+}
+
+bool native_thermal_heater(const bool is_bed, const char * const spec) {
+  Heater &h = is_bed ? bed : hotend;
+  float v[4] = { h.watts, h.capacity, h.loss, h.dead_time };
+  if (!parse(spec, v, 4) || !v[1] || !v[2]) return false;
+  h.watts = v[0]; h.capacity = v[1]; h.loss = v[2]; h.dead_time = v[3];
+  return plant = true;
+}
+
+bool native_thermal_fan(const char * const spec) {
+  return parse(spec, &fan_loss, 1) && (plant = true);
+}
+
+bool native_thermal_melt(const char * const spec) {
+  return parse(spec, &melt, 1) && (plant = true);
+}
+
+bool native_thermal_thermistor(const char * const spec) {
+  float v[3] = { r25, beta, pullup };
+  if (!parse(spec, v, 3) || !v[0] || !v[1]) return false;
+  r25 = v[0]; beta = v[1]; pullup = v[2];
+  return beta_model = plant = true;
+}
+
+bool native_thermal_log(const char * const path) {
+  if (!(log_out = fopen(path, "w"))) return false;
+  fputs("# time T_hotend target duty T_bed target duty fan\n", log_out);
+  return plant = true;
+}
+
+void native_thermal_start(const bool with_plant, const float celsius) {
+  plant |= with_plant;
+  ambient = celsius;
+  for (uint8_t i = 0; i < COUNT(native_adc_value); i++) native_adc_value[i] = beta_adc(celsius) + 0.5;
+  if (!plant) return;
+  heater_start(hotend);
+  heater_start(bed);
+  set_thermistor(TEMP_0_PIN, hotend.T, false);
+  #if HAS_TEMP_BED
+    set_thermistor(TEMP_BED_PIN, bed.T, true);
+  #endif
+}
+
+void native_thermal_tick() {
+  if (!plant) return;
+  #if HAS_FAN0
+    #if ENABLED(FAN_SOFT_PWM)
+      const float fan = native_pin_level(FAN_PIN);
+    #else
+      const float fan = native_analog_out[FAN_PIN] / 255.0;
+    #endif
+  #else
+    const float fan = 0;
+  #endif
+  heater_step(hotend, native_pin_level(HEATER_0_PIN), fan, melt * melt_volume() * 1000);
+  set_thermistor(TEMP_0_PIN, hotend.T, false);
+  track_run(hotend, thermalManager.target_temperature[0]);
+  #if HAS_TEMP_BED && HAS_HEATER_BED
+    heater_step(bed, native_pin_level(HEATER_BED_PIN), 0);
+    set_thermistor(TEMP_BED_PIN, bed.T, true);
+    track_run(bed, thermalManager.target_temperature_bed);
+  #endif
+  if (log_out && ++ticks % 100 == 0) {
+    fprintf(log_out, "%.1f %.2f %d %.2f %.2f %d %.2f %.2f\n", now(),
+      hotend.T, hotend.target, hotend.on_ms / 100.0, bed.T, bed.target, bed.on_ms / 100.0, fan);
+    hotend.on_ms = bed.on_ms = 0;
+  }
+}
+
+void native_thermal_report() {
+  if (!plant) return;
+  report_run(hotend);
+  report_run(bed);
+  if (log_out) fclose(log_out);
+}
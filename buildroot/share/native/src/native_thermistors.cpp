@@ -0,0 +1,109 @@
+/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * native_thermistors.cpp - Every thermistor table, old lookup against new
+ *
+ * --check-thermistors reads every raw reading, 0 to 1023 * OVERSAMPLENR,
+ * through every thermistortable_*.h with the table search analog2temp()
+ * used to do, and through its index table (THERMISTOR_INDEX_TABLES). For
+ * each table it gives the largest difference within the table, where it
+ * is, and the temperatures the two lookups read there. Every run of raw
+ * readings more than 0.25°C apart is listed first.
+ *
+ * Readings before the table's first point are extrapolated by both, the
+ * index table only as far as a short goes. They are only checked to read
+ * past the first point's temperature, the way the table goes, in both.
+ *
+ * buildroot/share/scripts/check_thermistors.py runs it and checks the
+ * differences.
+ */
+
+// Include every table, not just those of the configured sensors. Some give
+// raw readings as fractions of a count, which AVR builds only warn about.
+#define ANY_THERMISTOR_IS(n) 1
+#pragma GCC diagnostic ignored "-Wnarrowing"
+
+#include <Arduino.h>
+#include "Marlin.h"
+#include "temperature.h"
+#include "native_host.h"
+
+#if ENABLED(THERMISTOR_INDEX_TABLES)
+
+  #define THERMISTOR_TABLES(T) T(1) T(2) T(3) T(4) T(5) T(6) T(7) T(71) T(8) T(9) T(10) T(11) T(12) T(13) T(20) \
+    T(51) T(52) T(55) T(60) T(66) T(70) T(75) T(110) T(147) T(1010) T(1047) T(998) T(999)
+
+  // Readings further apart than this are listed, in runs of consecutive raw values
+  #define THERMISTOR_TOLERANCE 0.25
+
+  static bool check_table(const int n, const short (*tt)[2], const uint8_t len, const short * const it, const uint16_t ilen) {
+    const int first = (short)pgm_read_word(&tt[0][0]);
+    const float t0 = (short)pgm_read_word(&tt[0][1]),
+                way = len > 1 && (short)pgm_read_word(&tt[1][1]) > t0 ? -1 : 1; // Extrapolation before the first point goes this way
+    float worst = -1, worst_search = 0, worst_index = 0, run_worst = 0;
+    int worst_raw = first, run_start = -1;
+    bool beyond = true;
+    for (int raw = 0; raw <= 1023 * OVERSAMPLENR + 1; raw++) {
+      float search = 0, index = 0, diff = 0;
+      if (raw <= 1023 * OVERSAMPLENR) {
+        search = Temperature::temptable2temp(tt, len, raw);
+        index = Temperature::indextable2temp(it, ilen, raw);
+        diff = fabs(search - index);
+      }
+      if (raw < first) {
+        if ((search - t0) * way < 0 || (index - t0) * way < -0.1) beyond = false;
+        continue;
+      }
+      if (diff > worst) {
+        worst = diff;
+        worst_raw = raw;
+        worst_search = search;
+        worst_index = index;
+      }
+      if (diff > THERMISTOR_TOLERANCE) {
+        if (run_start < 0) { run_start = raw; run_worst = 0; }
+        NOLESS(run_worst, diff);
+      }
+      else if (run_start >= 0) {
+        fprintf(stderr, "native: thermistor %d: raw %d-%d differ by up to %.2f degC\n", n, run_start, raw - 1, run_worst);
+        run_start = -1;
+      }
+    }
+    fprintf(stderr, "native: thermistor %d: worst %.2f degC at raw %d (search %.2f, index %.2f), %s before the table\n",
+      n, worst, worst_raw, worst_search, worst_index, beyond ? "beyond" : "NOT beyond");
+    return beyond;
+  }
+
+  bool native_check_thermistors() {
+    bool ok = true;
+    #define _CHECK_TABLE(N) ok &= check_table(N, temptable_ ## N, COUNT(temptable_ ## N), indextable_ ## N, COUNT(indextable_ ## N));
+    THERMISTOR_TABLES(_CHECK_TABLE)
+    #undef _CHECK_TABLE
+    return ok;
+  }
+
+#else
+
+  bool native_check_thermistors() {
+    fprintf(stderr, "native: --check-thermistors needs THERMISTOR_INDEX_TABLES\n");
+    return false;
+  }
+
+#endif
@@ -0,0 +1,72 @@
+#!/usr/bin/env python
+
+""" Check the G-code float parser of the native build (marlin --parse-floats).
+
+Random moves go through the firmware's parser, and every value must come out
+bit-identical to strtof() of its text. The numbers look like a slicer's: a
+sign, up to 6 integer and 6 fraction digits, with or without the leading or
+trailing zero. Some run on into the next parameter with no space ("X1.5E2"
+is X1.5 and E2), and some are too long for the fast path.
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument('marlin', help='the native build (.pioenvs/native/program)')
+parser.add_argument('-n', '--lines', type=int, default=100000, help='lines of G-code to parse (default=100000)')
+parser.add_argument('--seed', type=int, default=1, help='random seed (default=1)')
+args = parser.parse_args()
+
+def digits(n):
+  return ''.join(random.choice('0123456789') for _ in range(n))
+
+def number():
+  """ A number as a slicer or a person might write it """
+  if random.random() < 0.05:
+    whole, frac = digits(random.randint(5, 12)), digits(random.randint(0, 12))
+  else:
+    whole, frac = digits(random.randint(0, 6)), digits(random.randint(0, 6))
+  text = random.choice(['', '', '-', '+']) + whole
+  if frac or random.random() < 0.2:
+    text += '.' + frac
+  return text if whole or frac else text + '0'
+
+def line():
+  letters = random.sample('XYZEF', random.randint(1, 5))
+  words = []
+  for a in letters:
+    word = a + number()
+    if words and words[-1][0] != 'E' and a == 'E' and random.random() < 0.3:
+      words[-1] += word  # No space before E
+    else:
+      words.append(word)
+  return random.choice(['G0', 'G1', 'G92']) + ' ' + ' '.join(words)
+
+def main():
+  random.seed(args.seed)
+  fd, path = tempfile.mkstemp(suffix='.gcode')
+  with os.fdopen(fd, 'w') as f:
+    for _ in range(args.lines):
+      text = line()
+      while len(text) >= 96: # MAX_CMD_SIZE
+        text = line()
+      f.write(text + '\n')
+  try:
+    run = subprocess.Popen([args.marlin, '-q', '--parse-floats', path],
+                           stderr=subprocess.PIPE, universal_newlines=True)
+    log = run.communicate()[1]
+  finally:
+    os.remove(path)
+  print(log, end='')
+  print('FAIL' if run.returncode else 'OK')
+  return 1 if run.returncode else 0
+
+if __name__ == '__main__':
+  sys.exit(main())
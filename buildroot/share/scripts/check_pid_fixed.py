@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+
+""" Compare the PID_FIXED_POINT PID with the float one (marlin --plant).
+
+Both native builds heat the simulated hotend and bed through the same job,
+by default the bed to 60C and the hotend to 210C, then 230C and 200C. Their
+temperatures, logged every 100ms, must stay within --max-diff of each other,
+and within --rms-diff RMS. Build the bed with PIDTEMPBED in both to compare
+its PID too. Each heater's runs, as the native build reports them, are
+printed for both builds.
+"""
+
+from __future__ import print_function
+
+import argparse
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument('float_build', help='the native build with the float PID')
+parser.add_argument('fixed_build', help='the native build with PID_FIXED_POINT')
+parser.add_argument('gcode', nargs='?', help='G-code to run (default: the heating job above)')
+parser.add_argument('--max-diff', type=float, default=0.5, help='largest temperature difference in degC (default=0.5)')
+parser.add_argument('--rms-diff', type=float, default=0.1, help='largest RMS temperature difference in degC (default=0.1)')
+args = parser.parse_args()
+
+JOB = """M140 S60
+M109 S210
+G4 S120
+M104 S230
+G4 S90
+M104 S200
+G4 S90
+"""
+
+COLUMNS = (('hotend', 1), ('bed', 4))
+
+def run(marlin, gcode):
+  """ The thermal log of a build, as rows of floats, and its reports """
+  fd, path = tempfile.mkstemp(suffix='.log')
+  os.close(fd)
+  try:
+    proc = subprocess.Popen([marlin, '-q', '--plant', '--thermal-log', path, gcode],
+                            stderr=subprocess.PIPE, universal_newlines=True)
+    log = proc.communicate()[1]
+    if proc.returncode:
+      sys.exit('%s failed:\n%s' % (marlin, log))
+    with open(path) as f:
+      rows = [[float(v) for v in line.split()] for line in f if not line.startswith('#')]
+  finally:
+    os.remove(path)
+  return rows, [line for line in log.splitlines() if line.startswith(('native: hotend', 'native: bed'))]
+
+def main():
+  gcode = args.gcode
+  if not gcode:
+    fd, gcode = tempfile.mkstemp(suffix='.gcode')
+    with os.fdopen(fd, 'w') as f:
+      f.write(JOB)
+  try:
+    want, want_runs = run(args.float_build, gcode)
+    got, got_runs = run(args.fixed_build, gcode)
+  finally:
+    if not args.gcode:
+      os.remove(gcode)
+
+  for name, runs in (('float', want_runs), ('fixed', got_runs)):
+    for line in runs:
+      print('%s %s' % (name, line))
+
+  n = min(len(want), len(got))
+  print('%d samples (float), %d samples (fixed)' % (len(want), len(got)))
+  bad = not n or abs(len(want) - len(got)) > 1
+  for heater, col in COLUMNS:
+    diffs = [g[col] - w[col] for w, g in zip(want[:n], got[:n])]
+    worst = max(range(n), key=lambda i: abs(diffs[i])) if n else 0
+    rms = math.sqrt(sum(d * d for d in diffs) / n) if n else 0
+    print('%-6s worst %+.2fC at %.1fs, rms %.3fC' % (heater, diffs[worst] if n else 0, want[worst][0] if n else 0, rms))
+    if n and (abs(diffs[worst]) > args.max_diff or rms > args.rms_diff):
+      bad = True
+  print('FAIL' if bad else 'OK')
+  return 1 if bad else 0
+
+if __name__ == '__main__':
+  sys.exit(main())
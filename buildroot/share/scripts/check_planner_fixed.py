@@ -0,0 +1,84 @@
+#!/usr/bin/env python
+
+""" Compare the PLANNER_FIXED_POINT planner with the float one (marlin --blocks).
+
+Both native builds run the same G-code, and every block they discard must
+have the same step count and nominal rate. The trapezoids may differ by the
+rounding of the integer math: initial and final rates by a
+part in --rate-tolerance (plus a step per second) and accelerate_until and
+decelerate_after by a part in --step-tolerance of the block (plus 2 steps).
+
+The float planner can end a block at the next one's safe speed, above its
+own nominal rate, where the fixed one stops at the nominal rate. Float rates
+are capped at nominal_rate, and ramp ends at the block's step count, first.
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument('float_build', help='the native build with the float planner')
+parser.add_argument('fixed_build', help='the native build with PLANNER_FIXED_POINT')
+parser.add_argument('gcode', nargs='?', help='G-code to stream (default: -p from the SD card)')
+parser.add_argument('-s', '--sd', help='FAT image for the SD card')
+parser.add_argument('-p', '--print', help='file on the SD card to print')
+parser.add_argument('--rate-tolerance', type=float, default=1000, help='rates may differ by 1 part in this (default=1000)')
+parser.add_argument('--step-tolerance', type=float, default=1000, help='ramp steps may differ by 1 part in this of the block (default=1000)')
+args = parser.parse_args()
+
+FIELDS = ('initial_rate', 'final_rate', 'accelerate_until', 'decelerate_after')
+
+def run(marlin):
+  """ The blocks a build discards, as tuples of ints """
+  fd, path = tempfile.mkstemp(suffix='.txt')
+  os.close(fd)
+  cmd = [marlin, '-q', '--blocks', path]
+  if args.sd: cmd += ['-s', args.sd]
+  if args.print: cmd += ['-p', args.print]
+  if args.gcode: cmd.append(args.gcode)
+  try:
+    if subprocess.call(cmd, stderr=open(os.devnull, 'w')):
+      sys.exit('%s failed' % marlin)
+    with open(path) as f:
+      return [tuple(int(v) for v in line.split()) for line in f]
+  finally:
+    os.remove(path)
+
+def main():
+  want, got = run(args.float_build), run(args.fixed_build)
+  print('%d blocks (float), %d blocks (fixed)' % (len(want), len(got)))
+  if len(want) != len(got):
+    print('FAIL')
+    return 1
+  worst = dict((f, (0.0, None)) for f in FIELDS)
+  bad = 0
+  for n, (w, g) in enumerate(zip(want, got)):
+    if w[:2] != g[:2]:
+      print('block %d: steps/nominal_rate %d/%d, fixed %d/%d' % (n, w[0], w[1], g[0], g[1]))
+      bad += 1
+      continue
+    for i, f in enumerate(FIELDS):
+      a, b = min(w[i + 2], w[1] if f.endswith('rate') else w[0]), g[i + 2]
+      if f.endswith('rate'):
+        limit = a / args.rate_tolerance + 1
+      else:
+        limit = w[0] / args.step_tolerance + 2
+      if abs(b - a) > worst[f][0] * limit:
+        worst[f] = (abs(b - a) / limit, n)
+      if abs(b - a) > limit:
+        if bad < 10:
+          print('block %d: %s %d, fixed %d' % (n, f, a, b))
+        bad += 1
+  for f in FIELDS:
+    print('%-17s worst %3.0f%% of tolerance%s' % (f, worst[f][0] * 100,
+          '' if worst[f][1] is None else ' (block %d)' % worst[f][1]))
+  print('FAIL' if bad else 'OK')
+  return 1 if bad else 0
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+
+""" Compare the SD_READ_AHEAD command scanner with the byte loop (marlin --sd-read).
+
+Both native builds read the same file from the SD card into the command
+queue, one built with SD_READ_AHEAD, which scans the read-ahead buffer a run
+at a time, and one without it, which reads a byte at a time. They must queue
+the same commands. The byte loop keeps blanks around a command that the
+scanner drops, which the parser skips anyway, so those are ignored.
+
+Each build then reads the file --runs times with nothing recorded, and the
+fastest host time per byte of each is given. That is the host's time, not
+the AVR's, but the scanner and the byte loop are timed alike.
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument('scanner_build', help='the native build with SD_READ_AHEAD')
+parser.add_argument('byte_build', help='the native build without SD_READ_AHEAD')
+parser.add_argument('-s', '--sd', required=True, help='FAT image for the SD card')
+parser.add_argument('-p', '--print', required=True, help='file on the SD card to read')
+parser.add_argument('--runs', type=int, default=5, help='timed reads of each build (default=5)')
+args = parser.parse_args()
+
+def read(marlin, commands=None):
+  """ The report of a build reading the file """
+  cmd = [marlin, '-q', '-s', args.sd, '-p', args.print, '--sd-read']
+  if commands: cmd += ['--commands', commands]
+  proc = subprocess.Popen(cmd, stderr=subprocess.PIPE, universal_newlines=True)
+  log = proc.communicate()[1]
+  m = re.search(r'read (\d+) commands, (\d+) bytes in ([\d.]+) ms', log)
+  if proc.returncode or not m:
+    sys.exit('%s failed:\n%s' % (marlin, log))
+  return int(m.group(1)), int(m.group(2)), float(m.group(3))
+
+def commands(marlin):
+  """ The commands a build queues, blanks around them dropped """
+  fd, path = tempfile.mkstemp(suffix='.txt')
+  os.close(fd)
+  try:
+    read(marlin, path)
+    with open(path) as f:
+      return [line.rstrip('\n').strip(' \t') for line in f]
+  finally:
+    os.remove(path)
+
+def main():
+  want, got = commands(args.byte_build), commands(args.scanner_build)
+  print('%d commands (byte loop), %d commands (scanner)' % (len(want), len(got)))
+  bad = 0
+  for n, (w, g) in enumerate(zip(want, got)):
+    if w != g:
+      if bad < 10:
+        print('command %d: %r, scanner %r' % (n, w, g))
+      bad += 1
+  if len(want) != len(got):
+    bad += 1
+
+  ns = {}
+  for name, marlin in (('byte loop', args.byte_build), ('scanner', args.scanner_build)):
+    runs = [read(marlin) for _ in range(max(args.runs, 1))]
+    size = runs[0][1]
+    ns[name] = min(r[2] for r in runs) * 1e6 / size if size else 0
+    print('%-9s %d bytes, %.1f ns per byte (host)' % (name, size, ns[name]))
+  if ns['scanner']:
+    print('scanner %.2fx the byte loop' % (ns['byte loop'] / ns['scanner']))
+  print('FAIL' if bad else 'OK')
+  return 1 if bad else 0
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,247 @@
+#!/usr/bin/env python
+
+""" Check a stepper pulse trace recorded by the native build (marlin --trace).
+
+Every block must get exactly the steps it asked for, in the direction its
+direction_bits give, with no DIR change while it runs. Blocks an endstop cut
+short are counted, not failed. The step rate of each block's lead axis is
+compared with its speed profile over windows of a few steps, and the spacing
+of steps at the nominal rate gives the jitter. The profile is the trapezoid,
+or with S_CURVE_ACCELERATION the S-curve ramps the trace gives.
+
+The stepper sets a new rate once per step, so where the rate changes by more
+than --lag of itself within one step (the slow end of a ramp) it runs a step
+behind the profile. Those windows are counted, not checked.
+
+With --ringing, the X and Y motors drive a damped mass on a spring, and the
+ringing left after each stop is reported. With INPUT_SHAPING the trace holds
+the motor steps apart from the block steps.
+"""
+
+from __future__ import print_function
+
+import argparse
+import math
+import struct
+import sys
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument('trace', help='trace file written by marlin --trace')
+parser.add_argument('-w', '--window', type=int, default=16, help='steps per rate measurement (default=16)')
+parser.add_argument('-t', '--tolerance', type=float, default=20, help='allowed rate error in %% (default=20)')
+parser.add_argument('--lag', type=float, default=2, help='skip windows where the rate changes by more than this %% in one step (default=2)')
+parser.add_argument('--skip-e', action='store_true', help="don't check E step counts (LIN_ADVANCE adds steps)")
+parser.add_argument('--ringing', metavar='HZ[:ZETA]', help='resonance of the X and Y axes (default damping 0.05)')
+parser.add_argument('--stop', type=float, default=20, help='gap in ms that ends a move, for --ringing (default=20)')
+args = parser.parse_args()
+
+AXES = 'XYZE'
+
+def bezier(u):
+  """ The S-curve's share of the rate change at u of the ramp time, and its integral """
+  return u * u * u * (10 - 15 * u + 6 * u * u), u * u * u * u * (2.5 - 3 * u + u * u)
+
+class Block(object):
+  def __init__(self, v, f_cpu):
+    self.steps = v[0:4]
+    (self.events, self.direction_bits, self.initial_rate, self.nominal_rate, self.final_rate,
+     self.accel, self.accelerate_until, self.decelerate_after) = v[4:12]
+    self.s_curve = len(v) > 12
+    if self.s_curve:
+      self.cruise_rate = v[12]
+      self.ramp_up, self.ramp_down = v[13] * 8.0 / f_cpu, v[14] * 8.0 / f_cpu # Seconds
+    self.lead = self.steps.index(self.events)
+    self.count = [0, 0, 0, 0]
+    self.wrong_way = 0
+    self.times = []  # Lead axis step times, in cycles
+
+  def expected_rate(self, n):
+    """ The trapezoid's step rate at step n """
+    up = math.sqrt(self.initial_rate ** 2 + 2.0 * self.accel * n)
+    down = math.sqrt(self.final_rate ** 2 + 2.0 * self.accel * max(self.events - n, 0))
+    return min(self.nominal_rate, up, down)
+
+  def expected_times(self, steps):
+    """ When the profile takes each of the first steps, in seconds from the first """
+    if self.s_curve:
+      return [self.s_curve_time(n) for n in range(steps)]
+    t, rate = [0.0], self.expected_rate
+    for n in range(1, steps):
+      t.append(t[-1] + (1.0 / rate(n - 1) + 4.0 / rate(n - 0.5) + 1.0 / rate(n)) / 6) # Simpson's rule
+    return t
+
+  def s_curve_time(self, n):
+    """ When the S-curve profile takes step n: up to accelerate_until, cruise, then down after decelerate_after """
+    def ramp(n, r0, r1, T):
+      # Time to cover n steps of a ramp from r0 to r1 lasting T, then at r1
+      if T <= 0:
+        return n / float(r1)
+      d = r1 - r0
+      covered = (r0 + r1) * 0.5 * T
+      if n >= covered:
+        return T + (n - covered) / float(r1)
+      lo, hi = 0.0, T
+      for _ in range(50):
+        t = (lo + hi) / 2
+        if r0 * t + d * T * bezier(t / T)[1] < n: lo = t
+        else: hi = t
+      return (lo + hi) / 2
+    c = self.cruise_rate
+    up, down = self.accelerate_until, self.decelerate_after
+    if n <= up:
+      return ramp(n, self.initial_rate, c, self.ramp_up)
+    t = ramp(up, self.initial_rate, c, self.ramp_up) + (min(n, down) - up) / float(c)
+    return t + ramp(n - down, c, self.final_rate, self.ramp_down) if n > down else t
+
+def read_trace(path):
+  with open(path, 'rb') as f:
+    data = f.read()
+  if data[:4] != b'MSTP':
+    sys.exit('%s: not a step trace' % path)
+  f_cpu = struct.unpack_from('<I', data, 4)[0]
+  blocks, stray, mid_block_dir = [], 0, [0, 0, 0]
+  block_steps, motor_steps = ([], []), ([], []) # X and Y (cycle, direction)
+  block = None
+  pos = 8
+  while pos + 10 <= len(data):
+    cycle, kind, arg = struct.unpack_from('<QBB', data, pos)
+    pos += 10
+    axis = arg & 0x7F
+    if kind == ord('B'):
+      n = 15 if arg & 1 else 12
+      block = Block(list(struct.unpack_from('<%di' % n, data, pos)), f_cpu)
+      blocks.append(block)
+      pos += 4 * n
+    elif kind == ord('D'):
+      if block and axis < 3 and any(block.count):
+        mid_block_dir[axis] += 1
+    elif kind == ord('P'):
+      motor_steps[axis].append((cycle, -1 if arg & 0x80 else 1))
+    elif kind == ord('S'):
+      if axis < 2:
+        block_steps[axis].append((cycle, -1 if arg & 0x80 else 1))
+      if block is None or block.count[block.lead] >= block.events and axis == block.lead:
+        stray += 1
+        continue
+      backward = bool(arg & 0x80)
+      block.count[axis] += 1
+      if backward != bool(block.direction_bits & (1 << axis)):
+        block.wrong_way += 1
+      if axis == block.lead:
+        block.times.append(cycle)
+    else:
+      sys.exit('%s: bad record at offset %d' % (path, pos - 10))
+  shaped = motor_steps[0] or motor_steps[1]
+  if shaped:
+    # Shaped axes set their DIR pins on their own time. Their motors must end up where the blocks went.
+    mid_block_dir = mid_block_dir[2]
+    for i in range(2):
+      if sum(d for _, d in motor_steps[i]) != sum(d for _, d in block_steps[i]):
+        print('%s motor steps differ from block steps' % AXES[i])
+        stray += 1
+  else:
+    mid_block_dir = sum(mid_block_dir)
+    motor_steps = block_steps
+  return f_cpu, blocks, stray, mid_block_dir, motor_steps
+
+def ringing(steps, f_cpu, hz, zeta, gap):
+  """ Ringing amplitude, in steps, of the mass at each stop of the motor """
+  w = 2 * math.pi * hz
+  wd = w * math.sqrt(1 - zeta * zeta)
+  u = v = 0.0 # Mass position and speed, relative to the motor
+  amplitudes = []
+  last = None
+  for cycle, d in steps:
+    if last is not None:
+      dt = (cycle - last) / float(f_cpu)
+      if dt >= gap:
+        amplitudes.append(math.hypot(u, (v + zeta * w * u) / wd))
+      e, c, s = math.exp(-zeta * w * dt), math.cos(wd * dt), math.sin(wd * dt)
+      u, v = (e * (u * c + (v + zeta * w * u) / wd * s),
+              e * (v * c - (w * w * u + zeta * w * v) / wd * s))
+    u -= d
+    last = cycle
+  if last is not None:
+    amplitudes.append(math.hypot(u, (v + zeta * w * u) / wd))
+  return amplitudes
+
+def main():
+  f_cpu, blocks, stray, mid_block_dir, motor_steps = read_trace(args.trace)
+  w = max(args.window, 2)
+  axes = 3 if args.skip_e else 4
+  count_errors = wrong_way = cut_short = lagging = 0
+  total = [0, 0, 0, 0]
+  rate_errors, jitter = [], []
+  max_rate, shortest = 0.0, None
+
+  for b in blocks:
+    for i in range(4):
+      total[i] += b.count[i]
+    wrong_way += b.wrong_way
+    if b.count[b.lead] < b.events:
+      cut_short += 1
+      count_errors += sum(1 for i in range(axes) if b.count[i] > b.steps[i])
+      continue
+    count_errors += sum(1 for i in range(axes) if b.count[i] != b.steps[i])
+
+    t = b.times
+    for k in range(1, len(t)):
+      dt = t[k] - t[k - 1]
+      if shortest is None or dt < shortest:
+        shortest = dt
+      # Steps at the nominal rate, away from the ramps
+      if b.accelerate_until + w < k <= b.decelerate_after - w:
+        jitter.append(dt * b.nominal_rate / float(f_cpu) - 1)
+    # Mean rates over the window, since the rate changes a lot over a few
+    # steps when a ramp starts from rest
+    ideal = b.expected_times(len(t)) if b.s_curve or min(b.initial_rate, b.final_rate) > 0 else None
+    for k in range(w, len(t)):
+      span = t[k] - t[k - w]
+      if span <= 0:
+        continue
+      rate = w * f_cpu / float(span)
+      max_rate = max(max_rate, rate)
+      if ideal:
+        expected = w / (ideal[k] - ideal[k - w])
+        ends = 1 / (ideal[k - w + 1] - ideal[k - w]), 1 / (ideal[k] - ideal[k - 1])
+      else:
+        expected = b.expected_rate(k - w / 2.0)
+        ends = b.expected_rate(k - w), b.expected_rate(k)
+      # Rate change per step, against the slower end
+      if min(ends) <= 0 or abs(ends[1] - ends[0]) / (w - 1) > min(ends) * args.lag / 100.0:
+        lagging += 1
+      elif expected > 0:
+        rate_errors.append(rate / expected - 1)
+
+  def pct(x):
+    return '%+.1f%%' % (100 * x)
+
+  def rms(v):
+    return math.sqrt(sum(x * x for x in v) / len(v)) if v else 0
+
+  print('%d blocks (%d cut short), steps %s' % (len(blocks), cut_short,
+        ' '.join('%s:%d' % (AXES[i], total[i]) for i in range(4))))
+  print('step count errors %d, wrong-way steps %d, DIR changes mid-block %d, steps outside blocks %d'
+        % (count_errors, wrong_way, mid_block_dir, stray))
+  if rate_errors:
+    print('rate vs profile (%d-step windows): rms %s, worst %s / %s, %d windows a step behind not checked'
+          % (w, pct(rms(rate_errors)), pct(max(rate_errors)), pct(min(rate_errors)), lagging))
+    print('max rate %.0f steps/s, shortest step interval %.2fus' % (max_rate, shortest * 1e6 / f_cpu))
+  if jitter:
+    print('interval jitter at nominal rate: rms %s, worst %s' % (pct(rms(jitter)), pct(max(jitter, key=abs))))
+  if args.ringing:
+    hz, _, zeta = args.ringing.partition(':')
+    for i in range(2):
+      a = ringing(motor_steps[i], f_cpu, float(hz), float(zeta or 0.05), args.stop / 1000.0)
+      if a:
+        print('%s ringing after each stop (steps): %s' % (AXES[i], ' '.join('%.2f' % x for x in a)))
+
+  worst = max(abs(x) for x in rate_errors) if rate_errors else 0
+  if count_errors or wrong_way or mid_block_dir or stray or worst * 100 > args.tolerance:
+    print('FAIL')
+    return 1
+  print('OK')
+  return 0
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,143 @@
+#!/usr/bin/env python
+
+""" Check the Anycubic TFT serial port of the native build (marlin --tft-in).
+
+Bursts of status polls go to the firmware as the TFT, several to a line
+so they arrive back to back and fill the receive ring faster than the
+main loop takes them. Their replies outrun the line, so the firmware
+drops the ones that don't fit in the transmit ring rather than wait for
+it. Every reply must be whole and in the format of its poll, and the
+replies must come in the order of the polls, with none extra. A34 replies
+hold the single replies of the fields that changed since the last A34, in
+order, and 'A34 F' replies hold all eight. With --sd the file list is
+polled too (A8 S0). Its reply is the lines from 'FN ' to 'END', and the
+firmware sends or drops each file's two lines together.
+
+After the bursts come single polls, one per line, and each of those must
+be answered. No pass of the main loop may take longer than --max-loop.
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument('marlin', help='the native build (.pioenvs/native/program)')
+parser.add_argument('-n', '--lines', type=int, default=20, help='lines of polls to send (default=20)')
+parser.add_argument('-b', '--burst', type=int, default=24, help='polls per line (default=24)')
+parser.add_argument('-s', '--sd', help='an SD card image, to poll its file list as well')
+parser.add_argument('--max-loop', type=float, default=5, help='longest allowed main loop pass in ms (default=5)')
+args = parser.parse_args()
+
+FIELD = [r' {0,2}-?\d{1,3}'] * 4 + [
+  r'\d{1,3}',
+  r'X: -?\d+\.\d\d Y: -?\d+\.\d\d Z: -?\d+\.\d\d ',
+  r'(?: {0,2}\d{1,3}|J02|---)',
+  r'(?:\d\d H \d\d M| 999:999)'
+]
+SINGLE = ['A%dV %s' % (n, FIELD[n]) for n in range(8)]
+REPLY = dict(('A%d' % n, SINGLE[n]) for n in range(8))
+REPLY['A34'] = 'A34V' + ''.join('(?: %s)?' % f for f in SINGLE)
+REPLY['A34 F'] = 'A34V' + ''.join(' ' + f for f in SINGLE)
+REPLY['A8 S0'] = r'FN (?:\|[^|]+\|[^|]*){0,4}(?:\|END)?'
+
+def polls():
+  """ A0-A7 in turn, with an A34 or A34 F after every seventh, and with
+      --sd a file list after every A34 F """
+  n = 0
+  while True:
+    for a in range(8):
+      yield 'A%d' % a
+      n += 1
+      if n % 7 == 0:
+        yield 'A34 F' if n % 14 else 'A34'
+        if args.sd and n % 14:
+          yield 'A8 S0'
+
+def join_lists(lines):
+  """ Join the lines of each file list into one, separated by '|' """
+  out = []
+  for l in lines:
+    if (out and out[-1].startswith('FN ') and not out[-1].endswith('|END')
+        and l != 'FN ' and not re.match(r'A\d+V', l)):
+      out[-1] += '|' + l
+    else:
+      out.append(l)
+  return out
+
+SINGLES = ['A%d' % n for n in range(8)] + ['A34 F'] + (['A8 S0'] if args.sd else [])
+
+def main():
+  sent = []
+  gen = polls()
+  fd, tft_in = tempfile.mkstemp(suffix='.txt')
+  with os.fdopen(fd, 'w') as f:
+    # With no SD card the autostart check, 5s after boot, spends 2s looking
+    # for one, and the main loop with it
+    f.write('wait 7\n')
+    for _ in range(args.lines):
+      line = [next(gen) for _ in range(args.burst)]
+      sent += line
+      f.write(':'.join(line) + '\n')
+    f.write('wait 1\n')
+    for a in SINGLES:
+      sent.append(a)
+      f.write(a + '\n')
+  fd, tft_out = tempfile.mkstemp(suffix='.out')
+  os.close(fd)
+  try:
+    sd = ['-s', args.sd] if args.sd else []
+    run = subprocess.Popen([args.marlin, '-q', '--timeout', '60', '--tft-in', tft_in, '--tft', tft_out] + sd,
+                           stderr=subprocess.PIPE, universal_newlines=True)
+    log = run.communicate()[1]
+    with open(tft_out, 'rb') as f:
+      out = f.read().decode('latin-1')
+  finally:
+    os.remove(tft_in)
+    os.remove(tft_out)
+  if run.returncode:
+    sys.exit('%s failed:\n%s' % (args.marlin, log))
+
+  # J codes are sent unasked, e.g. J17 for the main board reset
+  # A file without a long name has an empty second line
+  lines = [l for l in out.split('\r\n') if not re.match(r'J\d\d$', l)]
+  replies = [l for l in join_lists(lines) if l]
+
+  # Match each reply to the next poll it answers; the polls skipped over
+  # had their replies dropped
+  answered, i, bad = [], 0, 0
+  for got in replies:
+    j = i
+    while j < len(sent) and not re.match(REPLY[sent[j]] + '$', got):
+      j += 1
+    if j == len(sent):
+      if bad < 5:
+        print('reply %r after poll %d answers no later poll' % (got, i))
+      bad += 1
+      continue
+    answered.append(j)
+    i = j + 1
+  unanswered = [a for a in range(len(sent) - len(SINGLES), len(sent)) if a not in answered]
+  for a in unanswered:
+    print('single poll %d (%s) got no reply' % (a, sent[a]))
+  longest = re.search(r'longest loop\(\) ([\d.]+) ms', log)
+  longest = float(longest.group(1)) if longest else float('inf')
+
+  print('%d polls in %d lines of %d and %d single, %d replies, %d bytes received'
+        % (len(sent), args.lines, args.burst, len(SINGLES), len(replies), len(out)))
+  print('replies dropped %d, wrong or out of order %d, single polls unanswered %d'
+        % (len(sent) - len(answered), bad, len(unanswered)))
+  print('longest loop pass %.2f ms (at most %g)' % (longest, args.max_loop))
+  if bad or unanswered or longest > args.max_loop:
+    print('FAIL')
+    return 1
+  print('OK')
+  return 0
+
+if __name__ == '__main__':
+  sys.exit(main())
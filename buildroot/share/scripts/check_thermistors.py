@@ -0,0 +1,59 @@
+#!/usr/bin/env python
+
+""" Check the thermistor index tables of the native build (marlin --check-thermistors).
+
+Every raw reading of every thermistortable_*.h is read with the table search
+and with the index table (THERMISTOR_INDEX_TABLES). The native build lists
+each run of readings more than 0.25 degC apart, and every run must be one of
+the known ones below: near table points that fall between ADC counts, where
+a table with an entry per count can't follow. Readings before a table's
+first point must read past its temperature with both lookups.
+"""
+
+from __future__ import print_function
+
+import argparse
+import re
+import subprocess
+import sys
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument('marlin', help='the native build (.pioenvs/native/program)')
+args = parser.parse_args()
+
+OVERSAMPLENR = 16
+
+# Table, first and last raw reading, largest difference (degC), where
+KNOWN = [
+  (6,     913 * OVERSAMPLENR,  915 * OVERSAMPLENR,   4.75, 'the step from 45 to 40 degC at ADC 914'),
+  (66,     17 * OVERSAMPLENR,   18 * OVERSAMPLENR, 101.6,  'the 850 degC point at ADC 17.5, past the 500 degC top'),
+  (66,   1006 * OVERSAMPLENR, 1023 * OVERSAMPLENR,   4.6,  'the points below 80 degC, at fractions of a count'),
+]
+
+def main():
+  run = subprocess.Popen([args.marlin, '--check-thermistors'], stderr=subprocess.PIPE, universal_newlines=True)
+  log = run.communicate()[1]
+  bad, tables = 0, 0
+  for line in log.splitlines():
+    print(line)
+    m = re.match(r'native: thermistor (\d+): raw (\d+)-(\d+) differ by up to ([\d.]+) degC', line)
+    if m:
+      table, first, last, diff = int(m.group(1)), int(m.group(2)), int(m.group(3)), float(m.group(4))
+      known = [k for k in KNOWN if k[0] == table and k[1] <= first and last <= k[2] and diff <= k[3]]
+      if known:
+        print('  known: %s' % known[0][4])
+      else:
+        print('  NOT KNOWN')
+        bad += 1
+    elif re.match(r'native: thermistor \d+: worst', line):
+      tables += 1
+      if 'NOT beyond' in line:
+        bad += 1
+  if run.returncode or not tables:
+    bad += 1
+  print('%d tables' % tables)
+  print('FAIL' if bad else 'OK')
+  return 1 if bad else 0
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -7,7 +7,8 @@ http://en.wikipedia.org/wiki/Steinhart-Hart_equation
 The main use is for Arduino programs that read data from the circuit board described here:
 http://reprap.org/wiki/Temperature_Sensor_v2.0
 
-Usage: python createTemperatureLookup.py [options]
+Usage: python createTemperatureLookupMarlin.py [options]
+       python createTemperatureLookupMarlin.py --index [--tolerance=...] thermistortable_*.h
 
 Options:
   -h, --help        show this help
@@ -16,9 +17,13 @@ Options:
   --t2=ttt:rrr      middle temperature temperature:resistance point (around 150 degC)
   --t3=ttt:rrr      high temperature temperature:resistance point (around 250 degC)
   --num-temps=...   the number of temperature points to calculate (default: 36)
+  --index           write thermistortables_index.h for the given thermistor tables
+  --tolerance=...   with --index, warn where a table differs by more degC (default: 0.1)
 """
 
+from __future__ import print_function
 from math import *
+import re
 import sys
 import getopt
 
@@ -47,9 +52,9 @@ class Thermistor:
         a = y1 - (b + l1**2 *c)*l1
 
         if c < 0:
-            print "//////////////////////////////////////////////////////////////////////////////////////"
-            print "// WARNING: negative coefficient 'c'! Something may be wrong with the measurements! //"
-            print "//////////////////////////////////////////////////////////////////////////////////////"
+            print("//////////////////////////////////////////////////////////////////////////////////////")
+            print("// WARNING: negative coefficient 'c'! Something may be wrong with the measurements! //")
+            print("//////////////////////////////////////////////////////////////////////////////////////")
             c = -c
         self.c1 = a                         # Steinhart-Hart coefficients
         self.c2 = b
@@ -83,6 +88,119 @@ class Thermistor:
         r = exp((y-x)**(1.0/3) - (y+x)**(1.0/3))
         return (r / (self.rp + r)) * ARES
 
+OVERSAMPLENR = 16                           # raw readings are the sum of this many ADC samples
+INDEX_SCALE = 16                            # index table entries per degC
+
+def ptrt(t, r0):
+    "Pt100 / Pt1000 resistance at a temperature, as PtRt() in thermistortables.h"
+    return r0 * (1.0 + 3.9083E-3 * t + -5.775E-7 * t * t)
+
+def read_table(path):
+    "Read the name and (raw, temperature) points of a thermistortable_*.h"
+    src = re.sub(r'//[^\n]*|/\*.*?\*/', '', open(path).read(), flags=re.S)
+    m = re.search(r'temptable_(\w+)\[\]\[2\]\s*PROGMEM\s*=\s*\{(.*?)\};', src, re.S)
+    if not m:
+        sys.exit("%s: no temptable found" % path)
+    points = []
+    for e in re.finditer(r'PtLine\(([^)]*)\)|\{([^{}]*),([^{}]*)\}', m.group(2)):
+        if e.group(1):
+            t, r0, rup = [float(x) for x in e.group(1).split(',')]
+            points.append((int(1024 / (rup / ptrt(t, r0) + 1)) * OVERSAMPLENR, t))
+        else:
+            raw = int(eval(e.group(2).replace('OVERSAMPLENR', str(OVERSAMPLENR)).replace('(short)', 'int')))
+            temp = e.group(3).strip()
+            points.append((raw, float(temp) if re.match(r'^-?[\d.]+$', temp) else temp))
+    return m.group(1), points
+
+def scan2temp(points, raw):
+    "Temperature of a raw reading, as the table search in Temperature::analog2temp() gave it"
+    for i in range(1, len(points)):
+        if points[i][0] > raw:
+            (r0, t0), (r1, t1) = points[i - 1], points[i]
+            return t0 + (raw - r0) * float(t1 - t0) / (r1 - r0)
+    return points[-1][1]
+
+def index2temp(table, raw):
+    "Temperature of a raw reading from an index table, as Temperature::analog2temp() gets it"
+    i = raw // OVERSAMPLENR
+    if i >= len(table) - 1:
+        return table[-1] / float(INDEX_SCALE)
+    return (table[i] * OVERSAMPLENR + (table[i + 1] - table[i]) * (raw % OVERSAMPLENR)) / float(INDEX_SCALE * OVERSAMPLENR)
+
+def print_index(paths, tolerance):
+    "Print thermistortables_index.h: each table's temperatures at every ADC count"
+    tables = []
+    for path in paths:
+        name, points = read_table(path)
+        temps = set(t for _, t in points)
+        if any(isinstance(t, str) for t in temps):
+            # A dummy table reads one fixed value
+            if len(temps) != 1:
+                sys.exit("%s: can't evaluate temperatures %s" % (path, ', '.join(map(str, temps))))
+            tables.append((name, ['%s * INDEXTABLE_SCALE' % temps.pop()], None))
+            continue
+        # Readings below the first point extend its segment, as far as a short goes
+        last = -(-points[-1][0] // OVERSAMPLENR)
+        table = [int(round(scan2temp(points, adc * OVERSAMPLENR) * INDEX_SCALE)) for adc in range(last + 1)]
+        table = [max(-32767, min(t, 32767)) for t in table]
+        error, at = max((abs(index2temp(table, raw) - scan2temp(points, raw)), raw) for raw in range(points[0][0], 1024 * OVERSAMPLENR))
+        if error > tolerance:
+            print("temptable_%s: %.2f degC off at raw %d, ADC %.1f. Points between ADC counts?" % (name, error, at, at / float(OVERSAMPLENR)), file=sys.stderr)
+        tables.append((name, table, error))
+
+    tables.sort(key=lambda t: (len(t[0]), t[0]))
+    print("""/**
+ * Marlin 3D Printer Firmware
+ * Copyright (C) 2016 MarlinFirmware [https://github.com/MarlinFirmware/Marlin]
+ *
+ * Based on Sprinter and grbl.
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Thermistor tables indexed by ADC count, for THERMISTOR_INDEX_TABLES
+ *
+ * Entry n is the temperature, in 1/INDEXTABLE_SCALE degC, of a raw reading
+ * of n * OVERSAMPLENR. Readings in between are interpolated, and readings
+ * past the end of a table read its last entry.
+ *
+ * Generated from the thermistortable_*.h tables. Don't edit this file,
+ * change the table and run
+ *
+ *   buildroot/share/scripts/createTemperatureLookupMarlin.py --index Marlin/thermistortable_*.h > Marlin/thermistortables_index.h
+ */
+
+#ifndef THERMISTORTABLES_INDEX_H_
+#define THERMISTORTABLES_INDEX_H_
+
+#define INDEXTABLE_SCALE %d""" % INDEX_SCALE)
+    for name, table, error in tables:
+        print()
+        print("#if ANY_THERMISTOR_IS(%s)" % name)
+        if error is not None:
+            print("  // At most %.2f degC from temptable_%s" % (error, name))
+        print("  const short indextable_%s[] PROGMEM = {" % name)
+        for i in range(0, len(table), 12):
+            print("    " + ", ".join(str(t) for t in table[i:i + 12]) + ("," if i + 12 < len(table) else ""))
+        print("  };")
+        print("#endif")
+    print()
+    print("#endif // THERMISTORTABLES_INDEX_H_")
+
 def main(argv):
     "Default values"
     t1 = 25                                 # low temperature in Kelvin (25 degC)
@@ -93,11 +211,13 @@ def main(argv):
     r3 = 226.15                             # resistance at high temperature (226.15 Ohm)
     rp = 4700;                              # pull-up resistor (4.7 kOhm)
     num_temps = 36;                         # number of entries for look-up table
+    index = False                           # write index tables for the given thermistor tables
+    tolerance = 0.1                         # largest difference from a thermistor table (degC)
 
     try:
-        opts, args = getopt.getopt(argv, "h", ["help", "rp=", "t1=", "t2=", "t3=", "num-temps="])
+        opts, args = getopt.getopt(argv, "h", ["help", "rp=", "t1=", "t2=", "t3=", "num-temps=", "index", "tolerance="])
     except getopt.GetoptError as err:
-        print  str(err)
+        print(str(err))
         usage()
         sys.exit(2)
 
@@ -121,36 +241,44 @@ def main(argv):
             r3 = float(arg[1])
         elif opt == "--num-temps":
             num_temps = int(arg)
+        elif opt == "--index":
+            index = True
+        elif opt == "--tolerance":
+            tolerance = float(arg)
+
+    if index:
+        print_index(args, tolerance)
+        return
 
     t = Thermistor(rp, t1, r1, t2, r2, t3, r3)
     increment = int((ARES-1)/(num_temps-1));
-    step = (TMIN-TMAX) / (num_temps-1)
+    step = (TMIN-TMAX) // (num_temps-1)
     low_bound = t.temp(ARES-1);
     up_bound = t.temp(1);
     min_temp = int(TMIN if TMIN > low_bound else low_bound)
     max_temp = int(TMAX if TMAX < up_bound else up_bound)
-    temps = range(max_temp, TMIN+step, step);
+    temps = list(range(max_temp, TMIN+step, step));
 
-    print "// Thermistor lookup table for Marlin"
-    print "// ./createTemperatureLookupMarlin.py --rp=%s --t1=%s:%s --t2=%s:%s --t3=%s:%s --num-temps=%s" % (rp, t1, r1, t2, r2, t3, r3, num_temps)
-    print "// Steinhart-Hart Coefficients: a=%.15g, b=%.15g, c=%.15g " % (t.c1, t.c2, t.c3)
-    print "// Theoretical limits of termistor: %.2f to %.2f degC" % (low_bound, up_bound)
-    print
-    print "#define NUMTEMPS %s" % (len(temps))
-    print "const short temptable[NUMTEMPS][2] PROGMEM = {"
+    print("// Thermistor lookup table for Marlin")
+    print("// ./createTemperatureLookupMarlin.py --rp=%s --t1=%s:%s --t2=%s:%s --t3=%s:%s --num-temps=%s" % (rp, t1, r1, t2, r2, t3, r3, num_temps))
+    print("// Steinhart-Hart Coefficients: a=%.15g, b=%.15g, c=%.15g " % (t.c1, t.c2, t.c3))
+    print("// Theoretical limits of termistor: %.2f to %.2f degC" % (low_bound, up_bound))
+    print()
+    print("#define NUMTEMPS %s" % (len(temps)))
+    print("const short temptable[NUMTEMPS][2] PROGMEM = {")
 
     for temp in temps:
         adc = t.adc(temp)
-        print "    { (short) (%7.2f * OVERSAMPLENR ), %4s }%s // v=%.3f\tr=%.3f\tres=%.3f degC/count" % (adc , temp, \
+        print("    { (short) (%7.2f * OVERSAMPLENR ), %4s }%s // v=%.3f\tr=%.3f\tres=%.3f degC/count" % (adc , temp, \
                         ',' if temp != temps[-1] else ' ', \
                         t.voltage(adc), \
                         t.resist( adc), \
                         t.resol(  adc) \
-                    )
-    print "};"
+                    ))
+    print("};")
 
 def usage():
-    print __doc__
+    print(__doc__)
 
 if __name__ == "__main__":
     main(sys.argv[1:])